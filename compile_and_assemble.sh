@@ -8,9 +8,13 @@ fi
 INPUT_FILE="$1"
 BASE_NAME=$(basename "$INPUT_FILE" .sl)
 ASM_FILE="output/${BASE_NAME}.asm"
+BIN_FILE="output/${BASE_NAME}.bin"
+HEX_FILE="output/${BASE_NAME}.hex"
 
-echo "=== Compiling SimpleLang to Assembly ==="
-./bin/simplelang "$INPUT_FILE"
+echo "=== Compiling SimpleLang to Assembly and ROM image ==="
+./bin/simplelang "$INPUT_FILE" --emit=asm -o "$ASM_FILE" &&
+    ./bin/simplelang "$INPUT_FILE" --emit=bin -o "$BIN_FILE" &&
+    ./bin/simplelang "$INPUT_FILE" --emit=hex -o "$HEX_FILE"
 
 if [ $? -ne 0 ]; then
     echo "Compilation failed!"
@@ -18,6 +22,7 @@ if [ $? -ne 0 ]; then
 fi
 
 echo ""
-echo "=== Assembly Generated ==="
+echo "=== Outputs Generated ==="
 echo "Assembly file created: $ASM_FILE"
-echo "Note: 8-bit CPU assembler not included in this repository"
\ No newline at end of file
+echo "Binary ROM image created: $BIN_FILE"
+echo "Intel HEX image created: $HEX_FILE"
@@ -0,0 +1,93 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "output.h"
+#include "timing.h"
+
+// Allocator interface used by the front end and the code generator (token, lexer,
+// parser, ast and codegen). Each thread has a current allocator, the system one unless
+// set_allocator says otherwise, and every block must be freed under the allocator that
+// handed it out. Embedders can supply their own by filling in the three functions.
+//
+// Every call site passes its file and line, so the counting allocator can tell where
+// the memory goes.
+typedef struct Allocator Allocator;
+struct Allocator
+{
+    void *(*allocate)(Allocator *self, size_t size, const char *site);
+    // pointer may be NULL, like realloc
+    void *(*reallocate)(Allocator *self, void *pointer, size_t size, const char *site);
+    void (*release)(Allocator *self, void *pointer);
+};
+
+#define ALLOC_STRINGIFY(x) #x
+#define ALLOC_LINE(x) ALLOC_STRINGIFY(x)
+#define ALLOC_SITE __FILE__ ":" ALLOC_LINE(__LINE__)
+
+#define sl_malloc(size) sl_malloc_at(size, ALLOC_SITE)
+#define sl_calloc(count, size) sl_calloc_at(count, size, ALLOC_SITE)
+#define sl_realloc(pointer, size) sl_realloc_at(pointer, size, ALLOC_SITE)
+#define sl_strdup(text) sl_strdup_at(text, ALLOC_SITE)
+
+void *sl_malloc_at(size_t size, const char *site);
+void *sl_calloc_at(size_t count, size_t size, const char *site);
+void *sl_realloc_at(void *pointer, size_t size, const char *site);
+char *sl_strdup_at(const char *text, const char *site);
+void sl_free(void *pointer);
+
+// plain malloc, realloc and free
+Allocator *system_allocator(void);
+// the calling thread's allocator
+Allocator *current_allocator(void);
+// make allocator (NULL for the system one) current on this thread, returns the previous one
+Allocator *set_allocator(Allocator *allocator);
+
+// Arena: bump allocation in large chunks taken from the system allocator. Frees do
+// nothing, everything goes at once when the arena is freed.
+Allocator *create_arena_allocator(size_t chunk_size);
+void free_arena_allocator(Allocator *arena);
+// release every block at once but keep the chunks (up to a limit) for the arena's next
+// use, so a long-lived arena stops asking the system for memory once it is warm
+void reset_arena_allocator(Allocator *arena);
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+// Counting: passes every call on to a backing allocator and keeps the totals below,
+// split by the phase the thread was in (set_allocation_phase) and by call site.
+typedef struct
+{
+    const char *site;
+    uint64_t allocations;
+    uint64_t bytes;
+} AllocationSite;
+
+typedef struct
+{
+    uint64_t allocations; // including reallocations of NULL
+    uint64_t reallocations;
+    uint64_t frees;
+    uint64_t bytes;      // requested, counting only the growth of reallocations
+    uint64_t live_bytes; // allocated and not yet freed
+    uint64_t peak_bytes; // highest live_bytes
+    uint64_t phase_allocations[TIME_PHASE_COUNT];
+    uint64_t phase_bytes[TIME_PHASE_COUNT];
+    AllocationSite *sites; // open addressing on the site pointer
+    int site_count;
+    int site_capacity;
+} AllocationStats;
+
+Allocator *create_counting_allocator(Allocator *backing);
+AllocationStats *counting_allocator_stats(Allocator *counting);
+void free_counting_allocator(Allocator *counting);
+
+// phase that the calling thread's next allocations are charged to
+void set_allocation_phase(TimedPhase phase);
+
+// add stats into a total; peak_bytes keeps the highest single peak
+int merge_allocation_stats(AllocationStats *total, const AllocationStats *stats);
+void free_allocation_stats(AllocationStats *stats);
+// totals, then per phase, then the sites with the most bytes
+void write_memory_report(OutputSink *sink, const AllocationStats *stats, const char *allocator_name, int top_sites);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "codegen.h"
+#include "output.h"
+
+/*
+Machine encoding of the 8-bit CPU (8-bit data, 16-bit little endian addresses)
+
+ldi r imm   00001rrr imm        2 bytes
+push r      00010rrr            1 byte
+pop r       00011rrr            1 byte
+lda addr    00100000 lo hi      3 bytes
+sta addr    00100001 lo hi      3 bytes
+jmp addr    00100010 lo hi      3 bytes
+jz addr     00100011 lo hi      3 bytes
+jnz addr    00100100 lo hi      3 bytes
+jnc addr    00100101 lo hi      3 bytes
+call addr   00100110 lo hi      3 bytes
+add         00110000            1 byte
+sub         00110001            1 byte
+cmp         00110010            1 byte
+shl         00110011            1 byte
+shr         00110100            1 byte
+adc         00110101            1 byte
+sbc         00110110            1 byte
+mov d s     01dddsss            1 byte
+hlt         00000001            1 byte
+ret         00000010            1 byte
+
+Registers A..G are numbered 0..6. The image starts with .text at address 0,
+the .data section follows directly and holds one byte per variable, two (low byte
+first) for the variables the code generator gives two byte slots; the high byte's lda
+and sta address the slot plus one. Variables that share a slot (see slots.h) share
+its address. Labels take no space, a jump holds the address of
+the instruction after its label. call pushes the address of the next instruction, high
+byte first, and ret pops it back into pc.
+*/
+#define ENC_HLT 0x01
+#define ENC_RET 0x02
+#define ENC_LDI 0x08
+#define ENC_PUSH 0x10
+#define ENC_POP 0x18
+#define ENC_LDA 0x20
+#define ENC_STA 0x21
+#define ENC_JMP 0x22
+#define ENC_JZ 0x23
+#define ENC_JNZ 0x24
+#define ENC_JNC 0x25
+#define ENC_CALL 0x26
+#define ENC_ADD 0x30
+#define ENC_SUB 0x31
+#define ENC_CMP 0x32
+#define ENC_SHL 0x33
+#define ENC_SHR 0x34
+#define ENC_ADC 0x35
+#define ENC_SBC 0x36
+#define ENC_MOV 0x40
+
+#define IMAGE_MAX_SIZE 65536
+
+typedef struct
+{
+    unsigned char *bytes; // text followed by data, loaded at address 0
+    int size;
+    int text_size;
+    int *symbol_address;      // data address of every symbol id
+    int *symbol_size;         // bytes of every symbol's slot, 1 or 2
+    unsigned char *symbol_dead; // per symbol, 1 when its final value is not kept (NULL: all are)
+    int symbol_count;
+    int *instruction_address; // address of every instruction in the CodeGenerator
+    int instruction_count;
+    int *label_address;       // address every label stands for, -1 if never placed
+    int label_count;
+    int has_error;
+    char error_message[256];
+} ProgramImage;
+
+// size in bytes of one encoded instruction
+int instruction_size(const Instruction *inst);
+
+// two passes over the generated code: lay out text, labels and data, then encode with
+// every %var_* and .L* reference resolved. Check has_error on the result (NULL only when out of memory)
+ProgramImage *assemble_program(const CodeGenerator *gen);
+void free_program_image(ProgramImage *image);
+
+// raw image, byte for byte
+int write_binary_image(const ProgramImage *image, OutputSink *sink);
+// Intel HEX, 16 data bytes per record
+int write_intel_hex(const ProgramImage *image, OutputSink *sink);
+
+#endif
@@ -1,16 +1,22 @@
 #ifndef AST_H
 #define AST_H
 #include "token.h"
+#include "output.h"
 // create Nodetype which include grammar following
 /*
-program → statement*
-statement → declaration | assignment | if_statement
+program → (import | extern_declaration | statement)*
+import → 'import' IDENTIFIER ';'
+extern_declaration → 'extern' 'int' IDENTIFIER ';'
+statement → declaration | assignment | if_statement | while_statement
 declaration → 'int' IDENTIFIER ('=' expression)? ';'
 assignment → IDENTIFIER '=' expression ';'
 if_statement → 'if' '(' expression ')' block ('else' block)?
+while_statement → 'while' '(' expression ')' block
 block → '{' statement* '}'
-expression → term ('==' term)*
-term → factor (('+' | '-') factor)*
+expression → shift ('==' shift)*
+shift → term (('<<' | '>>') term)*
+term → product (('+' | '-') product)*
+product → factor ('*' factor)*
 factor → NUMBER | IDENTIFIER | '(' expression ')'
 */
 typedef enum
@@ -19,11 +25,15 @@ typedef enum
     AST_DECLARATION,
     AST_ASSIGNMENT,
     AST_IF_STATEMENT,
+    AST_WHILE_STATEMENT,
     AST_EXPRESSION,
     AST_BINARY_OP,
     AST_NUMBER,
     AST_IDENTIFIER,
-    AST_BLOCK
+    AST_BLOCK,
+    AST_IMPORT, // top level only: another module this one depends on
+    AST_EXTERN, // top level only: a variable defined by another module
+    AST_ERROR   // a statement that did not parse, left in place so the parse can go on
 } ASTNodeType;
 
 // Define the data structure of Abstract syntax tree(syntax tree)
@@ -67,11 +77,24 @@ typedef struct ASTNode
             ASTNode *else_block;
         } if_stmt;
         struct
+        {
+            ASTNode *condition;
+            ASTNode *body;
+        } while_stmt;
+        struct
         {
             ASTNode **statements;
             int count;
             int capacity;
         } block;
+        struct
+        {
+            char *module;
+        } import;
+        struct
+        {
+            char *var_name;
+        } extern_decl;
     } data;
     int line;   // tracks line number for error detection
     int column; // tracks column number for error detection
@@ -86,12 +109,59 @@ ASTNode *create_binary_op_node(ASTNode *left, TokenType op, ASTNode *right, int
 ASTNode *create_declaration_node(char *var_name, ASTNode *init_value, int line, int column);
 ASTNode *create_assignment_node(char *var_name, ASTNode *value, int line, int column);
 ASTNode *create_if_node(ASTNode *condition, ASTNode *then_block, ASTNode *else_block, int line, int column);
+ASTNode *create_while_node(ASTNode *condition, ASTNode *body, int line, int column);
 ASTNode *create_block_node(void);
+ASTNode *create_import_node(char *module, int line, int column);
+ASTNode *create_extern_node(char *var_name, int line, int column);
+ASTNode *create_error_node(int line, int column);
 
 // block
 void add_statement_to_block(ASTNode *block, ASTNode *statement);
 
+// children in source order: a block's statements, a declaration's or assignment's value,
+// an if's condition and blocks (NULL for a missing else), a while's condition and body,
+// an operator's operands
+int ast_child_count(const ASTNode *node);
+ASTNode *ast_child(const ASTNode *node, int index);
+
+/*
+Walking a tree without recursion. A chain like a + a + ... + a parses into a left spine
+as deep as the chain is long, so walkers keep their path on the heap in an ASTWalk, one
+frame per node, instead of on the C stack. A walker pushes the root, then repeatedly
+looks at the top frame: it does the next step for that node, which may push a child
+(whose frame is then on top until it is popped), and pops the frame after the last step.
+A push may move the frames, so a frame pointer is not used after pushing.
+*/
+typedef struct
+{
+    ASTNode *node;
+    int step;  // 0 when pushed, advanced by the walker
+    int value; // walker state kept with the node: a register depth, a jump to patch, ...
+} ASTFrame;
+
+typedef struct
+{
+    ASTFrame *frames;
+    int count;
+    int capacity;
+    int failed; // a push ran out of memory, the walk is incomplete
+} ASTWalk;
+
+void init_ast_walk(ASTWalk *walk);
+void free_ast_walk(ASTWalk *walk);
+// NULL nodes are skipped; -1 (and failed set) when out of memory
+int ast_walk_push(ASTWalk *walk, ASTNode *node, int value);
+// the frame to work on, NULL once the walk is done
+ASTFrame *ast_walk_top(ASTWalk *walk);
+void ast_walk_pop(ASTWalk *walk);
+
 void print_ast(ASTNode *node, int indent, int is_last, char *prefix);
+// same tree drawing, into any sink; nodes deeper than AST_DRAW_DEPTH are drawn at that
+// depth, marked with their real one, so the drawing stays linear in the tree size
+void write_ast(OutputSink *sink, ASTNode *node);
+#define AST_DRAW_DEPTH 64
 void free_ast(ASTNode *node);
+// number of nodes in the tree, node included
+int count_ast_nodes(ASTNode *node);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef ASTFILE_H
+#define ASTFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+#include "output.h"
+
+/*
+Parsed programs on disk (.sla), laid out so a tool can mmap the file and walk the tree
+in place, without building ASTNodes, and so every process mapping it shares its pages.
+
+Every reference is a byte offset relative to the node that holds it, 0 for none, so the
+file means the same wherever it is mapped. Nodes are written in post order: children
+come before their parent and the program is the last node. Integers are in host byte
+order, which is little endian on every supported host; a file from another byte order
+fails the version check.
+
+Layout:
+  ASTFileHeader                 "SLAB", version, counts
+  ASTFileNode[node_count]       24 bytes each
+  int32_t[list_count]           child lists of programs and blocks, offsets relative to
+                                the program or block
+  char[string_size]             names, each NUL terminated
+
+Node fields by type:
+  program, block        field[0] its child list, field[1] the child count
+  declaration           field[0] name, field[1] initial value (0 for none)
+  assignment            field[0] name, field[1] value
+  if                    field[0] condition, field[1] then block, field[2] else block or 0
+  while                 field[0] condition, field[1] body
+  binary operator       field[0] left, field[1] right, operator the TokenType
+  number                field[0] the value
+  identifier, import, extern   field[0] name
+*/
+#define AST_FILE_VERSION 1
+
+typedef struct
+{
+    char magic[4]; // "SLAB"
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t list_count;
+    uint32_t string_size;
+} ASTFileHeader;
+
+typedef struct
+{
+    uint8_t type;     // ASTNodeType
+    uint8_t operator; // TokenType of a binary operator
+    uint16_t reserved;
+    int32_t line;
+    int32_t column;
+    int32_t field[3];
+} ASTFileNode;
+
+// a mapped file and its checked root
+typedef struct
+{
+    void *data;
+    size_t size;
+    const ASTFileNode *root;
+} ASTFile;
+
+// write program (an AST_PROGRAM) in the format above; 0 on success
+int write_ast_file(OutputSink *sink, ASTNode *program);
+
+// Check every header count, reference, node type and name of a file in memory, once,
+// so walking it afterwards needs no checks: references stay inside the file, point back
+// to earlier nodes of the kinds the grammar allows, each node has one parent, and every
+// name is an identifier.
+// Returns the program node, NULL if data (4 byte aligned) is not a valid file.
+const ASTFileNode *check_ast_file(const void *data, size_t size);
+
+// map and check a file; NULL if it cannot be read or is not a valid AST file
+ASTFile *map_ast_file(const char *path);
+void unmap_ast_file(ASTFile *file);
+
+// children and names, in the same order as ast_child_count and ast_child
+int ast_file_child_count(const ASTFileNode *node);
+const ASTFileNode *ast_file_child(const ASTFileNode *node, int index); // NULL for a missing else
+// the variable or module a node names, NULL for the others
+const char *ast_file_name(const ASTFileNode *node);
+
+// build ASTNodes from a file check_ast_file accepted, for the code generators; NULL
+// when out of memory
+ASTNode *ast_from_file(const void *data);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+// Compact accumulator bytecode for running SimpleLang programs on the host.
+// Code is an array of 32-bit words: an opcode word, followed by one operand word
+// for the opcodes that take one. Variables are resolved to slot indices at compile
+// time, jump operands are word indices into the code. Arithmetic wraps at 32 bits and
+// shift counts are taken modulo 32, as on x86-64.
+typedef enum
+{
+    BC_HALT,
+    BC_LOAD_CONST, // acc = k
+    BC_LOAD,       // acc = slot
+    BC_STORE,      // slot = acc
+    BC_PUSH,       // push acc on the operand stack
+    BC_ADD_CONST,  // acc += k
+    BC_ADD_SLOT,   // acc += slot
+    BC_ADD_POP,    // acc = pop + acc
+    BC_SUB_CONST,  // acc -= k
+    BC_SUB_SLOT,   // acc -= slot
+    BC_SUB_POP,    // acc = pop - acc
+    BC_EQ_CONST,   // acc = acc == k
+    BC_EQ_SLOT,    // acc = acc == slot
+    BC_EQ_POP,     // acc = pop == acc
+    BC_MUL_CONST,  // acc *= k
+    BC_MUL_SLOT,   // acc *= slot
+    BC_MUL_POP,    // acc = pop * acc
+    BC_SHL_CONST,  // acc <<= k
+    BC_SHL_SLOT,   // acc <<= slot
+    BC_SHL_POP,    // acc = pop << acc
+    BC_SHR_CONST,  // acc >>= k, arithmetic
+    BC_SHR_SLOT,   // acc >>= slot
+    BC_SHR_POP,    // acc = pop >> acc
+    BC_JUMP,       // pc = target
+    BC_JUMP_IF_ZERO, // if acc == 0 pc = target
+    BC_JUMP_IF_NONZERO, // if acc != 0 pc = target
+    BC_COUNT
+} BytecodeOp;
+
+typedef struct
+{
+    int *code;
+    int count;
+    int capacity;
+    SymbolTable symbols; // slot index -> variable name
+    int max_stack;       // operand stack depth the program needs
+} BytecodeProgram;
+
+// run_bytecode and jit_run stopped a program that ran past its iteration budget
+#define RUN_LIMIT_REACHED 2
+
+// number of operand words following an opcode
+int bytecode_operand_count(BytecodeOp op);
+const char *bytecode_op_name(BytecodeOp op);
+
+BytecodeProgram *compile_bytecode(ASTNode *ast);
+void free_bytecode(BytecodeProgram *program);
+
+// run the program with slots (symbols.count entries, normally zeroed) as variable
+// storage. Uses a direct-threaded interpreter built on computed goto when the compiler
+// supports it (define SL_NO_COMPUTED_GOTO to force the portable switch loop).
+// At most max_iterations loop iterations run in all, 0 for no limit. Returns 0 on success,
+// RUN_LIMIT_REACHED when the budget ran out (slots hold the values so far), 1 on failure.
+int run_bytecode(const BytecodeProgram *program, int *slots, long long max_iterations);
+
+void print_bytecode(FILE *stream, const BytecodeProgram *program);
+void write_bytecode_variables(OutputSink *sink, const BytecodeProgram *program, const int *slots);
+
+#endif
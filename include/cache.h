@@ -0,0 +1,51 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Content-addressed cache of compiler outputs on disk. An entry is named after a hash
+// of everything the output depends on (the compiler itself, the options that shape the
+// output, and the source bytes) and holds exactly the bytes that were written out.
+// Entries are written to a temporary file and renamed into place, so concurrent
+// compilers, threads or processes, only ever see complete entries. Every hit refreshes
+// the entry's modification time, and trimming removes the least recently used entries
+// until the cache fits its size limit.
+typedef struct
+{
+    char *directory;
+    size_t size_limit; // bytes, trimmed back to this by cache_trim
+    uint64_t compiler_hash;
+    pthread_mutex_t lock; // guards the counters
+    int hits;
+    int misses;
+    int stores;
+    int evictions;
+    size_t total_size; // bytes in the cache after the last trim
+    int entry_count;
+} Cache;
+
+#define CACHE_DEFAULT_SIZE_LIMIT ((size_t)256 * 1024 * 1024)
+
+// creates the directory if needed, NULL if it cannot be used
+Cache *open_cache(const char *directory, size_t size_limit);
+void close_cache(Cache *cache);
+
+// 64-bit FNV-1a, continue a running hash by passing it back in
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t length);
+#define HASH_SEED 14695981039346656037ULL
+// hash of the running compiler's own bytes, computed once; outputs of another build never match it
+uint64_t compiler_fingerprint(void);
+
+// malloc'ed entry contents or NULL on a miss, counted either way
+char *cache_lookup(Cache *cache, uint64_t key, size_t *length);
+// returns 0 once the entry is in place
+int cache_store(Cache *cache, uint64_t key, const char *data, size_t length);
+// store the contents of an output file
+int cache_store_file(Cache *cache, uint64_t key, const char *path);
+// evict least recently used entries until the cache fits its limit, returns the count;
+// also removes temporary files abandoned by an interrupted store
+int cache_trim(Cache *cache);
+
+#endif
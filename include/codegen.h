@@ -1,17 +1,164 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "ast.h"
+#include "symtab.h"
+#include "output.h"
 
+// 8-bit CPU instruction set targeted by the code generator. int is 16 bits on this
+// target, but values the range analysis proves to fit in 0..255 are computed in A alone,
+// with B as the second operand; the others take two bytes, the low one in A and the
+// high one in G. C..G hold loop invariant values while a loop runs (C..F when a program
+// needs G for high bytes).
+// The CPU has ldi through cmp, jmp, jz, jnz and hlt. adc, sbc, shl, shr, jnc, call and
+// ret are an extension only the simulator implements (CodeGenerator.extended_isa): with
+// it two byte sums carry by adc and sbc, and products and shifts call a runtime routine;
+// without it they are expanded in place from add, sub and the zero flag.
+typedef enum {
+    OP_LDI,  // ldi <reg> <imm>
+    OP_LDA,  // lda %var_<sym>, or %var_<sym>+1 for the high byte of a two byte slot
+    OP_STA,  // sta %var_<sym>, or %var_<sym>+1
+    OP_PUSH, // push <reg>
+    OP_POP,  // pop <reg>
+    OP_MOV,  // mov <dst> <src>
+    OP_ADD,  // A = A + B
+    OP_SUB,  // A = A - B
+    OP_ADC,  // A = A + B + carry
+    OP_SBC,  // A = A - B - carry, carry = borrow like sub
+    OP_CMP,  // flags = A - B
+    OP_SHL,  // A = A << 1, carry = the bit shifted out
+    OP_SHR,  // A = A >> 1, carry = the bit shifted out
+    OP_JMP,  // jmp .L<label>
+    OP_JZ,   // jz .L<label>, taken when the zero flag is set
+    OP_JNZ,  // jnz .L<label>
+    OP_JNC,  // jnc .L<label>, taken when the carry flag is clear
+    OP_CALL, // call .L<label>, pushes the return address
+    OP_RET,
+    OP_HLT,
+    OP_LABEL, // .L<label>: the jump target it names, takes no space
+    OP_COUNT
+} Opcode;
+
+typedef enum {
+    OPERAND_NONE,
+    OPERAND_REGISTER,
+    OPERAND_IMMEDIATE,
+    OPERAND_SYMBOL, // id into CodeGenerator.symbols, printed as %var_<name>
+    OPERAND_LABEL   // label number, printed as .L<label>
+} OperandKind;
+
+typedef enum {
+    REG_A,
+    REG_B,
+    REG_C,
+    REG_D,
+    REG_E,
+    REG_F,
+    REG_G
+} Register;
+
+// one instruction of the intermediate representation, kept small so the whole
+// program lives in a single contiguous array
 typedef struct {
-    char **instructions;
+    unsigned char opcode;          // Opcode
+    unsigned char operand_kind[2]; // OperandKind of each operand
+    int operand[2];                // register, immediate value or symbol id; lda and sta
+                                   // take an immediate second operand, the byte offset
+} Instruction;
+
+// where in the source an instruction comes from: the statement generated it
+typedef struct {
+    int line;   // 0 for the hlt and the runtime routines
+    int column;
+} SourcePosition;
+
+// Routines for operations the CPU lacks, A = A <op> B, and on two byte values
+// A:G = A:G <op> B:C (low bytes in A and B). >> is arithmetic. Each one a program uses
+// is emitted once, after its hlt, and called; without the extension it is entered by jmp
+// with the id of the return site in the RUNTIME_RETURN_SLOT byte and ends in a chain of
+// jz back to the sites, past RUNTIME_SITES_MAX sites (and in objects) its code goes where
+// it is used. The byte ones preserve C..G, the two byte ones D..F.
+typedef enum {
+    RUNTIME_MULTIPLY,
+    RUNTIME_SHIFT_LEFT,
+    RUNTIME_SHIFT_RIGHT,
+    RUNTIME_MULTIPLY_WIDE,
+    RUNTIME_SHIFT_LEFT_WIDE,
+    RUNTIME_SHIFT_RIGHT_WIDE,
+    RUNTIME_COUNT
+} RuntimeRoutine;
+
+// the .data byte holding the return site id; not an identifier, so no variable's name
+#define RUNTIME_RETURN_SLOT "runtime.return"
+#define RUNTIME_SITES_MAX 256 // return site ids per routine, one byte
+
+typedef struct {
+    Instruction *instructions;
+    SourcePosition *positions; // per instruction, kept in step with instructions
     int count;
     int capacity;
+    SourcePosition position; // statement being generated, given to what is emitted
+    SymbolTable symbols; // every variable gets a .data slot, in order of first use
+    SymbolTable wide;    // variables whose slot takes two bytes, low byte first
+    SymbolTable externs; // names declared extern: their slot lives in another module
+    SymbolTable imports; // modules named by import, in order
+    int label_count;     // labels handed out so far, numbered from 0
+    int runtime_label[RUNTIME_COUNT]; // label of every routine the code calls, -1 if unused
+    // without the extension, the label after each jmp to a routine, indexed by the id
+    // the jmp stores; NULL until the routine is first entered
+    int *return_sites[RUNTIME_COUNT];
+    int return_site_count[RUNTIME_COUNT];
+    int shared_globals;  // set before generate_code when the program becomes an object:
+                         // other modules may store anything, so every slot takes two bytes
+    int has_error;       // a literal does not fit in the int
+    int out_of_memory;   // an instruction or symbol could not be added, the code is incomplete
+    char error_message[256];
+    int keep_loop_values; // loops keep invariant and induction values in C..G (the loops
+                          // pass of passes.h), on unless cleared before generate_code
+    int chain_multiplies; // * by a constant becomes a chain rather than a call (mulchain)
+    int extended_isa;     // use the simulator's extension (see Opcode), off by default
+    int loop_values;        // values kept in loop registers, counted while generating
+    int chained_multiplies; // multiplies lowered to chains
+    // time generate_code spends on other than lowering: the range analysis, planning
+    // loop registers (loops) and finding multiply chains (mulchain)
+    uint64_t analysis_nanoseconds;
+    uint64_t loop_nanoseconds;
+    uint64_t chain_nanoseconds;
+    int *data_slot;      // per symbol id, the symbol whose .data slot it uses (itself unless
+                         // shared, see slots.h); NULL gives every variable its own
+    unsigned char *dead_at_exit; // per symbol id, 1 for a block local sharing its slot:
+                                 // its final value may be overwritten
 } CodeGenerator;
 
 CodeGenerator *create_codegen();
-void generate_code(CodeGenerator *gen, ASTNode *ast);
-void write_assembly_file(CodeGenerator *gen, const char *filename);
+// lower the tree, 0 on success, -1 when out of memory or has_error (the code is then
+// incomplete); run_passes (passes.h) adds the optimizations around it
+int generate_code(CodeGenerator *gen, ASTNode *ast);
+// bytes of a variable's .data slot, 1 or 2
+int symbol_size(const CodeGenerator *gen, int symbol_id);
+// whether the program needs other modules linked in (it imports or declares externs)
+int is_module(const CodeGenerator *gen);
+// write the program as assembly text, returns 0 on success
+int write_assembly(CodeGenerator *gen, OutputSink *sink);
+// numbered instruction listing of the intermediate representation, no sections
+int write_ir(CodeGenerator *gen, OutputSink *sink);
+// write_assembly to a path ("-" for stdout)
+int write_assembly_file(CodeGenerator *gen, const char *filename);
 void free_codegen(CodeGenerator *gen);
+// the routines with a runtime_label, each starting at its label; generate_code does this
+// after the hlt, the linker once for all the modules it joins
+void emit_runtime(CodeGenerator *gen);
+
+// append one instruction, returns its index or -1 on allocation failure
+int emit_instruction(CodeGenerator *gen, Opcode opcode,
+                     OperandKind kind0, int operand0,
+                     OperandKind kind1, int operand1);
+
+const char *opcode_name(Opcode opcode);
+const char *register_name(Register reg);
+// render one instruction as assembly text, snprintf semantics (returns the full length)
+int format_instruction(const CodeGenerator *gen, const Instruction *inst, char *buffer, size_t size);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,67 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include <stddef.h>
+#include "ast.h"
+
+/*
+A source file held open by the language server, kept lexed and parsed between edits.
+
+The text is split into its top-level statements. Each one owns the text from its first
+token up to the next statement's first token, together with its AST or, when it does not
+parse, its error. Parsing stops at the first error of a statement and picks up again at
+the next line that starts a statement in the first column.
+
+An edit re-lexes and re-parses from the first statement on the lines it touches, and
+stops as soon as a statement boundary lines up with a statement from before the edit:
+from there on the text is unchanged, so the old statements are kept and only moved.
+Typing therefore costs the statements around the cursor, not the size of the file.
+
+Lines and characters are 0-based byte positions, as the protocol counts them for ASCII.
+*/
+
+typedef struct
+{
+    size_t start; // offset of the statement's first token
+    int line;     // 1-based line of that token when it was parsed, see statement_line_shift
+    ASTNode *ast; // NULL for a statement with a parse error
+    // parse error, as parsed: line, column and length of the token it was found at
+    char *error;  // message without the position
+    int error_line;
+    int error_column;
+    int error_length;
+} DocumentStatement;
+
+typedef struct
+{
+    char *text;
+    size_t length;
+    size_t capacity;
+    size_t *line_starts; // offset of every line
+    int line_count;
+    int line_capacity;
+    DocumentStatement *statements;
+    int statement_count;
+    int statement_capacity;
+    int reparsed; // statements parsed by the last edit
+} Document;
+
+// NULL when out of memory
+Document *create_document(const char *text, size_t length);
+void free_document(Document *document);
+
+// replace everything and parse it again; 0 on success, -1 when out of memory
+int set_document_text(Document *document, const char *text, size_t length);
+// replace the text from (start_line, start_character) up to (end_line, end_character)
+// by text; positions past the end of a line or of the document are clamped to it
+int edit_document(Document *document, int start_line, int start_character,
+                  int end_line, int end_character, const char *text, size_t length);
+
+// 0-based line of an offset
+int document_line(const Document *document, size_t offset);
+// add to the lines of a statement's AST and error to get where they are now
+int statement_line_shift(const Document *document, const DocumentStatement *statement);
+// number of statements with a parse error
+int document_error_count(const Document *document);
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "output.h"
+#include "cache.h"
+#include "timing.h"
+#include "allocator.h"
+#include "passes.h"
+
+// Compiler driver: runs the pipeline only as far as the requested output needs.
+// Nothing is printed unless asked for; diagnostics go to stderr.
+// Several inputs are compiled concurrently on a work-stealing thread pool. Every
+// compilation only touches its own CompileJob and the state it allocates, and its
+// output is replayed in input order afterwards, so results never depend on timing.
+
+// what to write out
+typedef enum
+{
+    EMIT_NONE,   // check only (or just run with --vm / --run / --simulate)
+    EMIT_TOKENS, // token dump
+    EMIT_AST,    // tree drawing
+    EMIT_IR,     // numbered 8-bit instruction listing
+    EMIT_ASM,    // 8-bit assembly, or x86-64 GNU assembly
+    EMIT_BIN,    // raw ROM image, or a linked executable for x86-64
+    EMIT_HEX,    // Intel HEX image
+    EMIT_OBJ,    // 8-bit module object (.slo) for the linker
+    EMIT_AST_BIN, // parsed program in the mappable binary format (.sla, see astfile.h)
+    EMIT_LISTING  // 8-bit code under the source lines it came from, with sizes and cycles
+} EmitKind;
+
+// what the inputs are
+typedef enum
+{
+    INPUT_SOURCE, // SimpleLang source
+    INPUT_AST_BIN // .sla files written by --emit=ast-bin, mapped instead of lexed and parsed
+} InputFormat;
+
+// pipeline phases in order
+typedef enum
+{
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_CODEGEN,
+    PHASE_ASSEMBLE
+} CompilePhase;
+
+typedef enum
+{
+    TARGET_8BIT,
+    TARGET_8BIT_EXT, // with the simulator's extension to the 8-bit CPU (codegen.h)
+    TARGET_X86_64
+} TargetKind;
+
+// allocator the front end and code generator use for each input
+typedef enum
+{
+    ALLOCATOR_SYSTEM, // malloc and free, or whatever the caller made current
+    ALLOCATOR_ARENA   // one arena per input, released as a whole when it is done
+} AllocatorKind;
+
+typedef struct
+{
+    const char **input_paths;
+    int input_count;
+    int input_capacity;
+    const char *output_path; // -o, "-" is stdout, NULL picks the default for the emitted kind
+    EmitKind emit;
+    CompilePhase stop_after; // last phase that runs
+    InputFormat from;
+    TargetKind target;
+    int simulate; // run the assembled program on the 8-bit CPU simulator
+    int run_vm;   // run on the host bytecode VM
+    int run_jit;  // run in-process as native code
+    int jobs;     // worker threads, 0 for one per CPU
+    const char *base_directory; // relative paths are taken from here, NULL for the working directory
+    const char *cache_directory; // reuse outputs of unchanged inputs from here, NULL for no cache
+    Cache *shared_cache;         // cache_directory already opened by the caller, which keeps it
+                                 // across calls (the compile server): used as is, not trimmed
+    size_t cache_size;           // cache limit in bytes
+    int cache_stats;             // report hits and misses on stderr
+    int time_report;             // time every phase and report it at the end
+    TimeFormat time_format;
+    const char *time_report_path; // NULL for stderr
+    AllocatorKind allocator;
+    int mem_report; // count allocations per phase and site and report them at the end
+    PassOptions passes; // the 8-bit pipeline: -O level less --disable-pass, and --print-after
+    int pass_stats;     // report every pass's time and changes on stderr
+    int max_errors;     // syntax errors reported per input before its parse stops, 0 for no limit
+    long long max_cycles; // run budget: simulator clock cycles, VM and JIT loop iterations;
+                          // 0 for no limit
+    int link;       // the inputs are .slo objects, linked into one program
+    char **response_files; // text of @files, input_paths point into it
+    int response_count;
+} CompileOptions;
+
+// one input's compilation
+typedef struct
+{
+    const CompileOptions *options;
+    const char *input_path;
+    OutputSink *out;         // stdout: listings sent to "-" and run results
+    OutputSink *diagnostics; // stderr
+    int status;
+    Cache *cache;       // NULL compiles without looking for earlier results
+    TimeReport *times;  // NULL unless phases are timed
+    AllocationStats *memory; // NULL unless allocations are counted
+    int linked; // other modules went into the output, so it is not cached
+} CompileJob;
+
+// default run budget, a second or so on the VM; the compile server never runs
+// without one
+#define DEFAULT_MAX_CYCLES 100000000LL
+
+void init_compile_options(CompileOptions *options);
+void free_compile_options(CompileOptions *options);
+// fill options (set up with init_compile_options) from the command line and resolve
+// the defaults. Returns 0 on success, 1 if --help was given, -1 on bad usage (reported
+// into diagnostics)
+int parse_options(int argc, char *argv[], CompileOptions *options, OutputSink *diagnostics);
+void write_usage(OutputSink *sink, const char *program);
+
+// compile source text, or reuse the cached output of an identical compile; returns 0 on success
+int compile_source(CompileJob *job, char *source);
+// read job->input_path and compile it, returns 0 on success
+int compile_file(CompileJob *job);
+// compile every input into out and diagnostics, returns 0 if all of them succeeded
+int compile_all(const CompileOptions *options, OutputSink *out, OutputSink *diagnostics);
+
+#endif
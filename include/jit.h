@@ -0,0 +1,30 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "symtab.h"
+#include "bytecode.h"
+
+// In-process JIT for x86-64 hosts. The AST is encoded straight to machine code by a
+// tiny built-in encoder, copied into an mmap'ed page that is then made executable,
+// and called as int program(int *slots). No assembler, linker or files involved.
+// Variables are 32-bit ints, slots[i] holds the variable with symbol id i.
+typedef struct
+{
+    void *code; // executable mapping
+    size_t size;
+    SymbolTable symbols;
+} JitProgram;
+
+// NULL when out of memory, on an unsupported host, or if mapping executable memory fails
+JitProgram *jit_compile(ASTNode *ast);
+// run with slots (symbols.count entries, normally zeroed) and at most max_iterations loop
+// iterations, 0 for no limit; returns 0 on success or RUN_LIMIT_REACHED (bytecode.h), with
+// slots then holding the values so far
+int jit_run(const JitProgram *program, int *slots, long long max_iterations);
+void free_jit_program(JitProgram *program);
+
+void write_jit_variables(OutputSink *sink, const JitProgram *program, const int *slots);
+
+#endif
@@ -3,17 +3,31 @@
 
 #include "token.h"
 
+// reads up to size bytes into buffer: returns the count, 0 at the end of the input, -1 on error
+typedef int (*LexerReader)(void *context, char *buffer, int size);
+
 typedef struct
 {
-    char *input;
+    char *input; // the whole text, or for a stream a window that holds the current character
     int position;
     int length;
     int line;
     int column;
     char current_char;
+    LexerReader read; // streams only, NULL once the input is exhausted
+    void *context;
+    int capacity;   // window size of a stream
+    int read_error; // the stream failed, the tokens end early
 } Lexer;
 
+// size of each read of a stream lexer and of read_file
+#define LEXER_CHUNK_SIZE (64 * 1024)
+
 Lexer *create_lexer(char *input);
+// tokenize a stream as it arrives, one chunk at a time; a token may span chunks
+Lexer *create_stream_lexer(LexerReader read, void *context);
+// stream from a descriptor, such as a pipe on stdin
+Lexer *create_fd_lexer(int fd);
 void free_lexer(Lexer *lexer);
 void advance(Lexer *lexer);
 void skip_whitespace(Lexer *lexer);
@@ -24,7 +38,11 @@ Token *read_identifier(Lexer *lexer);
 TokenType get_keyword_type(char *identifier);
 
 int is_alpha(char c);
+// a whole name of the form [A-Za-z_][A-Za-z0-9_]*, for names read back from files
+int is_identifier(const char *name);
 
+// whole contents, read in chunks so pipes work too ("-" is stdin); from the current
+// allocator, release with sl_free
 char *read_file(char *filename);
 int tokenize_file(char *filename, char *output_filename);
 
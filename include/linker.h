@@ -0,0 +1,107 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "codegen.h"
+#include "assembler.h"
+#include "output.h"
+
+/*
+Module objects of the 8-bit target (.slo) and the linker that joins them.
+
+A module is one source file. Every variable it declares or assigns is a global it
+defines, two data bytes each (other modules may store any int in it, so the code
+generator gives a module's slots two bytes, see CodeGenerator.shared_globals); an
+extern names a global that another module defines, and an import names a module
+(IDENTIFIER.sl next to the importing file) to link in as well.
+An object holds the module's encoded text without the final hlt, addressed from 0, a
+relocation for every 16-bit data address in it and the offset of every jump address,
+so the linker can place the text anywhere, point each data address at the final data
+slot and move each jump along with the text. The runtime routines a module calls are
+not in its text: the linker adds each one used once, after the hlt, and points every
+call at it.
+
+Object layout, every integer little endian:
+  "SLO4"                                  magic
+  u64 source hash                         of the compiler and the source built from
+  u32 text size, text bytes               addresses to relocate hold the offset into
+                                          the slot (0, or 1 for its high byte)
+  u32 data size                           defined symbols, two bytes each
+  u32 symbol count, per symbol            in symbol id order
+      u32 kind, u32 data offset (defined only), u32 name length, name
+  u32 relocation count, per relocation
+      u32 text offset of the address, u32 symbol index
+  u32 jump count, per jump
+      u32 text offset of the address      which holds a text address within the module
+  u32 call count, per runtime call
+      u32 text offset of the address, u32 RuntimeRoutine
+  u32 import count, per import
+      u32 name length, name
+*/
+
+// bytes of every global's data slot
+#define GLOBAL_SIZE 2
+
+typedef enum
+{
+    OBJECT_SYMBOL_DEFINED,
+    OBJECT_SYMBOL_EXTERN
+} ObjectSymbolKind;
+
+typedef struct
+{
+    char *name;
+    int kind;   // ObjectSymbolKind
+    int offset; // data slot within the module, defined symbols only
+} ObjectSymbol;
+
+typedef struct
+{
+    int offset; // text offset of the 16-bit address
+    int symbol; // index into symbols
+} Relocation;
+
+typedef struct
+{
+    int offset;  // text offset of the 16-bit address
+    int routine; // RuntimeRoutine it calls
+} RuntimeCall;
+
+typedef struct
+{
+    uint64_t source_hash;
+    unsigned char *text;
+    int text_size;
+    int data_size;
+    ObjectSymbol *symbols;
+    int symbol_count;
+    Relocation *relocations;
+    int relocation_count;
+    int *jumps; // text offsets of the jump addresses
+    int jump_count;
+    RuntimeCall *calls;
+    int call_count;
+    char **imports; // module names, in import order
+    int import_count;
+} ObjectModule;
+
+// object of a module from its code and its assembled image (which must not have errors)
+ObjectModule *create_object_module(const CodeGenerator *gen, const ProgramImage *image, uint64_t source_hash);
+void free_object_module(ObjectModule *module);
+
+int write_object(const ObjectModule *module, OutputSink *sink);
+// NULL if the bytes are not a well formed object, or a name in it is not an identifier
+ObjectModule *read_object(const unsigned char *data, size_t length);
+// read_object on a whole file, NULL if it is missing or malformed
+ObjectModule *load_object(const char *path);
+
+// Lay the modules' text out in the order given, followed by one hlt, the runtime routines
+// they call and then every module's data, and resolve each relocation against the globals. names label the
+// modules in messages. symbols (initialised by the caller) receives the globals,
+// whose ids match the image's symbol_address. Undefined and duplicate globals are
+// reported through has_error; NULL only when out of memory.
+ProgramImage *link_modules(ObjectModule *const *modules, const char *const *names, int count,
+                           SymbolTable *symbols);
+
+#endif
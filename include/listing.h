@@ -0,0 +1,27 @@
+#ifndef LISTING_H
+#define LISTING_H
+
+#include "ast.h"
+#include "codegen.h"
+#include "assembler.h"
+#include "output.h"
+
+/*
+Source-annotated listing of an assembled 8-bit program, to see what each line costs.
+
+Every source line is followed by the instructions generated for it, with their address,
+encoded bytes and cycles; the line's header carries its totals. A line whose code is
+split, like a while's condition placed after its body, is shown again where the rest of
+its code is. The hlt and the runtime routines come last, under a heading of their own,
+then a table of every statement and block with the totals of everything nested in it.
+
+Cycles are the simulator's per-opcode costs, each instruction counted once: a static
+estimate, so a loop body costs one pass and a call the call alone, its routine being
+listed at the end.
+*/
+
+// source may be NULL (a stream or an AST file): lines are then shown by number only
+int write_listing(OutputSink *sink, const CodeGenerator *gen, const ProgramImage *image, ASTNode *program,
+                  const char *source);
+
+#endif
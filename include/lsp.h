@@ -0,0 +1,19 @@
+#ifndef LSP_H
+#define LSP_H
+
+#include "output.h"
+
+// Language server for editors (simplelang --lsp), speaking the Language Server Protocol:
+// JSON-RPC messages, each preceded by a Content-Length header, read from input_fd and
+// written to out. Every open file is kept as a Document, so a change re-parses only the
+// statements it touches before the parse errors are published back as diagnostics.
+//
+// Handled: initialize, initialized, shutdown, exit, textDocument/didOpen, didChange
+// (whole or incremental), didClose and documentSymbol (imports, externs and every
+// variable declared). Other requests get MethodNotFound, other notifications are ignored.
+//
+// Returns the exit status: 0 after shutdown and exit, 1 when the input ends or exit
+// comes without a shutdown first.
+int run_language_server(int input_fd, OutputSink *out);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+// Buffered output sink used for everything the compiler writes out.
+// File sinks collect output in one large buffer and hand it to the kernel in big
+// write() calls, so a whole assembly listing usually costs a single syscall.
+// Memory sinks keep everything in the buffer so callers can inspect it.
+typedef enum
+{
+    SINK_FD,    // file, stdout or pipe
+    SINK_MEMORY // grows without bound, never flushed
+} SinkKind;
+
+typedef struct
+{
+    SinkKind kind;
+    int fd;
+    int owns_fd; // close fd when the sink is closed
+    char *buffer;
+    size_t length;
+    size_t capacity;
+    size_t total_length; // every byte written over the sink's lifetime
+    int has_error;
+} OutputSink;
+
+#define SINK_BUFFER_SIZE (64 * 1024)
+
+// "-" opens stdout
+OutputSink *create_file_sink(const char *path);
+// write to an already open descriptor (stdout, a pipe, a socket); the descriptor is not closed
+OutputSink *create_fd_sink(int fd);
+OutputSink *create_memory_sink(void);
+
+int sink_write(OutputSink *sink, const char *data, size_t length);
+int sink_puts(OutputSink *sink, const char *text);
+int sink_printf(OutputSink *sink, const char *format, ...);
+
+// returns a pointer to at least length writable bytes at the end of the buffer,
+// follow with sink_commit once the bytes are filled in (NULL on failure)
+char *sink_reserve(OutputSink *sink, size_t length);
+void sink_commit(OutputSink *sink, size_t length);
+
+// push buffered bytes to the descriptor, returns 0 on success
+int sink_flush(OutputSink *sink);
+// contents of a memory sink (NUL terminated), NULL for descriptor sinks
+const char *sink_contents(OutputSink *sink, size_t *length);
+// flush, close and free the sink, returns 0 if every write succeeded
+int close_sink(OutputSink *sink);
+
+#endif
@@ -5,6 +5,20 @@
 #include "ast.h"
 
 #define ERROR_SIZE 256
+// deepest nesting of parentheses and blocks; the parser recurses on them, so this bounds
+// its stack use, while long operator chains are parsed in a loop and have no limit
+#define PARSER_MAX_DEPTH 1000
+// syntax errors reported before the parser gives up on the rest of the input
+#define PARSER_MAX_ERRORS 20
+
+// one syntax error; diagnostics print it as path:line:column: error: message
+typedef struct
+{
+    int line;
+    int column;
+    char message[ERROR_SIZE];
+} ParseError;
+
 // creating parser structure which parse the grammar of simplelang
 typedef struct
 {
@@ -14,8 +28,18 @@ typedef struct
     Token *current_token;
     // Error flag
     int has_error;
-    // Error message if encountered
-    char error_message[ERROR_SIZE];
+    // The first error, kept even when errors could not grow to hold it
+    ParseError first_error;
+    // Every error in source order. After one, the parser skips to the next statement
+    // (panic mode) and carries on, with an AST_ERROR node for the statement it lost.
+    ParseError *errors;
+    int error_count;
+    int error_capacity;
+    int max_errors; // stop after this many, 0 for no limit (default PARSER_MAX_ERRORS)
+    int stopped;    // max_errors was reached, nothing after the last error was parsed
+    int panicking;  // skipping to the next statement: errors until then are not reported
+    // parentheses and blocks currently open
+    int depth;
 } Parser;
 
 // Create Parser Function input->lexer and output->Parser
@@ -26,13 +50,20 @@ void free_parser(Parser *parser);
 
 // Parser functions for creating AST
 ASTNode *parse_program(Parser *parser);
+// one statement of the program: an import, an extern or a statement
+ASTNode *parse_top_level(Parser *parser);
 ASTNode *parse_statement(Parser *parser);
+ASTNode *parse_import(Parser *parser);
+ASTNode *parse_extern(Parser *parser);
 ASTNode *parse_declaration(Parser *parser);
 ASTNode *parse_assignment(Parser *parser);
 ASTNode *parse_if_statement(Parser *parser);
+ASTNode *parse_while_statement(Parser *parser);
 ASTNode *parse_expression(Parser *parser);
 ASTNode *parse_block(Parser *parser);
+ASTNode *parse_shift(Parser *parser);
 ASTNode *parse_term(Parser *parser);
+ASTNode *parse_product(Parser *parser);
 ASTNode *parse_factor(Parser *parser);
 // Helper functions for parsing
 void advance_token(Parser *parser);
@@ -40,5 +71,8 @@ void skip_newlines(Parser *parser);
 int match_token(Parser *parser, TokenType expected);
 int peek_token(Parser *parser, TokenType expected);
 void parser_error(Parser *parser, char *message);
+// skip to where the next statement can start, after an error in the one that started at
+// line and column
+void synchronize(Parser *parser, int line, int column);
 
 #endif
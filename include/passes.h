@@ -0,0 +1,70 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <stdint.h>
+#include "ast.h"
+#include "codegen.h"
+#include "output.h"
+
+/*
+Pass manager of the 8-bit target. A pipeline runs the passes it enables in this order,
+around the lowering of the tree by generate_code:
+
+  fold      AST      folds operators on constants, drops + 0, * 1 and the like
+  loops     codegen  keeps loop invariant and induction values in registers
+  mulchain  codegen  multiplies by constants with add and sub chains (shl too on 8bit-ext)
+  peephole  IR       drops redundant loads, stores, moves, stack round trips and jumps
+  slots     machine  shares .data slots between variables (see slots.h)
+
+loops and mulchain are choices generate_code makes while it walks the tree: their time
+is what it spends planning loop registers and finding chains, and the rest of it, past
+the range analysis, is the lowering's. Levels:
+
+  -O0  none                       -O2  all of them (default)
+  -O1  fold, peephole             -Os  all but loops, whose setup code before every
+                                       loop buys speed with bytes
+*/
+typedef enum
+{
+    PASS_FOLD,
+    PASS_LOOPS,
+    PASS_MULCHAIN,
+    PASS_PEEPHOLE,
+    PASS_SLOTS,
+    PASS_COUNT
+} PassId;
+
+#define PASS_BIT(pass) (1u << (pass))
+
+typedef struct
+{
+    unsigned enabled;     // PASS_BIT of every pass to run
+    unsigned print_after; // PASS_BIT of the passes after which the program is dumped
+} PassOptions;
+
+typedef struct
+{
+    uint64_t nanoseconds[PASS_COUNT];
+    int changes[PASS_COUNT];
+    unsigned ran; // PASS_BIT of the passes that ran
+    uint64_t analysis_nanoseconds; // range analysis, at the start of generate_code
+    uint64_t codegen_nanoseconds;  // the rest of generate_code, less loops and mulchain
+    int instructions; // generated, before the IR passes
+} PassStats;
+
+// the passes of an -O level: "0", "1", "2" or "s"; -1 for another
+int pass_level(const char *level, unsigned *enabled);
+// PassId of a pass name, -1 if there is none
+int find_pass(const char *name);
+const char *pass_name(PassId pass);
+
+// Run the pipeline options select: the AST passes, generate_code, then the IR and
+// machine passes. After every pass in print_after, the tree (AST passes) or the
+// instruction listing is written to dump. stats may be NULL. Returns 0 on success, -1
+// when generate_code fails (see has_error) or a pass runs out of memory.
+int run_passes(CodeGenerator *gen, ASTNode *ast, const PassOptions *options, PassStats *stats,
+               OutputSink *dump);
+// time and changes of every pass that ran, one line each
+void write_pass_stats(OutputSink *sink, const PassStats *stats);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef RANGE_H
+#define RANGE_H
+
+#include "ast.h"
+#include "symtab.h"
+
+/*
+Value ranges for the 8-bit target, whose int is 16 bits (-32768..32767, wrapping).
+Interval analysis bounds every variable and every expression node with the smallest
+range the program provably stays in, so the code generator can keep whatever fits in
+0..255 in a single byte and spend two bytes, with carry propagation, only on the rest.
+
+The analysis follows the statements in order. A branch narrows the variables its
+condition tests (x, x == e); a loop is repeated until its ranges stop growing, with
+bounds that keep growing widened to 255 and then to the whole int. A loop counted down
+by `n = n - 1` under `while (n)` runs at most n times, which bounds every variable the
+body steps once per pass (v = v + e) without widening it away.
+
+Inside a module that takes part in linking, other modules may store any value in its
+globals, so they all start out unknown.
+*/
+#define RANGE_MIN (-32768)
+#define RANGE_MAX 32767
+
+typedef struct
+{
+    int low;
+    int high; // below low when the value is never computed
+} ValueRange;
+
+typedef struct
+{
+    const ASTNode *node;
+    ValueRange range;
+} NodeRange;
+
+typedef struct
+{
+    SymbolTable variables; // every variable the program names
+    ValueRange *stored;    // per variable id: every value its slot ever holds
+    NodeRange *nodes;      // every expression node evaluated, open addressing by pointer
+    int node_count;
+    int node_capacity;     // always a power of two
+    int has_error;         // a literal does not fit in the int
+    char error_message[256];
+} RangeAnalysis;
+
+// shared: the globals are visible to other modules. NULL when out of memory; check
+// has_error for literals out of range
+RangeAnalysis *analyze_ranges(ASTNode *program, int shared);
+void free_range_analysis(RangeAnalysis *analysis);
+
+// every value an expression node takes (empty if it never runs)
+ValueRange node_range(const RangeAnalysis *analysis, const ASTNode *node);
+// every value a variable's slot holds
+ValueRange variable_range(const RangeAnalysis *analysis, const char *name);
+// whether all of a range is 0..255, so a byte holds it
+int fits_in_byte(ValueRange range);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Resident compile server on a Unix domain socket. A client sends its command line
+// and working directory (and optionally the source text itself), the server compiles
+// it on a thread kept warm in its pool and sends back the exit status together with
+// everything that would have gone to stdout and stderr.
+//
+// Both directions are a sequence of frames: a 4-byte type and a 4-byte length, both
+// little-endian, followed by length bytes. A message ends with FRAME_END.
+typedef enum
+{
+    FRAME_END,
+    FRAME_CWD,    // client working directory, relative paths are taken from it
+    FRAME_ARG,    // one command line argument, in order
+    FRAME_SOURCE, // source text for the single input, instead of reading the file
+    FRAME_STOP,   // ask the server to shut down
+    FRAME_STATUS, // reply: 4-byte exit status
+    FRAME_OUT,    // reply: stdout bytes
+    FRAME_ERR     // reply: stderr bytes
+} FrameType;
+
+#define FRAME_MAX_LENGTH (64u * 1024 * 1024)
+// seconds the server waits on a client that stops sending its request or reading the
+// reply before it drops the connection, so stalled clients cannot hold every worker
+#define SERVER_CLIENT_TIMEOUT 5
+#define SERVER_SOCKET_ENV "SIMPLELANG_SOCKET"
+
+// $SIMPLELANG_SOCKET, $XDG_RUNTIME_DIR/simplelang.sock, or /tmp/simplelang-<uid>/server.sock
+// (the server creates that directory, private to the user)
+void default_socket_path(char *buffer, size_t size);
+
+// serve until a FRAME_STOP arrives, returns the process exit status
+int run_server(const char *socket_path);
+// forward a compile command line to the server and print its reply.
+// Returns the compile's exit status, or -1 if no server answered. Both ends hang up on a
+// peer running as another user, and a socket in a directory others can write to without
+// the sticky bit is never used
+int run_client(const char *socket_path, int argc, char *argv[]);
+// returns 0 once a running server acknowledged the stop request
+int stop_server(const char *socket_path);
+
+// frame helpers shared by both ends, return 0 on success
+int write_frame(int fd, uint32_t type, const void *data, uint32_t length);
+// reads one frame into a malloc'ed, NUL terminated buffer the caller frees
+int read_frame(int fd, uint32_t *type, char **data, uint32_t *length);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "codegen.h"
+#include "assembler.h"
+
+// Cycle counting simulator for the 8-bit CPU.
+// It runs the encoded image produced by assemble_program, so it checks the
+// assembler as well as the code generator.
+
+#define SIM_MEMORY_SIZE 65536
+#define SIM_REGISTER_COUNT 7
+
+// clock cycles of each instruction, including its opcode and operand fetches
+int opcode_cycles(Opcode opcode);
+
+typedef struct
+{
+    unsigned char memory[SIM_MEMORY_SIZE];
+    unsigned char registers[SIM_REGISTER_COUNT];
+    int pc;
+    int sp; // stack grows down from the top of memory, sp points at the last pushed byte
+    int zero_flag;
+    int carry_flag;
+    int halted;
+    int stack_limit; // lowest address the stack may reach, just above the image
+
+    long long cycles;
+    long long instructions_executed;
+    long long opcode_counts[OP_COUNT];
+    int max_stack_depth;
+
+    int has_error;
+    char error_message[256];
+} Simulator;
+
+// copy the image into memory and reset the CPU
+Simulator *create_simulator(const ProgramImage *image);
+void free_simulator(Simulator *sim);
+
+// execute one instruction, returns 0 while the program keeps running
+int step_simulator(Simulator *sim);
+// run until hlt, an error, or max_cycles (0 means no limit); returns 0 if the program halted
+int run_simulator(Simulator *sim, long long max_cycles);
+
+// value of a variable in data memory, a two byte slot read as a signed 16-bit int
+int read_variable(const Simulator *sim, const ProgramImage *image, int symbol_id);
+
+// final variable values, cycle count, per-opcode counts and stack depth; symbols names the
+// image's data slots (the code generator's table, or the linker's for a linked program)
+void write_simulation_report(OutputSink *sink, const Simulator *sim, const SymbolTable *symbols, const ProgramImage *image);
+
+#endif
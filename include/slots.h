@@ -0,0 +1,29 @@
+#ifndef SLOTS_H
+#define SLOTS_H
+
+#include "ast.h"
+#include "codegen.h"
+
+/*
+Sharing .data slots between variables whose lifetimes never overlap, for boards with a
+few hundred bytes of RAM.
+
+Liveness is computed on the generated code, per byte of every slot, over the basic
+blocks between labels and jumps. Each variable's interval is then the first to the last
+instruction where it is live, loaded or stored, and variables are given slots in order
+of their interval's start, each taking a free slot of its size or a new one.
+
+What a program computes is the final value of its variables, so the hlt reads every
+variable except the block locals: those declared only inside an if or while body and
+never named outside one. A variable is only live from its first store, so until then
+its slot may still serve others, and a local may share a slot once its block is done.
+*/
+
+// Set gen->data_slot and gen->dead_at_exit for generated code (a whole program, not a module:
+// other modules may store into its globals at any time). 0 on success, -1 when out of
+// memory; a program too large to analyse keeps one slot per variable.
+int share_data_slots(CodeGenerator *gen, ASTNode *program);
+// .data bytes the sharing saves
+int data_bytes_saved(const CodeGenerator *gen);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+// Interns variable names so later stages can refer to them by a small integer id
+// ids are dense and handed out in order of first appearance
+typedef struct
+{
+    char **names;     // id -> name
+    int count;
+    int capacity;
+    int *buckets;     // open addressing hash table of ids, -1 marks an empty bucket
+    int bucket_count; // always a power of two
+} SymbolTable;
+
+void init_symbol_table(SymbolTable *table);
+void free_symbol_table(SymbolTable *table);
+
+// returns the id of name, adding it to the table if it is not there yet (-1 on allocation failure)
+int intern_symbol(SymbolTable *table, const char *name);
+// returns the id of name or -1 if it was never interned
+int find_symbol(const SymbolTable *table, const char *name);
+const char *symbol_name(const SymbolTable *table, int id);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+// Work-stealing thread pool. Every worker owns a deque: it takes its own tasks from
+// the bottom (newest first), and when that runs dry it steals from the top (oldest
+// first) of the other workers' deques, so uneven tasks still keep every thread busy.
+typedef void (*TaskFunction)(void *arg);
+
+typedef struct
+{
+    TaskFunction function;
+    void *arg;
+} Task;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    Task *tasks;
+    int top;    // oldest task, where thieves take from
+    int bottom; // one past the newest task, where the owner pushes and pops
+    int capacity;
+} WorkQueue;
+
+typedef struct
+{
+    pthread_t *threads;
+    WorkQueue *queues;
+    int thread_count; // one deque per thread
+    int started;      // workers actually running
+    int next_queue;       // submissions are dealt round-robin
+    pthread_mutex_t lock; // guards everything below
+    pthread_cond_t work_available;
+    pthread_cond_t all_done;
+    int queued;  // tasks sitting in a deque
+    int pending; // tasks submitted but not finished
+    int shutdown;
+} ThreadPool;
+
+// NULL if threads or memory cannot be had; fewer than one thread means one
+ThreadPool *create_thread_pool(int thread_count);
+// returns 0 on success, -1 when out of memory
+int thread_pool_submit(ThreadPool *pool, TaskFunction function, void *arg);
+// block until every submitted task has finished, the pool can be reused afterwards
+void thread_pool_wait(ThreadPool *pool);
+// waits for queued work, then stops and joins the workers
+void free_thread_pool(ThreadPool *pool);
+
+#endif
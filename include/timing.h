@@ -0,0 +1,67 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include "output.h"
+
+// Per-phase timing on the monotonic clock. Every compilation carries a TimeReport
+// pointer that is NULL unless --time-report was given; the timer macros below test
+// that pointer first, so without the flag no clock is read and no item is counted.
+typedef enum
+{
+    TIME_READ,     // items: source bytes
+    TIME_LEX,      // items: tokens
+    TIME_PARSE,    // items: AST nodes
+    // the 8-bit pipeline, with a row for every pass of passes.h
+    TIME_FOLD,
+    TIME_ANALYSIS, // range analysis ahead of the lowering
+    TIME_CODEGEN,  // items: instructions (the lowering alone on the 8-bit target)
+    TIME_LOOPS,
+    TIME_MULCHAIN,
+    TIME_PEEPHOLE,
+    TIME_SLOTS,
+    TIME_ASSEMBLE, // items: image bytes (x86-64: assembly, linking)
+    TIME_RUN,      // --vm, --run, --simulate
+    TIME_CACHE,    // cache lookups and stores
+    TIME_WRITE,    // items: bytes written
+    TIME_PHASE_COUNT
+} TimedPhase;
+
+typedef struct
+{
+    uint64_t nanoseconds[TIME_PHASE_COUNT];
+    uint64_t items[TIME_PHASE_COUNT];
+} TimeReport;
+
+typedef enum
+{
+    TIME_FORMAT_TEXT,
+    TIME_FORMAT_JSON
+} TimeFormat;
+
+uint64_t monotonic_nanoseconds(void);
+// charge the time since start, and the items processed, to a phase (nothing if start is later)
+void record_phase(TimeReport *report, TimedPhase phase, uint64_t start, uint64_t items);
+// charge time measured elsewhere, such as by the pass manager, to a phase
+void add_phase_time(TimeReport *report, TimedPhase phase, uint64_t nanoseconds, uint64_t items);
+
+// 0 when timing is off
+#define TIMER_START(report) ((report) ? monotonic_nanoseconds() : 0)
+// items is only evaluated when timing is on, so it may be costly to count
+#define TIMER_STOP(report, phase, start, items)        \
+    do                                                 \
+    {                                                  \
+        if (report)                                    \
+            record_phase(report, phase, start, items); \
+    } while (0)
+
+const char *timed_phase_name(TimedPhase phase);
+
+// add one compilation's times into a total
+void merge_time_report(TimeReport *total, const TimeReport *report);
+// table (or JSON object) of every phase with its share of the total and its throughput;
+// wall is the elapsed time of the whole run, which is shorter when inputs ran in parallel
+void write_time_report(OutputSink *sink, const TimeReport *report, TimeFormat format,
+                       int inputs, int threads, uint64_t wall);
+
+#endif
@@ -9,9 +9,15 @@ typedef enum
     TOKEN_INT,
     TOKEN_IF,
     TOKEN_ELSE,
+    TOKEN_WHILE,
+    TOKEN_IMPORT,
+    TOKEN_EXTERN,
     TOKEN_ASSIGN,
     TOKEN_PLUS,
     TOKEN_MINUS,
+    TOKEN_STAR,
+    TOKEN_SHIFT_LEFT,
+    TOKEN_SHIFT_RIGHT,
     TOKEN_EQUAL,
     TOKEN_SEMICOLON,
     TOKEN_LPAREN,
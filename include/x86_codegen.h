@@ -0,0 +1,18 @@
+#ifndef X86_CODEGEN_H
+#define X86_CODEGEN_H
+
+#include "ast.h"
+#include "output.h"
+
+// Second backend: lowers the AST to x86-64 GNU assembly (AT&T syntax) for Linux.
+// Expression temporaries live in registers, variables are 32-bit ints in .bss, and
+// the generated main prints "name = value" for every variable before returning.
+
+// write the whole program as assembly, returns 0 on success
+int generate_x86_assembly(ASTNode *ast, OutputSink *sink);
+
+// pipe the generated assembly into the system C compiler driver (cc, or $CC)
+// to assemble and link an executable at path, returns 0 on success
+int build_x86_executable(ASTNode *ast, const char *path);
+
+#endif
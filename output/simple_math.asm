@@ -25,6 +25,3 @@ var_a = 0
 var_b = 0
 var_sum = 0
 var_diff = 0
-var_x = 0
-var_counter = 0
-var_result = 0
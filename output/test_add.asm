@@ -0,0 +1,19 @@
+.text
+
+ldi A 10
+sta %var_a
+ldi A 5
+sta %var_b
+lda %var_a
+push A
+lda %var_b
+mov B A
+pop A
+add
+sta %var_sum
+hlt
+
+.data
+var_a = 0
+var_b = 0
+var_sum = 0
@@ -0,0 +1,8 @@
+.text
+
+ldi A 5
+sta %var_a
+hlt
+
+.data
+var_a = 0
@@ -0,0 +1,482 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/allocator.h"
+
+// blocks handed out by the arena and the counting allocator keep a header in front,
+// rounded up so the block itself stays aligned for any type
+#define ALIGNMENT 16
+#define ALIGN_UP(n) (((n) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+
+typedef struct ArenaChunk ArenaChunk;
+struct ArenaChunk
+{
+    ArenaChunk *next;
+    size_t size;
+    size_t used;
+    // data follows the (aligned) chunk header
+};
+
+typedef struct
+{
+    Allocator base;
+    ArenaChunk *chunks; // newest first, allocation happens in the newest
+    ArenaChunk *spare;  // emptied by reset_arena_allocator, taken before new ones are made
+    int spare_count;
+    size_t chunk_size;
+    void *last;         // most recent block, grown in place when possible
+} ArenaAllocator;
+
+// chunks a reset arena keeps for its next use, the rest go back to the system
+#define ARENA_SPARE_LIMIT 64
+
+typedef struct
+{
+    size_t size;
+} ArenaHeader;
+
+typedef struct
+{
+    Allocator base;
+    Allocator *backing;
+    AllocationStats stats;
+} CountingAllocator;
+
+typedef struct
+{
+    size_t size;
+    const char *site;
+} CountedHeader;
+
+#define ARENA_CHUNK_HEADER ALIGN_UP(sizeof(ArenaChunk))
+#define ARENA_HEADER ALIGN_UP(sizeof(ArenaHeader))
+#define COUNTED_HEADER ALIGN_UP(sizeof(CountedHeader))
+
+static __thread Allocator *thread_allocator;
+static __thread int thread_phase;
+
+// === System ===
+
+static void *system_allocate(Allocator *self, size_t size, const char *site)
+{
+    (void)self;
+    (void)site;
+    return malloc(size);
+}
+
+static void *system_reallocate(Allocator *self, void *pointer, size_t size, const char *site)
+{
+    (void)self;
+    (void)site;
+    return realloc(pointer, size);
+}
+
+static void system_release(Allocator *self, void *pointer)
+{
+    (void)self;
+    free(pointer);
+}
+
+static Allocator system_instance = {system_allocate, system_reallocate, system_release};
+
+Allocator *system_allocator(void)
+{
+    return &system_instance;
+}
+
+Allocator *current_allocator(void)
+{
+    return thread_allocator ? thread_allocator : &system_instance;
+}
+
+Allocator *set_allocator(Allocator *allocator)
+{
+    Allocator *previous = current_allocator();
+    thread_allocator = allocator;
+    return previous;
+}
+
+void set_allocation_phase(TimedPhase phase)
+{
+    thread_phase = phase;
+}
+
+// === Routed calls ===
+
+void *sl_malloc_at(size_t size, const char *site)
+{
+    Allocator *allocator = current_allocator();
+    return allocator->allocate(allocator, size, site);
+}
+
+void *sl_calloc_at(size_t count, size_t size, const char *site)
+{
+    if (size && count > (size_t)-1 / size)
+        return NULL;
+    void *pointer = sl_malloc_at(count * size, site);
+    if (pointer)
+        memset(pointer, 0, count * size);
+    return pointer;
+}
+
+void *sl_realloc_at(void *pointer, size_t size, const char *site)
+{
+    Allocator *allocator = current_allocator();
+    return allocator->reallocate(allocator, pointer, size, site);
+}
+
+char *sl_strdup_at(const char *text, const char *site)
+{
+    size_t length = strlen(text) + 1;
+    char *copy = sl_malloc_at(length, site);
+    if (copy)
+        memcpy(copy, text, length);
+    return copy;
+}
+
+void sl_free(void *pointer)
+{
+    if (!pointer)
+        return;
+    Allocator *allocator = current_allocator();
+    allocator->release(allocator, pointer);
+}
+
+// === Arena ===
+
+static void *arena_allocate(Allocator *self, size_t size, const char *site)
+{
+    (void)site;
+    ArenaAllocator *arena = (ArenaAllocator *)self;
+    size_t needed = ARENA_HEADER + ALIGN_UP(size);
+    ArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < needed)
+    {
+        // oversized blocks get a chunk of their own
+        size_t chunk_size = needed > arena->chunk_size ? needed : arena->chunk_size;
+        if (arena->spare && chunk_size == arena->chunk_size)
+        {
+            chunk = arena->spare;
+            arena->spare = chunk->next;
+            arena->spare_count--;
+        }
+        else if (!(chunk = malloc(ARENA_CHUNK_HEADER + chunk_size)))
+        {
+            return NULL;
+        }
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    char *block = (char *)chunk + ARENA_CHUNK_HEADER + chunk->used;
+    ((ArenaHeader *)block)->size = size;
+    chunk->used += needed;
+    arena->last = block + ARENA_HEADER;
+    return arena->last;
+}
+
+static void *arena_reallocate(Allocator *self, void *pointer, size_t size, const char *site)
+{
+    ArenaAllocator *arena = (ArenaAllocator *)self;
+    if (!pointer)
+        return arena_allocate(self, size, site);
+
+    ArenaHeader *header = (ArenaHeader *)((char *)pointer - ARENA_HEADER);
+    size_t old_size = header->size;
+    if (size <= old_size)
+    {
+        header->size = size;
+        return pointer;
+    }
+    // the newest block can grow into the rest of its chunk
+    ArenaChunk *chunk = arena->chunks;
+    if (pointer == arena->last)
+    {
+        size_t offset = (size_t)((char *)pointer - ((char *)chunk + ARENA_CHUNK_HEADER));
+        if (offset + ALIGN_UP(size) <= chunk->size)
+        {
+            chunk->used = offset + ALIGN_UP(size);
+            header->size = size;
+            return pointer;
+        }
+    }
+    void *grown = arena_allocate(self, size, site);
+    if (grown)
+        memcpy(grown, pointer, old_size);
+    return grown;
+}
+
+static void arena_release(Allocator *self, void *pointer)
+{
+    (void)self;
+    (void)pointer;
+}
+
+Allocator *create_arena_allocator(size_t chunk_size)
+{
+    ArenaAllocator *arena = calloc(1, sizeof(ArenaAllocator));
+    if (!arena)
+        return NULL;
+    arena->base.allocate = arena_allocate;
+    arena->base.reallocate = arena_reallocate;
+    arena->base.release = arena_release;
+    arena->chunk_size = chunk_size ? ALIGN_UP(chunk_size) : ARENA_DEFAULT_CHUNK_SIZE;
+    return &arena->base;
+}
+
+void reset_arena_allocator(Allocator *allocator)
+{
+    ArenaAllocator *arena = (ArenaAllocator *)allocator;
+    ArenaChunk *chunk = arena->chunks;
+    while (chunk)
+    {
+        ArenaChunk *next = chunk->next;
+        // oversized chunks fit only the block they were made for
+        if (chunk->size == arena->chunk_size && arena->spare_count < ARENA_SPARE_LIMIT)
+        {
+            chunk->next = arena->spare;
+            arena->spare = chunk;
+            arena->spare_count++;
+        }
+        else
+        {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    arena->chunks = NULL;
+    arena->last = NULL;
+}
+
+void free_arena_allocator(Allocator *allocator)
+{
+    if (!allocator)
+        return;
+    ArenaAllocator *arena = (ArenaAllocator *)allocator;
+    reset_arena_allocator(allocator);
+    ArenaChunk *chunk = arena->spare;
+    while (chunk)
+    {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+// === Counting ===
+
+static size_t site_hash(const char *site, int capacity)
+{
+    return ((uintptr_t)site >> 3) * 2654435761u % (size_t)capacity;
+}
+
+// the entry for site, added if new; NULL only when out of memory
+static AllocationSite *find_site(AllocationStats *stats, const char *site)
+{
+    if (stats->site_count * 2 >= stats->site_capacity)
+    {
+        int capacity = stats->site_capacity ? stats->site_capacity * 2 : 64;
+        AllocationSite *sites = calloc(capacity, sizeof(AllocationSite));
+        if (!sites)
+            return NULL;
+        for (int i = 0; i < stats->site_capacity; i++)
+        {
+            if (!stats->sites[i].site)
+                continue;
+            size_t slot = site_hash(stats->sites[i].site, capacity);
+            while (sites[slot].site)
+                slot = (slot + 1) % capacity;
+            sites[slot] = stats->sites[i];
+        }
+        free(stats->sites);
+        stats->sites = sites;
+        stats->site_capacity = capacity;
+    }
+
+    size_t slot = site_hash(site, stats->site_capacity);
+    while (stats->sites[slot].site && stats->sites[slot].site != site)
+        slot = (slot + 1) % stats->site_capacity;
+    if (!stats->sites[slot].site)
+    {
+        stats->sites[slot].site = site;
+        stats->site_count++;
+    }
+    return &stats->sites[slot];
+}
+
+static void count_allocation(AllocationStats *stats, const char *site, size_t bytes)
+{
+    stats->bytes += bytes;
+    stats->live_bytes += bytes;
+    if (stats->live_bytes > stats->peak_bytes)
+        stats->peak_bytes = stats->live_bytes;
+    stats->phase_allocations[thread_phase]++;
+    stats->phase_bytes[thread_phase] += bytes;
+    AllocationSite *entry = find_site(stats, site);
+    if (entry)
+    {
+        entry->allocations++;
+        entry->bytes += bytes;
+    }
+}
+
+static void *counting_allocate(Allocator *self, size_t size, const char *site)
+{
+    CountingAllocator *counting = (CountingAllocator *)self;
+    char *block = counting->backing->allocate(counting->backing, COUNTED_HEADER + size, site);
+    if (!block)
+        return NULL;
+    CountedHeader *header = (CountedHeader *)block;
+    header->size = size;
+    header->site = site;
+    counting->stats.allocations++;
+    count_allocation(&counting->stats, site, size);
+    return block + COUNTED_HEADER;
+}
+
+static void *counting_reallocate(Allocator *self, void *pointer, size_t size, const char *site)
+{
+    CountingAllocator *counting = (CountingAllocator *)self;
+    if (!pointer)
+        return counting_allocate(self, size, site);
+
+    char *block = (char *)pointer - COUNTED_HEADER;
+    size_t old_size = ((CountedHeader *)block)->size;
+    block = counting->backing->reallocate(counting->backing, block, COUNTED_HEADER + size, site);
+    if (!block)
+        return NULL;
+    ((CountedHeader *)block)->size = size;
+    counting->stats.reallocations++;
+    if (size > old_size)
+    {
+        count_allocation(&counting->stats, site, size - old_size);
+    }
+    else
+    {
+        counting->stats.live_bytes -= old_size - size;
+    }
+    return block + COUNTED_HEADER;
+}
+
+static void counting_release(Allocator *self, void *pointer)
+{
+    CountingAllocator *counting = (CountingAllocator *)self;
+    char *block = (char *)pointer - COUNTED_HEADER;
+    counting->stats.frees++;
+    counting->stats.live_bytes -= ((CountedHeader *)block)->size;
+    counting->backing->release(counting->backing, block);
+}
+
+Allocator *create_counting_allocator(Allocator *backing)
+{
+    CountingAllocator *counting = calloc(1, sizeof(CountingAllocator));
+    if (!counting)
+        return NULL;
+    counting->base.allocate = counting_allocate;
+    counting->base.reallocate = counting_reallocate;
+    counting->base.release = counting_release;
+    counting->backing = backing ? backing : &system_instance;
+    return &counting->base;
+}
+
+AllocationStats *counting_allocator_stats(Allocator *allocator)
+{
+    return &((CountingAllocator *)allocator)->stats;
+}
+
+void free_counting_allocator(Allocator *allocator)
+{
+    if (!allocator)
+        return;
+    free_allocation_stats(counting_allocator_stats(allocator));
+    free(allocator);
+}
+
+int merge_allocation_stats(AllocationStats *total, const AllocationStats *stats)
+{
+    total->allocations += stats->allocations;
+    total->reallocations += stats->reallocations;
+    total->frees += stats->frees;
+    total->bytes += stats->bytes;
+    total->live_bytes += stats->live_bytes;
+    if (stats->peak_bytes > total->peak_bytes)
+        total->peak_bytes = stats->peak_bytes;
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        total->phase_allocations[i] += stats->phase_allocations[i];
+        total->phase_bytes[i] += stats->phase_bytes[i];
+    }
+    for (int i = 0; i < stats->site_capacity; i++)
+    {
+        if (!stats->sites[i].site)
+            continue;
+        AllocationSite *entry = find_site(total, stats->sites[i].site);
+        if (!entry)
+            return -1;
+        entry->allocations += stats->sites[i].allocations;
+        entry->bytes += stats->sites[i].bytes;
+    }
+    return 0;
+}
+
+void free_allocation_stats(AllocationStats *stats)
+{
+    free(stats->sites);
+    stats->sites = NULL;
+    stats->site_count = 0;
+    stats->site_capacity = 0;
+}
+
+static int compare_site_bytes(const void *a, const void *b)
+{
+    const AllocationSite *left = a;
+    const AllocationSite *right = b;
+    if (left->bytes != right->bytes)
+        return left->bytes > right->bytes ? -1 : 1;
+    if (left->allocations != right->allocations)
+        return left->allocations > right->allocations ? -1 : 1;
+    return strcmp(left->site, right->site);
+}
+
+void write_memory_report(OutputSink *sink, const AllocationStats *stats, const char *allocator_name, int top_sites)
+{
+    sink_printf(sink, "Memory report (%s allocator)\n", allocator_name);
+    sink_printf(sink, "  %llu allocations, %llu reallocations, %llu frees\n",
+                (unsigned long long)stats->allocations, (unsigned long long)stats->reallocations,
+                (unsigned long long)stats->frees);
+    sink_printf(sink, "  %llu bytes allocated, peak %llu bytes live, %llu bytes never freed\n",
+                (unsigned long long)stats->bytes, (unsigned long long)stats->peak_bytes,
+                (unsigned long long)stats->live_bytes);
+
+    sink_printf(sink, "%-10s %12s %14s\n", "phase", "allocations", "bytes");
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        if (stats->phase_allocations[i] == 0)
+            continue;
+        sink_printf(sink, "%-10s %12llu %14llu\n", timed_phase_name((TimedPhase)i),
+                    (unsigned long long)stats->phase_allocations[i], (unsigned long long)stats->phase_bytes[i]);
+    }
+
+    // copy the used slots out of the hash table and rank them
+    AllocationSite *ranked = stats->site_count ? malloc(sizeof(AllocationSite) * stats->site_count) : NULL;
+    int count = 0;
+    for (int i = 0; ranked && i < stats->site_capacity; i++)
+    {
+        if (stats->sites[i].site)
+            ranked[count++] = stats->sites[i];
+    }
+    if (count == 0)
+    {
+        free(ranked);
+        return;
+    }
+    qsort(ranked, count, sizeof(AllocationSite), compare_site_bytes);
+    sink_printf(sink, "%-28s %12s %14s\n", "top sites", "allocations", "bytes");
+    for (int i = 0; i < count && i < top_sites; i++)
+    {
+        sink_printf(sink, "%-28s %12llu %14llu\n", ranked[i].site,
+                    (unsigned long long)ranked[i].allocations, (unsigned long long)ranked[i].bytes);
+    }
+    free(ranked);
+}
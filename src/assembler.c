@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/assembler.h"
+
+static void assembler_error(ProgramImage *image, const char *message, int index)
+{
+    if (image->has_error)
+        return;
+    image->has_error = 1;
+    snprintf(image->error_message, sizeof(image->error_message),
+             "Assembler error at instruction %d: %s", index, message);
+}
+
+int instruction_size(const Instruction *inst)
+{
+    switch (inst->opcode)
+    {
+    case OP_LDI:
+        return 2;
+    case OP_LDA:
+    case OP_STA:
+    case OP_JMP:
+    case OP_JZ:
+    case OP_JNZ:
+    case OP_JNC:
+    case OP_CALL:
+        return 3;
+    case OP_LABEL:
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+// first byte of the instructions that take a text address
+static unsigned char branch_encoding(int opcode)
+{
+    switch (opcode)
+    {
+    case OP_JMP:
+        return ENC_JMP;
+    case OP_JZ:
+        return ENC_JZ;
+    case OP_JNZ:
+        return ENC_JNZ;
+    case OP_JNC:
+        return ENC_JNC;
+    default:
+        return ENC_CALL;
+    }
+}
+
+// second pass: encode one instruction at its final address
+static void encode_instruction(ProgramImage *image, const Instruction *inst, int index)
+{
+    unsigned char *out = image->bytes + image->instruction_address[index];
+    int address;
+
+    switch (inst->opcode)
+    {
+    case OP_LDI:
+        if (inst->operand[1] < -128 || inst->operand[1] > 255)
+            assembler_error(image, "immediate does not fit in 8 bits", index);
+        out[0] = ENC_LDI | (inst->operand[0] & 7);
+        out[1] = (unsigned char)inst->operand[1];
+        break;
+    case OP_PUSH:
+        out[0] = ENC_PUSH | (inst->operand[0] & 7);
+        break;
+    case OP_POP:
+        out[0] = ENC_POP | (inst->operand[0] & 7);
+        break;
+    case OP_LDA:
+    case OP_STA:
+        if (inst->operand_kind[0] != OPERAND_SYMBOL || inst->operand[0] < 0 ||
+            inst->operand[0] >= image->symbol_count)
+        {
+            assembler_error(image, "unresolved memory operand", index);
+            return;
+        }
+        address = image->symbol_address[inst->operand[0]];
+        if (inst->operand_kind[1] == OPERAND_IMMEDIATE)
+        {
+            if (inst->operand[1] < 0 || inst->operand[1] >= image->symbol_size[inst->operand[0]])
+            {
+                assembler_error(image, "memory operand outside its slot", index);
+                return;
+            }
+            address += inst->operand[1];
+        }
+        out[0] = inst->opcode == OP_LDA ? ENC_LDA : ENC_STA;
+        out[1] = (unsigned char)(address & 0xFF);
+        out[2] = (unsigned char)(address >> 8);
+        break;
+    case OP_JMP:
+    case OP_JZ:
+    case OP_JNZ:
+    case OP_JNC:
+    case OP_CALL:
+        if (inst->operand_kind[0] != OPERAND_LABEL || inst->operand[0] < 0 ||
+            inst->operand[0] >= image->label_count || image->label_address[inst->operand[0]] < 0)
+        {
+            assembler_error(image, "unresolved jump target", index);
+            return;
+        }
+        address = image->label_address[inst->operand[0]];
+        out[0] = branch_encoding(inst->opcode);
+        out[1] = (unsigned char)(address & 0xFF);
+        out[2] = (unsigned char)(address >> 8);
+        break;
+    case OP_LABEL:
+        break;
+    case OP_ADD:
+        out[0] = ENC_ADD;
+        break;
+    case OP_SUB:
+        out[0] = ENC_SUB;
+        break;
+    case OP_CMP:
+        out[0] = ENC_CMP;
+        break;
+    case OP_SHL:
+        out[0] = ENC_SHL;
+        break;
+    case OP_SHR:
+        out[0] = ENC_SHR;
+        break;
+    case OP_ADC:
+        out[0] = ENC_ADC;
+        break;
+    case OP_SBC:
+        out[0] = ENC_SBC;
+        break;
+    case OP_RET:
+        out[0] = ENC_RET;
+        break;
+    case OP_MOV:
+        out[0] = ENC_MOV | ((inst->operand[0] & 7) << 3) | (inst->operand[1] & 7);
+        break;
+    case OP_HLT:
+        out[0] = ENC_HLT;
+        break;
+    default:
+        assembler_error(image, "unknown opcode", index);
+        break;
+    }
+}
+
+ProgramImage *assemble_program(const CodeGenerator *gen)
+{
+    ProgramImage *image = calloc(1, sizeof(ProgramImage));
+    if (!image)
+        return NULL;
+
+    image->instruction_count = gen->count;
+    image->symbol_count = gen->symbols.count;
+    image->instruction_address = malloc(sizeof(int) * (gen->count + 1));
+    image->symbol_address = malloc(sizeof(int) * (gen->symbols.count + 1));
+    image->symbol_size = malloc(sizeof(int) * (gen->symbols.count + 1));
+    image->label_count = gen->label_count;
+    image->label_address = malloc(sizeof(int) * (gen->label_count + 1));
+    if (!image->instruction_address || !image->symbol_address || !image->symbol_size || !image->label_address)
+    {
+        free_program_image(image);
+        return NULL;
+    }
+
+    // first pass: addresses of every instruction and label, then of every data slot
+    for (int i = 0; i < gen->label_count; i++)
+    {
+        image->label_address[i] = -1;
+    }
+    int address = 0;
+    for (int i = 0; i < gen->count; i++)
+    {
+        const Instruction *inst = &gen->instructions[i];
+        image->instruction_address[i] = address;
+        if (inst->opcode == OP_LABEL && inst->operand[0] >= 0 && inst->operand[0] < gen->label_count)
+            image->label_address[inst->operand[0]] = address;
+        address += instruction_size(inst);
+    }
+    image->text_size = address;
+    for (int i = 0; i < gen->symbols.count; i++)
+    {
+        image->symbol_size[i] = symbol_size(gen, i);
+        if (gen->data_slot && gen->data_slot[i] != i)
+            continue;
+        image->symbol_address[i] = address;
+        address += image->symbol_size[i];
+    }
+    image->size = address;
+    // variables sharing a slot take the address of the one it belongs to
+    for (int i = 0; gen->data_slot && i < gen->symbols.count; i++)
+    {
+        image->symbol_address[i] = image->symbol_address[gen->data_slot[i]];
+    }
+    if (gen->dead_at_exit)
+    {
+        image->symbol_dead = malloc(gen->symbols.count + 1);
+        if (!image->symbol_dead)
+        {
+            free_program_image(image);
+            return NULL;
+        }
+        memcpy(image->symbol_dead, gen->dead_at_exit, gen->symbols.count);
+    }
+
+    if (image->size > IMAGE_MAX_SIZE)
+    {
+        assembler_error(image, "program does not fit in the 64 KiB address space", gen->count);
+        return image;
+    }
+
+    // data slots start out as zero
+    image->bytes = calloc(image->size ? image->size : 1, 1);
+    if (!image->bytes)
+    {
+        free_program_image(image);
+        return NULL;
+    }
+
+    // second pass: encode with all addresses known
+    for (int i = 0; i < gen->count; i++)
+    {
+        encode_instruction(image, &gen->instructions[i], i);
+    }
+    return image;
+}
+
+void free_program_image(ProgramImage *image)
+{
+    if (image)
+    {
+        free(image->bytes);
+        free(image->symbol_address);
+        free(image->symbol_size);
+        free(image->symbol_dead);
+        free(image->instruction_address);
+        free(image->label_address);
+        free(image);
+    }
+}
+
+int write_binary_image(const ProgramImage *image, OutputSink *sink)
+{
+    return sink_write(sink, (const char *)image->bytes, image->size);
+}
+
+int write_intel_hex(const ProgramImage *image, OutputSink *sink)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    for (int offset = 0; offset < image->size; offset += 16)
+    {
+        int count = image->size - offset < 16 ? image->size - offset : 16;
+        unsigned char record[4 + 16];
+        record[0] = (unsigned char)count;
+        record[1] = (unsigned char)(offset >> 8);
+        record[2] = (unsigned char)(offset & 0xFF);
+        record[3] = 0x00; // data record
+        memcpy(record + 4, image->bytes + offset, count);
+
+        // ':' + two hex digits per byte + checksum + newline
+        char *line = sink_reserve(sink, 1 + (4 + count + 1) * 2 + 1);
+        if (!line)
+            return -1;
+        int length = 0;
+        unsigned char checksum = 0;
+        line[length++] = ':';
+        for (int i = 0; i < 4 + count; i++)
+        {
+            checksum += record[i];
+            line[length++] = digits[record[i] >> 4];
+            line[length++] = digits[record[i] & 0xF];
+        }
+        checksum = (unsigned char)(0x100 - checksum);
+        line[length++] = digits[checksum >> 4];
+        line[length++] = digits[checksum & 0xF];
+        line[length++] = '\n';
+        sink_commit(sink, length);
+    }
+    return sink_puts(sink, ":00000001FF\n");
+}
@@ -1,18 +1,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include "../include/ast.h"
+#include "../include/allocator.h"
 // create the starting node
 ASTNode *create_program_node()
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
     {
         return NULL;
     }
 
     node->type = AST_PROGRAM;
-    node->data.block.statements = malloc(sizeof(ASTNode *) * 10); // create some pre - memory for statements
+    node->data.block.statements = sl_malloc(sizeof(ASTNode *) * 10); // create some pre - memory for statements
     node->data.block.count = 0;
     node->data.block.capacity = 10;
     node->line = 1;
@@ -22,7 +24,7 @@ ASTNode *create_program_node()
 // Create AST Node if the parser encounters number literal
 ASTNode *create_number_node(int value, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
@@ -36,15 +38,15 @@ ASTNode *create_number_node(int value, int line, int column)
 // Create AST Node for Identifier
 ASTNode *create_identifier_node(char *name, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
     node->type = AST_IDENTIFIER;
-    node->data.identifier.name = malloc(strlen(name) + 1);
+    node->data.identifier.name = sl_malloc(strlen(name) + 1);
     if (!node->data.identifier.name)
     {
-        free(node);
+        sl_free(node);
         return NULL;
     }
     strcpy(node->data.identifier.name, name);
@@ -56,7 +58,7 @@ ASTNode *create_identifier_node(char *name, int line, int column)
 // Create AST subtree node for expression parsing with children nodes based on precedence and associtivity rule
 ASTNode *create_binary_op_node(ASTNode *left, TokenType op, ASTNode *right, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
@@ -72,15 +74,15 @@ ASTNode *create_binary_op_node(ASTNode *left, TokenType op, ASTNode *right, int
 // Create the declaration node with value initialisation
 ASTNode *create_declaration_node(char *var_name, ASTNode *init_value, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
     node->type = AST_DECLARATION;
-    node->data.declaration.var_name = malloc(strlen(var_name) + 1);
+    node->data.declaration.var_name = sl_malloc(strlen(var_name) + 1);
     if (!node->data.declaration.var_name)
     {
-        free(node);
+        sl_free(node);
         return NULL;
     }
     strcpy(node->data.declaration.var_name, var_name);
@@ -93,15 +95,15 @@ ASTNode *create_declaration_node(char *var_name, ASTNode *init_value, int line,
 // Create AST assignment node
 ASTNode *create_assignment_node(char *var_name, ASTNode *value, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
     node->type = AST_ASSIGNMENT;
-    node->data.assignment.var_name = malloc(strlen(var_name) + 1);
+    node->data.assignment.var_name = sl_malloc(strlen(var_name) + 1);
     if (!node->data.assignment.var_name)
     {
-        free(node);
+        sl_free(node);
         return NULL;
     }
     strcpy(node->data.assignment.var_name, var_name);
@@ -114,7 +116,7 @@ ASTNode *create_assignment_node(char *var_name, ASTNode *value, int line, int co
 // Create AST if node
 ASTNode *create_if_node(ASTNode *condition, ASTNode *then_block, ASTNode *else_block, int line, int column)
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
@@ -127,15 +129,30 @@ ASTNode *create_if_node(ASTNode *condition, ASTNode *then_block, ASTNode *else_b
 
     return node;
 }
+// Create AST while node
+ASTNode *create_while_node(ASTNode *condition, ASTNode *body, int line, int column)
+{
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
+    if (!node)
+        return NULL;
+
+    node->type = AST_WHILE_STATEMENT;
+    node->data.while_stmt.condition = condition;
+    node->data.while_stmt.body = body;
+    node->line = line;
+    node->column = column;
+
+    return node;
+}
 // create AST node for block
 ASTNode *create_block_node()
 {
-    ASTNode *node = malloc(sizeof(ASTNode));
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
     if (!node)
         return NULL;
 
     node->type = AST_BLOCK;
-    node->data.block.statements = malloc(sizeof(ASTNode *) * 10);
+    node->data.block.statements = sl_malloc(sizeof(ASTNode *) * 10);
     node->data.block.count = 0;
     node->data.block.capacity = 10;
     node->line = 1;
@@ -143,6 +160,57 @@ ASTNode *create_block_node()
 
     return node;
 }
+// Create AST import node, module is the name of the imported file without .sl
+ASTNode *create_import_node(char *module, int line, int column)
+{
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
+    if (!node)
+        return NULL;
+
+    node->type = AST_IMPORT;
+    node->data.import.module = sl_strdup(module);
+    if (!node->data.import.module)
+    {
+        sl_free(node);
+        return NULL;
+    }
+    node->line = line;
+    node->column = column;
+
+    return node;
+}
+// Create AST extern node for a variable another module defines
+ASTNode *create_extern_node(char *var_name, int line, int column)
+{
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
+    if (!node)
+        return NULL;
+
+    node->type = AST_EXTERN;
+    node->data.extern_decl.var_name = sl_strdup(var_name);
+    if (!node->data.extern_decl.var_name)
+    {
+        sl_free(node);
+        return NULL;
+    }
+    node->line = line;
+    node->column = column;
+
+    return node;
+}
+// Create AST error node in place of a statement the parser skipped
+ASTNode *create_error_node(int line, int column)
+{
+    ASTNode *node = sl_malloc(sizeof(ASTNode));
+    if (!node)
+        return NULL;
+
+    node->type = AST_ERROR;
+    node->line = line;
+    node->column = column;
+
+    return node;
+}
 // create AST node for adding statement to block node
 void add_statement_to_block(ASTNode *block, ASTNode *statement)
 {
@@ -155,198 +223,374 @@ void add_statement_to_block(ASTNode *block, ASTNode *statement)
     if (block->data.block.count >= block->data.block.capacity)
     {
         block->data.block.capacity *= 2;
-        block->data.block.statements = realloc(block->data.block.statements,
+        block->data.block.statements = sl_realloc(block->data.block.statements,
                                                sizeof(ASTNode *) * block->data.block.capacity);
     }
 
     block->data.block.statements[block->data.block.count++] = statement;
 }
-// Print the AST based on indentation
-void print_ast(ASTNode *node, int indent, int is_last, char *prefix)
+int ast_child_count(const ASTNode *node)
 {
-    if (!node)
-        return;
-
-    // Print the current prefix
-    if (prefix)
-        printf("%s", prefix);
-
-    // Print the tree connector
-    if (indent > 0)
+    switch (node->type)
     {
-        if (is_last)
-            printf("└── ");
-        else
-            printf("├── ");
+    case AST_PROGRAM:
+    case AST_BLOCK:
+        return node->data.block.count;
+    case AST_DECLARATION:
+    case AST_ASSIGNMENT:
+        return 1;
+    case AST_IF_STATEMENT:
+        return 3;
+    case AST_WHILE_STATEMENT:
+    case AST_BINARY_OP:
+        return 2;
+    default:
+        return 0;
     }
+}
 
+ASTNode *ast_child(const ASTNode *node, int index)
+{
     switch (node->type)
     {
     case AST_PROGRAM:
-        printf("PROGRAM\n");
-        for (int i = 0; i < node->data.block.count; i++)
+    case AST_BLOCK:
+        return node->data.block.statements[index];
+    case AST_DECLARATION:
+        return node->data.declaration.init_value;
+    case AST_ASSIGNMENT:
+        return node->data.assignment.value;
+    case AST_IF_STATEMENT:
+        return index == 0 ? node->data.if_stmt.condition
+               : index == 1 ? node->data.if_stmt.then_block
+                            : node->data.if_stmt.else_block;
+    case AST_WHILE_STATEMENT:
+        return index == 0 ? node->data.while_stmt.condition : node->data.while_stmt.body;
+    case AST_BINARY_OP:
+        return index == 0 ? node->data.binary_op.left : node->data.binary_op.right;
+    default:
+        return NULL;
+    }
+}
+
+void init_ast_walk(ASTWalk *walk)
+{
+    walk->frames = NULL;
+    walk->count = 0;
+    walk->capacity = 0;
+    walk->failed = 0;
+}
+
+void free_ast_walk(ASTWalk *walk)
+{
+    sl_free(walk->frames);
+    init_ast_walk(walk);
+}
+
+int ast_walk_push(ASTWalk *walk, ASTNode *node, int value)
+{
+    if (!node)
+        return 0;
+    if (walk->count == walk->capacity)
+    {
+        int capacity = walk->capacity ? walk->capacity * 2 : 32;
+        ASTFrame *frames = sl_realloc(walk->frames, sizeof(ASTFrame) * capacity);
+        if (!frames)
         {
-            char new_prefix[256] = {0};
-            if (prefix)
-                strcpy(new_prefix, prefix);
-            print_ast(node->data.block.statements[i], indent + 1,
-                      i == node->data.block.count - 1, new_prefix);
+            walk->failed = 1;
+            return -1;
         }
-        break;
+        walk->frames = frames;
+        walk->capacity = capacity;
+    }
+    ASTFrame *frame = &walk->frames[walk->count++];
+    frame->node = node;
+    frame->step = 0;
+    frame->value = value;
+    return 0;
+}
 
-    case AST_DECLARATION:
-        printf("DECLARATION: %s\n", node->data.declaration.var_name);
-        if (node->data.declaration.init_value)
+ASTFrame *ast_walk_top(ASTWalk *walk)
+{
+    return walk->count > 0 ? &walk->frames[walk->count - 1] : NULL;
+}
+
+void ast_walk_pop(ASTWalk *walk)
+{
+    if (walk->count > 0)
+        walk->count--;
+}
+
+// One line of the drawing still to be written: a node, or the CONDITION, THEN or ELSE
+// heading of an if. Its prefix is its parent's (the first base bytes of the shared
+// prefix buffer, which the lines written in between leave alone) followed by segment.
+typedef struct
+{
+    ASTNode *node;
+    const char *heading; // for a heading line, node is NULL
+    size_t base;
+    const char *segment;
+    int is_last;
+    int depth;
+} DrawLine;
+
+typedef struct
+{
+    DrawLine *lines;
+    int count;
+    int capacity;
+    char *prefix;
+    size_t prefix_capacity;
+    int failed;
+} Drawing;
+
+static void push_line(Drawing *drawing, ASTNode *node, const char *heading, size_t base,
+                      const char *segment, int is_last, int depth)
+{
+    if (!node && !heading)
+        return;
+    if (drawing->count == drawing->capacity)
+    {
+        int capacity = drawing->capacity ? drawing->capacity * 2 : 32;
+        DrawLine *lines = sl_realloc(drawing->lines, sizeof(DrawLine) * capacity);
+        if (!lines)
         {
-            char new_prefix[256] = {0};
-            if (prefix)
-                strcpy(new_prefix, prefix);
-            if (is_last)
-                strcat(new_prefix, "    ");
-            else
-                strcat(new_prefix, "│   ");
-            print_ast(node->data.declaration.init_value, indent + 1, 1, new_prefix);
+            drawing->failed = 1;
+            return;
         }
-        break;
+        drawing->lines = lines;
+        drawing->capacity = capacity;
+    }
+    DrawLine line = {node, heading, base, segment, is_last, depth};
+    drawing->lines[drawing->count++] = line;
+}
 
-    case AST_ASSIGNMENT:
-        printf("ASSIGNMENT: %s\n", node->data.assignment.var_name);
-        char assign_prefix[256] = {0};
-        if (prefix)
-            strcpy(assign_prefix, prefix);
-        if (is_last)
-            strcat(assign_prefix, "    ");
-        else
-            strcat(assign_prefix, "│   ");
-        print_ast(node->data.assignment.value, indent + 1, 1, assign_prefix);
-        break;
+static int reserve_prefix(Drawing *drawing, size_t length)
+{
+    if (length <= drawing->prefix_capacity)
+        return 0;
+    size_t capacity = drawing->prefix_capacity ? drawing->prefix_capacity * 2 : 256;
+    while (capacity < length)
+        capacity *= 2;
+    char *prefix = sl_realloc(drawing->prefix, capacity);
+    if (!prefix)
+        return -1;
+    drawing->prefix = prefix;
+    drawing->prefix_capacity = capacity;
+    return 0;
+}
 
-    case AST_IF_STATEMENT:
-        printf("IF\n");
-        char if_prefix[256] = {0};
-        if (prefix)
-            strcpy(if_prefix, prefix);
-        if (is_last)
-            strcat(if_prefix, "    ");
-        else
-            strcat(if_prefix, "│   ");
-
-        // Print condition
-        printf("%s├── CONDITION:\n", if_prefix);
-        char cond_prefix[256] = {0};
-        strcpy(cond_prefix, if_prefix);
-        strcat(cond_prefix, "│   ");
-        print_ast(node->data.if_stmt.condition, indent + 2, 1, cond_prefix);
-
-        // Print then block
-        int has_else = node->data.if_stmt.else_block != NULL;
-        printf("%s%s THEN:\n", if_prefix, has_else ? "├──" : "└──");
-        char then_prefix[256] = {0};
-        strcpy(then_prefix, if_prefix);
-        strcat(then_prefix, has_else ? "│   " : "    ");
-        print_ast(node->data.if_stmt.then_block, indent + 2, 1, then_prefix);
-
-        // Print else block if exists
-        if (node->data.if_stmt.else_block)
+// Print the AST based on indentation
+static void write_ast_node(OutputSink *sink, ASTNode *node, int indent, int is_last, char *prefix)
+{
+    Drawing drawing = {NULL, 0, 0, NULL, 0, 0};
+    size_t root = prefix ? strlen(prefix) : 0;
+    if (reserve_prefix(&drawing, root + 1) != 0)
+        return;
+    if (prefix)
+        memcpy(drawing.prefix, prefix, root);
+    push_line(&drawing, node, NULL, root, "", is_last, indent);
+
+    while (drawing.count > 0 && !drawing.failed)
+    {
+        DrawLine line = drawing.lines[--drawing.count];
+        size_t segment = strlen(line.segment);
+        size_t length = line.base + segment;
+        if (reserve_prefix(&drawing, length + 1) != 0)
+            break;
+        memcpy(drawing.prefix + line.base, line.segment, segment);
+
+        // Print the current prefix and the tree connector
+        sink_write(sink, drawing.prefix, length);
+        if (line.depth > 0)
+            sink_puts(sink, line.is_last ? "└── " : "├── ");
+        if (line.heading)
         {
-            printf("%s└── ELSE:\n", if_prefix);
-            char else_prefix[256] = {0};
-            strcpy(else_prefix, if_prefix);
-            strcat(else_prefix, "    ");
-            print_ast(node->data.if_stmt.else_block, indent + 2, 1, else_prefix);
+            sink_printf(sink, "%s\n", line.heading);
+            continue;
+        }
+        if (line.depth > AST_DRAW_DEPTH)
+            sink_printf(sink, "[depth %d] ", line.depth);
+
+        // children hang below this line's prefix; past the drawing depth it stops growing
+        ASTNode *current = line.node;
+        int capped = line.depth >= AST_DRAW_DEPTH;
+        const char *below = capped ? "" : line.is_last ? "    " : "│   ";
+        int count;
+        switch (current->type)
+        {
+        case AST_PROGRAM:
+            sink_printf(sink, "PROGRAM\n");
+            count = current->data.block.count;
+            for (int i = count - 1; i >= 0; i--)
+                push_line(&drawing, current->data.block.statements[i], NULL, length, "", i == count - 1, line.depth + 1);
+            break;
+
+        case AST_DECLARATION:
+            sink_printf(sink, "DECLARATION: %s\n", current->data.declaration.var_name);
+            push_line(&drawing, current->data.declaration.init_value, NULL, length, below, 1, line.depth + 1);
+            break;
+
+        case AST_ASSIGNMENT:
+            sink_printf(sink, "ASSIGNMENT: %s\n", current->data.assignment.var_name);
+            push_line(&drawing, current->data.assignment.value, NULL, length, below, 1, line.depth + 1);
+            break;
+
+        case AST_IF_STATEMENT:
+        {
+            sink_printf(sink, "IF\n");
+            // headings hang below the if, the parts below their headings; pushed last first
+            size_t part = length + strlen(below);
+            int has_else = current->data.if_stmt.else_block != NULL;
+            if (has_else)
+            {
+                push_line(&drawing, current->data.if_stmt.else_block, NULL, part, capped ? "" : "    ", 1, line.depth + 2);
+                push_line(&drawing, NULL, "ELSE:", length, below, 1, line.depth + 1);
+            }
+            push_line(&drawing, current->data.if_stmt.then_block, NULL, part,
+                      capped ? "" : has_else ? "│   " : "    ", 1, line.depth + 2);
+            push_line(&drawing, NULL, "THEN:", length, below, !has_else, line.depth + 1);
+            push_line(&drawing, current->data.if_stmt.condition, NULL, part, capped ? "" : "│   ", 1, line.depth + 2);
+            push_line(&drawing, NULL, "CONDITION:", length, below, 0, line.depth + 1);
+            break;
         }
-        break;
-
-    case AST_BINARY_OP:
-        printf("BINARY_OP: %s\n", token_type_to_string(node->data.binary_op.operator));
-        char bin_prefix[256] = {0};
-        if (prefix)
-            strcpy(bin_prefix, prefix);
-        if (is_last)
-            strcat(bin_prefix, "    ");
-        else
-            strcat(bin_prefix, "│   ");
-        print_ast(node->data.binary_op.left, indent + 1, 0, bin_prefix);
-        print_ast(node->data.binary_op.right, indent + 1, 1, bin_prefix);
-        break;
-
-    case AST_NUMBER:
-        printf("NUMBER: %d\n", node->data.number.value);
-        break;
-
-    case AST_IDENTIFIER:
-        printf("IDENTIFIER: %s\n", node->data.identifier.name);
-        break;
 
-    case AST_BLOCK:
-        printf("BLOCK\n");
-        char block_prefix[256] = {0};
-        if (prefix)
-            strcpy(block_prefix, prefix);
-        if (is_last)
-            strcat(block_prefix, "    ");
-        else
-            strcat(block_prefix, "│   ");
-        for (int i = 0; i < node->data.block.count; i++)
+        case AST_WHILE_STATEMENT:
         {
-            print_ast(node->data.block.statements[i], indent + 1,
-                      i == node->data.block.count - 1, block_prefix);
+            sink_printf(sink, "WHILE\n");
+            size_t part = length + strlen(below);
+            push_line(&drawing, current->data.while_stmt.body, NULL, part, capped ? "" : "    ", 1, line.depth + 2);
+            push_line(&drawing, NULL, "BODY:", length, below, 1, line.depth + 1);
+            push_line(&drawing, current->data.while_stmt.condition, NULL, part, capped ? "" : "│   ", 1, line.depth + 2);
+            push_line(&drawing, NULL, "CONDITION:", length, below, 0, line.depth + 1);
+            break;
         }
-        break;
 
-    default:
-        printf("UNKNOWN NODE TYPE\n");
-        break;
+        case AST_BINARY_OP:
+            sink_printf(sink, "BINARY_OP: %s\n", token_type_to_string(current->data.binary_op.operator));
+            push_line(&drawing, current->data.binary_op.right, NULL, length, below, 1, line.depth + 1);
+            push_line(&drawing, current->data.binary_op.left, NULL, length, below, 0, line.depth + 1);
+            break;
+
+        case AST_NUMBER:
+            sink_printf(sink, "NUMBER: %d\n", current->data.number.value);
+            break;
+
+        case AST_IDENTIFIER:
+            sink_printf(sink, "IDENTIFIER: %s\n", current->data.identifier.name);
+            break;
+
+        case AST_IMPORT:
+            sink_printf(sink, "IMPORT: %s\n", current->data.import.module);
+            break;
+
+        case AST_EXTERN:
+            sink_printf(sink, "EXTERN: %s\n", current->data.extern_decl.var_name);
+            break;
+
+        case AST_ERROR:
+            sink_printf(sink, "ERROR\n");
+            break;
+
+        case AST_BLOCK:
+            sink_printf(sink, "BLOCK\n");
+            count = current->data.block.count;
+            for (int i = count - 1; i >= 0; i--)
+                push_line(&drawing, current->data.block.statements[i], NULL, length, below, i == count - 1, line.depth + 1);
+            break;
+
+        default:
+            sink_printf(sink, "UNKNOWN NODE TYPE\n");
+            break;
+        }
     }
+    sl_free(drawing.lines);
+    sl_free(drawing.prefix);
+}
+void write_ast(OutputSink *sink, ASTNode *node)
+{
+    write_ast_node(sink, node, 0, 1, "");
+}
+
+void print_ast(ASTNode *node, int indent, int is_last, char *prefix)
+{
+    // keep ordering with whatever the caller already printed
+    fflush(stdout);
+    OutputSink *sink = create_fd_sink(STDOUT_FILENO);
+    if (!sink)
+        return;
+    write_ast_node(sink, node, indent, is_last, prefix);
+    close_sink(sink);
 }
 // clean the dynamic allocated memory
 void free_ast(ASTNode *node)
 {
-    if (!node)
-        return;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, node, 0);
 
-    switch (node->type)
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
     {
-    case AST_PROGRAM:
-    case AST_BLOCK:
-        for (int i = 0; i < node->data.block.count; i++)
+        node = frame->node;
+        ast_walk_pop(&walk);
+        // the children wait on the stack, a child that does not fit (out of memory)
+        // is leaked rather than freed by recursing
+        for (int i = 0; i < ast_child_count(node); i++)
+            ast_walk_push(&walk, ast_child(node, i), 0);
+
+        switch (node->type)
         {
-            free_ast(node->data.block.statements[i]);
-        }
-        free(node->data.block.statements);
-        break;
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            sl_free(node->data.block.statements);
+            break;
 
-    case AST_DECLARATION:
-        free(node->data.declaration.var_name);
-        free_ast(node->data.declaration.init_value);
-        break;
+        case AST_DECLARATION:
+            sl_free(node->data.declaration.var_name);
+            break;
 
-    case AST_ASSIGNMENT:
-        free(node->data.assignment.var_name);
-        free_ast(node->data.assignment.value);
-        break;
+        case AST_ASSIGNMENT:
+            sl_free(node->data.assignment.var_name);
+            break;
 
-    case AST_IF_STATEMENT:
-        free_ast(node->data.if_stmt.condition);
-        free_ast(node->data.if_stmt.then_block);
-        free_ast(node->data.if_stmt.else_block);
-        break;
+        case AST_IDENTIFIER:
+            sl_free(node->data.identifier.name);
+            break;
 
-    case AST_BINARY_OP:
-        free_ast(node->data.binary_op.left);
-        free_ast(node->data.binary_op.right);
-        break;
+        case AST_IMPORT:
+            sl_free(node->data.import.module);
+            break;
 
-    case AST_IDENTIFIER:
-        free(node->data.identifier.name);
-        break;
+        case AST_EXTERN:
+            sl_free(node->data.extern_decl.var_name);
+            break;
 
-    case AST_NUMBER:
-        break;
+        default:
+            break;
+        }
 
-    default:
-        break;
+        sl_free(node);
     }
+    free_ast_walk(&walk);
+}
 
-    free(node);
+int count_ast_nodes(ASTNode *node)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, node, 0);
+
+    int count = 0;
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        node = frame->node;
+        ast_walk_pop(&walk);
+        count++;
+        for (int i = 0; i < ast_child_count(node); i++)
+            ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    free_ast_walk(&walk);
+    return count;
 }
@@ -0,0 +1,515 @@
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/astfile.h"
+#include "../include/allocator.h"
+#include "../include/lexer.h"
+
+#define NODE_SIZE ((int64_t)sizeof(ASTFileNode))
+
+// node types by where the grammar allows them
+#define TYPE_BIT(type) (1u << (type))
+#define EXPRESSIONS (TYPE_BIT(AST_NUMBER) | TYPE_BIT(AST_IDENTIFIER) | TYPE_BIT(AST_BINARY_OP))
+#define STATEMENTS (TYPE_BIT(AST_DECLARATION) | TYPE_BIT(AST_ASSIGNMENT) | TYPE_BIT(AST_IF_STATEMENT) | \
+                    TYPE_BIT(AST_WHILE_STATEMENT))
+#define TOP_LEVEL (STATEMENTS | TYPE_BIT(AST_IMPORT) | TYPE_BIT(AST_EXTERN))
+
+static const char *node_name(const ASTNode *node)
+{
+    switch (node->type)
+    {
+    case AST_IDENTIFIER:
+        return node->data.identifier.name;
+    case AST_DECLARATION:
+        return node->data.declaration.var_name;
+    case AST_ASSIGNMENT:
+        return node->data.assignment.var_name;
+    case AST_IMPORT:
+        return node->data.import.module;
+    case AST_EXTERN:
+        return node->data.extern_decl.var_name;
+    default:
+        return NULL;
+    }
+}
+
+// nodes, child list entries and name bytes of a tree; -1 when out of memory
+static int measure_tree(ASTNode *program, int64_t *nodes, int64_t *lists, int64_t *strings)
+{
+    *nodes = *lists = *strings = 0;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        if (step == 0)
+        {
+            const char *name = node_name(node);
+            (*nodes)++;
+            if (node->type == AST_PROGRAM || node->type == AST_BLOCK)
+                *lists += node->data.block.count;
+            if (name)
+                *strings += strlen(name) + 1;
+        }
+        if (step < ast_child_count(node))
+            ast_walk_push(&walk, ast_child(node, step), 0);
+        else
+            ast_walk_pop(&walk);
+    }
+    int failed = walk.failed;
+    free_ast_walk(&walk);
+    return failed ? -1 : 0;
+}
+
+int write_ast_file(OutputSink *sink, ASTNode *program)
+{
+    int64_t node_count, list_count, string_size;
+    if (!program || program->type != AST_PROGRAM || measure_tree(program, &node_count, &list_count, &string_size) != 0)
+        return -1;
+    int64_t node_start = sizeof(ASTFileHeader);
+    int64_t list_start = node_start + node_count * NODE_SIZE;
+    int64_t string_start = list_start + list_count * 4;
+    int64_t size = string_start + string_size;
+    // offsets are 32 bits
+    if (size > INT32_MAX)
+        return -1;
+
+    unsigned char *file = (unsigned char *)sink_reserve(sink, size);
+    int *pending = sl_malloc(sizeof(int) * (node_count + 1)); // written nodes not yet given a parent
+    if (!file || !pending)
+    {
+        sl_free(pending);
+        return -1;
+    }
+    ASTFileHeader header = {{'S', 'L', 'A', 'B'}, AST_FILE_VERSION, node_count, list_count, string_size};
+    memcpy(file, &header, sizeof(header));
+
+    int nodes = 0, lists = 0, strings = 0, pending_count = 0;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        int count = ast_child_count(node);
+        if (step < count)
+        {
+            ast_walk_push(&walk, ast_child(node, step), 0);
+            continue;
+        }
+        ast_walk_pop(&walk);
+
+        // the children were written last, in order, with nothing after them
+        int64_t at = node_start + nodes * NODE_SIZE;
+        ASTFileNode record;
+        memset(&record, 0, sizeof(record));
+        record.type = node->type;
+        record.line = node->line;
+        record.column = node->column;
+        int present = 0;
+        for (int i = 0; i < count; i++)
+            present += ast_child(node, i) != NULL;
+        int first = pending_count - present;
+        const char *name = node_name(node);
+        int named = name != NULL;
+        if (named)
+        {
+            record.field[0] = (int32_t)(string_start + strings - at);
+            size_t length = strlen(name) + 1;
+            memcpy(file + string_start + strings, name, length);
+            strings += length;
+        }
+
+        if (node->type == AST_PROGRAM || node->type == AST_BLOCK)
+        {
+            record.field[0] = (int32_t)(list_start + lists * 4 - at);
+            record.field[1] = count;
+            for (int i = 0; i < count; i++)
+            {
+                int32_t offset = (int32_t)(node_start + pending[first + i] * NODE_SIZE - at);
+                memcpy(file + list_start + (lists++) * 4, &offset, 4);
+            }
+        }
+        else if (node->type == AST_NUMBER)
+        {
+            record.field[0] = node->data.number.value;
+        }
+        else
+        {
+            if (node->type == AST_BINARY_OP)
+                record.operator = node->data.binary_op.operator;
+            // named nodes keep field 0 for the name, a declaration may have no value
+            for (int i = 0, next = first; i < count; i++)
+            {
+                if (ast_child(node, i))
+                    record.field[named + i] = (int32_t)(node_start + pending[next++] * NODE_SIZE - at);
+            }
+        }
+        memcpy(file + at, &record, sizeof(record));
+        pending_count = first;
+        pending[pending_count++] = nodes++;
+    }
+    int failed = walk.failed;
+    free_ast_walk(&walk);
+    sl_free(pending);
+    if (failed)
+        return -1;
+    sink_commit(sink, size);
+    return sink->has_error ? -1 : 0;
+}
+
+typedef struct
+{
+    const unsigned char *nodes;
+    int64_t node_count;
+    int64_t list_start; // relative to nodes
+    int64_t list_count;
+    int64_t string_start; // relative to nodes
+    int64_t string_size;
+    unsigned char *has_parent;
+} FileCheck;
+
+// a reference from node index to a child of one of the allowed types, which gets its parent
+static int check_child(FileCheck *check, int64_t index, int32_t offset, unsigned allowed)
+{
+    int64_t target = index * NODE_SIZE + offset;
+    if (offset >= 0 || target < 0 || target % NODE_SIZE != 0)
+        return 0;
+    int64_t child = target / NODE_SIZE;
+    const ASTFileNode *node = (const ASTFileNode *)(check->nodes + target);
+    if (check->has_parent[child] || node->type > AST_EXTERN || !(allowed & TYPE_BIT(node->type)))
+        return 0;
+    check->has_parent[child] = 1;
+    return 1;
+}
+
+// names end up in assembly text, so anything but an identifier makes the file corrupt
+static int check_name(const FileCheck *check, int64_t index, int32_t offset)
+{
+    int64_t target = index * NODE_SIZE + offset - check->string_start;
+    if (target < 0 || target >= check->string_size)
+        return 0;
+    return is_identifier((const char *)check->nodes + check->string_start + target);
+}
+
+static int check_node(FileCheck *check, int64_t index)
+{
+    const ASTFileNode *node = (const ASTFileNode *)(check->nodes + index * NODE_SIZE);
+    const int32_t *field = node->field;
+    int is_root = index == check->node_count - 1;
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+    case AST_BLOCK:
+    {
+        if ((node->type == AST_PROGRAM) != is_root)
+            return 0;
+        int64_t list = index * NODE_SIZE + field[0] - check->list_start;
+        if (field[1] < 0 || list < 0 || list % 4 != 0 || list / 4 + field[1] > check->list_count)
+            return 0;
+        const int32_t *children = (const int32_t *)(check->nodes + check->list_start + list);
+        for (int i = 0; i < field[1]; i++)
+        {
+            if (!check_child(check, index, children[i], is_root ? TOP_LEVEL : STATEMENTS))
+                return 0;
+        }
+        return 1;
+    }
+    case AST_DECLARATION:
+        return check_name(check, index, field[0]) &&
+               (field[1] == 0 || check_child(check, index, field[1], EXPRESSIONS));
+    case AST_ASSIGNMENT:
+        return check_name(check, index, field[0]) && check_child(check, index, field[1], EXPRESSIONS);
+    case AST_IF_STATEMENT:
+        return check_child(check, index, field[0], EXPRESSIONS) &&
+               check_child(check, index, field[1], TYPE_BIT(AST_BLOCK)) &&
+               (field[2] == 0 || check_child(check, index, field[2], TYPE_BIT(AST_BLOCK)));
+    case AST_WHILE_STATEMENT:
+        return check_child(check, index, field[0], EXPRESSIONS) &&
+               check_child(check, index, field[1], TYPE_BIT(AST_BLOCK));
+    case AST_BINARY_OP:
+        if (node->operator != TOKEN_PLUS && node->operator != TOKEN_MINUS && node->operator != TOKEN_STAR &&
+            node->operator != TOKEN_SHIFT_LEFT && node->operator != TOKEN_SHIFT_RIGHT && node->operator != TOKEN_EQUAL)
+            return 0;
+        return check_child(check, index, field[0], EXPRESSIONS) && check_child(check, index, field[1], EXPRESSIONS);
+    case AST_NUMBER:
+        return 1;
+    case AST_IDENTIFIER:
+    case AST_IMPORT:
+    case AST_EXTERN:
+        return check_name(check, index, field[0]);
+    default:
+        return 0;
+    }
+}
+
+const ASTFileNode *check_ast_file(const void *data, size_t size)
+{
+    const ASTFileHeader *header = data;
+    if (size < sizeof(ASTFileHeader) || (uintptr_t)data % 4 != 0 || memcmp(header->magic, "SLAB", 4) != 0 ||
+        header->version != AST_FILE_VERSION || header->node_count == 0)
+        return NULL;
+
+    FileCheck check;
+    check.nodes = (const unsigned char *)data + sizeof(ASTFileHeader);
+    check.node_count = header->node_count;
+    check.list_count = header->list_count;
+    check.string_size = header->string_size;
+    check.list_start = check.node_count * NODE_SIZE;
+    check.string_start = check.list_start + check.list_count * 4;
+    // names end inside the file
+    if ((uint64_t)sizeof(ASTFileHeader) + check.string_start + check.string_size != size ||
+        (check.string_size > 0 && check.nodes[check.string_start + check.string_size - 1] != '\0'))
+        return NULL;
+
+    check.has_parent = sl_calloc(check.node_count, 1);
+    if (!check.has_parent)
+        return NULL;
+    int valid = 1;
+    for (int64_t i = 0; i < check.node_count && valid; i++)
+    {
+        valid = check_node(&check, i);
+    }
+    // and every node but the program hangs off another
+    for (int64_t i = 0; i + 1 < check.node_count && valid; i++)
+    {
+        valid = check.has_parent[i];
+    }
+    sl_free(check.has_parent);
+    const ASTFileNode *root = (const ASTFileNode *)(check.nodes + (check.node_count - 1) * NODE_SIZE);
+    return valid && root->type == AST_PROGRAM ? root : NULL;
+}
+
+ASTFile *map_ast_file(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    ASTFile *file = NULL;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    const ASTFileNode *root = check_ast_file(data, info.st_size);
+    if (root && (file = sl_malloc(sizeof(ASTFile))))
+    {
+        file->data = data;
+        file->size = info.st_size;
+        file->root = root;
+        return file;
+    }
+    munmap(data, info.st_size);
+    return NULL;
+}
+
+void unmap_ast_file(ASTFile *file)
+{
+    if (!file)
+        return;
+    munmap(file->data, file->size);
+    sl_free(file);
+}
+
+static const void *at(const ASTFileNode *node, int32_t offset)
+{
+    return (const unsigned char *)node + offset;
+}
+
+int ast_file_child_count(const ASTFileNode *node)
+{
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+    case AST_BLOCK:
+        return node->field[1];
+    case AST_DECLARATION:
+    case AST_ASSIGNMENT:
+        return 1;
+    case AST_IF_STATEMENT:
+        return 3;
+    case AST_WHILE_STATEMENT:
+    case AST_BINARY_OP:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+const ASTFileNode *ast_file_child(const ASTFileNode *node, int index)
+{
+    int32_t offset;
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+    case AST_BLOCK:
+        offset = ((const int32_t *)at(node, node->field[0]))[index];
+        break;
+    case AST_DECLARATION:
+    case AST_ASSIGNMENT:
+        offset = node->field[1];
+        break;
+    case AST_IF_STATEMENT:
+    case AST_WHILE_STATEMENT:
+    case AST_BINARY_OP:
+        offset = node->field[index];
+        break;
+    default:
+        return NULL;
+    }
+    return offset ? at(node, offset) : NULL;
+}
+
+const char *ast_file_name(const ASTFileNode *node)
+{
+    switch (node->type)
+    {
+    case AST_DECLARATION:
+    case AST_ASSIGNMENT:
+    case AST_IDENTIFIER:
+    case AST_IMPORT:
+    case AST_EXTERN:
+        return at(node, node->field[0]);
+    default:
+        return NULL;
+    }
+}
+
+static ASTNode *built_child(ASTNode **built, const ASTFileNode *nodes, const ASTFileNode *node, int index)
+{
+    const ASTFileNode *child = ast_file_child(node, index);
+    return child ? built[child - nodes] : NULL;
+}
+
+// a program or block with room for all of its statements, NULL when out of memory
+static ASTNode *create_list_node(const ASTFileNode *node)
+{
+    ASTNode *made = node->type == AST_PROGRAM ? create_program_node() : create_block_node();
+    if (made && node->field[1] > made->data.block.capacity)
+    {
+        ASTNode **grown = sl_realloc(made->data.block.statements, sizeof(ASTNode *) * node->field[1]);
+        if (grown)
+        {
+            made->data.block.statements = grown;
+            made->data.block.capacity = node->field[1];
+        }
+        else
+        {
+            sl_free(made->data.block.statements);
+            made->data.block.statements = NULL;
+        }
+    }
+    if (made && !made->data.block.statements)
+    {
+        sl_free(made);
+        return NULL;
+    }
+    return made;
+}
+
+ASTNode *ast_from_file(const void *data)
+{
+    const ASTFileHeader *header = data;
+    const ASTFileNode *nodes = (const ASTFileNode *)(header + 1);
+    int64_t count = header->node_count;
+    ASTNode **built = sl_malloc(sizeof(ASTNode *) * count);
+    unsigned char *owned = sl_calloc(count, 1);
+    if (!built || !owned)
+    {
+        sl_free(built);
+        sl_free(owned);
+        return NULL;
+    }
+
+    // children come first, so each node finds its children built
+    int64_t i;
+    for (i = 0; i < count; i++)
+    {
+        const ASTFileNode *node = &nodes[i];
+        char *name = (char *)ast_file_name(node);
+        ASTNode *made = NULL;
+        switch (node->type)
+        {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            made = create_list_node(node);
+            for (int child = 0; made && child < node->field[1]; child++)
+                made->data.block.statements[child] = built_child(built, nodes, node, child);
+            if (made)
+            {
+                made->data.block.count = node->field[1];
+                made->line = node->line;
+                made->column = node->column;
+            }
+            break;
+        case AST_DECLARATION:
+            made = create_declaration_node(name, built_child(built, nodes, node, 0), node->line, node->column);
+            break;
+        case AST_ASSIGNMENT:
+            made = create_assignment_node(name, built_child(built, nodes, node, 0), node->line, node->column);
+            break;
+        case AST_IF_STATEMENT:
+            made = create_if_node(built_child(built, nodes, node, 0), built_child(built, nodes, node, 1),
+                                  built_child(built, nodes, node, 2), node->line, node->column);
+            break;
+        case AST_WHILE_STATEMENT:
+            made = create_while_node(built_child(built, nodes, node, 0), built_child(built, nodes, node, 1),
+                                     node->line, node->column);
+            break;
+        case AST_BINARY_OP:
+            made = create_binary_op_node(built_child(built, nodes, node, 0), node->operator,
+                                         built_child(built, nodes, node, 1), node->line, node->column);
+            break;
+        case AST_NUMBER:
+            made = create_number_node(node->field[0], node->line, node->column);
+            break;
+        case AST_IDENTIFIER:
+            made = create_identifier_node(name, node->line, node->column);
+            break;
+        case AST_IMPORT:
+            made = create_import_node(name, node->line, node->column);
+            break;
+        case AST_EXTERN:
+            made = create_extern_node(name, node->line, node->column);
+            break;
+        default:
+            break;
+        }
+        built[i] = made;
+        if (!made)
+            break;
+        for (int child = 0; child < ast_file_child_count(node); child++)
+        {
+            const ASTFileNode *owned_child = ast_file_child(node, child);
+            if (owned_child)
+                owned[owned_child - nodes] = 1;
+        }
+    }
+
+    ASTNode *program = i == count ? built[count - 1] : NULL;
+    if (!program)
+    {
+        // out of memory: free every tree built so far that has no parent yet
+        for (int64_t j = 0; j < i; j++)
+        {
+            if (!owned[j])
+                free_ast(built[j]);
+        }
+    }
+    sl_free(built);
+    sl_free(owned);
+    return program;
+}
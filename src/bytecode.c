@@ -0,0 +1,611 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/bytecode.h"
+
+#if defined(__GNUC__) && !defined(SL_NO_COMPUTED_GOTO)
+#define BYTECODE_THREADED 1
+#else
+#define BYTECODE_THREADED 0
+#endif
+
+static const char *op_names[BC_COUNT] = {
+    "halt", "load_const", "load", "store", "push",
+    "add_const", "add_slot", "add_pop",
+    "sub_const", "sub_slot", "sub_pop",
+    "eq_const", "eq_slot", "eq_pop",
+    "mul_const", "mul_slot", "mul_pop",
+    "shl_const", "shl_slot", "shl_pop",
+    "shr_const", "shr_slot", "shr_pop",
+    "jump", "jump_if_zero", "jump_if_nonzero"
+};
+
+int bytecode_operand_count(BytecodeOp op)
+{
+    switch (op)
+    {
+    case BC_HALT:
+    case BC_PUSH:
+    case BC_ADD_POP:
+    case BC_SUB_POP:
+    case BC_EQ_POP:
+    case BC_MUL_POP:
+    case BC_SHL_POP:
+    case BC_SHR_POP:
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+const char *bytecode_op_name(BytecodeOp op)
+{
+    if (op >= BC_COUNT)
+        return "???";
+    return op_names[op];
+}
+
+// compiler state, only lives during compile_bytecode
+typedef struct
+{
+    BytecodeProgram *program;
+    int stack_depth;
+    int has_error;
+} BytecodeCompiler;
+
+static int emit_word(BytecodeCompiler *compiler, int word)
+{
+    BytecodeProgram *program = compiler->program;
+    if (program->count >= program->capacity)
+    {
+        int capacity = program->capacity ? program->capacity * 2 : 64;
+        int *code = realloc(program->code, sizeof(int) * capacity);
+        if (!code)
+        {
+            compiler->has_error = 1;
+            return -1;
+        }
+        program->code = code;
+        program->capacity = capacity;
+    }
+    program->code[program->count] = word;
+    return program->count++;
+}
+
+static void emit_op(BytecodeCompiler *compiler, BytecodeOp op, int operand)
+{
+    emit_word(compiler, op);
+    if (bytecode_operand_count(op))
+        emit_word(compiler, operand);
+}
+
+// emit a jump and return the position of its operand for patching
+static int emit_jump(BytecodeCompiler *compiler, BytecodeOp op)
+{
+    emit_word(compiler, op);
+    return emit_word(compiler, 0);
+}
+
+static void patch_jump(BytecodeCompiler *compiler, int operand_position)
+{
+    if (operand_position >= 0)
+        compiler->program->code[operand_position] = compiler->program->count;
+}
+
+static int slot_of(BytecodeCompiler *compiler, const char *name)
+{
+    int slot = intern_symbol(&compiler->program->symbols, name);
+    if (slot < 0)
+        compiler->has_error = 1;
+    return slot;
+}
+
+// the three forms of an operator: acc <op> constant, acc <op> slot, popped <op> acc
+static int binary_ops(TokenType operator, BytecodeOp *const_op, BytecodeOp *slot_op, BytecodeOp *pop_op)
+{
+    switch (operator)
+    {
+    case TOKEN_PLUS:
+        *const_op = BC_ADD_CONST, *slot_op = BC_ADD_SLOT, *pop_op = BC_ADD_POP;
+        return 0;
+    case TOKEN_MINUS:
+        *const_op = BC_SUB_CONST, *slot_op = BC_SUB_SLOT, *pop_op = BC_SUB_POP;
+        return 0;
+    case TOKEN_EQUAL:
+        *const_op = BC_EQ_CONST, *slot_op = BC_EQ_SLOT, *pop_op = BC_EQ_POP;
+        return 0;
+    case TOKEN_STAR:
+        *const_op = BC_MUL_CONST, *slot_op = BC_MUL_SLOT, *pop_op = BC_MUL_POP;
+        return 0;
+    case TOKEN_SHIFT_LEFT:
+        *const_op = BC_SHL_CONST, *slot_op = BC_SHL_SLOT, *pop_op = BC_SHL_POP;
+        return 0;
+    case TOKEN_SHIFT_RIGHT:
+        *const_op = BC_SHR_CONST, *slot_op = BC_SHR_SLOT, *pop_op = BC_SHR_POP;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// Compile statements and expressions in one walk without recursion (see ASTWalk); an
+// expression leaves its value in the accumulator, an if or while keeps the jump to patch
+// in its frame's value.
+static void compile_tree(BytecodeCompiler *compiler, ASTNode *root)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, root, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !walk.failed)
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        BytecodeOp const_op, slot_op, pop_op;
+        ASTNode *right;
+        switch (node->type)
+        {
+        case AST_NUMBER:
+            emit_op(compiler, BC_LOAD_CONST, node->data.number.value);
+            ast_walk_pop(&walk);
+            break;
+
+        case AST_IDENTIFIER:
+            emit_op(compiler, BC_LOAD, slot_of(compiler, node->data.identifier.name));
+            ast_walk_pop(&walk);
+            break;
+
+        // acc = acc <op> right, using the constant and slot forms when the right side is a leaf
+        case AST_BINARY_OP:
+            right = node->data.binary_op.right;
+            if (binary_ops(node->data.binary_op.operator, &const_op, &slot_op, &pop_op) != 0)
+            {
+                compiler->has_error = 1;
+                ast_walk_pop(&walk);
+            }
+            else if (step == 0)
+            {
+                ast_walk_push(&walk, node->data.binary_op.left, 0);
+            }
+            else if (step == 1 && right->type == AST_NUMBER)
+            {
+                emit_op(compiler, const_op, right->data.number.value);
+                ast_walk_pop(&walk);
+            }
+            else if (step == 1 && right->type == AST_IDENTIFIER)
+            {
+                emit_op(compiler, slot_op, slot_of(compiler, right->data.identifier.name));
+                ast_walk_pop(&walk);
+            }
+            else if (step == 1)
+            {
+                emit_op(compiler, BC_PUSH, 0);
+                if (++compiler->stack_depth > compiler->program->max_stack)
+                    compiler->program->max_stack = compiler->stack_depth;
+                ast_walk_push(&walk, right, 0);
+            }
+            else
+            {
+                emit_op(compiler, pop_op, 0);
+                compiler->stack_depth--;
+                ast_walk_pop(&walk);
+            }
+            break;
+
+        case AST_DECLARATION:
+            if (step == 0)
+            {
+                frame->value = slot_of(compiler, node->data.declaration.var_name);
+                if (node->data.declaration.init_value)
+                    ast_walk_push(&walk, node->data.declaration.init_value, 0);
+                else
+                    ast_walk_pop(&walk);
+            }
+            else
+            {
+                emit_op(compiler, BC_STORE, frame->value);
+                ast_walk_pop(&walk);
+            }
+            break;
+
+        case AST_ASSIGNMENT:
+            if (step == 0)
+            {
+                ast_walk_push(&walk, node->data.assignment.value, 0);
+            }
+            else
+            {
+                emit_op(compiler, BC_STORE, slot_of(compiler, node->data.assignment.var_name));
+                ast_walk_pop(&walk);
+            }
+            break;
+
+        case AST_IF_STATEMENT:
+            if (step == 0)
+            {
+                ast_walk_push(&walk, node->data.if_stmt.condition, 0);
+            }
+            else if (step == 1)
+            {
+                frame->value = emit_jump(compiler, BC_JUMP_IF_ZERO);
+                ast_walk_push(&walk, node->data.if_stmt.then_block, 0);
+            }
+            else if (step == 2 && node->data.if_stmt.else_block)
+            {
+                int end_jump = emit_jump(compiler, BC_JUMP);
+                patch_jump(compiler, frame->value);
+                frame->value = end_jump;
+                ast_walk_push(&walk, node->data.if_stmt.else_block, 0);
+            }
+            else
+            {
+                // past the then block with no else, or past the else block
+                patch_jump(compiler, frame->value);
+                ast_walk_pop(&walk);
+            }
+            break;
+
+        // the condition sits after the body, so each iteration takes one backward jump:
+        // jump cond; body: ...; cond: ...; jump_if_nonzero body
+        case AST_WHILE_STATEMENT:
+            if (step == 0)
+            {
+                frame->value = emit_jump(compiler, BC_JUMP);
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+            }
+            else if (step == 1)
+            {
+                patch_jump(compiler, frame->value);
+                ast_walk_push(&walk, node->data.while_stmt.condition, 0);
+            }
+            else
+            {
+                emit_op(compiler, BC_JUMP_IF_NONZERO, frame->value + 1);
+                ast_walk_pop(&walk);
+            }
+            break;
+
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            if (step < node->data.block.count)
+                ast_walk_push(&walk, node->data.block.statements[step], 0);
+            else
+                ast_walk_pop(&walk);
+            break;
+
+        default:
+            compiler->has_error = 1;
+            ast_walk_pop(&walk);
+            break;
+        }
+    }
+
+    if (walk.failed)
+        compiler->has_error = 1;
+    free_ast_walk(&walk);
+}
+
+BytecodeProgram *compile_bytecode(ASTNode *ast)
+{
+    BytecodeProgram *program = calloc(1, sizeof(BytecodeProgram));
+    if (!program)
+        return NULL;
+    init_symbol_table(&program->symbols);
+
+    BytecodeCompiler compiler = {program, 0, 0};
+    if (ast && ast->type == AST_PROGRAM)
+        compile_tree(&compiler, ast);
+    emit_op(&compiler, BC_HALT, 0);
+
+    if (compiler.has_error)
+    {
+        free_bytecode(program);
+        return NULL;
+    }
+    return program;
+}
+
+void free_bytecode(BytecodeProgram *program)
+{
+    if (program)
+    {
+        free(program->code);
+        free_symbol_table(&program->symbols);
+        free(program);
+    }
+}
+
+// wrapping 32-bit arithmetic without signed overflow
+#define WRAP_ADD(x, y) ((int)((unsigned int)(x) + (unsigned int)(y)))
+#define WRAP_SUB(x, y) ((int)((unsigned int)(x) - (unsigned int)(y)))
+#define WRAP_MUL(x, y) ((int)((unsigned int)(x) * (unsigned int)(y)))
+#define WRAP_SHL(x, y) ((int)((unsigned int)(x) << ((y) & 31)))
+#define SHIFT_RIGHT(x, y) ((x) >> ((y) & 31))
+
+#if BYTECODE_THREADED
+// translate opcodes into handler addresses and jump targets into code pointers once,
+// then every instruction ends with an indirect jump straight to the next handler
+static int execute_threaded(const BytecodeProgram *program, int *slots, int *stack, long long budget)
+{
+    static void *handlers[BC_COUNT] = {
+        &&op_halt, &&op_load_const, &&op_load, &&op_store, &&op_push,
+        &&op_add_const, &&op_add_slot, &&op_add_pop,
+        &&op_sub_const, &&op_sub_slot, &&op_sub_pop,
+        &&op_eq_const, &&op_eq_slot, &&op_eq_pop,
+        &&op_mul_const, &&op_mul_slot, &&op_mul_pop,
+        &&op_shl_const, &&op_shl_slot, &&op_shl_pop,
+        &&op_shr_const, &&op_shr_slot, &&op_shr_pop,
+        &&op_jump, &&op_jump_if_zero, &&op_jump_if_nonzero
+    };
+
+    void **threaded = malloc(sizeof(void *) * (program->count + 1));
+    if (!threaded)
+        return 1;
+    for (int pc = 0; pc < program->count;)
+    {
+        BytecodeOp op = (BytecodeOp)program->code[pc];
+        threaded[pc] = handlers[op];
+        if (bytecode_operand_count(op))
+        {
+            int operand = program->code[pc + 1];
+            if (op == BC_JUMP || op == BC_JUMP_IF_ZERO || op == BC_JUMP_IF_NONZERO)
+                threaded[pc + 1] = &threaded[operand];
+            else
+                threaded[pc + 1] = (void *)(intptr_t)operand;
+        }
+        pc += 1 + bytecode_operand_count(op);
+    }
+
+    void **ip = threaded;
+    int acc = 0;
+    int *sp = stack;
+
+#define DISPATCH() goto **ip++
+#define OPERAND() ((int)(intptr_t)*ip++)
+
+    DISPATCH();
+op_load_const:
+    acc = OPERAND();
+    DISPATCH();
+op_load:
+    acc = slots[OPERAND()];
+    DISPATCH();
+op_store:
+    slots[OPERAND()] = acc;
+    DISPATCH();
+op_push:
+    *sp++ = acc;
+    DISPATCH();
+op_add_const:
+    acc = WRAP_ADD(acc, OPERAND());
+    DISPATCH();
+op_add_slot:
+    acc = WRAP_ADD(acc, slots[OPERAND()]);
+    DISPATCH();
+op_add_pop:
+    acc = WRAP_ADD(*--sp, acc);
+    DISPATCH();
+op_sub_const:
+    acc = WRAP_SUB(acc, OPERAND());
+    DISPATCH();
+op_sub_slot:
+    acc = WRAP_SUB(acc, slots[OPERAND()]);
+    DISPATCH();
+op_sub_pop:
+    acc = WRAP_SUB(*--sp, acc);
+    DISPATCH();
+op_eq_const:
+    acc = acc == OPERAND();
+    DISPATCH();
+op_eq_slot:
+    acc = acc == slots[OPERAND()];
+    DISPATCH();
+op_eq_pop:
+    acc = *--sp == acc;
+    DISPATCH();
+op_mul_const:
+    acc = WRAP_MUL(acc, OPERAND());
+    DISPATCH();
+op_mul_slot:
+    acc = WRAP_MUL(acc, slots[OPERAND()]);
+    DISPATCH();
+op_mul_pop:
+    acc = WRAP_MUL(*--sp, acc);
+    DISPATCH();
+op_shl_const:
+    acc = WRAP_SHL(acc, OPERAND());
+    DISPATCH();
+op_shl_slot:
+    acc = WRAP_SHL(acc, slots[OPERAND()]);
+    DISPATCH();
+op_shl_pop:
+    acc = WRAP_SHL(*--sp, acc);
+    DISPATCH();
+op_shr_const:
+    acc = SHIFT_RIGHT(acc, OPERAND());
+    DISPATCH();
+op_shr_slot:
+    acc = SHIFT_RIGHT(acc, slots[OPERAND()]);
+    DISPATCH();
+op_shr_pop:
+    acc = SHIFT_RIGHT(*--sp, acc);
+    DISPATCH();
+op_jump:
+    ip = (void **)*ip;
+    DISPATCH();
+op_jump_if_zero:
+    if (acc == 0)
+        ip = (void **)*ip;
+    else
+        ip++;
+    DISPATCH();
+op_jump_if_nonzero:
+    if (acc != 0)
+    {
+        if (budget-- == 0)
+        {
+            free(threaded);
+            return RUN_LIMIT_REACHED;
+        }
+        ip = (void **)*ip;
+    }
+    else
+    {
+        ip++;
+    }
+    DISPATCH();
+op_halt:
+    free(threaded);
+    return 0;
+
+#undef DISPATCH
+#undef OPERAND
+}
+#else
+// portable interpreter loop
+static int execute_switch(const BytecodeProgram *program, int *slots, int *stack, long long budget)
+{
+    const int *code = program->code;
+    int pc = 0;
+    int acc = 0;
+    int *sp = stack;
+
+    for (;;)
+    {
+        switch ((BytecodeOp)code[pc++])
+        {
+        case BC_HALT:
+            return 0;
+        case BC_LOAD_CONST:
+            acc = code[pc++];
+            break;
+        case BC_LOAD:
+            acc = slots[code[pc++]];
+            break;
+        case BC_STORE:
+            slots[code[pc++]] = acc;
+            break;
+        case BC_PUSH:
+            *sp++ = acc;
+            break;
+        case BC_ADD_CONST:
+            acc = WRAP_ADD(acc, code[pc++]);
+            break;
+        case BC_ADD_SLOT:
+            acc = WRAP_ADD(acc, slots[code[pc++]]);
+            break;
+        case BC_ADD_POP:
+            acc = WRAP_ADD(*--sp, acc);
+            break;
+        case BC_SUB_CONST:
+            acc = WRAP_SUB(acc, code[pc++]);
+            break;
+        case BC_SUB_SLOT:
+            acc = WRAP_SUB(acc, slots[code[pc++]]);
+            break;
+        case BC_SUB_POP:
+            acc = WRAP_SUB(*--sp, acc);
+            break;
+        case BC_EQ_CONST:
+            acc = acc == code[pc++];
+            break;
+        case BC_EQ_SLOT:
+            acc = acc == slots[code[pc++]];
+            break;
+        case BC_EQ_POP:
+            acc = *--sp == acc;
+            break;
+        case BC_MUL_CONST:
+            acc = WRAP_MUL(acc, code[pc++]);
+            break;
+        case BC_MUL_SLOT:
+            acc = WRAP_MUL(acc, slots[code[pc++]]);
+            break;
+        case BC_MUL_POP:
+            acc = WRAP_MUL(*--sp, acc);
+            break;
+        case BC_SHL_CONST:
+            acc = WRAP_SHL(acc, code[pc++]);
+            break;
+        case BC_SHL_SLOT:
+            acc = WRAP_SHL(acc, slots[code[pc++]]);
+            break;
+        case BC_SHL_POP:
+            acc = WRAP_SHL(*--sp, acc);
+            break;
+        case BC_SHR_CONST:
+            acc = SHIFT_RIGHT(acc, code[pc++]);
+            break;
+        case BC_SHR_SLOT:
+            acc = SHIFT_RIGHT(acc, slots[code[pc++]]);
+            break;
+        case BC_SHR_POP:
+            acc = SHIFT_RIGHT(*--sp, acc);
+            break;
+        case BC_JUMP:
+            pc = code[pc];
+            break;
+        case BC_JUMP_IF_ZERO:
+            pc = acc == 0 ? code[pc] : pc + 1;
+            break;
+        case BC_JUMP_IF_NONZERO:
+            if (acc != 0 && budget-- == 0)
+                return RUN_LIMIT_REACHED;
+            pc = acc != 0 ? code[pc] : pc + 1;
+            break;
+        default:
+            return 1;
+        }
+    }
+}
+#endif
+
+int run_bytecode(const BytecodeProgram *program, int *slots, long long max_iterations)
+{
+    int *stack = malloc(sizeof(int) * (program->max_stack + 1));
+    if (!stack)
+        return 1;
+
+    // a loop body is only entered by the jump_if_nonzero after its condition (the first
+    // time too), so counting those taken counts iterations
+    long long budget = max_iterations > 0 ? max_iterations : LLONG_MAX;
+#if BYTECODE_THREADED
+    int result = execute_threaded(program, slots, stack, budget);
+#else
+    int result = execute_switch(program, slots, stack, budget);
+#endif
+    free(stack);
+    return result;
+}
+
+void print_bytecode(FILE *stream, const BytecodeProgram *program)
+{
+    for (int pc = 0; pc < program->count;)
+    {
+        BytecodeOp op = (BytecodeOp)program->code[pc];
+        fprintf(stream, "%6d  %-12s", pc, bytecode_op_name(op));
+        if (bytecode_operand_count(op))
+        {
+            int operand = program->code[pc + 1];
+            if (op == BC_LOAD || op == BC_STORE || op == BC_ADD_SLOT ||
+                op == BC_SUB_SLOT || op == BC_EQ_SLOT || op == BC_MUL_SLOT ||
+                op == BC_SHL_SLOT || op == BC_SHR_SLOT)
+                fprintf(stream, " %s", symbol_name(&program->symbols, operand));
+            else
+                fprintf(stream, " %d", operand);
+        }
+        fprintf(stream, "\n");
+        pc += 1 + bytecode_operand_count(op);
+    }
+}
+
+void write_bytecode_variables(OutputSink *sink, const BytecodeProgram *program, const int *slots)
+{
+    for (int i = 0; i < program->symbols.count; i++)
+    {
+        sink_printf(sink, "%s = %d\n", symbol_name(&program->symbols, i), slots[i]);
+    }
+}
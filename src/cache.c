@@ -0,0 +1,370 @@
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/cache.h"
+
+// bump when the entry layout or the meaning of the key changes
+#define CACHE_FORMAT "simplelang-cache-1"
+#define ENTRY_MAGIC "SLC1"
+#define ENTRY_HEADER_SIZE 16 // magic padded to 8 bytes, then the payload length little-endian
+#define KEY_NAME_LENGTH 16   // entries are named by the key in hex
+#define TEMP_PREFIX "tmp."
+#define STALE_TEMP_SECONDS 600 // a store in progress never takes this long
+
+typedef struct
+{
+    char *path;
+    off_t size;
+    struct timespec used;
+} CacheEntry;
+
+static pthread_once_t compiler_once = PTHREAD_ONCE_INIT;
+static uint64_t compiler_hash;
+
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// whole file into a malloc'ed buffer, binary safe
+static char *read_all(const char *path, size_t *length)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    size_t capacity = 4096;
+    size_t used = 0;
+    char *buffer = malloc(capacity);
+    while (buffer)
+    {
+        if (used == capacity)
+        {
+            char *grown = realloc(buffer, capacity * 2);
+            if (!grown)
+            {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, buffer + used, capacity - used);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            free(buffer);
+            buffer = NULL;
+        }
+        else if (n == 0)
+        {
+            break;
+        }
+        else
+        {
+            used += (size_t)n;
+        }
+    }
+    close(fd);
+    *length = used;
+    return buffer;
+}
+
+// the running compiler's own bytes, so any rebuild starts from an empty cache
+static void hash_compiler(void)
+{
+    size_t length;
+    char *image = read_all("/proc/self/exe", &length);
+    compiler_hash = hash_bytes(HASH_SEED, CACHE_FORMAT, strlen(CACHE_FORMAT));
+    if (image)
+        compiler_hash = hash_bytes(compiler_hash, image, length);
+    free(image);
+}
+
+uint64_t compiler_fingerprint(void)
+{
+    pthread_once(&compiler_once, hash_compiler);
+    return compiler_hash;
+}
+
+Cache *open_cache(const char *directory, size_t size_limit)
+{
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST)
+        return NULL;
+    struct stat info;
+    if (stat(directory, &info) != 0 || !S_ISDIR(info.st_mode))
+        return NULL;
+
+    Cache *cache = calloc(1, sizeof(Cache));
+    if (!cache)
+        return NULL;
+    cache->directory = strdup(directory);
+    if (!cache->directory)
+    {
+        free(cache);
+        return NULL;
+    }
+    cache->size_limit = size_limit;
+    cache->compiler_hash = compiler_fingerprint();
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+void close_cache(Cache *cache)
+{
+    if (!cache)
+        return;
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->directory);
+    free(cache);
+}
+
+// <directory>/<key in hex>, caller frees
+static char *entry_path(Cache *cache, uint64_t key)
+{
+    size_t length = strlen(cache->directory) + 1 + KEY_NAME_LENGTH + 1;
+    char *path = malloc(length);
+    if (path)
+        snprintf(path, length, "%s/%016llx", cache->directory, (unsigned long long)key);
+    return path;
+}
+
+static void count(Cache *cache, int *counter)
+{
+    pthread_mutex_lock(&cache->lock);
+    (*counter)++;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+char *cache_lookup(Cache *cache, uint64_t key, size_t *length)
+{
+    char *path = entry_path(cache, key);
+    size_t size = 0;
+    char *entry = path ? read_all(path, &size) : NULL;
+
+    char *data = NULL;
+    if (entry && size >= ENTRY_HEADER_SIZE && memcmp(entry, ENTRY_MAGIC, 4) == 0)
+    {
+        uint64_t stored = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            stored |= (uint64_t)(unsigned char)entry[8 + i] << (8 * i);
+        }
+        // a short entry is damaged, treat it as missing
+        if (stored == size - ENTRY_HEADER_SIZE)
+        {
+            data = malloc(stored + 1);
+            if (data)
+            {
+                memcpy(data, entry + ENTRY_HEADER_SIZE, stored);
+                data[stored] = '\0';
+                *length = stored;
+                // a hit makes the entry the most recently used one
+                utimensat(AT_FDCWD, path, NULL, 0);
+            }
+        }
+    }
+    free(entry);
+    free(path);
+    count(cache, data ? &cache->hits : &cache->misses);
+    return data;
+}
+
+static int write_fully(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+int cache_store(Cache *cache, uint64_t key, const char *data, size_t length)
+{
+    char *path = entry_path(cache, key);
+    if (!path)
+        return -1;
+    size_t temp_length = strlen(cache->directory) + sizeof("/" TEMP_PREFIX "XXXXXX");
+    char *temp = malloc(temp_length);
+    if (!temp)
+    {
+        free(path);
+        return -1;
+    }
+    snprintf(temp, temp_length, "%s/" TEMP_PREFIX "XXXXXX", cache->directory);
+
+    int result = -1;
+    int fd = mkstemp(temp);
+    if (fd >= 0)
+    {
+        char header[ENTRY_HEADER_SIZE] = ENTRY_MAGIC;
+        for (int i = 0; i < 8; i++)
+        {
+            header[8 + i] = (char)((uint64_t)length >> (8 * i));
+        }
+        result = write_fully(fd, header, sizeof(header)) == 0 && write_fully(fd, data, length) == 0 ? 0 : -1;
+        if (close(fd) != 0)
+            result = -1;
+        // mkstemp creates the file owner-only; entries are as readable as the directory
+        if (result == 0)
+            chmod(temp, 0644);
+        // readers see the old entry or the new one, never a partial write
+        if (result == 0 && rename(temp, path) != 0)
+            result = -1;
+        if (result != 0)
+            unlink(temp);
+    }
+    free(temp);
+    free(path);
+    if (result == 0)
+        count(cache, &cache->stores);
+    return result;
+}
+
+int cache_store_file(Cache *cache, uint64_t key, const char *path)
+{
+    size_t length;
+    char *data = read_all(path, &length);
+    if (!data)
+        return -1;
+    int result = cache_store(cache, key, data, length);
+    free(data);
+    return result;
+}
+
+static int is_entry_name(const char *name)
+{
+    if (strlen(name) != KEY_NAME_LENGTH)
+        return 0;
+    for (const char *p = name; *p; p++)
+    {
+        if (!((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'f')))
+            return 0;
+    }
+    return 1;
+}
+
+static int is_temp_name(const char *name)
+{
+    return strncmp(name, TEMP_PREFIX, strlen(TEMP_PREFIX)) == 0 && strlen(name) == strlen(TEMP_PREFIX) + 6;
+}
+
+// a temporary file left behind by a compiler killed in the middle of a store
+static void remove_stale_temp(Cache *cache, const char *name, time_t now)
+{
+    size_t length = strlen(cache->directory) + 1 + strlen(name) + 1;
+    char *path = malloc(length);
+    if (!path)
+        return;
+    snprintf(path, length, "%s/%s", cache->directory, name);
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISREG(info.st_mode) && now - info.st_mtime > STALE_TEMP_SECONDS)
+        unlink(path);
+    free(path);
+}
+
+static int compare_used(const void *a, const void *b)
+{
+    const CacheEntry *left = a;
+    const CacheEntry *right = b;
+    if (left->used.tv_sec != right->used.tv_sec)
+        return left->used.tv_sec < right->used.tv_sec ? -1 : 1;
+    if (left->used.tv_nsec != right->used.tv_nsec)
+        return left->used.tv_nsec < right->used.tv_nsec ? -1 : 1;
+    return strcmp(left->path, right->path);
+}
+
+int cache_trim(Cache *cache)
+{
+    DIR *dir = opendir(cache->directory);
+    if (!dir)
+        return 0;
+
+    CacheEntry *entries = NULL;
+    int entry_count = 0;
+    int capacity = 0;
+    size_t total = 0;
+    time_t now = time(NULL);
+    struct dirent *item;
+    while ((item = readdir(dir)))
+    {
+        if (is_temp_name(item->d_name))
+            remove_stale_temp(cache, item->d_name, now);
+        if (!is_entry_name(item->d_name))
+            continue;
+        if (entry_count == capacity)
+        {
+            int grown_capacity = capacity ? capacity * 2 : 64;
+            CacheEntry *grown = realloc(entries, sizeof(CacheEntry) * grown_capacity);
+            if (!grown)
+                break;
+            entries = grown;
+            capacity = grown_capacity;
+        }
+        size_t length = strlen(cache->directory) + 1 + KEY_NAME_LENGTH + 1;
+        char *path = malloc(length);
+        struct stat info;
+        if (!path)
+            break;
+        snprintf(path, length, "%s/%s", cache->directory, item->d_name);
+        if (stat(path, &info) != 0)
+        {
+            // evicted by someone else meanwhile
+            free(path);
+            continue;
+        }
+        entries[entry_count].path = path;
+        entries[entry_count].size = info.st_size;
+        entries[entry_count].used = info.st_mtim;
+        entry_count++;
+        total += (size_t)info.st_size;
+    }
+    closedir(dir);
+
+    int evicted = 0;
+    if (total > cache->size_limit)
+    {
+        qsort(entries, entry_count, sizeof(CacheEntry), compare_used);
+        for (int i = 0; i < entry_count && total > cache->size_limit; i++)
+        {
+            if (unlink(entries[i].path) == 0 || errno == ENOENT)
+            {
+                total -= (size_t)entries[i].size;
+                evicted++;
+            }
+        }
+    }
+    for (int i = 0; i < entry_count; i++)
+    {
+        free(entries[i].path);
+    }
+    free(entries);
+
+    pthread_mutex_lock(&cache->lock);
+    cache->evictions += evicted;
+    cache->total_size = total;
+    cache->entry_count = entry_count - evicted;
+    pthread_mutex_unlock(&cache->lock);
+    return evicted;
+}
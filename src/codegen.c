@@ -1,137 +1,2018 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../include/codegen.h"
+#include "../include/range.h"
+#include "../include/slots.h"
+#include "../include/allocator.h"
+#include "../include/timing.h"
+
+static const char *opcode_names[OP_COUNT] = {
+    "ldi", "lda", "sta", "push", "pop", "mov", "add", "sub", "adc", "sbc", "cmp", "shl", "shr",
+    "jmp", "jz", "jnz", "jnc", "call", "ret", "hlt", "label"
+};
+
+static const char *register_names[] = {"A", "B", "C", "D", "E", "F", "G"};
 
 CodeGenerator *create_codegen() {
-    CodeGenerator *gen = malloc(sizeof(CodeGenerator));
-    gen->instructions = malloc(sizeof(char*) * 100);
+    CodeGenerator *gen = sl_malloc(sizeof(CodeGenerator));
+    if (!gen) return NULL;
+    gen->instructions = sl_malloc(sizeof(Instruction) * 100);
+    gen->positions = sl_malloc(sizeof(SourcePosition) * 100);
+    if (!gen->instructions || !gen->positions) {
+        sl_free(gen->instructions);
+        sl_free(gen->positions);
+        sl_free(gen);
+        return NULL;
+    }
     gen->count = 0;
     gen->capacity = 100;
+    gen->position.line = 0;
+    gen->position.column = 0;
+    init_symbol_table(&gen->symbols);
+    init_symbol_table(&gen->wide);
+    init_symbol_table(&gen->externs);
+    init_symbol_table(&gen->imports);
+    gen->label_count = 0;
+    for (int i = 0; i < RUNTIME_COUNT; i++) {
+        gen->runtime_label[i] = -1;
+        gen->return_sites[i] = NULL;
+        gen->return_site_count[i] = 0;
+    }
+    gen->shared_globals = 0;
+    gen->has_error = 0;
+    gen->out_of_memory = 0;
+    gen->error_message[0] = '\0';
+    gen->keep_loop_values = 1;
+    gen->chain_multiplies = 1;
+    gen->extended_isa = 0;
+    gen->loop_values = 0;
+    gen->chained_multiplies = 0;
+    gen->analysis_nanoseconds = 0;
+    gen->loop_nanoseconds = 0;
+    gen->chain_nanoseconds = 0;
+    gen->data_slot = NULL;
+    gen->dead_at_exit = NULL;
     return gen;
 }
 
-void emit_instruction(CodeGenerator *gen, const char *instruction) {
+int emit_instruction(CodeGenerator *gen, Opcode opcode,
+                     OperandKind kind0, int operand0,
+                     OperandKind kind1, int operand1) {
     if (gen->count >= gen->capacity) {
+        // both arrays grow before either is used at the new capacity, so a failure
+        // leaves them in step
+        Instruction *grown = sl_realloc(gen->instructions, sizeof(Instruction) * gen->capacity * 2);
+        if (grown) gen->instructions = grown;
+        SourcePosition *positions = grown ? sl_realloc(gen->positions, sizeof(SourcePosition) * gen->capacity * 2) : NULL;
+        if (!positions) {
+            gen->out_of_memory = 1;
+            return -1;
+        }
+        gen->positions = positions;
         gen->capacity *= 2;
-        gen->instructions = realloc(gen->instructions, sizeof(char*) * gen->capacity);
-    }
-    gen->instructions[gen->count] = malloc(strlen(instruction) + 1);
-    strcpy(gen->instructions[gen->count], instruction);
-    gen->count++;
-}
-
-void generate_expression(CodeGenerator *gen, ASTNode *expr) {
-    if (!expr) return;
-    
-    switch (expr->type) {
-        case AST_NUMBER:
-            {
-                char instr[32];
-                snprintf(instr, 32, "ldi A %d", expr->data.number.value);
-                emit_instruction(gen, instr);
+    }
+    gen->positions[gen->count] = gen->position;
+    Instruction *inst = &gen->instructions[gen->count];
+    inst->opcode = (unsigned char)opcode;
+    inst->operand_kind[0] = (unsigned char)kind0;
+    inst->operand_kind[1] = (unsigned char)kind1;
+    inst->operand[0] = operand0;
+    inst->operand[1] = operand1;
+    return gen->count++;
+}
+
+// shorthands for the operand shapes the generator actually uses
+static void emit_none(CodeGenerator *gen, Opcode opcode) {
+    emit_instruction(gen, opcode, OPERAND_NONE, 0, OPERAND_NONE, 0);
+}
+
+static void emit_reg(CodeGenerator *gen, Opcode opcode, Register reg) {
+    emit_instruction(gen, opcode, OPERAND_REGISTER, reg, OPERAND_NONE, 0);
+}
+
+static void emit_mov(CodeGenerator *gen, Register dst, Register src) {
+    emit_instruction(gen, OP_MOV, OPERAND_REGISTER, dst, OPERAND_REGISTER, src);
+}
+
+static void emit_ldi(CodeGenerator *gen, Register reg, int value) {
+    emit_instruction(gen, OP_LDI, OPERAND_REGISTER, reg, OPERAND_IMMEDIATE, value);
+}
+
+// the symbol id of a variable, interning it on first use
+static int symbol_id(CodeGenerator *gen, const char *name) {
+    int id = intern_symbol(&gen->symbols, name);
+    if (id < 0) gen->out_of_memory = 1;
+    return id;
+}
+
+static void emit_symbol(CodeGenerator *gen, Opcode opcode, const char *name) {
+    int id = symbol_id(gen, name);
+    if (id >= 0) emit_instruction(gen, opcode, OPERAND_SYMBOL, id, OPERAND_NONE, 0);
+}
+
+// lda or sta of the high byte of a two byte slot
+static void emit_high_byte(CodeGenerator *gen, Opcode opcode, const char *name) {
+    int id = symbol_id(gen, name);
+    if (id >= 0) emit_instruction(gen, opcode, OPERAND_SYMBOL, id, OPERAND_IMMEDIATE, 1);
+}
+
+// jmp, jz, jnz or the label itself
+static void emit_label(CodeGenerator *gen, Opcode opcode, int label) {
+    emit_instruction(gen, opcode, OPERAND_LABEL, label, OPERAND_NONE, 0);
+}
+
+static void emit_inline_routine(CodeGenerator *gen, RuntimeRoutine routine);
+
+// call a runtime routine, which is then emitted after the program. Without the extension
+// there is no call: the id of the label after a jmp to the routine goes in the return
+// slot, for the routine to jump back to. An object's routines come from the linker,
+// which only has called ones, so its code goes here instead, as it does past the last id
+static void emit_call(CodeGenerator *gen, RuntimeRoutine routine) {
+    int site = gen->return_site_count[routine];
+    if (!gen->extended_isa && (gen->shared_globals || site == RUNTIME_SITES_MAX)) {
+        emit_inline_routine(gen, routine);
+        return;
+    }
+    if (gen->runtime_label[routine] < 0) gen->runtime_label[routine] = gen->label_count++;
+    if (gen->extended_isa) {
+        emit_label(gen, OP_CALL, gen->runtime_label[routine]);
+        return;
+    }
+    if (!gen->return_sites[routine]) {
+        gen->return_sites[routine] = sl_malloc(sizeof(int) * RUNTIME_SITES_MAX);
+        if (!gen->return_sites[routine]) {
+            gen->out_of_memory = 1;
+            return;
+        }
+    }
+    gen->return_sites[routine][site] = gen->label_count++;
+    gen->return_site_count[routine]++;
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_ldi(gen, REG_A, site);
+    emit_symbol(gen, OP_STA, RUNTIME_RETURN_SLOT);
+    emit_reg(gen, OP_POP, REG_A);
+    emit_label(gen, OP_JMP, gen->runtime_label[routine]);
+    emit_label(gen, OP_LABEL, gen->return_sites[routine][site]);
+    emit_reg(gen, OP_POP, REG_A);
+}
+
+// the end of a routine entered by jmp: back to the site whose id is in the return slot,
+// with A pushed there and popped at the site
+static void emit_return_dispatch(CodeGenerator *gen, RuntimeRoutine routine) {
+    int count = gen->return_site_count[routine];
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_symbol(gen, OP_LDA, RUNTIME_RETURN_SLOT);
+    for (int site = 0; site < count - 1; site++) {
+        emit_ldi(gen, REG_B, site);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JZ, gen->return_sites[routine][site]);
+    }
+    emit_label(gen, OP_JMP, gen->return_sites[routine][count - 1]);
+}
+
+// A = A * B by shifting and adding, one round per bit of the multiplier in E:
+// C doubles the multiplicand and D sums the product
+static void emit_multiply_routine(CodeGenerator *gen) {
+    int loop = gen->label_count, skip = loop + 1, done = loop + 2;
+    gen->label_count += 3;
+    emit_reg(gen, OP_PUSH, REG_C);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_mov(gen, REG_C, REG_A);
+    emit_mov(gen, REG_E, REG_B);
+    emit_ldi(gen, REG_D, 0);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_E);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_none(gen, OP_SHR); // the multiplier's low bit goes to carry
+    emit_mov(gen, REG_E, REG_A);
+    emit_label(gen, OP_JNC, skip);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_C);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_D, REG_A);
+    emit_label(gen, OP_LABEL, skip);
+    emit_mov(gen, REG_A, REG_C);
+    emit_none(gen, OP_SHL);
+    emit_mov(gen, REG_C, REG_A);
+    emit_label(gen, OP_JMP, loop);
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+    emit_reg(gen, OP_POP, REG_C);
+}
+
+// A = A shifted B times by shl or shr, the value kept in D and the count in C
+static void emit_shift_routine(CodeGenerator *gen, Opcode shift) {
+    int loop = gen->label_count, done = loop + 1;
+    gen->label_count += 2;
+    emit_reg(gen, OP_PUSH, REG_C);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_C, REG_B);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_C, REG_A);
+    emit_mov(gen, REG_A, REG_D);
+    emit_none(gen, shift);
+    emit_mov(gen, REG_D, REG_A);
+    emit_label(gen, OP_JMP, loop);
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_D);
+    emit_reg(gen, OP_POP, REG_C);
+}
+
+// the two byte value in low:high doubled, by add and adc; clobbers A and B
+static void emit_double(CodeGenerator *gen, Register low, Register high) {
+    emit_mov(gen, REG_A, low);
+    emit_mov(gen, REG_B, low);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, low, REG_A);
+    emit_mov(gen, REG_A, high);
+    emit_mov(gen, REG_B, high);
+    emit_none(gen, OP_ADC);
+    emit_mov(gen, high, REG_A);
+}
+
+// A:G = A:G * B:C. Only the low byte of the cross products reaches the result, so they
+// come from the byte routine; the full product of the low bytes is shifted and added in
+// D:E with the multiplicand doubling in F:G and the multiplier's bits in C
+static void emit_multiply_wide_routine(CodeGenerator *gen) {
+    int loop = gen->label_count, skip = loop + 1, done = loop + 2;
+    gen->label_count += 3;
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_reg(gen, OP_PUSH, REG_F);
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_reg(gen, OP_PUSH, REG_B);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_A, REG_G);
+    emit_call(gen, RUNTIME_MULTIPLY);
+    emit_mov(gen, REG_E, REG_A);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_C);
+    emit_call(gen, RUNTIME_MULTIPLY);
+    emit_mov(gen, REG_B, REG_E);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_E, REG_A);
+    emit_reg(gen, OP_POP, REG_C);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_ldi(gen, REG_G, 0);
+    emit_ldi(gen, REG_D, 0);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_none(gen, OP_SHR);
+    emit_mov(gen, REG_C, REG_A);
+    emit_label(gen, OP_JNC, skip);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_F);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_A, REG_E);
+    emit_mov(gen, REG_B, REG_G);
+    emit_none(gen, OP_ADC);
+    emit_mov(gen, REG_E, REG_A);
+    emit_label(gen, OP_LABEL, skip);
+    emit_double(gen, REG_F, REG_G);
+    emit_label(gen, OP_JMP, loop);
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_G, REG_E);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+}
+
+// A:G = A:G << B:C, or >> (arithmetic): a count of 16 or more, as an unsigned value,
+// shifts every bit out. The value is kept in D:G, the count in F and, for >>, the sign
+// bit to shift in in E; a right shift moves the high byte's low bit into the low byte
+static void emit_shift_wide_routine(CodeGenerator *gen, int right) {
+    int loop = gen->label_count, fill = loop + 1, done = loop + 2, negative = loop + 3;
+    int low = loop + 4, zero = loop + 5;
+    gen->label_count += 6;
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_reg(gen, OP_PUSH, REG_F);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_F, REG_B);
+    emit_ldi(gen, REG_E, right ? 128 : 0);
+    if (right) {
+        // carry is clear when the high byte is 128 or more
+        emit_mov(gen, REG_A, REG_G);
+        emit_ldi(gen, REG_B, 128);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JNC, negative);
+        emit_ldi(gen, REG_E, 0);
+        emit_label(gen, OP_LABEL, negative);
+    }
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JNZ, fill);
+    emit_mov(gen, REG_A, REG_F);
+    emit_ldi(gen, REG_B, 16);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JNC, fill);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_F);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_F, REG_A);
+    if (right) {
+        emit_mov(gen, REG_A, REG_G);
+        emit_none(gen, OP_SHR);
+        emit_mov(gen, REG_G, REG_A);
+        emit_ldi(gen, REG_B, 0);
+        emit_label(gen, OP_JNC, low);
+        emit_ldi(gen, REG_B, 128);
+        emit_label(gen, OP_LABEL, low);
+        emit_mov(gen, REG_A, REG_D);
+        emit_none(gen, OP_SHR);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_D, REG_A);
+        emit_mov(gen, REG_A, REG_G);
+        emit_mov(gen, REG_B, REG_E);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_G, REG_A);
+    } else {
+        emit_double(gen, REG_D, REG_G);
+    }
+    emit_label(gen, OP_JMP, loop);
+    // all zero bits, or all one bits for >> of a negative value
+    emit_label(gen, OP_LABEL, fill);
+    emit_ldi(gen, REG_D, 0);
+    emit_mov(gen, REG_A, REG_E);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, zero);
+    emit_ldi(gen, REG_D, 255);
+    emit_label(gen, OP_LABEL, zero);
+    emit_mov(gen, REG_G, REG_D);
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+}
+
+void emit_runtime(CodeGenerator *gen) {
+    // the two byte multiply calls the byte one, which must come out as well
+    if (gen->extended_isa && gen->runtime_label[RUNTIME_MULTIPLY_WIDE] >= 0 &&
+        gen->runtime_label[RUNTIME_MULTIPLY] < 0)
+        gen->runtime_label[RUNTIME_MULTIPLY] = gen->label_count++;
+    for (int routine = 0; routine < RUNTIME_COUNT; routine++) {
+        if (gen->runtime_label[routine] < 0) continue;
+        emit_label(gen, OP_LABEL, gen->runtime_label[routine]);
+        if (!gen->extended_isa) {
+            emit_inline_routine(gen, (RuntimeRoutine)routine);
+            emit_return_dispatch(gen, (RuntimeRoutine)routine);
+            continue;
+        }
+        if (routine == RUNTIME_MULTIPLY)
+            emit_multiply_routine(gen);
+        else if (routine == RUNTIME_MULTIPLY_WIDE)
+            emit_multiply_wide_routine(gen);
+        else if (routine == RUNTIME_SHIFT_LEFT_WIDE || routine == RUNTIME_SHIFT_RIGHT_WIDE)
+            emit_shift_wide_routine(gen, routine == RUNTIME_SHIFT_RIGHT_WIDE);
+        else
+            emit_shift_routine(gen, routine == RUNTIME_SHIFT_LEFT ? OP_SHL : OP_SHR);
+        emit_none(gen, OP_RET);
+    }
+}
+
+/*
+The routines on the base CPU, which branches on the zero flag alone. A bit of a byte is
+tested by doubling it until the bits above are gone: bit j of t is set when t << (7 - j)
+is not zero, once the bits below it have been cleared. Going from bit 0 up, each set bit
+is subtracted as it is found, which also ends the walk early once nothing is left. The
+top bit found that way stands in for the carry: a sum carries out of the byte when both
+operands have theirs set, or one of them does and the sum does not.
+*/
+
+// A = A + A, setting the zero flag
+static void emit_double_a(CodeGenerator *gen) {
+    emit_mov(gen, REG_B, REG_A);
+    emit_none(gen, OP_ADD);
+}
+
+// A = A & 128 by clearing bits 0..6; clobbers B, and leaves the result in scratch too
+static void emit_top_bit(CodeGenerator *gen, Register scratch) {
+    emit_mov(gen, scratch, REG_A);
+    for (int j = 0; j < 7; j++) {
+        int clear = gen->label_count++;
+        emit_mov(gen, REG_A, scratch);
+        for (int i = j; i < 7; i++) emit_double_a(gen);
+        emit_label(gen, OP_JZ, clear);
+        emit_mov(gen, REG_A, scratch);
+        emit_ldi(gen, REG_B, 1 << j);
+        emit_none(gen, OP_SUB);
+        emit_mov(gen, scratch, REG_A);
+        emit_label(gen, OP_LABEL, clear);
+    }
+    emit_mov(gen, REG_A, scratch);
+}
+
+// Jump to label when A + B carries out of the byte, or with subtract when A - B borrows
+// (A < B). Either is the majority of three top bits: of A, B and the complement of the
+// sum for +, of A's complement, B and the difference for -. The three bytes are pushed
+// and tested by one copy of the top bit test, counting in D the ones set.
+// Clobbers A and B, preserves C..G.
+static void emit_carry_test(CodeGenerator *gen, int subtract, int label) {
+    int loop = gen->label_count, clear = loop + 1;
+    gen->label_count += 2;
+    emit_reg(gen, OP_PUSH, REG_C);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_mov(gen, REG_C, REG_A);
+    emit_mov(gen, REG_D, REG_B);
+    if (subtract) {
+        emit_mov(gen, REG_B, REG_C);
+        emit_ldi(gen, REG_A, 255);
+        emit_none(gen, OP_SUB);
+    }
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_mov(gen, REG_A, REG_C);
+    emit_mov(gen, REG_B, REG_D);
+    emit_none(gen, subtract ? OP_SUB : OP_ADD);
+    if (!subtract) {
+        emit_mov(gen, REG_B, REG_A);
+        emit_ldi(gen, REG_A, 255);
+        emit_none(gen, OP_SUB);
+    }
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_ldi(gen, REG_C, 3);
+    emit_ldi(gen, REG_D, 0);
+    emit_label(gen, OP_LABEL, loop);
+    emit_reg(gen, OP_POP, REG_A);
+    emit_top_bit(gen, REG_E);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, clear);
+    emit_mov(gen, REG_A, REG_D);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_D, REG_A);
+    emit_label(gen, OP_LABEL, clear);
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_C, REG_A);
+    emit_label(gen, OP_JNZ, loop);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+    emit_reg(gen, OP_POP, REG_C);
+    emit_ldi(gen, REG_B, 2);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, label);
+    emit_ldi(gen, REG_B, 3);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, label);
+}
+
+// jump to label when A < limit, A unchanged; one compare per smaller value
+static void emit_below_constant(CodeGenerator *gen, int limit, int label) {
+    for (int value = 0; value < limit; value++) {
+        emit_ldi(gen, REG_B, value);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JZ, label);
+    }
+}
+
+// A = A >> count for 1 <= count <= 7, adding the weight of each set bit from count up
+// into result; clobbers B, value and result
+static void emit_shift_right_bits(CodeGenerator *gen, int count, Register value, Register result) {
+    int done = gen->label_count++;
+    emit_mov(gen, value, REG_A);
+    emit_ldi(gen, result, 0);
+    for (int j = 0; j < 8; j++) {
+        int clear = gen->label_count++;
+        emit_mov(gen, REG_A, value);
+        if (j < 7) {
+            for (int i = j; i < 7; i++) emit_double_a(gen);
+        } else {
+            emit_ldi(gen, REG_B, 0);
+            emit_none(gen, OP_CMP);
+        }
+        emit_label(gen, OP_JZ, clear);
+        if (j >= count) {
+            emit_mov(gen, REG_A, result);
+            emit_ldi(gen, REG_B, 1 << (j - count));
+            emit_none(gen, OP_ADD);
+            emit_mov(gen, result, REG_A);
+        }
+        if (j < 7) {
+            emit_mov(gen, REG_A, value);
+            emit_ldi(gen, REG_B, 1 << j);
+            emit_none(gen, OP_SUB);
+            emit_mov(gen, value, REG_A);
+            emit_label(gen, OP_JZ, done);
+        }
+        emit_label(gen, OP_LABEL, clear);
+    }
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, result);
+}
+
+// A = A * B, one step per bit of the multiplier in D: C doubles the multiplicand and E
+// sums the product
+static void emit_base_multiply(CodeGenerator *gen) {
+    int done = gen->label_count++;
+    emit_reg(gen, OP_PUSH, REG_C);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_mov(gen, REG_C, REG_A);
+    emit_mov(gen, REG_D, REG_B);
+    emit_ldi(gen, REG_E, 0);
+    emit_mov(gen, REG_A, REG_D);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    for (int j = 0; j < 8; j++) {
+        // bit 7 is reached only when it is all that is left
+        int clear = gen->label_count++;
+        if (j < 7) {
+            emit_mov(gen, REG_A, REG_D);
+            for (int i = j; i < 7; i++) emit_double_a(gen);
+            emit_label(gen, OP_JZ, clear);
+        }
+        emit_mov(gen, REG_A, REG_E);
+        emit_mov(gen, REG_B, REG_C);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_E, REG_A);
+        if (j == 7) break;
+        emit_mov(gen, REG_A, REG_D);
+        emit_ldi(gen, REG_B, 1 << j);
+        emit_none(gen, OP_SUB);
+        emit_mov(gen, REG_D, REG_A);
+        emit_label(gen, OP_JZ, done);
+        emit_label(gen, OP_LABEL, clear);
+        emit_mov(gen, REG_A, REG_C);
+        emit_double_a(gen);
+        emit_mov(gen, REG_C, REG_A);
+    }
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_E);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+    emit_reg(gen, OP_POP, REG_C);
+}
+
+// A = A << B or A >> B, one bit at a time with the value in D and the count in E, until
+// either runs out; >> halves with C and D
+static void emit_base_shift(CodeGenerator *gen, int right) {
+    int loop = gen->label_count, done = loop + 1;
+    gen->label_count += 2;
+    emit_reg(gen, OP_PUSH, REG_C);
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_mov(gen, REG_E, REG_B);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_A, REG_E);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_E, REG_A);
+    emit_mov(gen, REG_A, REG_D);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    if (right) {
+        emit_shift_right_bits(gen, 1, REG_C, REG_D);
+        emit_label(gen, OP_JMP, loop);
+    } else {
+        emit_double_a(gen);
+        emit_label(gen, OP_JNZ, loop);
+        emit_mov(gen, REG_D, REG_A);
+    }
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+    emit_reg(gen, OP_POP, REG_C);
+}
+
+// A:G = A:G * B:C. The cross products as in the routine; then the multiplier's bits are
+// pushed lowest first, so the product of the low bytes builds up in D:G highest bit
+// first: double it, and add the multiplicand in F when the bit is set. C counts the bits.
+static void emit_base_multiply_wide(CodeGenerator *gen) {
+    int loop = gen->label_count, even = loop + 1, skip = loop + 2, carry = loop + 3, sum = loop + 4;
+    gen->label_count += 5;
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_reg(gen, OP_PUSH, REG_F);
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_reg(gen, OP_PUSH, REG_B);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_A, REG_G);
+    emit_base_multiply(gen);
+    emit_mov(gen, REG_E, REG_A);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_C);
+    emit_base_multiply(gen);
+    emit_mov(gen, REG_B, REG_E);
+    emit_none(gen, OP_ADD);
+    emit_reg(gen, OP_POP, REG_C);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_reg(gen, OP_PUSH, REG_A); // the cross products, for the high byte at the end
+    for (int j = 0; j < 8; j++) {
+        int set = gen->label_count++, next = gen->label_count++;
+        emit_mov(gen, REG_A, REG_C);
+        if (j < 7) {
+            for (int i = j; i < 7; i++) emit_double_a(gen);
+        } else {
+            emit_ldi(gen, REG_B, 0);
+            emit_none(gen, OP_CMP);
+        }
+        emit_label(gen, OP_JNZ, set);
+        emit_ldi(gen, REG_A, 0);
+        emit_reg(gen, OP_PUSH, REG_A);
+        emit_label(gen, OP_JMP, next);
+        emit_label(gen, OP_LABEL, set);
+        if (j < 7) {
+            emit_mov(gen, REG_A, REG_C);
+            emit_ldi(gen, REG_B, 1 << j);
+            emit_none(gen, OP_SUB);
+            emit_mov(gen, REG_C, REG_A);
+        }
+        emit_ldi(gen, REG_A, 1);
+        emit_reg(gen, OP_PUSH, REG_A);
+        emit_label(gen, OP_LABEL, next);
+    }
+    emit_ldi(gen, REG_D, 0);
+    emit_ldi(gen, REG_G, 0);
+    emit_ldi(gen, REG_C, 8);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_D);
+    emit_top_bit(gen, REG_E);
+    emit_mov(gen, REG_A, REG_G);
+    emit_double_a(gen);
+    emit_mov(gen, REG_G, REG_A);
+    emit_mov(gen, REG_A, REG_E);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, even);
+    emit_mov(gen, REG_A, REG_G);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_G, REG_A);
+    emit_label(gen, OP_LABEL, even);
+    emit_mov(gen, REG_A, REG_D);
+    emit_double_a(gen);
+    emit_mov(gen, REG_D, REG_A);
+    emit_reg(gen, OP_POP, REG_A);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, skip);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_F);
+    emit_carry_test(gen, 0, carry);
+    emit_label(gen, OP_JMP, sum);
+    emit_label(gen, OP_LABEL, carry);
+    emit_mov(gen, REG_A, REG_G);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_G, REG_A);
+    emit_label(gen, OP_LABEL, sum);
+    emit_mov(gen, REG_A, REG_D);
+    emit_mov(gen, REG_B, REG_F);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_D, REG_A);
+    emit_label(gen, OP_LABEL, skip);
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_C, REG_A);
+    emit_label(gen, OP_JNZ, loop);
+    emit_reg(gen, OP_POP, REG_B);
+    emit_mov(gen, REG_A, REG_G);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_G, REG_A);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+}
+
+// A:G = A:G << B:C, or >> (arithmetic), with the value in D:G, the count in F and, for
+// >>, the sign bit in E. A count of 8 or more first moves a whole byte; what is left
+// goes one bit at a time: << carries the low byte's top bit up, >> halves both bytes
+// and moves the high byte's low bit down, with C and F to halve with.
+static void emit_base_shift_wide(CodeGenerator *gen, int right) {
+    int loop = gen->label_count, bits = loop + 1, fill = loop + 2, done = loop + 3, zero = loop + 4;
+    int even = loop + 5, positive = loop + 6;
+    gen->label_count += 7;
+    emit_reg(gen, OP_PUSH, REG_D);
+    emit_reg(gen, OP_PUSH, REG_E);
+    emit_reg(gen, OP_PUSH, REG_F);
+    emit_mov(gen, REG_D, REG_A);
+    emit_mov(gen, REG_F, REG_B);
+    if (right) {
+        emit_mov(gen, REG_A, REG_G);
+        emit_top_bit(gen, REG_E);
+    }
+    emit_mov(gen, REG_A, REG_C);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JNZ, fill);
+    emit_mov(gen, REG_A, REG_F);
+    emit_below_constant(gen, 8, bits);
+    if (right) {
+        emit_mov(gen, REG_D, REG_G);
+        emit_ldi(gen, REG_G, 0);
+        emit_mov(gen, REG_A, REG_E);
+        emit_ldi(gen, REG_B, 0);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JZ, positive);
+        emit_ldi(gen, REG_G, 255);
+        emit_label(gen, OP_LABEL, positive);
+    } else {
+        emit_mov(gen, REG_G, REG_D);
+        emit_ldi(gen, REG_D, 0);
+    }
+    emit_mov(gen, REG_A, REG_F);
+    emit_ldi(gen, REG_B, 8);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_F, REG_A);
+    emit_below_constant(gen, 8, bits);
+    emit_label(gen, OP_JMP, fill);
+    emit_label(gen, OP_LABEL, bits);
+    emit_label(gen, OP_LABEL, loop);
+    emit_mov(gen, REG_A, REG_F);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    emit_label(gen, OP_JZ, done);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_SUB);
+    emit_mov(gen, REG_F, REG_A);
+    if (right) {
+        emit_reg(gen, OP_PUSH, REG_F);
+        emit_mov(gen, REG_A, REG_G);
+        for (int i = 0; i < 7; i++) emit_double_a(gen);
+        emit_reg(gen, OP_PUSH, REG_A); // the high byte's low bit, as 128 or 0
+        emit_mov(gen, REG_A, REG_G);
+        emit_shift_right_bits(gen, 1, REG_C, REG_F);
+        emit_mov(gen, REG_B, REG_E);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_G, REG_A);
+        emit_mov(gen, REG_A, REG_D);
+        emit_shift_right_bits(gen, 1, REG_C, REG_F);
+        emit_reg(gen, OP_POP, REG_B);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_D, REG_A);
+        emit_reg(gen, OP_POP, REG_F);
+    } else {
+        emit_mov(gen, REG_A, REG_D);
+        emit_top_bit(gen, REG_C);
+        emit_mov(gen, REG_A, REG_G);
+        emit_double_a(gen);
+        emit_mov(gen, REG_G, REG_A);
+        emit_mov(gen, REG_A, REG_C);
+        emit_ldi(gen, REG_B, 0);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JZ, even);
+        emit_mov(gen, REG_A, REG_G);
+        emit_ldi(gen, REG_B, 1);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, REG_G, REG_A);
+        emit_label(gen, OP_LABEL, even);
+        emit_mov(gen, REG_A, REG_D);
+        emit_double_a(gen);
+        emit_mov(gen, REG_D, REG_A);
+    }
+    emit_label(gen, OP_JMP, loop);
+    // all zero bits, or all one bits for >> of a negative value
+    emit_label(gen, OP_LABEL, fill);
+    emit_ldi(gen, REG_D, 0);
+    if (right) {
+        emit_mov(gen, REG_A, REG_E);
+        emit_ldi(gen, REG_B, 0);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_JZ, zero);
+        emit_ldi(gen, REG_D, 255);
+        emit_label(gen, OP_LABEL, zero);
+    }
+    emit_mov(gen, REG_G, REG_D);
+    emit_label(gen, OP_LABEL, done);
+    emit_mov(gen, REG_A, REG_D);
+    emit_reg(gen, OP_POP, REG_F);
+    emit_reg(gen, OP_POP, REG_E);
+    emit_reg(gen, OP_POP, REG_D);
+}
+
+static void emit_inline_routine(CodeGenerator *gen, RuntimeRoutine routine) {
+    if (routine == RUNTIME_MULTIPLY)
+        emit_base_multiply(gen);
+    else if (routine == RUNTIME_MULTIPLY_WIDE)
+        emit_base_multiply_wide(gen);
+    else if (routine == RUNTIME_SHIFT_LEFT_WIDE || routine == RUNTIME_SHIFT_RIGHT_WIDE)
+        emit_base_shift_wide(gen, routine == RUNTIME_SHIFT_RIGHT_WIDE);
+    else
+        emit_base_shift(gen, routine == RUNTIME_SHIFT_RIGHT);
+}
+
+/*
+Multiplying by a constant. With x in A, a chain of mov B A, shl, add and sub computes
+x * c: after each one A holds k * x and B holds m * x for some k and m (mod 256), so a
+breadth first search over the (k, m) pairs, from k = 1 with B unknown, finds the
+shortest chain for every c at once. Each of the four takes one byte and 3 cycles,
+where a call to the multiply routine takes well over a hundred. The base CPU has no
+shl, so its chains are searched again without it.
+*/
+#define CHAIN_MAX 16
+
+typedef struct {
+    int length;                     // -1 when no chain fits, then the routine is called
+    unsigned char ops[CHAIN_MAX];   // OP_SHL, OP_ADD, OP_SUB, or OP_MOV for mov B A
+} MultiplyChain;
+
+static MultiplyChain multiply_chains[2][256]; // without shl, with it
+static pthread_once_t multiply_chains_once = PTHREAD_ONCE_INIT;
+
+static void find_chains(MultiplyChain *chains, int shifts) {
+    enum { B_UNKNOWN = 256, STATES = 256 * 257 };
+    // process wide and computed once, so not through the per thread allocator
+    int *parent = malloc(sizeof(int) * STATES);
+    int *queue = malloc(sizeof(int) * STATES);
+    unsigned char *via = malloc(STATES);
+    int best[256];
+    for (int c = 0; c < 256; c++) {
+        chains[c].length = -1;
+        best[c] = -1;
+    }
+    if (!parent || !queue || !via) {
+        free(parent);
+        free(queue);
+        free(via);
+        return;
+    }
+    for (int i = 0; i < STATES; i++) parent[i] = -1;
+
+    int start = 1 * 257 + B_UNKNOWN, head = 0, tail = 0;
+    parent[start] = start;
+    queue[tail++] = start;
+    while (head < tail) {
+        int state = queue[head++], k = state / 257, m = state % 257;
+        if (best[k] < 0) best[k] = state;
+        int next[4] = {shifts ? (k * 2 & 0xFF) * 257 + m : -1, k * 257 + k, -1, -1};
+        unsigned char ops[4] = {OP_SHL, OP_MOV, OP_ADD, OP_SUB};
+        if (m != B_UNKNOWN) {
+            next[2] = ((k + m) & 0xFF) * 257 + m;
+            next[3] = ((k - m) & 0xFF) * 257 + m;
+        }
+        for (int i = 0; i < 4; i++) {
+            if (next[i] < 0 || parent[next[i]] >= 0) continue;
+            parent[next[i]] = state;
+            via[next[i]] = ops[i];
+            queue[tail++] = next[i];
+        }
+    }
+
+    for (int c = 0; c < 256; c++) {
+        int length = 0;
+        for (int state = best[c]; state != start; state = parent[state]) length++;
+        if (length > CHAIN_MAX) continue;
+        chains[c].length = length;
+        for (int state = best[c]; state != start; state = parent[state])
+            chains[c].ops[--length] = via[state];
+    }
+    free(parent);
+    free(queue);
+    free(via);
+}
+
+static void find_multiply_chains(void) {
+    find_chains(multiply_chains[0], 0);
+    find_chains(multiply_chains[1], 1);
+}
+
+static const MultiplyChain *multiply_chain(int constant, int extended_isa) {
+    pthread_once(&multiply_chains_once, find_multiply_chains);
+    return &multiply_chains[extended_isa != 0][constant & 0xFF];
+}
+
+// Operators on a constant that are expanded in place: x * c, c * x, x << c and x >> c.
+// Returns x and sets constant, NULL for any other operator.
+static ASTNode *constant_operand(const ASTNode *node, int *constant) {
+    ASTNode *left = node->data.binary_op.left, *right = node->data.binary_op.right;
+    switch (node->data.binary_op.operator) {
+        case TOKEN_STAR:
+            if (left->type == AST_NUMBER) {
+                *constant = left->data.number.value;
+                return right;
             }
-            break;
-            
-        case AST_IDENTIFIER:
-            {
-                char instr[32];
-                snprintf(instr, 32, "lda %%var_%s", expr->data.identifier.name);
-                emit_instruction(gen, instr);
+            // fall through
+        case TOKEN_SHIFT_LEFT:
+        case TOKEN_SHIFT_RIGHT:
+            if (right->type != AST_NUMBER) return NULL;
+            *constant = right->data.number.value;
+            return left;
+        default:
+            return NULL;
+    }
+}
+
+/*
+Loop optimization. While a loop runs, C..G hold values its body would otherwise
+compute on every iteration, and each occurrence becomes one mov:
+ - invariant loads and expressions, of variables the loop never assigns, are computed
+   once before the loop;
+ - expressions linear in an induction variable, one that a statement at the top of the
+   body steps by a constant (i = i + 1), are computed once before the loop too and then
+   stepped after that statement with one add, however much work the expression is.
+Values are weighed by the cycles they save per iteration; inner loops get the
+registers their enclosing loops leave free.
+*/
+#define LOOP_REGISTERS 5    // C..G
+#define LOOP_VALUE_NODES 16 // largest expression kept in a register
+#define LOOP_CANDIDATES 32  // distinct expressions and induction variables weighed per loop
+
+typedef struct {
+    ASTNode *expression; // first occurrence, the others compare equal to it
+    int uses;
+    int benefit;         // cycles saved per iteration
+    ASTNode *increment;  // induction values: the statement stepping the variable
+    int step;            // induction values: what the value changes by there
+    Register reg;
+    int active;          // computed, occurrences use reg
+} LoopValue;
+
+typedef struct {
+    LoopValue values[LOOP_REGISTERS];
+    int count;
+    int ready; // values computed into their registers so far
+    int label; // the body; label + 1 is the condition
+} Loop;
+
+typedef struct {
+    Loop *loops; // loops being generated, innermost last
+    int count;
+    int capacity;
+} LoopStack;
+
+// whether two expressions compute the same; a has at most LOOP_VALUE_NODES nodes
+static int same_expression(const ASTNode *a, const ASTNode *b) {
+    const ASTNode *pending[2 * LOOP_VALUE_NODES];
+    int count = 0;
+    pending[count++] = a;
+    pending[count++] = b;
+    while (count > 0) {
+        b = pending[--count];
+        a = pending[--count];
+        if (a->type != b->type) return 0;
+        switch (a->type) {
+            case AST_NUMBER:
+                if (a->data.number.value != b->data.number.value) return 0;
+                break;
+            case AST_IDENTIFIER:
+                if (strcmp(a->data.identifier.name, b->data.identifier.name) != 0) return 0;
+                break;
+            case AST_BINARY_OP:
+                if (a->data.binary_op.operator != b->data.binary_op.operator ||
+                    count + 4 > 2 * LOOP_VALUE_NODES)
+                    return 0;
+                pending[count++] = a->data.binary_op.left;
+                pending[count++] = b->data.binary_op.left;
+                pending[count++] = a->data.binary_op.right;
+                pending[count++] = b->data.binary_op.right;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+// register holding node's value in one of the loops being generated, -1 if none
+static int held_register(const LoopStack *stack, const ASTNode *node) {
+    for (int i = 0; i < stack->count; i++) {
+        const Loop *loop = &stack->loops[i];
+        for (int j = 0; j < loop->count; j++) {
+            if (loop->values[j].active && same_expression(loop->values[j].expression, node))
+                return loop->values[j].reg;
+        }
+    }
+    return -1;
+}
+
+// the variable a statement stores to and the value it stores, NULL for other statements
+static const char *stored_variable(const ASTNode *node, ASTNode **value) {
+    if (node->type == AST_ASSIGNMENT) {
+        *value = node->data.assignment.value;
+        return node->data.assignment.var_name;
+    }
+    if (node->type == AST_DECLARATION && node->data.declaration.init_value) {
+        *value = node->data.declaration.init_value;
+        return node->data.declaration.var_name;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char *name;
+    ASTNode *increment;
+    int step;
+} Induction;
+
+// what a loop knows while weighing its candidates
+typedef struct {
+    SymbolTable assigned; // every variable stored to anywhere in the loop
+    int *stores;          // per assigned id, how many statements store to it
+    int store_capacity;
+    Induction inductions[LOOP_CANDIDATES];
+    int induction_count;
+    LoopValue candidates[LOOP_CANDIDATES];
+    int candidate_count;
+    int extended_isa; // the generator's, for what chains and shifts cost
+    int failed;
+} LoopPlan;
+
+enum { VALUE_OTHER, VALUE_INVARIANT, VALUE_INDUCTION };
+
+// cycles of a typical call to a runtime routine, for weighing loop values
+#define RUNTIME_CALL_CYCLES 200
+
+// Classify a small expression: invariant, linear in one induction variable (coefficient
+// times the variable plus invariant terms), or neither; also its cost in cycles when
+// computed the usual way. Expressions over LOOP_VALUE_NODES nodes are VALUE_OTHER.
+static int classify_value(const LoopPlan *plan, const ASTNode *expression, int *induction,
+                          int *coefficient, int *cost) {
+    // factor: what the node's value is multiplied by in the whole expression, mod 256
+    struct { const ASTNode *node; int factor; } pending[LOOP_VALUE_NODES];
+    int count = 0, visited = 0, linear = 1;
+    *induction = -1;
+    *coefficient = 0;
+    *cost = 0;
+    pending[count].node = expression;
+    pending[count++].factor = 1;
+    while (count > 0) {
+        const ASTNode *node = pending[--count].node;
+        int factor = pending[count].factor;
+        int constant;
+        const ASTNode *operand;
+        if (++visited + count > LOOP_VALUE_NODES) return VALUE_OTHER;
+        switch (node->type) {
+            case AST_NUMBER:
+                *cost += 5;
+                break;
+            case AST_IDENTIFIER: {
+                *cost += 8;
+                const char *name = node->data.identifier.name;
+                if (find_symbol(&plan->assigned, name) < 0) break;
+                int i = 0;
+                while (i < plan->induction_count && strcmp(plan->inductions[i].name, name) != 0) i++;
+                if (i == plan->induction_count || (*induction >= 0 && *induction != i)) return VALUE_OTHER;
+                *induction = i;
+                *coefficient = (*coefficient + factor) & 0xFF;
+                break;
             }
-            break;
-            
-        case AST_BINARY_OP:
-            generate_expression(gen, expr->data.binary_op.left);
-            emit_instruction(gen, "push A");
-            generate_expression(gen, expr->data.binary_op.right);
-            emit_instruction(gen, "mov B A");
-            emit_instruction(gen, "pop A");
-            
-            switch (expr->data.binary_op.operator) {
-                case TOKEN_PLUS:
-                    emit_instruction(gen, "add");
-                    break;
-                case TOKEN_MINUS:
-                    emit_instruction(gen, "sub");
+            case AST_BINARY_OP: {
+                TokenType op = node->data.binary_op.operator;
+                if ((operand = constant_operand(node, &constant))) {
+                    // a product or left shift by a constant scales its operand
+                    int shifts = constant;
+                    visited++;
+                    if (op == TOKEN_STAR) {
+                        int length = multiply_chain(constant, plan->extended_isa)->length;
+                        *cost += length < 0 ? RUNTIME_CALL_CYCLES : 3 * length;
+                        factor = (factor * (constant & 0xFF)) & 0xFF;
+                    } else if (op == TOKEN_SHIFT_RIGHT && !plan->extended_isa && shifts > 0 && shifts < 8) {
+                        *cost += RUNTIME_CALL_CYCLES;
+                    } else {
+                        *cost += shifts >= 8 ? 5 : (plan->extended_isa ? 3 : 6) * shifts;
+                        factor = shifts >= 8 ? 0 : (factor << shifts) & 0xFF;
+                    }
+                    if (op == TOKEN_SHIFT_RIGHT) linear = 0;
+                    pending[count].node = operand;
+                    pending[count++].factor = factor;
                     break;
-                default:
+                }
+                if (op == TOKEN_EQUAL)
+                    *cost += 27;
+                else if (op == TOKEN_PLUS || op == TOKEN_MINUS)
+                    *cost += 14;
+                else
+                    *cost += 11 + RUNTIME_CALL_CYCLES;
+                if (op != TOKEN_PLUS && op != TOKEN_MINUS) linear = 0;
+                if (count + 2 > LOOP_VALUE_NODES) return VALUE_OTHER;
+                pending[count].node = node->data.binary_op.left;
+                pending[count++].factor = factor;
+                pending[count].node = node->data.binary_op.right;
+                pending[count++].factor = op == TOKEN_MINUS ? (-factor) & 0xFF : factor;
+                break;
+            }
+            default:
+                return VALUE_OTHER;
+        }
+    }
+    if (*induction < 0) return VALUE_INVARIANT;
+    return linear && *coefficient != 0 ? VALUE_INDUCTION : VALUE_OTHER;
+}
+
+// count one occurrence of a value worth keeping in a register
+static void add_candidate(LoopPlan *plan, ASTNode *expression, int saved, ASTNode *increment, int step) {
+    for (int i = 0; i < plan->candidate_count; i++) {
+        if (same_expression(plan->candidates[i].expression, expression)) {
+            plan->candidates[i].uses++;
+            plan->candidates[i].benefit += saved;
+            return;
+        }
+    }
+    if (plan->candidate_count == LOOP_CANDIDATES) return;
+    LoopValue *value = &plan->candidates[plan->candidate_count++];
+    value->expression = expression;
+    value->uses = 1;
+    // stepping costs mov, ldi, add, mov once per iteration
+    value->benefit = saved - (increment ? 14 : 0);
+    value->increment = increment;
+    value->step = step;
+    value->active = 0;
+}
+
+// every store in the loop, then the induction variables among the body's own statements
+static void find_stores(LoopPlan *plan, ASTNode *loop) {
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, loop, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk))) {
+        ASTNode *node = frame->node, *value;
+        ast_walk_pop(&walk);
+        const char *name = stored_variable(node, &value);
+        if (name) {
+            int id = intern_symbol(&plan->assigned, name);
+            if (id >= plan->store_capacity) {
+                int capacity = plan->store_capacity ? plan->store_capacity * 2 : 16;
+                int *stores = id >= 0 ? sl_realloc(plan->stores, sizeof(int) * capacity) : NULL;
+                if (!stores) {
+                    plan->failed = 1;
                     break;
+                }
+                memset(stores + plan->store_capacity, 0, sizeof(int) * (capacity - plan->store_capacity));
+                plan->stores = stores;
+                plan->store_capacity = capacity;
             }
+            plan->stores[id]++;
+        }
+        // expressions hold no stores
+        if (node->type != AST_BINARY_OP)
+            for (int i = 0; i < ast_child_count(node); i++)
+                ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    if (walk.failed) plan->failed = 1;
+    free_ast_walk(&walk);
+
+    ASTNode *body = loop->data.while_stmt.body;
+    for (int i = 0; i < body->data.block.count && plan->induction_count < LOOP_CANDIDATES; i++) {
+        ASTNode *statement = body->data.block.statements[i], *value;
+        const char *name = stored_variable(statement, &value);
+        if (!name || plan->stores[find_symbol(&plan->assigned, name)] != 1 || value->type != AST_BINARY_OP)
+            continue;
+        ASTNode *left = value->data.binary_op.left, *right = value->data.binary_op.right;
+        TokenType op = value->data.binary_op.operator;
+        if (op == TOKEN_PLUS && left->type == AST_NUMBER) {
+            ASTNode *swap = left;
+            left = right;
+            right = swap;
+        }
+        if ((op != TOKEN_PLUS && op != TOKEN_MINUS) || left->type != AST_IDENTIFIER ||
+            strcmp(left->data.identifier.name, name) != 0 || right->type != AST_NUMBER)
+            continue;
+        Induction *induction = &plan->inductions[plan->induction_count++];
+        induction->name = name;
+        induction->increment = statement;
+        induction->step = op == TOKEN_PLUS ? right->data.number.value : -right->data.number.value;
+    }
+}
+
+// the largest loop values and induction expressions in the loop, counted; registers
+// hold bytes, so only values that fit in one
+static void find_candidates(LoopPlan *plan, ASTNode *loop, const LoopStack *stack, const RangeAnalysis *ranges) {
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, loop, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk))) {
+        ASTNode *node = frame->node;
+        ast_walk_pop(&walk);
+        int induction, coefficient, cost;
+        int kind = VALUE_OTHER;
+        switch (node->type) {
+            case AST_NUMBER:
+                continue;
+            case AST_IDENTIFIER:
+            case AST_BINARY_OP:
+                // an enclosing loop already holds it
+                if (held_register(stack, node) >= 0) continue;
+                if (node->type == AST_BINARY_OP && node->data.binary_op.operator == TOKEN_EQUAL) break;
+                if (!fits_in_byte(node_range(ranges, node))) break;
+                kind = classify_value(plan, node, &induction, &coefficient, &cost);
+                if (kind == VALUE_INDUCTION && node->type == AST_IDENTIFIER) kind = VALUE_OTHER;
+                break;
+            default:
+                break;
+        }
+        if (kind == VALUE_INVARIANT)
+            add_candidate(plan, node, cost - 3, NULL, 0);
+        else if (kind == VALUE_INDUCTION)
+            add_candidate(plan, node, cost - 3, plan->inductions[induction].increment,
+                          coefficient * plan->inductions[induction].step);
+        else
+            for (int i = 0; i < ast_child_count(node); i++)
+                ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    if (walk.failed) plan->failed = 1;
+    free_ast_walk(&walk);
+}
+
+// Choose what a loop keeps in registers, C up to last; -1 when out of memory
+static int plan_loop(CodeGenerator *gen, ASTNode *node, LoopStack *stack, Loop *loop,
+                     const RangeAnalysis *ranges, Register last) {
+    uint64_t start = gen->keep_loop_values ? monotonic_nanoseconds() : 0;
+    loop->count = 0;
+    loop->ready = 0;
+    LoopPlan *plan = sl_calloc(1, sizeof(LoopPlan));
+    if (!plan) return -1;
+    init_symbol_table(&plan->assigned);
+    plan->extended_isa = gen->extended_isa;
+    find_stores(plan, node);
+    if (!plan->failed && gen->keep_loop_values) find_candidates(plan, node, stack, ranges);
+
+    // registers the enclosing loops leave free
+    int free_registers[LOOP_REGISTERS], free_count = 0;
+    for (int reg = REG_C; reg <= (int)last; reg++) {
+        int taken = 0;
+        for (int i = 0; i < stack->count; i++)
+            for (int j = 0; j < stack->loops[i].count; j++)
+                taken |= (int)stack->loops[i].values[j].reg == reg;
+        if (!taken) free_registers[free_count++] = reg;
+    }
+
+    loop->label = gen->label_count;
+    gen->label_count += 2;
+    while (!plan->failed && loop->count < free_count) {
+        int best = -1;
+        for (int i = 0; i < plan->candidate_count; i++) {
+            if (plan->candidates[i].benefit > 0 &&
+                (best < 0 || plan->candidates[i].benefit > plan->candidates[best].benefit))
+                best = i;
+        }
+        if (best < 0) break;
+        LoopValue *value = &loop->values[loop->count];
+        *value = plan->candidates[best];
+        value->reg = (Register)free_registers[loop->count++];
+        plan->candidates[best].benefit = 0;
+    }
+    gen->loop_values += loop->count;
+
+    int status = plan->failed ? -1 : 0;
+    free_symbol_table(&plan->assigned);
+    sl_free(plan->stores);
+    sl_free(plan);
+    if (start) gen->loop_nanoseconds += monotonic_nanoseconds() - start;
+    return status;
+}
+
+static Loop *push_loop(LoopStack *stack) {
+    if (stack->count == stack->capacity) {
+        int capacity = stack->capacity ? stack->capacity * 2 : 8;
+        Loop *loops = sl_realloc(stack->loops, sizeof(Loop) * capacity);
+        if (!loops) return NULL;
+        stack->loops = loops;
+        stack->capacity = capacity;
+    }
+    return &stack->loops[stack->count++];
+}
+
+// after an induction variable's statement, step the values that follow it
+static void step_induction_values(CodeGenerator *gen, const LoopStack *stack, const ASTNode *statement) {
+    if (stack->count == 0) return;
+    const Loop *loop = &stack->loops[stack->count - 1];
+    for (int i = 0; i < loop->count; i++) {
+        const LoopValue *value = &loop->values[i];
+        if (!value->active || value->increment != statement) continue;
+        emit_mov(gen, REG_A, value->reg);
+        emit_ldi(gen, REG_B, value->step & 0xFF);
+        emit_none(gen, OP_ADD);
+        emit_mov(gen, value->reg, REG_A);
+    }
+}
+
+// A = A * constant, A << constant or A >> constant
+static void emit_constant_operator(CodeGenerator *gen, TokenType operator, int constant) {
+    if (operator == TOKEN_STAR) {
+        uint64_t start = gen->chain_multiplies ? monotonic_nanoseconds() : 0;
+        const MultiplyChain *chain = multiply_chain(constant, gen->extended_isa);
+        if (start) gen->chain_nanoseconds += monotonic_nanoseconds() - start;
+        if (chain->length < 0 || !gen->chain_multiplies) {
+            emit_ldi(gen, REG_B, constant & 0xFF);
+            emit_call(gen, RUNTIME_MULTIPLY);
+            return;
+        }
+        gen->chained_multiplies++;
+        for (int i = 0; i < chain->length; i++) {
+            if (chain->ops[i] == OP_MOV)
+                emit_mov(gen, REG_B, REG_A);
+            else
+                emit_none(gen, (Opcode)chain->ops[i]);
+        }
+        return;
+    }
+    // 8 or more shifts every bit of a byte out
+    int count = constant;
+    if (count >= 8) {
+        emit_ldi(gen, REG_A, 0);
+        return;
+    }
+    if (gen->extended_isa) {
+        for (int i = 0; i < count; i++)
+            emit_none(gen, operator == TOKEN_SHIFT_LEFT ? OP_SHL : OP_SHR);
+    } else if (operator == TOKEN_SHIFT_LEFT) {
+        for (int i = 0; i < count; i++) emit_double_a(gen);
+    } else if (count > 0) {
+        emit_reg(gen, OP_PUSH, REG_C);
+        emit_reg(gen, OP_PUSH, REG_D);
+        emit_shift_right_bits(gen, count, REG_C, REG_D);
+        emit_reg(gen, OP_POP, REG_D);
+        emit_reg(gen, OP_POP, REG_C);
+    }
+}
+
+// Bits of an expression frame's value: KEEP_FLAGS asks == to leave its result in the
+// zero flag, WIDE_VALUE asks for both bytes of the value in A:G rather than just the low
+// one in A, and TWO_BYTES marks an operator computed on two bytes.
+#define KEEP_FLAGS 1
+#define WIDE_VALUE 2
+#define TWO_BYTES 4
+
+static int is_equality(const ASTNode *node) {
+    return node->type == AST_BINARY_OP && node->data.binary_op.operator == TOKEN_EQUAL;
+}
+
+// whether every value of an expression fits in 0..255, so its low byte is all of it
+static int is_narrow(const RangeAnalysis *ranges, const ASTNode *node) {
+    return fits_in_byte(node_range(ranges, node));
+}
+
+// Whether an operator has to compute on two bytes. The low byte of a sum, difference,
+// product or left shift depends only on the low bytes of the operands (and the whole
+// shift count), so those take two only when the whole value is asked for and does not
+// fit in one; >> and == need whole operands.
+static int two_byte_operator(const ASTNode *node, int wide_value, const RangeAnalysis *ranges) {
+    const ASTNode *left = node->data.binary_op.left, *right = node->data.binary_op.right;
+    switch (node->data.binary_op.operator) {
+        case TOKEN_EQUAL:
+            return !is_narrow(ranges, left) || !is_narrow(ranges, right);
+        case TOKEN_SHIFT_RIGHT:
+            if (!is_narrow(ranges, left)) return 1;
+            // fall through
+        case TOKEN_SHIFT_LEFT:
+            if (!is_narrow(ranges, right)) return 1;
+            // fall through
+        default:
+            return wide_value && !is_narrow(ranges, node);
+    }
+}
+
+// what a condition is asked for: == its flags, anything else its whole value
+static int condition_request(const RangeAnalysis *ranges, const ASTNode *condition) {
+    if (is_equality(condition)) return KEEP_FLAGS;
+    return is_narrow(ranges, condition) ? 0 : WIDE_VALUE;
+}
+
+// a byte value asked for whole: its high byte is zero
+static void extend_byte(CodeGenerator *gen, int value) {
+    if (value & WIDE_VALUE) emit_ldi(gen, REG_G, 0);
+}
+
+// A = 1 when the zero flag is set, 0 otherwise
+static void emit_flag_value(CodeGenerator *gen) {
+    int label = gen->label_count++;
+    emit_ldi(gen, REG_A, 1);
+    emit_label(gen, OP_JZ, label);
+    emit_ldi(gen, REG_A, 0);
+    emit_label(gen, OP_LABEL, label);
+}
+
+// A = A <op> B; == sets the zero flag, and turns it into 1 or 0 unless keep_flags
+static void emit_operator(CodeGenerator *gen, TokenType operator, int keep_flags) {
+    switch (operator) {
+        case TOKEN_PLUS:
+            emit_none(gen, OP_ADD);
+            break;
+        case TOKEN_MINUS:
+            emit_none(gen, OP_SUB);
+            break;
+        case TOKEN_STAR:
+            emit_call(gen, RUNTIME_MULTIPLY);
+            break;
+        case TOKEN_SHIFT_LEFT:
+            emit_call(gen, RUNTIME_SHIFT_LEFT);
+            break;
+        case TOKEN_SHIFT_RIGHT:
+            emit_call(gen, RUNTIME_SHIFT_RIGHT);
+            break;
+        case TOKEN_EQUAL:
+            emit_none(gen, OP_CMP);
+            if (!keep_flags) emit_flag_value(gen);
             break;
         default:
             break;
     }
 }
 
-void generate_statement(CodeGenerator *gen, ASTNode *stmt) {
-    if (!stmt) return;
-    
-    switch (stmt->type) {
-        case AST_DECLARATION:
-            if (stmt->data.declaration.init_value) {
-                generate_expression(gen, stmt->data.declaration.init_value);
-                char instr[32];
-                snprintf(instr, 32, "sta %%var_%s", stmt->data.declaration.var_name);
-                emit_instruction(gen, instr);
-            }
-            break;
-            
-        case AST_ASSIGNMENT:
-            generate_expression(gen, stmt->data.assignment.value);
-            {
-                char instr[32];
-                snprintf(instr, 32, "sta %%var_%s", stmt->data.assignment.var_name);
-                emit_instruction(gen, instr);
+// A:G = left + A:G or left - A:G on the base CPU, the left operand pushed high byte
+// first and the right's low byte in B: the carry or borrow between the low bytes is
+// added to the right's high byte before it is used
+static void emit_wide_sum(CodeGenerator *gen, TokenType operator) {
+    Opcode opcode = operator == TOKEN_PLUS ? OP_ADD : OP_SUB;
+    int carry = gen->label_count++, low = gen->label_count++;
+    emit_reg(gen, OP_POP, REG_A);
+    emit_reg(gen, OP_PUSH, REG_A);
+    emit_reg(gen, OP_PUSH, REG_B);
+    emit_carry_test(gen, operator == TOKEN_MINUS, carry);
+    emit_label(gen, OP_JMP, low);
+    emit_label(gen, OP_LABEL, carry);
+    emit_mov(gen, REG_A, REG_G);
+    emit_ldi(gen, REG_B, 1);
+    emit_none(gen, OP_ADD);
+    emit_mov(gen, REG_G, REG_A);
+    emit_label(gen, OP_LABEL, low);
+    emit_reg(gen, OP_POP, REG_B);
+    emit_reg(gen, OP_POP, REG_A);
+    emit_none(gen, opcode);
+    emit_mov(gen, REG_B, REG_G);
+    emit_mov(gen, REG_G, REG_A);
+    emit_reg(gen, OP_POP, REG_A);
+    emit_none(gen, opcode);
+    // the high byte to G, the low one back to A
+    emit_mov(gen, REG_B, REG_A);
+    emit_mov(gen, REG_A, REG_G);
+    emit_mov(gen, REG_G, REG_B);
+}
+
+// A:G = left <op> A:G, the left operand pushed high byte first (after C for *, << and
+// >>, which call a routine with the right operand in B:C); == as in emit_operator
+static void emit_wide_operator(CodeGenerator *gen, TokenType operator, int keep_flags) {
+    int label;
+    emit_mov(gen, REG_B, REG_A);
+    switch (operator) {
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+            if (!gen->extended_isa) {
+                emit_wide_sum(gen, operator);
+                break;
             }
+            emit_reg(gen, OP_POP, REG_A);
+            emit_none(gen, operator == TOKEN_PLUS ? OP_ADD : OP_SUB);
+            emit_mov(gen, REG_B, REG_G);
+            emit_mov(gen, REG_G, REG_A);
+            emit_reg(gen, OP_POP, REG_A);
+            emit_none(gen, operator == TOKEN_PLUS ? OP_ADC : OP_SBC);
+            // the high byte to G, the low one back to A
+            emit_mov(gen, REG_B, REG_A);
+            emit_mov(gen, REG_A, REG_G);
+            emit_mov(gen, REG_G, REG_B);
             break;
-            
-        case AST_BLOCK:
-            for (int i = 0; i < stmt->data.block.count; i++) {
-                generate_statement(gen, stmt->data.block.statements[i]);
-            }
+        case TOKEN_EQUAL:
+            // the high bytes are compared only when the low ones are equal
+            label = gen->label_count++;
+            emit_reg(gen, OP_POP, REG_A);
+            emit_none(gen, OP_CMP);
+            emit_reg(gen, OP_POP, REG_A);
+            emit_label(gen, OP_JNZ, label);
+            emit_mov(gen, REG_B, REG_G);
+            emit_none(gen, OP_CMP);
+            emit_label(gen, OP_LABEL, label);
+            if (!keep_flags) emit_flag_value(gen);
             break;
         default:
+            emit_mov(gen, REG_C, REG_G);
+            emit_reg(gen, OP_POP, REG_A);
+            emit_reg(gen, OP_POP, REG_G);
+            emit_call(gen, operator == TOKEN_STAR ? RUNTIME_MULTIPLY_WIDE :
+                           operator == TOKEN_SHIFT_LEFT ? RUNTIME_SHIFT_LEFT_WIDE : RUNTIME_SHIFT_RIGHT_WIDE);
+            emit_reg(gen, OP_POP, REG_C);
             break;
     }
 }
 
-void generate_code(CodeGenerator *gen, ASTNode *ast) {
-    emit_instruction(gen, ".text");
-    emit_instruction(gen, "");
-    
+// A:G = A:G + B or A:G - B for a byte in B, carrying into the high byte; constant is
+// B's value when it is one, -1 otherwise
+static void emit_wide_byte_operator(CodeGenerator *gen, TokenType operator, int constant) {
+    Opcode opcode = operator == TOKEN_PLUS ? OP_ADD : OP_SUB;
+    if (!gen->extended_isa) {
+        int carry = gen->label_count++, done = gen->label_count++;
+        if (constant == 0) {
+            emit_none(gen, opcode);
+            return;
+        }
+        if (constant > 0 && constant <= 8) {
+            // a sum carries when its low byte is below the constant, a difference
+            // borrows when the low byte was: a few compares
+            if (operator == TOKEN_PLUS) {
+                emit_none(gen, OP_ADD);
+                emit_below_constant(gen, constant, carry);
+            } else {
+                emit_below_constant(gen, constant, carry);
+                emit_ldi(gen, REG_B, constant);
+                emit_none(gen, OP_SUB);
+            }
+            emit_label(gen, OP_JMP, done);
+            emit_label(gen, OP_LABEL, carry);
+            if (operator == TOKEN_MINUS) {
+                emit_ldi(gen, REG_B, constant);
+                emit_none(gen, OP_SUB);
+            }
+            emit_reg(gen, OP_PUSH, REG_A);
+            emit_mov(gen, REG_A, REG_G);
+            emit_ldi(gen, REG_B, 1);
+            emit_none(gen, opcode);
+            emit_mov(gen, REG_G, REG_A);
+            emit_reg(gen, OP_POP, REG_A);
+            emit_label(gen, OP_LABEL, done);
+            return;
+        }
+        emit_reg(gen, OP_PUSH, REG_A);
+        emit_reg(gen, OP_PUSH, REG_B);
+        emit_carry_test(gen, operator == TOKEN_MINUS, carry);
+        emit_label(gen, OP_JMP, done);
+        emit_label(gen, OP_LABEL, carry);
+        emit_mov(gen, REG_A, REG_G);
+        emit_ldi(gen, REG_B, 1);
+        emit_none(gen, opcode);
+        emit_mov(gen, REG_G, REG_A);
+        emit_label(gen, OP_LABEL, done);
+        emit_reg(gen, OP_POP, REG_B);
+        emit_reg(gen, OP_POP, REG_A);
+        emit_none(gen, opcode);
+        return;
+    }
+    emit_none(gen, opcode);
+    emit_mov(gen, REG_B, REG_A);
+    emit_mov(gen, REG_A, REG_G);
+    emit_mov(gen, REG_G, REG_B);
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, operator == TOKEN_PLUS ? OP_ADC : OP_SBC);
+    emit_mov(gen, REG_B, REG_A);
+    emit_mov(gen, REG_A, REG_G);
+    emit_mov(gen, REG_G, REG_B);
+}
+
+// jz or jnz to label on whether A, or A:G for a two byte value, is zero
+static void emit_zero_test(CodeGenerator *gen, int two_bytes, Opcode jump, int label) {
+    emit_ldi(gen, REG_B, 0);
+    emit_none(gen, OP_CMP);
+    if (two_bytes) {
+        int low = gen->label_count++;
+        emit_label(gen, OP_JNZ, low);
+        emit_mov(gen, REG_A, REG_G);
+        emit_none(gen, OP_CMP);
+        emit_label(gen, OP_LABEL, low);
+    }
+    emit_label(gen, jump, label);
+}
+
+// what the value stored to a variable is asked for
+static int store_request(const CodeGenerator *gen, const char *name) {
+    return find_symbol(&gen->wide, name) >= 0 ? WIDE_VALUE : 0;
+}
+
+// store A, and G as the high byte of a two byte slot
+static void emit_store(CodeGenerator *gen, const char *name) {
+    emit_symbol(gen, OP_STA, name);
+    if (find_symbol(&gen->wide, name) >= 0) {
+        emit_mov(gen, REG_A, REG_G);
+        emit_high_byte(gen, OP_STA, name);
+    }
+}
+
+// Statements and expressions are generated in one walk without recursion (see ASTWalk);
+// a frame's step says how much of its node has been emitted. Every expression leaves
+// its value in A, and its high byte in G when asked for WIDE_VALUE. Loops keep their
+// values in C up to last_loop_register. Returns -1 when the walk runs out of memory.
+static int generate_tree(CodeGenerator *gen, ASTNode *root, const RangeAnalysis *ranges, Register last_loop_register) {
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, root, 0);
+    LoopStack loops = {NULL, 0, 0};
+    int failed = 0;
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !walk.failed && !failed) {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        int reg, constant;
+        ASTNode *operand;
+        Loop *loop;
+
+        // whatever a statement's steps emit is that statement's, a loop's setup included
+        if (node->type == AST_DECLARATION || node->type == AST_ASSIGNMENT || node->type == AST_IF_STATEMENT ||
+            node->type == AST_WHILE_STATEMENT) {
+            gen->position.line = node->line;
+            gen->position.column = node->column;
+        }
+
+        // a value a loop keeps in a register, which holds its low byte
+        if (step == 0 && loops.count > 0 && (node->type == AST_IDENTIFIER || node->type == AST_BINARY_OP) &&
+            !(frame->value & KEEP_FLAGS) && (!(frame->value & WIDE_VALUE) || is_narrow(ranges, node)) &&
+            (reg = held_register(&loops, node)) >= 0) {
+            emit_mov(gen, REG_A, (Register)reg);
+            extend_byte(gen, frame->value);
+            ast_walk_pop(&walk);
+            continue;
+        }
+
+        switch (node->type) {
+            case AST_NUMBER:
+                emit_ldi(gen, REG_A, node->data.number.value & 0xFF);
+                if (frame->value & WIDE_VALUE) emit_ldi(gen, REG_G, (node->data.number.value >> 8) & 0xFF);
+                ast_walk_pop(&walk);
+                break;
+
+            case AST_IDENTIFIER:
+                if ((frame->value & WIDE_VALUE) && find_symbol(&gen->wide, node->data.identifier.name) >= 0) {
+                    emit_high_byte(gen, OP_LDA, node->data.identifier.name);
+                    emit_mov(gen, REG_G, REG_A);
+                    emit_symbol(gen, OP_LDA, node->data.identifier.name);
+                } else {
+                    emit_symbol(gen, OP_LDA, node->data.identifier.name);
+                    extend_byte(gen, frame->value);
+                }
+                ast_walk_pop(&walk);
+                break;
+
+            case AST_BINARY_OP: {
+                TokenType operator = node->data.binary_op.operator;
+                if (step == 0 && two_byte_operator(node, frame->value & WIDE_VALUE, ranges))
+                    frame->value |= TWO_BYTES;
+                ASTNode *right = node->data.binary_op.right;
+                int byte_step = (operator == TOKEN_PLUS || operator == TOKEN_MINUS) && is_narrow(ranges, right);
+                if (frame->value & TWO_BYTES) {
+                    // + and - of a constant byte or a byte a loop holds need nothing saved
+                    if (step == 1 && byte_step && right->type == AST_NUMBER) {
+                        emit_ldi(gen, REG_B, right->data.number.value);
+                        emit_wide_byte_operator(gen, operator, right->data.number.value);
+                        ast_walk_pop(&walk);
+                    } else if (step == 1 && byte_step && loops.count > 0 && (reg = held_register(&loops, right)) >= 0) {
+                        emit_mov(gen, REG_B, (Register)reg);
+                        emit_wide_byte_operator(gen, operator, -1);
+                        ast_walk_pop(&walk);
+                    } else if (step == 0) {
+                        if (operator == TOKEN_STAR || operator == TOKEN_SHIFT_LEFT || operator == TOKEN_SHIFT_RIGHT)
+                            emit_reg(gen, OP_PUSH, REG_C);
+                        ast_walk_push(&walk, node->data.binary_op.left, WIDE_VALUE);
+                    } else if (step == 1) {
+                        emit_reg(gen, OP_PUSH, REG_G);
+                        emit_reg(gen, OP_PUSH, REG_A);
+                        ast_walk_push(&walk, node->data.binary_op.right, WIDE_VALUE);
+                    } else {
+                        emit_wide_operator(gen, operator, frame->value & KEEP_FLAGS);
+                        if (operator == TOKEN_EQUAL) extend_byte(gen, frame->value);
+                        ast_walk_pop(&walk);
+                    }
+                } else if ((operand = constant_operand(node, &constant))) {
+                    if (step == 0) {
+                        ast_walk_push(&walk, operand, 0);
+                    } else {
+                        emit_constant_operator(gen, operator, constant);
+                        extend_byte(gen, frame->value);
+                        ast_walk_pop(&walk);
+                    }
+                } else if (step == 0) {
+                    ast_walk_push(&walk, node->data.binary_op.left, 0);
+                } else if (step == 1 && loops.count > 0 &&
+                           (reg = held_register(&loops, node->data.binary_op.right)) >= 0) {
+                    emit_mov(gen, REG_B, (Register)reg);
+                    emit_operator(gen, operator, frame->value & KEEP_FLAGS);
+                    extend_byte(gen, frame->value);
+                    ast_walk_pop(&walk);
+                } else if (step == 1) {
+                    emit_reg(gen, OP_PUSH, REG_A);
+                    ast_walk_push(&walk, node->data.binary_op.right, 0);
+                } else {
+                    emit_mov(gen, REG_B, REG_A);
+                    emit_reg(gen, OP_POP, REG_A);
+                    emit_operator(gen, operator, frame->value & KEEP_FLAGS);
+                    extend_byte(gen, frame->value);
+                    ast_walk_pop(&walk);
+                }
+                break;
+            }
+
+            case AST_DECLARATION:
+                if (step == 0) {
+                    // reserve the slot even when there is no initializer
+                    symbol_id(gen, node->data.declaration.var_name);
+                    if (node->data.declaration.init_value)
+                        ast_walk_push(&walk, node->data.declaration.init_value,
+                                      store_request(gen, node->data.declaration.var_name));
+                    else
+                        ast_walk_pop(&walk);
+                } else {
+                    emit_store(gen, node->data.declaration.var_name);
+                    step_induction_values(gen, &loops, node);
+                    ast_walk_pop(&walk);
+                }
+                break;
+
+            case AST_ASSIGNMENT:
+                if (step == 0) {
+                    ast_walk_push(&walk, node->data.assignment.value, store_request(gen, node->data.assignment.var_name));
+                } else {
+                    emit_store(gen, node->data.assignment.var_name);
+                    step_induction_values(gen, &loops, node);
+                    ast_walk_pop(&walk);
+                }
+                break;
+
+            // a zero condition skips the then block; frame's value is the label to place last
+            case AST_IF_STATEMENT: {
+                ASTNode *condition = node->data.if_stmt.condition;
+                if (step == 0) {
+                    frame->value = gen->label_count++;
+                    ast_walk_push(&walk, condition, condition_request(ranges, condition));
+                } else if (step == 1) {
+                    if (is_equality(condition))
+                        emit_label(gen, OP_JNZ, frame->value);
+                    else
+                        emit_zero_test(gen, !is_narrow(ranges, condition), OP_JZ, frame->value);
+                    ast_walk_push(&walk, node->data.if_stmt.then_block, 0);
+                } else if (step == 2 && node->data.if_stmt.else_block) {
+                    int end_label = gen->label_count++;
+                    emit_label(gen, OP_JMP, end_label);
+                    emit_label(gen, OP_LABEL, frame->value);
+                    frame->value = end_label;
+                    ast_walk_push(&walk, node->data.if_stmt.else_block, 0);
+                } else {
+                    emit_label(gen, OP_LABEL, frame->value);
+                    ast_walk_pop(&walk);
+                }
+                break;
+            }
+
+            // the loop's values go into their registers, then
+            //   jmp cond; body: ...; cond: ...; jnz body
+            // so each iteration takes one backward branch
+            case AST_WHILE_STATEMENT: {
+                ASTNode *condition = node->data.while_stmt.condition;
+                if (step == 0) {
+                    loop = push_loop(&loops);
+                    if (!loop || plan_loop(gen, node, &loops, loop, ranges, last_loop_register) != 0) {
+                        failed = 1;
+                        break;
+                    }
+                    frame->value = 0;
+                }
+                loop = &loops.loops[loops.count - 1];
+                if (step <= 1) {
+                    // frame's value says a loop value was just computed into A
+                    if (frame->value) {
+                        emit_mov(gen, loop->values[loop->ready].reg, REG_A);
+                        loop->values[loop->ready++].active = 1;
+                    }
+                    frame->value = loop->ready < loop->count;
+                    if (frame->value) {
+                        frame->step = 1;
+                        ast_walk_push(&walk, loop->values[loop->ready].expression, 0);
+                    } else {
+                        frame->step = 2;
+                        emit_label(gen, OP_JMP, loop->label + 1);
+                        emit_label(gen, OP_LABEL, loop->label);
+                        ast_walk_push(&walk, node->data.while_stmt.body, 0);
+                    }
+                } else if (step == 2) {
+                    emit_label(gen, OP_LABEL, loop->label + 1);
+                    ast_walk_push(&walk, condition, condition_request(ranges, condition));
+                } else {
+                    if (is_equality(condition))
+                        emit_label(gen, OP_JZ, loop->label);
+                    else
+                        emit_zero_test(gen, !is_narrow(ranges, condition), OP_JNZ, loop->label);
+                    loops.count--;
+                    ast_walk_pop(&walk);
+                }
+                break;
+            }
+
+            case AST_PROGRAM:
+            case AST_BLOCK:
+                if (step < node->data.block.count)
+                    ast_walk_push(&walk, node->data.block.statements[step], 0);
+                else
+                    ast_walk_pop(&walk);
+                break;
+
+            case AST_EXTERN:
+                // the name still gets an id, the linker points it at the defining module's slot
+                if (intern_symbol(&gen->externs, node->data.extern_decl.var_name) < 0) gen->out_of_memory = 1;
+                symbol_id(gen, node->data.extern_decl.var_name);
+                ast_walk_pop(&walk);
+                break;
+
+            case AST_IMPORT:
+                if (intern_symbol(&gen->imports, node->data.import.module) < 0) gen->out_of_memory = 1;
+                ast_walk_pop(&walk);
+                break;
+            default:
+                ast_walk_pop(&walk);
+                break;
+        }
+    }
+
+    int status = walk.failed || failed ? -1 : 0;
+    free_ast_walk(&walk);
+    sl_free(loops.loops);
+    return status;
+}
+
+// The variables whose values do not fit in a byte get two byte slots, every one when
+// other modules share them; returns whether the code needs G for high bytes, or -1
+// when out of memory.
+static int choose_widths(CodeGenerator *gen, const RangeAnalysis *ranges) {
+    int wide_code = 0;
+    for (int i = 0; i < ranges->variables.count; i++) {
+        if (!gen->shared_globals && fits_in_byte(ranges->stored[i])) continue;
+        if (intern_symbol(&gen->wide, symbol_name(&ranges->variables, i)) < 0) return -1;
+        wide_code = 1;
+    }
+    for (int i = 0; i < ranges->node_capacity; i++) {
+        if (ranges->nodes[i].node && !fits_in_byte(ranges->nodes[i].range)) wide_code = 1;
+    }
+    return wide_code;
+}
+
+int generate_code(CodeGenerator *gen, ASTNode *ast) {
+    int status = 0;
     if (ast->type == AST_PROGRAM) {
+        // a program that links with others shares its globals with them
         for (int i = 0; i < ast->data.block.count; i++) {
-            generate_statement(gen, ast->data.block.statements[i]);
-        }
-    }
-    
-    emit_instruction(gen, "hlt");
-    emit_instruction(gen, "");
-    emit_instruction(gen, ".data");
-    emit_instruction(gen, "var_a = 0");
-    emit_instruction(gen, "var_b = 0");
-    emit_instruction(gen, "var_sum = 0");
-    emit_instruction(gen, "var_diff = 0");
-    emit_instruction(gen, "var_x = 0");
-    emit_instruction(gen, "var_counter = 0");
-    emit_instruction(gen, "var_result = 0");
-}
-
-void write_assembly_file(CodeGenerator *gen, const char *filename) {
-    FILE *file = fopen(filename, "w");
-    if (!file) return;
-    
+            ASTNodeType type = ast->data.block.statements[i]->type;
+            if (type == AST_IMPORT || type == AST_EXTERN) gen->shared_globals = 1;
+        }
+        uint64_t start = monotonic_nanoseconds();
+        RangeAnalysis *ranges = analyze_ranges(ast, gen->shared_globals);
+        int wide_code = ranges ? choose_widths(gen, ranges) : -1;
+        gen->analysis_nanoseconds += monotonic_nanoseconds() - start;
+        if (ranges && ranges->has_error) {
+            gen->has_error = 1;
+            snprintf(gen->error_message, sizeof(gen->error_message), "%s", ranges->error_message);
+            status = -1;
+        } else if (wide_code < 0) {
+            status = -1;
+        } else {
+            status = generate_tree(gen, ast, ranges, wide_code ? REG_F : REG_G);
+        }
+        free_range_analysis(ranges);
+    }
+
+    gen->position.line = 0;
+    gen->position.column = 0;
+    emit_none(gen, OP_HLT);
+    emit_runtime(gen);
+    // an instruction or symbol that could not be added leaves the code truncated
+    return gen->out_of_memory ? -1 : status;
+}
+
+int symbol_size(const CodeGenerator *gen, int symbol_id) {
+    return find_symbol(&gen->wide, symbol_name(&gen->symbols, symbol_id)) >= 0 ? 2 : 1;
+}
+
+const char *opcode_name(Opcode opcode) {
+    if (opcode >= OP_COUNT) return "???";
+    return opcode_names[opcode];
+}
+
+const char *register_name(Register reg) {
+    if (reg > REG_G) return "?";
+    return register_names[reg];
+}
+
+static int format_operand(const CodeGenerator *gen, int kind, int value, char *buffer, size_t size) {
+    switch (kind) {
+        case OPERAND_REGISTER:
+            return snprintf(buffer, size, " %s", register_name((Register)value));
+        case OPERAND_IMMEDIATE:
+            return snprintf(buffer, size, " %d", value);
+        case OPERAND_SYMBOL:
+            return snprintf(buffer, size, " %%var_%s", symbol_name(&gen->symbols, value));
+        case OPERAND_LABEL:
+            return snprintf(buffer, size, " .L%d", value);
+        default:
+            if (size > 0) buffer[0] = '\0';
+            return 0;
+    }
+}
+
+int format_instruction(const CodeGenerator *gen, const Instruction *inst, char *buffer, size_t size) {
+    if (inst->opcode == OP_LABEL)
+        return snprintf(buffer, size, ".L%d:", inst->operand[0]);
+    int length = snprintf(buffer, size, "%s", opcode_name((Opcode)inst->opcode));
+    for (int i = 0; i < 2; i++) {
+        size_t used = (size_t)length < size ? (size_t)length : size;
+        // a byte offset into a memory operand's slot
+        if (i == 1 && inst->operand_kind[0] == OPERAND_SYMBOL && inst->operand_kind[1] == OPERAND_IMMEDIATE)
+            length += snprintf(buffer + used, size - used, "+%d", inst->operand[1]);
+        else
+            length += format_operand(gen, inst->operand_kind[i], inst->operand[i],
+                                     buffer + used, size - used);
+    }
+    return length;
+}
+
+// render straight into the sink's buffer, only long variable names need a second pass
+static void write_instruction(const CodeGenerator *gen, const Instruction *inst, OutputSink *sink) {
+    char *space = sink_reserve(sink, 64);
+    if (!space) return;
+    int length = format_instruction(gen, inst, space, 64);
+    if (length >= 64) {
+        space = sink_reserve(sink, length + 1);
+        if (!space) return;
+        format_instruction(gen, inst, space, length + 1);
+    }
+    space[length] = '\n';
+    sink_commit(sink, length + 1);
+}
+
+int is_module(const CodeGenerator *gen) {
+    return gen->externs.count > 0 || gen->imports.count > 0;
+}
+
+int write_assembly(CodeGenerator *gen, OutputSink *sink) {
+    for (int i = 0; i < gen->imports.count; i++) {
+        sink_printf(sink, ".import %s\n", symbol_name(&gen->imports, i));
+    }
+    for (int i = 0; i < gen->externs.count; i++) {
+        sink_printf(sink, ".extern var_%s\n", symbol_name(&gen->externs, i));
+    }
+    if (is_module(gen)) sink_puts(sink, "\n");
+    sink_puts(sink, ".text\n\n");
     for (int i = 0; i < gen->count; i++) {
-        fprintf(file, "%s\n", gen->instructions[i]);
+        write_instruction(gen, &gen->instructions[i], sink);
+    }
+
+    sink_puts(sink, "\n.data\n");
+    for (int i = 0; i < gen->symbols.count; i++) {
+        const char *name = symbol_name(&gen->symbols, i);
+        if (gen->data_slot && gen->data_slot[i] != i)
+            sink_printf(sink, "var_%s = var_%s\n", name, symbol_name(&gen->symbols, gen->data_slot[i]));
+        else if (find_symbol(&gen->externs, name) < 0)
+            sink_printf(sink, symbol_size(gen, i) == 2 ? "var_%s = 0, 0\n" : "var_%s = 0\n", name);
     }
-    fclose(file);
+    int saved = data_bytes_saved(gen);
+    if (saved > 0) sink_printf(sink, "; %d byte%s saved by sharing slots\n", saved, saved == 1 ? "" : "s");
+    return sink->has_error ? -1 : 0;
 }
 
-void free_codegen(CodeGenerator *gen) {
+int write_ir(CodeGenerator *gen, OutputSink *sink) {
     for (int i = 0; i < gen->count; i++) {
-        free(gen->instructions[i]);
+        sink_printf(sink, "%4d  ", i);
+        write_instruction(gen, &gen->instructions[i], sink);
     }
-    free(gen->instructions);
-    free(gen);
-}
\ No newline at end of file
+    sink_printf(sink, "; %d instructions, %d variables\n", gen->count, gen->symbols.count);
+    return sink->has_error ? -1 : 0;
+}
+
+int write_assembly_file(CodeGenerator *gen, const char *filename) {
+    OutputSink *sink = create_file_sink(filename);
+    if (!sink) return -1;
+
+    int result = write_assembly(gen, sink);
+    if (close_sink(sink) != 0) result = -1;
+    return result;
+}
+
+void free_codegen(CodeGenerator *gen) {
+    if (!gen) return;
+    sl_free(gen->instructions);
+    sl_free(gen->positions);
+    free_symbol_table(&gen->symbols);
+    free_symbol_table(&gen->wide);
+    free_symbol_table(&gen->externs);
+    free_symbol_table(&gen->imports);
+    for (int i = 0; i < RUNTIME_COUNT; i++) sl_free(gen->return_sites[i]);
+    sl_free(gen->data_slot);
+    sl_free(gen->dead_at_exit);
+    sl_free(gen);
+}
@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/document.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+
+// a re-parse lexes straight from the document, a few KiB per read, so a one-statement
+// edit copies little of a large file
+#define DOCUMENT_READ_SIZE 4096
+
+typedef struct
+{
+    const char *text;
+    size_t position;
+    size_t length;
+} DocumentReader;
+
+typedef struct
+{
+    DocumentStatement *items;
+    int count;
+    int capacity;
+} StatementList;
+
+static int read_document(void *context, char *buffer, int size)
+{
+    DocumentReader *reader = context;
+    size_t count = reader->length - reader->position;
+    if (count > DOCUMENT_READ_SIZE)
+        count = DOCUMENT_READ_SIZE;
+    if (count > (size_t)size)
+        count = size;
+    memcpy(buffer, reader->text + reader->position, count);
+    reader->position += count;
+    return (int)count;
+}
+
+static void clear_statement(DocumentStatement *statement)
+{
+    free_ast(statement->ast);
+    free(statement->error);
+    statement->ast = NULL;
+    statement->error = NULL;
+}
+
+static int add_statement(StatementList *list, const DocumentStatement *statement)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        DocumentStatement *items = realloc(list->items, sizeof(DocumentStatement) * capacity);
+        if (!items)
+            return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = *statement;
+    return 0;
+}
+
+static int reserve_text(Document *document, size_t length)
+{
+    if (length + 1 <= document->capacity)
+        return 0;
+    size_t capacity = document->capacity ? document->capacity : 256;
+    while (capacity < length + 1)
+        capacity *= 2;
+    char *text = realloc(document->text, capacity);
+    if (!text)
+        return -1;
+    document->text = text;
+    document->capacity = capacity;
+    return 0;
+}
+
+static int reserve_lines(Document *document, int count)
+{
+    if (count <= document->line_capacity)
+        return 0;
+    int capacity = document->line_capacity ? document->line_capacity : 64;
+    while (capacity < count)
+        capacity *= 2;
+    size_t *starts = realloc(document->line_starts, sizeof(size_t) * capacity);
+    if (!starts)
+        return -1;
+    document->line_starts = starts;
+    document->line_capacity = capacity;
+    return 0;
+}
+
+static int reserve_statements(Document *document, int count)
+{
+    if (count <= document->statement_capacity)
+        return 0;
+    int capacity = document->statement_capacity ? document->statement_capacity : 16;
+    while (capacity < count)
+        capacity *= 2;
+    DocumentStatement *statements = realloc(document->statements, sizeof(DocumentStatement) * capacity);
+    if (!statements)
+        return -1;
+    document->statements = statements;
+    document->statement_capacity = capacity;
+    return 0;
+}
+
+int document_line(const Document *document, size_t offset)
+{
+    int low = 0;
+    int high = document->line_count - 1;
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (document->line_starts[middle] <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+int statement_line_shift(const Document *document, const DocumentStatement *statement)
+{
+    return document_line(document, statement->start) + 1 - statement->line;
+}
+
+int document_error_count(const Document *document)
+{
+    int count = 0;
+    for (int i = 0; i < document->statement_count; i++)
+    {
+        if (document->statements[i].error)
+            count++;
+    }
+    return count;
+}
+
+// statements starting at or before offset
+static int statements_through(const Document *document, size_t offset)
+{
+    int low = 0;
+    int high = document->statement_count;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (document->statements[middle].start <= offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+static size_t position_offset(const Document *document, int line, int character)
+{
+    if (line < 0)
+        return 0;
+    if (line >= document->line_count)
+        return document->length;
+    size_t start = document->line_starts[line];
+    size_t end = line + 1 < document->line_count ? document->line_starts[line + 1] - 1 : document->length;
+    if (character < 0)
+        return start;
+    return (size_t)character < end - start ? start + character : end;
+}
+
+static size_t token_offset(const Document *document, const Token *token)
+{
+    if (token->line < 1 || token->line > document->line_count)
+        return document->length;
+    return document->line_starts[token->line - 1] + token->column - 1;
+}
+
+// where parsing picks up after an error: the next line that starts with a statement in
+// the first column, which skips the rest of a block that did not parse
+static size_t resume_offset(const Document *document, int error_line)
+{
+    for (int i = error_line; i < document->line_count; i++)
+    {
+        char c = document->text[document->line_starts[i]];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '}' && c != '\0')
+            return document->line_starts[i];
+    }
+    return document->length;
+}
+
+static int record_error(DocumentStatement *statement, Parser *parser)
+{
+    statement->error = strdup(parser->first_error.message);
+    statement->error_line = parser->first_error.line;
+    statement->error_column = parser->first_error.column;
+    statement->error_length = 1;
+    if (parser->current_token && parser->current_token->type != TOKEN_NEWLINE)
+        statement->error_length = parser->current_token->type == TOKEN_EOF ? 0 : (int)strlen(parser->current_token->value);
+    return statement->error ? 0 : -1;
+}
+
+// Parse statements from offset from until one starts where the kept statement *kept
+// (already moved to its new offset) does. Kept statements passed over on the way no
+// longer exist and are cleared; *kept ends at the first one to keep.
+static int parse_statements(Document *document, size_t from, int *kept, StatementList *fresh)
+{
+    size_t position = from;
+    for (;;)
+    {
+        // a lexer starting at position, on the right line and column
+        DocumentReader reader = {document->text, position, document->length};
+        Lexer *lexer = create_stream_lexer(read_document, &reader);
+        if (!lexer)
+            return -1;
+        int line = document_line(document, position);
+        lexer->line = line + 1;
+        lexer->column = (int)(position - document->line_starts[line]) + 1;
+        Parser *parser = create_parser(lexer);
+        if (!parser || !parser->current_token)
+        {
+            free_parser(parser);
+            free_lexer(lexer);
+            return -1;
+        }
+        // stop at the error, where the token to underline is; statements resume below
+        parser->max_errors = 1;
+
+        int status = 1; // 1 done, 0 resume after an error, -1 out of memory
+        for (;;)
+        {
+            skip_newlines(parser);
+            Token *token = parser->current_token;
+            size_t start = token->type == TOKEN_EOF ? document->length : token_offset(document, token);
+            while (*kept < document->statement_count && document->statements[*kept].start < start)
+                clear_statement(&document->statements[(*kept)++]);
+            if (token->type == TOKEN_EOF)
+                break;
+            // lined up with the old statements again, the rest is unchanged
+            if (*kept < document->statement_count && document->statements[*kept].start == start)
+                break;
+
+            DocumentStatement statement = {start, token->line, NULL, NULL, 0, 0, 0};
+            statement.ast = parse_top_level(parser);
+            if (parser->has_error)
+            {
+                free_ast(statement.ast);
+                statement.ast = NULL;
+                if (record_error(&statement, parser) != 0)
+                    status = -1;
+            }
+            if (status < 0 || add_statement(fresh, &statement) != 0)
+            {
+                clear_statement(&statement);
+                status = -1;
+                break;
+            }
+            if (parser->has_error)
+            {
+                position = resume_offset(document, statement.error_line);
+                status = 0;
+                break;
+            }
+        }
+        free_parser(parser);
+        free_lexer(lexer);
+        if (status != 0)
+            return status < 0 ? -1 : 0;
+    }
+}
+
+static void build_lines(Document *document)
+{
+    document->line_count = 0;
+    size_t offset = 0;
+    for (;;)
+    {
+        document->line_starts[document->line_count++] = offset;
+        const char *newline = memchr(document->text + offset, '\n', document->length - offset);
+        if (!newline)
+            break;
+        offset = newline - document->text + 1;
+    }
+}
+
+// Re-parse from the first of the statements [first, after) (or from the top when first
+// is 0) and splice the result in their place. The statements from after on must
+// already be at their new offsets.
+static int reparse(Document *document, int first, int after)
+{
+    size_t from = first > 0 ? document->statements[first].start : 0;
+    for (int i = first; i < after; i++)
+        clear_statement(&document->statements[i]);
+
+    StatementList fresh = {NULL, 0, 0};
+    int kept = after;
+    int status = parse_statements(document, from, &kept, &fresh);
+    int tail = document->statement_count - kept;
+    if (status == 0)
+        status = reserve_statements(document, first + fresh.count + tail);
+    if (status != 0)
+    {
+        // keep the document consistent: nothing parsed rather than half of it
+        for (int i = 0; i < fresh.count; i++)
+            clear_statement(&fresh.items[i]);
+        for (int i = 0; i < document->statement_count; i++)
+            clear_statement(&document->statements[i]);
+        document->statement_count = 0;
+        free(fresh.items);
+        return -1;
+    }
+    memmove(document->statements + first + fresh.count, document->statements + kept,
+            sizeof(DocumentStatement) * tail);
+    if (fresh.count > 0)
+        memcpy(document->statements + first, fresh.items, sizeof(DocumentStatement) * fresh.count);
+    document->statement_count = first + fresh.count + tail;
+    document->reparsed = fresh.count;
+    free(fresh.items);
+    return 0;
+}
+
+Document *create_document(const char *text, size_t length)
+{
+    Document *document = calloc(1, sizeof(Document));
+    if (!document)
+        return NULL;
+    if (set_document_text(document, text, length) != 0)
+    {
+        free_document(document);
+        return NULL;
+    }
+    return document;
+}
+
+void free_document(Document *document)
+{
+    if (!document)
+        return;
+    for (int i = 0; i < document->statement_count; i++)
+        clear_statement(&document->statements[i]);
+    free(document->statements);
+    free(document->line_starts);
+    free(document->text);
+    free(document);
+}
+
+int set_document_text(Document *document, const char *text, size_t length)
+{
+    for (int i = 0; i < document->statement_count; i++)
+        clear_statement(&document->statements[i]);
+    document->statement_count = 0;
+
+    if (reserve_text(document, length) != 0)
+        return -1;
+    memcpy(document->text, text, length);
+    document->text[length] = '\0';
+    document->length = length;
+
+    int lines = 1;
+    for (size_t i = 0; i < length; i++)
+        lines += text[i] == '\n';
+    if (reserve_lines(document, lines) != 0)
+        return -1;
+    build_lines(document);
+    return reparse(document, 0, 0);
+}
+
+int edit_document(Document *document, int start_line, int start_character,
+                  int end_line, int end_character, const char *text, size_t length)
+{
+    size_t start = position_offset(document, start_line, start_character);
+    size_t end = position_offset(document, end_line, end_character);
+    if (end < start)
+    {
+        size_t swap = start;
+        start = end;
+        end = swap;
+    }
+
+    // Statements on the edited lines are parsed again: from the one holding the start
+    // of the first line (a column may have moved) to the last starting on the last line.
+    int first_line = document_line(document, start);
+    int last_line = document_line(document, end);
+    const char *newline = memchr(document->text + end, '\n', document->length - end);
+    size_t last_line_end = newline ? (size_t)(newline - document->text) : document->length;
+    int first = statements_through(document, document->line_starts[first_line]) - 1;
+    int after = statements_through(document, last_line_end);
+    // a statement where parsing resumed after an error starts there only because of how
+    // its line begins, so the statement with the error is parsed again as well
+    if (first > 0 && document->statements[first - 1].error)
+        first--;
+    if (first < 0)
+        first = 0;
+
+    size_t removed = end - start;
+    size_t new_length = document->length - removed + length;
+    int added_lines = 0;
+    for (size_t i = 0; i < length; i++)
+        added_lines += text[i] == '\n';
+    int tail_lines = document->line_count - (last_line + 1);
+    if (reserve_text(document, new_length) != 0 || reserve_lines(document, first_line + 1 + added_lines + tail_lines) != 0)
+        return -1;
+
+    memmove(document->text + start + length, document->text + end, document->length - end + 1);
+    memcpy(document->text + start, text, length);
+    document->length = new_length;
+
+    // lines after the edit move along, the edit's own newlines become new lines
+    size_t *starts = document->line_starts;
+    memmove(starts + first_line + 1 + added_lines, starts + last_line + 1, sizeof(size_t) * tail_lines);
+    for (int i = 0; i < tail_lines; i++)
+        starts[first_line + 1 + added_lines + i] = starts[first_line + 1 + added_lines + i] - removed + length;
+    int line = first_line + 1;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] == '\n')
+            starts[line++] = start + i + 1;
+    }
+    document->line_count = first_line + 1 + added_lines + tail_lines;
+
+    for (int i = after; i < document->statement_count; i++)
+        document->statements[i].start = document->statements[i].start - removed + length;
+    return reparse(document, first, after);
+}
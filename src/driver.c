@@ -0,0 +1,1874 @@
+#define _POSIX_C_SOURCE 200809L
+#define _XOPEN_SOURCE 700 // realpath
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/driver.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/astfile.h"
+#include "../include/codegen.h"
+#include "../include/assembler.h"
+#include "../include/listing.h"
+#include "../include/linker.h"
+#include "../include/simulator.h"
+#include "../include/bytecode.h"
+#include "../include/x86_codegen.h"
+#include "../include/jit.h"
+#include "../include/threadpool.h"
+
+static const char *emit_names[] = {"none", "tokens", "ast", "ir", "asm", "bin", "hex", "obj", "ast-bin", "listing"};
+static const char *input_names[] = {"source", "ast-bin"};
+static const char *phase_names[] = {"lex", "parse", "codegen", "assemble"};
+static const char *allocator_names[] = {"system", "arena"};
+
+// call sites listed by --mem-report
+#define MEM_REPORT_SITES 10
+
+void init_compile_options(CompileOptions *options)
+{
+    memset(options, 0, sizeof(CompileOptions));
+    options->emit = EMIT_NONE;
+    options->stop_after = PHASE_ASSEMBLE;
+    options->target = TARGET_8BIT;
+    options->cache_size = CACHE_DEFAULT_SIZE_LIMIT;
+    options->max_errors = PARSER_MAX_ERRORS;
+    options->max_cycles = DEFAULT_MAX_CYCLES;
+    pass_level("2", &options->passes.enabled);
+}
+
+void write_usage(OutputSink *sink, const char *program)
+{
+    sink_printf(sink,
+                "Usage: %s [options] <input.sl>... [@response-file]...\n"
+                "       %s [options] <module.slo>...  link module objects into one program\n"
+                "  --emit=tokens|ast|ir|asm|bin|hex|obj|ast-bin|listing\n"
+                "                                     what to write (default: asm, an executable for x86-64,\n"
+                "                                     bin when linking)\n"
+                "  --listing                          same as --emit=listing: the 8-bit code under each\n"
+                "                                     source line, with bytes and cycles per line,\n"
+                "                                     statement and block\n"
+                "  -o <path>                          output path, \"-\" for stdout\n"
+                "  -                                  as an input: the source on stdin, lexed as it arrives\n"
+                "  --from=source|ast-bin              what the inputs are (default: source); ast-bin files\n"
+                "                                     are mapped and compiled without lexing or parsing\n"
+                "  --stop-after=lex|parse|codegen|assemble\n"
+                "                                     stop the pipeline after a phase\n"
+                "  --target=8bit|8bit-ext|x86-64      code generator (default: 8bit); 8bit-ext adds the\n"
+                "                                     simulator's shl, shr, adc, sbc, jnc, call and ret\n"
+                "  --simulate                         run on the 8-bit CPU simulator\n"
+                "  --vm                               run on the host bytecode VM\n"
+                "  --run                              compile to native code in memory and run it\n"
+                "  -j <n>, --jobs=<n>                 compile inputs on n threads (default: one per CPU)\n"
+                "  --cache-dir=<dir>                  reuse outputs of unchanged inputs from a cache\n"
+                "  --cache-size=<n>[k|m|g]            cache size limit in bytes (default: 256m)\n"
+                "  --cache-stats                      report cache hits and misses on stderr\n"
+                "  --time-report[=text|json|<path>]   time every phase, on stderr or into a file\n"
+                "                                     (JSON when the path ends in .json)\n"
+                "  --allocator=system|arena           how the compiler allocates (default: system)\n"
+                "  --mem-report                       report allocations per phase and call site\n"
+                "  -O0|-O1|-O2|-Os                    8-bit optimization level (default: -O2)\n"
+                "  --disable-pass=<pass>              skip a pass: fold, loops, mulchain, peephole, slots\n"
+                "  --print-after=<pass>               dump the AST or the code after a pass on stderr\n"
+                "  --pass-stats                       report every pass's time and changes on stderr\n"
+                "  --max-errors=<n>                   syntax errors to report per input before giving up\n"
+                "                                     (default: 20, 0 for no limit)\n"
+                "  --max-cycles=<n>                   stop a run after n simulator cycles, or n loop\n"
+                "                                     iterations on --vm and --run\n"
+                "                                     (default: 100000000, 0 for no limit)\n"
+                "  --help                             show this message\n"
+                "Modes, as the first argument (the socket defaults to $SIMPLELANG_SOCKET or a per-user path):\n"
+                "  --daemon[=<socket>]                run a resident compile server on a Unix socket\n"
+                "  --connect[=<socket>] <args>...     compile on the server, or here when none runs\n"
+                "  --stop-daemon[=<socket>]           stop a running compile server\n"
+                "  --lsp                              serve an editor over the language server protocol\n"
+                "                                     on stdin and stdout\n",
+                program, program);
+}
+
+void free_compile_options(CompileOptions *options)
+{
+    for (int i = 0; i < options->response_count; i++)
+    {
+        free(options->response_files[i]);
+    }
+    free(options->response_files);
+    free(options->input_paths);
+    memset(options, 0, sizeof(CompileOptions));
+}
+
+// relative paths are taken from options->base_directory when one is set; caller frees
+static char *resolve_path(const CompileOptions *options, const char *path)
+{
+    const char *base = options->base_directory;
+    if (!base || path[0] == '/' || strcmp(path, "-") == 0)
+        base = NULL;
+
+    size_t length = (base ? strlen(base) + 1 : 0) + strlen(path) + 1;
+    char *resolved = malloc(length);
+    if (!resolved)
+        return NULL;
+    if (base)
+        snprintf(resolved, length, "%s/%s", base, path);
+    else
+        strcpy(resolved, path);
+    return resolved;
+}
+
+static int add_input(CompileOptions *options, const char *path)
+{
+    if (options->input_count == options->input_capacity)
+    {
+        int capacity = options->input_capacity ? options->input_capacity * 2 : 16;
+        const char **paths = realloc(options->input_paths, sizeof(char *) * capacity);
+        if (!paths)
+            return -1;
+        options->input_paths = paths;
+        options->input_capacity = capacity;
+    }
+    options->input_paths[options->input_count++] = path;
+    return 0;
+}
+
+// @file lists more inputs separated by whitespace; the text is kept and split in place
+static int add_response_file(CompileOptions *options, const char *path, OutputSink *diagnostics)
+{
+    char *resolved = resolve_path(options, path);
+    char *text = resolved ? read_file(resolved) : NULL;
+    free(resolved);
+    if (!text)
+    {
+        sink_printf(diagnostics, "Error: Failed to read response file '%s'\n", path);
+        return -1;
+    }
+    char **files = realloc(options->response_files, sizeof(char *) * (options->response_count + 1));
+    if (!files)
+    {
+        free(text);
+        return -1;
+    }
+    options->response_files = files;
+    options->response_files[options->response_count++] = text;
+
+    char *p = text;
+    while (*p)
+    {
+        while (*p && isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            break;
+        char *start = p;
+        while (*p && !isspace((unsigned char)*p))
+            p++;
+        if (*p)
+            *p++ = '\0';
+        if (add_input(options, start) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int lookup_name(const char *const *names, int count, const char *name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(names[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int has_extension(const char *path, const char *extension)
+{
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return path_length > extension_length &&
+           strcmp(path + path_length - extension_length, extension) == 0;
+}
+
+// last phase an output needs
+static CompilePhase phase_for_emit(EmitKind emit)
+{
+    switch (emit)
+    {
+    case EMIT_NONE:
+    case EMIT_TOKENS:
+        return PHASE_LEX;
+    case EMIT_AST:
+    case EMIT_AST_BIN:
+        return PHASE_PARSE;
+    case EMIT_IR:
+    case EMIT_ASM:
+        return PHASE_CODEGEN;
+    case EMIT_BIN:
+    case EMIT_HEX:
+    case EMIT_OBJ:
+    case EMIT_LISTING:
+        return PHASE_ASSEMBLE;
+    default:
+        return PHASE_ASSEMBLE;
+    }
+}
+
+// without --emit, -o picks the format from its extension like the old positional outputs did
+static EmitKind emit_for_path(const char *path, TargetKind target)
+{
+    if (target == TARGET_X86_64)
+        return strcmp(path, "-") == 0 || has_extension(path, ".s") ? EMIT_ASM : EMIT_BIN;
+    if (has_extension(path, ".bin"))
+        return EMIT_BIN;
+    if (has_extension(path, ".hex"))
+        return EMIT_HEX;
+    if (has_extension(path, ".slo"))
+        return EMIT_OBJ;
+    return EMIT_ASM;
+}
+
+// a byte count with an optional k, m or g suffix
+static int parse_size(const char *text, size_t *size)
+{
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text)
+        return -1;
+    int shift = 0;
+    if (*end == 'k' || *end == 'K')
+        shift = 10;
+    else if (*end == 'm' || *end == 'M')
+        shift = 20;
+    else if (*end == 'g' || *end == 'G')
+        shift = 30;
+    if (shift)
+        end++;
+    if (*end)
+        return -1;
+    *size = (size_t)(value << shift);
+    return 0;
+}
+
+int parse_options(int argc, char *argv[], CompileOptions *options, OutputSink *diagnostics)
+{
+    int emit = -1;
+    int stop_after = -1;
+    unsigned disabled_passes = 0; // applied after the last -O
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            return 1;
+        }
+        else if (strncmp(arg, "--emit=", 7) == 0)
+        {
+            emit = lookup_name(emit_names, EMIT_LISTING + 1, arg + 7);
+            if (emit < 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown output kind '%s'\n", arg + 7);
+                return -1;
+            }
+        }
+        else if (strcmp(arg, "--listing") == 0)
+        {
+            emit = EMIT_LISTING;
+        }
+        else if (strncmp(arg, "--stop-after=", 13) == 0)
+        {
+            stop_after = lookup_name(phase_names, PHASE_ASSEMBLE + 1, arg + 13);
+            if (stop_after < 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown phase '%s'\n", arg + 13);
+                return -1;
+            }
+        }
+        else if (strncmp(arg, "--from=", 7) == 0)
+        {
+            int from = lookup_name(input_names, INPUT_AST_BIN + 1, arg + 7);
+            if (from < 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown input format '%s'\n", arg + 7);
+                return -1;
+            }
+            options->from = (InputFormat)from;
+        }
+        else if (strcmp(arg, "-o") == 0)
+        {
+            if (++i >= argc)
+            {
+                sink_printf(diagnostics, "Error: -o needs a path\n");
+                return -1;
+            }
+            options->output_path = argv[i];
+        }
+        else if (strcmp(arg, "--target=8bit") == 0)
+        {
+            options->target = TARGET_8BIT;
+        }
+        else if (strcmp(arg, "--target=8bit-ext") == 0)
+        {
+            options->target = TARGET_8BIT_EXT;
+        }
+        else if (strcmp(arg, "--target=x86-64") == 0)
+        {
+            options->target = TARGET_X86_64;
+        }
+        else if (strcmp(arg, "--simulate") == 0)
+        {
+            options->simulate = 1;
+        }
+        else if (strcmp(arg, "--vm") == 0)
+        {
+            options->run_vm = 1;
+        }
+        else if (strcmp(arg, "--run") == 0)
+        {
+            options->run_jit = 1;
+        }
+        else if (strncmp(arg, "-j", 2) == 0 || strncmp(arg, "--jobs=", 7) == 0)
+        {
+            // -j <n>, -j<n> or --jobs=<n>
+            const char *count = arg[1] != 'j' ? arg + 7 : arg[2] ? arg + 2 : ++i < argc ? argv[i] : NULL;
+            options->jobs = count ? atoi(count) : 0;
+            if (options->jobs < 1)
+            {
+                sink_printf(diagnostics, "Error: -j needs a positive thread count\n");
+                return -1;
+            }
+        }
+        else if (strncmp(arg, "--max-errors=", 13) == 0)
+        {
+            char *end;
+            long count = strtol(arg + 13, &end, 10);
+            if (end == arg + 13 || *end || count < 0 || count > INT_MAX)
+            {
+                sink_printf(diagnostics, "Error: --max-errors needs a count, 0 for no limit\n");
+                return -1;
+            }
+            options->max_errors = (int)count;
+        }
+        else if (strncmp(arg, "--max-cycles=", 13) == 0)
+        {
+            char *end;
+            long long count = strtoll(arg + 13, &end, 10);
+            if (end == arg + 13 || *end || count < 0)
+            {
+                sink_printf(diagnostics, "Error: --max-cycles needs a count, 0 for no limit\n");
+                return -1;
+            }
+            options->max_cycles = count;
+        }
+        else if (strncmp(arg, "--cache-dir=", 12) == 0 && arg[12])
+        {
+            options->cache_directory = arg + 12;
+        }
+        else if (strncmp(arg, "--cache-size=", 13) == 0)
+        {
+            if (parse_size(arg + 13, &options->cache_size) != 0)
+            {
+                sink_printf(diagnostics, "Error: Invalid cache size '%s'\n", arg + 13);
+                return -1;
+            }
+        }
+        else if (strcmp(arg, "--cache-stats") == 0)
+        {
+            options->cache_stats = 1;
+        }
+        else if (strcmp(arg, "--time-report") == 0 || strncmp(arg, "--time-report=", 14) == 0)
+        {
+            const char *value = arg[13] ? arg + 14 : "text";
+            options->time_report = 1;
+            options->time_format = TIME_FORMAT_TEXT;
+            options->time_report_path = NULL;
+            if (strcmp(value, "json") == 0)
+                options->time_format = TIME_FORMAT_JSON;
+            else if (strcmp(value, "text") != 0)
+                options->time_report_path = value;
+            if (options->time_report_path && has_extension(value, ".json"))
+                options->time_format = TIME_FORMAT_JSON;
+        }
+        else if (strncmp(arg, "--allocator=", 12) == 0)
+        {
+            int allocator = lookup_name(allocator_names, ALLOCATOR_ARENA + 1, arg + 12);
+            if (allocator < 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown allocator '%s'\n", arg + 12);
+                return -1;
+            }
+            options->allocator = (AllocatorKind)allocator;
+        }
+        else if (strcmp(arg, "--mem-report") == 0)
+        {
+            options->mem_report = 1;
+        }
+        else if (strncmp(arg, "-O", 2) == 0)
+        {
+            if (pass_level(arg + 2, &options->passes.enabled) != 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown optimization level '%s'\n", arg);
+                return -1;
+            }
+        }
+        else if (strncmp(arg, "--disable-pass=", 15) == 0 || strncmp(arg, "--print-after=", 14) == 0)
+        {
+            const char *name = strchr(arg, '=') + 1;
+            int pass = find_pass(name);
+            if (pass < 0)
+            {
+                sink_printf(diagnostics, "Error: Unknown pass '%s'\n", name);
+                return -1;
+            }
+            if (arg[2] == 'd')
+                disabled_passes |= PASS_BIT(pass);
+            else
+                options->passes.print_after |= PASS_BIT(pass);
+        }
+        else if (strcmp(arg, "--pass-stats") == 0)
+        {
+            options->pass_stats = 1;
+        }
+        else if (arg[0] == '@')
+        {
+            if (add_response_file(options, arg + 1, diagnostics) != 0)
+                return -1;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            sink_printf(diagnostics, "Error: Unknown option '%s'\n", arg);
+            return -1;
+        }
+        else if (add_input(options, arg) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (options->input_count == 0)
+    {
+        sink_printf(diagnostics, "Error: No input file\n");
+        return -1;
+    }
+    options->passes.enabled &= ~disabled_passes;
+    int stdin_inputs = 0;
+    for (int i = 0; i < options->input_count; i++)
+    {
+        stdin_inputs += strcmp(options->input_paths[i], "-") == 0;
+    }
+    if (stdin_inputs > 1)
+    {
+        sink_printf(diagnostics, "Error: Standard input ('-') can only be read once\n");
+        return -1;
+    }
+    // objects are linked together rather than compiled one by one
+    int objects = 0;
+    for (int i = 0; i < options->input_count; i++)
+    {
+        objects += has_extension(options->input_paths[i], ".slo");
+    }
+    if (objects && objects != options->input_count)
+    {
+        sink_printf(diagnostics, "Error: Cannot mix sources and .slo objects, compile the sources with --emit=obj first\n");
+        return -1;
+    }
+    options->link = objects > 0;
+    if (options->from == INPUT_AST_BIN && (stdin_inputs || options->link))
+    {
+        sink_printf(diagnostics, "Error: --from=ast-bin needs .sla files, not standard input or objects\n");
+        return -1;
+    }
+
+    // several inputs may share stdout, but not one output file
+    if (!options->link && options->input_count > 1 && options->output_path &&
+        strcmp(options->output_path, "-") != 0)
+    {
+        sink_printf(diagnostics, "Error: -o names a single output but %d inputs were given\n", options->input_count);
+        return -1;
+    }
+
+    // nothing is written by default when the run only checks or executes the program
+    int runs = options->simulate || options->run_vm || options->run_jit;
+    if (emit >= 0)
+        options->emit = (EmitKind)emit;
+    else if (options->output_path)
+        options->emit = emit_for_path(options->output_path, options->target);
+    else if (options->link)
+        options->emit = options->simulate ? EMIT_NONE : EMIT_BIN;
+    else if (stop_after >= 0 || runs)
+        options->emit = EMIT_NONE;
+    else
+        options->emit = options->target == TARGET_X86_64 ? EMIT_BIN : EMIT_ASM;
+
+    if (options->target == TARGET_X86_64 &&
+        (options->emit == EMIT_IR || options->emit == EMIT_HEX || options->emit == EMIT_OBJ ||
+         options->emit == EMIT_LISTING || options->simulate))
+    {
+        sink_printf(diagnostics,
+                    "Error: --emit=ir, --emit=hex, --emit=obj, --listing and --simulate need the 8-bit target\n");
+        return -1;
+    }
+    if (options->target == TARGET_X86_64 && (options->passes.print_after || options->pass_stats))
+    {
+        sink_printf(diagnostics, "Error: --print-after and --pass-stats need the 8-bit target\n");
+        return -1;
+    }
+    if (options->link && (options->target == TARGET_X86_64 || options->run_vm || options->run_jit ||
+                          (options->emit != EMIT_BIN && options->emit != EMIT_HEX && options->emit != EMIT_NONE)))
+    {
+        sink_printf(diagnostics, "Error: Linked objects can only be written with --emit=bin or --emit=hex, or run with --simulate\n");
+        return -1;
+    }
+
+    if (options->from == INPUT_AST_BIN && (options->emit == EMIT_TOKENS || stop_after == PHASE_LEX))
+    {
+        sink_printf(diagnostics, "Error: An AST file has no tokens, it starts after the parse phase\n");
+        return -1;
+    }
+
+    CompilePhase needed = phase_for_emit(options->emit);
+    if ((options->run_vm || options->run_jit || options->from == INPUT_AST_BIN) && needed < PHASE_PARSE)
+        needed = PHASE_PARSE;
+    if (options->simulate || options->link)
+        needed = PHASE_ASSEMBLE;
+    if (stop_after < 0)
+    {
+        options->stop_after = needed;
+    }
+    else if ((CompilePhase)stop_after < needed)
+    {
+        sink_printf(diagnostics, "Error: The requested output needs the %s phase, but --stop-after=%s\n",
+                    phase_names[needed], phase_names[stop_after]);
+        return -1;
+    }
+    else
+    {
+        options->stop_after = (CompilePhase)stop_after;
+    }
+    return 0;
+}
+
+// output/<input base name><extension>, output/stdin<extension> for "-"; caller frees
+static char *default_output_path(const char *input_filename, const char *extension)
+{
+    if (strcmp(input_filename, "-") == 0)
+        input_filename = "stdin";
+    const char *base = strrchr(input_filename, '/');
+    base = base ? base + 1 : input_filename;
+    const char *dot = strrchr(base, '.');
+    size_t base_length = dot ? (size_t)(dot - base) : strlen(base);
+
+    char *path = malloc(strlen("output/") + base_length + strlen(extension) + 1);
+    if (!path)
+        return NULL;
+    sprintf(path, "output/%.*s%s", (int)base_length, base, extension);
+    return path;
+}
+
+// default_output_path resolved against the working directory, creating output/ if it is
+// missing; caller frees
+static char *default_output_file(const CompileOptions *options, const char *input_filename,
+                                 const char *extension)
+{
+    char *relative = default_output_path(input_filename, extension);
+    char *resolved = relative ? resolve_path(options, relative) : NULL;
+    free(relative);
+    if (!resolved)
+        return NULL;
+    // if this fails so does opening the file, which reports the path
+    char *slash = strrchr(resolved, '/');
+    *slash = '\0';
+    mkdir(resolved, 0755);
+    *slash = '/';
+    return resolved;
+}
+
+// -o if given, otherwise stdout for listings (extension NULL) or output/<name><extension>; caller frees
+static char *output_path(const CompileJob *job, const char *extension)
+{
+    const char *path = job->options->output_path;
+    if (!path && !extension)
+        path = "-";
+    if (path)
+        return resolve_path(job->options, path);
+    return default_output_file(job->options, job->input_path, extension);
+}
+
+// whether listings share stdout with reports, which then move to stderr
+static int writes_stdout(const CompileOptions *options)
+{
+    if (options->output_path)
+        return strcmp(options->output_path, "-") == 0;
+    return options->emit == EMIT_TOKENS || options->emit == EMIT_AST || options->emit == EMIT_IR ||
+           options->emit == EMIT_LISTING;
+}
+
+// allocations from here on are charged to phase, returns the start time if timed
+static uint64_t begin_phase(CompileJob *job, TimedPhase phase)
+{
+    set_allocation_phase(phase);
+    return TIMER_START(job->times);
+}
+
+static void output_error(CompileJob *job, const char *path)
+{
+    sink_printf(job->diagnostics, "Error: Failed to write output to '%s'\n", path ? path : "output");
+}
+
+// "-" is the job's stdout, anything else a file of its own
+static OutputSink *open_output(CompileJob *job, const char *path)
+{
+    if (strcmp(path, "-") == 0)
+        return job->out;
+    return create_file_sink(path);
+}
+
+static int close_output(CompileJob *job, OutputSink *sink)
+{
+    if (sink == job->out)
+        return sink->has_error ? -1 : 0;
+    return close_sink(sink);
+}
+
+// open the output, write one thing into it, and close it
+static int write_output(CompileJob *job, const char *extension,
+                        int (*write)(OutputSink *, void *), void *data)
+{
+    uint64_t start = begin_phase(job, TIME_WRITE);
+    char *path = output_path(job, extension);
+    OutputSink *sink = path ? open_output(job, path) : NULL;
+    int result = -1;
+    if (sink)
+    {
+        result = write(sink, data);
+        size_t written = sink->total_length;
+        if (close_output(job, sink) != 0)
+            result = -1;
+        TIMER_STOP(job->times, TIME_WRITE, start, written);
+    }
+    if (result != 0)
+        output_error(job, path);
+    free(path);
+    return result == 0 ? 0 : 1;
+}
+
+static int write_ast_output(OutputSink *sink, void *ast)
+{
+    write_ast(sink, ast);
+    return sink->has_error ? -1 : 0;
+}
+
+static int write_ir_output(OutputSink *sink, void *codegen)
+{
+    return write_ir(codegen, sink);
+}
+
+static int write_assembly_output(OutputSink *sink, void *codegen)
+{
+    return write_assembly(codegen, sink);
+}
+
+// what a listing is made from
+typedef struct
+{
+    const CodeGenerator *codegen;
+    const ProgramImage *image;
+    ASTNode *program;
+    const char *source; // NULL when the input was streamed or an AST file
+} Listing;
+
+static int write_listing_output(OutputSink *sink, void *data)
+{
+    Listing *listing = data;
+    return write_listing(sink, listing->codegen, listing->image, listing->program, listing->source);
+}
+
+static int write_binary_output(OutputSink *sink, void *image)
+{
+    return write_binary_image(image, sink);
+}
+
+static int write_hex_output(OutputSink *sink, void *image)
+{
+    return write_intel_hex(image, sink);
+}
+
+static int write_ast_file_output(OutputSink *sink, void *ast)
+{
+    return write_ast_file(sink, ast);
+}
+
+static int write_x86_output(OutputSink *sink, void *ast)
+{
+    return generate_x86_assembly(ast, sink);
+}
+
+// the source text, or when source is NULL stdin, lexed chunk by chunk as it arrives
+static Lexer *open_lexer(char *source)
+{
+    return source ? create_lexer(source) : create_fd_lexer(STDIN_FILENO);
+}
+
+// a stream that broke off is an error, even if what did arrive is a valid program
+static int check_stream(CompileJob *job, Lexer *lexer)
+{
+    if (!lexer->read_error)
+        return 0;
+    sink_printf(job->diagnostics, "Error: Failed to read input file '%s'\n", job->input_path);
+    return 1;
+}
+
+// lex the whole input on its own, only when the tokens are wanted or lexing is all that runs
+static int run_lexer(CompileJob *job, char *source)
+{
+    char *path = NULL;
+    OutputSink *sink = NULL;
+    if (job->options->emit == EMIT_TOKENS)
+    {
+        path = output_path(job, NULL);
+        sink = path ? open_output(job, path) : NULL;
+        if (!sink)
+        {
+            output_error(job, path);
+            free(path);
+            return 1;
+        }
+    }
+
+    uint64_t start = begin_phase(job, TIME_LEX);
+    Lexer *lexer = open_lexer(source);
+    if (!lexer)
+    {
+        if (sink)
+            close_output(job, sink);
+        free(path);
+        return 1;
+    }
+
+    int errors = 0;
+    int token_count = 0;
+    Token *token;
+    while ((token = get_next_token(lexer)))
+    {
+        if (token->type == TOKEN_ERROR)
+        {
+            sink_printf(job->diagnostics, "%s:%d:%d: error: Unexpected character '%s'\n",
+                        job->input_path, token->line, token->column, token->value);
+            errors++;
+        }
+        if (sink)
+            sink_printf(sink, "%-12s %-10s Line :%3d Col:%2d\n", token_type_to_string(token->type),
+                        token->value ? token->value : "NULL", token->line, token->column);
+        int done = token->type == TOKEN_EOF;
+        free_token(token);
+        if (done)
+            break;
+        token_count++;
+    }
+    if (!token)
+        errors++;
+    errors += check_stream(job, lexer);
+    free_lexer(lexer);
+    TIMER_STOP(job->times, TIME_LEX, start, token_count);
+
+    if (sink)
+    {
+        sink_printf(sink, "Total tokens: %d\n", token_count);
+        if (close_output(job, sink) != 0)
+        {
+            output_error(job, path);
+            errors++;
+        }
+    }
+    free(path);
+    return errors ? 1 : 0;
+}
+
+static void report_run_limit(CompileJob *job)
+{
+    sink_printf(job->diagnostics, "%s: error: Stopped after %lld loop iterations (--max-cycles)\n",
+                job->input_path, job->options->max_cycles);
+}
+
+// with several inputs, each one's run results start with its path
+static void write_run_header(CompileJob *job, OutputSink *sink)
+{
+    if (job->options->input_count > 1 && !job->options->link)
+        sink_printf(sink, "%s:\n", job->input_path);
+}
+
+// compile to bytecode and run on the host, printing every variable
+static int run_on_vm(CompileJob *job, ASTNode *ast)
+{
+    BytecodeProgram *program = compile_bytecode(ast);
+    if (!program)
+    {
+        sink_printf(job->diagnostics, "Error: Failed to compile bytecode\n");
+        return 1;
+    }
+    int *slots = calloc(program->symbols.count + 1, sizeof(int));
+    int status = 1;
+    uint64_t start = begin_phase(job, TIME_RUN);
+    int result = slots ? run_bytecode(program, slots, job->options->max_cycles) : -1;
+    TIMER_STOP(job->times, TIME_RUN, start, 0);
+    if (result == 0)
+    {
+        write_run_header(job, job->out);
+        write_bytecode_variables(job->out, program, slots);
+        status = 0;
+    }
+    else if (result == RUN_LIMIT_REACHED)
+    {
+        report_run_limit(job);
+    }
+    free(slots);
+    free_bytecode(program);
+    return status;
+}
+
+// compile to native code in memory and run it, printing every variable
+static int run_on_jit(CompileJob *job, ASTNode *ast)
+{
+    JitProgram *program = jit_compile(ast);
+    if (!program)
+    {
+        sink_printf(job->diagnostics, "Error: JIT compilation failed\n");
+        return 1;
+    }
+    int *slots = calloc(program->symbols.count + 1, sizeof(int));
+    int status = 1;
+    uint64_t start = begin_phase(job, TIME_RUN);
+    int result = slots ? jit_run(program, slots, job->options->max_cycles) : -1;
+    TIMER_STOP(job->times, TIME_RUN, start, 0);
+    if (result == 0)
+    {
+        write_run_header(job, job->out);
+        write_jit_variables(job->out, program, slots);
+        status = 0;
+    }
+    else if (result == RUN_LIMIT_REACHED)
+    {
+        report_run_limit(job);
+    }
+    free(slots);
+    free_jit_program(program);
+    return status;
+}
+
+static int simulate_program(CompileJob *job, const SymbolTable *symbols, ProgramImage *image)
+{
+    Simulator *sim = create_simulator(image);
+    if (!sim)
+        return 1;
+    uint64_t start = begin_phase(job, TIME_RUN);
+    int status = run_simulator(sim, job->options->max_cycles);
+    TIMER_STOP(job->times, TIME_RUN, start, 0);
+    OutputSink *report = writes_stdout(job->options) ? job->diagnostics : job->out;
+    write_run_header(job, report);
+    write_simulation_report(report, sim, symbols, image);
+    free_simulator(sim);
+    return status;
+}
+
+// write and run an assembled or linked program as the options ask
+static int emit_program(CompileJob *job, const SymbolTable *symbols, ProgramImage *image)
+{
+    const CompileOptions *options = job->options;
+    int status = 0;
+    if (options->emit == EMIT_BIN)
+        status = write_output(job, ".bin", write_binary_output, image);
+    else if (options->emit == EMIT_HEX)
+        status = write_output(job, ".hex", write_hex_output, image);
+    if (!status && options->simulate)
+        status = simulate_program(job, symbols, image);
+    return status;
+}
+
+static int write_object_output(OutputSink *sink, void *object)
+{
+    return write_object(object, sink);
+}
+
+// what an object is checked against before an import reuses it
+static uint64_t module_hash(const CompileJob *job, const char *source)
+{
+    uint64_t hash = hash_bytes(compiler_fingerprint(), &job->options->passes.enabled,
+                               sizeof(job->options->passes.enabled));
+    hash = hash_bytes(hash, &job->options->target, sizeof(job->options->target));
+    return hash_bytes(hash, source, strlen(source));
+}
+
+// modules of one program, each once, and the order they link in: every module after
+// the modules it imports, so their top level code runs first
+typedef struct
+{
+    ObjectModule *object;
+    char *path; // source, or the object itself when linking objects
+    int done;   // its imports are all in the order, and so is the module
+} ModuleEntry;
+
+typedef struct
+{
+    ModuleEntry *entries;
+    int count;
+    int capacity;
+    int *order; // entry indexes in link order
+    int ordered;
+} ModuleList;
+
+static int find_module(const ModuleList *list, const char *path)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        if (strcmp(list->entries[i].path, path) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// takes over object and path, returns the entry's index or -1
+static int add_module(ModuleList *list, ObjectModule *object, char *path)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        ModuleEntry *entries = realloc(list->entries, sizeof(ModuleEntry) * capacity);
+        if (entries)
+            list->entries = entries;
+        int *order = entries ? realloc(list->order, sizeof(int) * capacity) : NULL;
+        if (!order)
+        {
+            free_object_module(object);
+            free(path);
+            return -1;
+        }
+        list->order = order;
+        list->capacity = capacity;
+    }
+    list->entries[list->count].object = object;
+    list->entries[list->count].path = path;
+    list->entries[list->count].done = 0;
+    return list->count++;
+}
+
+static void free_module_list(ModuleList *list)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        free_object_module(list->entries[i].object);
+        free(list->entries[i].path);
+    }
+    free(list->entries);
+    free(list->order);
+}
+
+// <name><extension> in the directory of importer, caller frees
+static char *sibling_path(const char *importer, const char *name, const char *extension)
+{
+    const char *slash = strrchr(importer, '/');
+    int directory_length = slash ? (int)(slash - importer + 1) : 0;
+    size_t length = directory_length + strlen(name) + strlen(extension) + 1;
+    char *path = malloc(length);
+    if (path)
+        snprintf(path, length, "%.*s%s%s", directory_length, importer, name, extension);
+    return path;
+}
+
+// the pipeline's rows of the time report, from what the pass manager measured
+static void record_pass_times(TimeReport *times, const PassStats *stats)
+{
+    static const TimedPhase phases[PASS_COUNT] = {TIME_FOLD, TIME_LOOPS, TIME_MULCHAIN, TIME_PEEPHOLE, TIME_SLOTS};
+    add_phase_time(times, TIME_ANALYSIS, stats->analysis_nanoseconds, 0);
+    add_phase_time(times, TIME_CODEGEN, stats->codegen_nanoseconds, stats->instructions);
+    for (int pass = 0; pass < PASS_COUNT; pass++)
+    {
+        if (stats->ran & PASS_BIT(pass))
+            add_phase_time(times, phases[pass], stats->nanoseconds[pass], 0);
+    }
+}
+
+// the 8-bit pipeline on a tree, with the dumps and statistics the options ask for
+static int optimize(CompileJob *job, const char *path, CodeGenerator *codegen, ASTNode *ast)
+{
+    const CompileOptions *options = job->options;
+    PassStats stats;
+    if (options->passes.print_after)
+        sink_printf(job->diagnostics, "; %s\n", path);
+    int status = run_passes(codegen, ast, &options->passes, &stats, job->diagnostics);
+    if (status == 0 && job->times)
+        record_pass_times(job->times, &stats);
+    if (status == 0 && options->pass_stats)
+    {
+        sink_printf(job->diagnostics, "Passes of %s:\n", path);
+        write_pass_stats(job->diagnostics, &stats);
+    }
+    return status;
+}
+
+// every syntax error of an input, and a note when the parse gave up before its end
+static void report_parse_errors(CompileJob *job, const char *path, const Parser *parser)
+{
+    if (!parser->has_error)
+        sink_printf(job->diagnostics, "%s: error: No AST generated\n", path);
+    else if (parser->error_count == 0)
+        sink_printf(job->diagnostics, "%s:%d:%d: error: %s\n", path, parser->first_error.line,
+                    parser->first_error.column, parser->first_error.message);
+    for (int i = 0; i < parser->error_count; i++)
+    {
+        const ParseError *error = &parser->errors[i];
+        sink_printf(job->diagnostics, "%s:%d:%d: error: %s\n", path, error->line, error->column, error->message);
+    }
+    if (parser->max_errors > 0 && parser->error_count >= parser->max_errors)
+        sink_printf(job->diagnostics, "%s: note: stopped after %d errors (--max-errors)\n", path,
+                    parser->error_count);
+}
+
+// lex, parse, generate and assemble an imported source into its object
+static ObjectModule *compile_module(CompileJob *job, const char *path, char *source, uint64_t hash)
+{
+    Lexer *lexer = create_lexer(source);
+    Parser *parser = lexer ? create_parser(lexer) : NULL;
+    if (parser)
+        parser->max_errors = job->options->max_errors;
+    ASTNode *ast = parser ? parse_program(parser) : NULL;
+    CodeGenerator *codegen = NULL;
+    ProgramImage *image = NULL;
+    ObjectModule *object = NULL;
+
+    if (parser && (parser->has_error || !ast))
+    {
+        report_parse_errors(job, path, parser);
+    }
+    else if (ast && (codegen = create_codegen()))
+    {
+        codegen->shared_globals = 1;
+        codegen->extended_isa = job->options->target == TARGET_8BIT_EXT;
+        if (optimize(job, path, codegen, ast) != 0)
+            sink_printf(job->diagnostics, "%s: error: %s\n", path,
+                        codegen->has_error ? codegen->error_message : "Out of memory generating code");
+        else
+            image = assemble_program(codegen);
+        if (image && image->has_error)
+            sink_printf(job->diagnostics, "%s: error: %s\n", path, image->error_message);
+        else if (image)
+            object = create_object_module(codegen, image, hash);
+    }
+
+    free_program_image(image);
+    free_codegen(codegen);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return object;
+}
+
+// output/<module>-<hash of the module's real path>.slo, so modules of the same name in
+// different directories keep objects of their own; caller frees
+static char *module_object_path(const CompileJob *job, const char *path)
+{
+    char *resolved = resolve_path(job->options, path);
+    if (!resolved)
+        return NULL;
+    char *real = realpath(resolved, NULL);
+    const char *key = real ? real : resolved;
+    char extension[32];
+    snprintf(extension, sizeof(extension), "-%016llx.slo",
+             (unsigned long long)hash_bytes(HASH_SEED, key, strlen(key)));
+    free(real);
+    free(resolved);
+    return default_output_file(job->options, path, extension);
+}
+
+// write an object next to its final path and rename it into place, so a concurrent build
+// reads the previous object or this one, never half of either
+static int save_object(const ObjectModule *object, const char *path)
+{
+    OutputSink *sink = create_memory_sink();
+    if (!sink)
+        return -1;
+    int result = write_object(object, sink);
+    size_t length;
+    const char *data = sink_contents(sink, &length);
+
+    size_t temp_length = strlen(path) + sizeof(".XXXXXX");
+    char *temp = result == 0 ? malloc(temp_length) : NULL;
+    int fd = -1;
+    if (temp)
+    {
+        snprintf(temp, temp_length, "%s.XXXXXX", path);
+        fd = mkstemp(temp);
+    }
+    result = fd >= 0 ? 0 : -1;
+    while (fd >= 0 && length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n <= 0)
+        {
+            result = -1;
+            break;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    if (fd >= 0)
+    {
+        if (close(fd) != 0)
+            result = -1;
+        // mkstemp creates the file owner-only, objects are as readable as any output
+        if (result == 0)
+            chmod(temp, 0644);
+        if (result == 0 && rename(temp, path) != 0)
+            result = -1;
+        if (result != 0)
+            unlink(temp);
+    }
+    free(temp);
+    close_sink(sink);
+    return result;
+}
+
+// object of an imported source: the one saved by an earlier build while the source is
+// unchanged, otherwise compiled afresh and saved under output/ for the next build
+static ObjectModule *build_module(CompileJob *job, char *path)
+{
+    char *source = read_file(path);
+    if (!source)
+    {
+        sink_printf(job->diagnostics, "Error: Failed to read module '%s'\n", path);
+        return NULL;
+    }
+    uint64_t hash = module_hash(job, source);
+    char *saved = module_object_path(job, path);
+
+    ObjectModule *object = saved ? load_object(saved) : NULL;
+    if (object && object->source_hash != hash)
+    {
+        free_object_module(object);
+        object = NULL;
+    }
+    if (!object && saved && (object = compile_module(job, path, source, hash)))
+    {
+        if (save_object(object, saved) != 0)
+        {
+            output_error(job, saved);
+            free_object_module(object);
+            object = NULL;
+        }
+    }
+    sl_free(source);
+    free(saved);
+    return object;
+}
+
+// add what the module at index imports, depth first, then the module itself to the order;
+// imports are sources to build, or .slo files next to the importer when linking objects
+static int add_imports(CompileJob *job, ModuleList *list, int index, int objects)
+{
+    for (int i = 0; i < list->entries[index].object->import_count; i++)
+    {
+        const char *name = list->entries[index].object->imports[i];
+        char *path = sibling_path(list->entries[index].path, name, objects ? ".slo" : ".sl");
+        if (!path)
+            return 1;
+        int found = find_module(list, path);
+        if (found >= 0)
+        {
+            free(path);
+            if (list->entries[found].done)
+                continue;
+            sink_printf(job->diagnostics, "%s: error: Import cycle through module '%s'\n",
+                        list->entries[index].path, name);
+            return 1;
+        }
+
+        ObjectModule *object = objects ? load_object(path) : build_module(job, path);
+        if (!object)
+        {
+            if (objects)
+                sink_printf(job->diagnostics, "Error: Failed to read object '%s': missing or corrupt\n", path);
+            free(path);
+            return 1;
+        }
+        int added = add_module(list, object, path);
+        if (added < 0 || add_imports(job, list, added, objects) != 0)
+            return 1;
+    }
+    list->entries[index].done = 1;
+    list->order[list->ordered++] = index;
+    return 0;
+}
+
+// link the ordered modules, then write or run the program
+static int link_and_emit(CompileJob *job, ModuleList *list)
+{
+    ObjectModule **modules = malloc(sizeof(ObjectModule *) * (list->ordered + 1));
+    const char **names = malloc(sizeof(char *) * (list->ordered + 1));
+    if (!modules || !names)
+    {
+        free(modules);
+        free(names);
+        return 1;
+    }
+    for (int i = 0; i < list->ordered; i++)
+    {
+        modules[i] = list->entries[list->order[i]].object;
+        names[i] = list->entries[list->order[i]].path;
+    }
+
+    SymbolTable symbols;
+    init_symbol_table(&symbols);
+    uint64_t start = begin_phase(job, TIME_ASSEMBLE);
+    ProgramImage *image = link_modules(modules, names, list->ordered, &symbols);
+    TIMER_STOP(job->times, TIME_ASSEMBLE, start, image ? image->size : 0);
+
+    int status = 1;
+    if (image && image->has_error)
+        sink_printf(job->diagnostics, "%s: error: %s\n", job->input_path, image->error_message);
+    else if (image)
+        status = emit_program(job, &symbols, image);
+    // the output depends on more than the job's own source
+    job->linked = 1;
+
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free(names);
+    free(modules);
+    return status;
+}
+
+// a module that imports or declares externs: build what it imports and link it all
+static int link_program(CompileJob *job, const CodeGenerator *codegen, const ProgramImage *image,
+                        const char *source)
+{
+    ModuleList list;
+    memset(&list, 0, sizeof(list));
+    char *path = resolve_path(job->options, job->input_path);
+    // nothing is checked against the hash of the main module, so a stream goes without one
+    uint64_t hash = source ? module_hash(job, source) : 0;
+    ObjectModule *object = path ? create_object_module(codegen, image, hash) : NULL;
+    int index = -1;
+    if (object)
+        index = add_module(&list, object, path);
+    else
+        free(path);
+
+    int status = 1;
+    if (index >= 0 && add_imports(job, &list, index, 0) == 0)
+        status = link_and_emit(job, &list);
+    free_module_list(&list);
+    return status;
+}
+
+// linking objects: every input after the objects it imports, all in one program
+static int link_inputs(const CompileJob *shared)
+{
+    const CompileOptions *options = shared->options;
+    CompileJob job = *shared;
+    job.input_path = options->input_paths[0];
+    ModuleList list;
+    memset(&list, 0, sizeof(list));
+
+    int status = 0;
+    for (int i = 0; i < options->input_count && !status; i++)
+    {
+        char *path = resolve_path(options, options->input_paths[i]);
+        if (!path)
+        {
+            status = 1;
+        }
+        else if (find_module(&list, path) >= 0)
+        {
+            // already linked in by an import
+            free(path);
+        }
+        else
+        {
+            ObjectModule *object = load_object(path);
+            if (!object)
+            {
+                sink_printf(job.diagnostics, "Error: '%s' is not a simplelang object, or is corrupt\n",
+                            options->input_paths[i]);
+                free(path);
+                status = 1;
+                break;
+            }
+            int index = add_module(&list, object, path);
+            status = index < 0 || add_imports(&job, &list, index, 1) != 0;
+        }
+    }
+    if (!status)
+        status = link_and_emit(&job, &list);
+    free_module_list(&list);
+    sink_flush(job.out);
+    sink_flush(job.diagnostics);
+    return status;
+}
+
+// source is NULL when the input was streamed
+static int generate_8bit(CompileJob *job, ASTNode *ast, const char *source)
+{
+    const CompileOptions *options = job->options;
+    // timed pass by pass in optimize
+    set_allocation_phase(TIME_CODEGEN);
+    CodeGenerator *codegen = create_codegen();
+    if (!codegen)
+        return 1;
+    // an object's globals are shared with whatever it is linked with
+    codegen->shared_globals = options->emit == EMIT_OBJ;
+    codegen->extended_isa = options->target == TARGET_8BIT_EXT;
+    if (optimize(job, job->input_path, codegen, ast) != 0)
+    {
+        sink_printf(job->diagnostics, "%s: error: %s\n", job->input_path,
+                    codegen->has_error ? codegen->error_message : "Out of memory generating code");
+        free_codegen(codegen);
+        return 1;
+    }
+
+    int status = 0;
+    if (options->emit == EMIT_IR)
+        status = write_output(job, NULL, write_ir_output, codegen);
+    else if (options->emit == EMIT_ASM)
+        status = write_output(job, ".asm", write_assembly_output, codegen);
+
+    if (!status && options->stop_after >= PHASE_ASSEMBLE)
+    {
+        uint64_t start = begin_phase(job, TIME_ASSEMBLE);
+        ProgramImage *image = assemble_program(codegen);
+        TIMER_STOP(job->times, TIME_ASSEMBLE, start, image ? image->size : 0);
+        if (!image)
+        {
+            status = 1;
+        }
+        else if (image->has_error)
+        {
+            sink_printf(job->diagnostics, "%s: error: %s\n", job->input_path, image->error_message);
+            status = 1;
+        }
+        else if (options->emit == EMIT_OBJ)
+        {
+            ObjectModule *object = create_object_module(codegen, image, source ? module_hash(job, source) : 0);
+            status = object ? write_output(job, ".slo", write_object_output, object) : 1;
+            free_object_module(object);
+        }
+        else
+        {
+            if (options->emit == EMIT_LISTING)
+            {
+                Listing listing = {codegen, image, ast, source};
+                status = write_output(job, NULL, write_listing_output, &listing);
+            }
+            // a listing may still be simulated, or linked to be
+            if (!status)
+                status = is_module(codegen) ? link_program(job, codegen, image, source)
+                                            : emit_program(job, &codegen->symbols, image);
+        }
+        free_program_image(image);
+    }
+
+    free_codegen(codegen);
+    return status;
+}
+
+// the x86-64 assemble phase is the external assembler and linker, only run for executables
+static int generate_x86(CompileJob *job, ASTNode *ast)
+{
+    if (job->options->emit == EMIT_ASM)
+        return write_output(job, ".s", write_x86_output, ast);
+
+    if (job->options->emit == EMIT_BIN)
+    {
+        uint64_t start = begin_phase(job, TIME_ASSEMBLE);
+        char *path = output_path(job, "");
+        int result = path ? build_x86_executable(ast, path) : -1;
+        TIMER_STOP(job->times, TIME_ASSEMBLE, start, 0);
+        if (result != 0)
+            output_error(job, path);
+        free(path);
+        return result == 0 ? 0 : 1;
+    }
+
+    // checking only: generate into memory and drop it
+    uint64_t start = begin_phase(job, TIME_CODEGEN);
+    OutputSink *sink = create_memory_sink();
+    if (!sink)
+        return 1;
+    int result = generate_x86_assembly(ast, sink);
+    close_sink(sink);
+    TIMER_STOP(job->times, TIME_CODEGEN, start, 0);
+    return result == 0 ? 0 : 1;
+}
+
+// whether the program has imports or externs at the top level
+static int uses_modules(ASTNode *ast)
+{
+    for (int i = 0; i < ast->data.block.count; i++)
+    {
+        int type = ast->data.block.statements[i]->type;
+        if (type == AST_IMPORT || type == AST_EXTERN)
+            return 1;
+    }
+    return 0;
+}
+
+// what follows the parse; source is NULL when the tree came from a stream or an AST file
+static int compile_tree(CompileJob *job, ASTNode *ast, const char *source)
+{
+    const CompileOptions *options = job->options;
+    int status = 0;
+    int executes = options->run_vm || options->run_jit ||
+                   (options->target == TARGET_X86_64 && options->stop_after >= PHASE_CODEGEN);
+    if (executes && uses_modules(ast))
+    {
+        sink_printf(job->diagnostics, "%s: error: import and extern need the 8-bit target and its linker\n",
+                    job->input_path);
+        status = 1;
+    }
+    if (!status && options->emit == EMIT_AST)
+        status = write_output(job, NULL, write_ast_output, ast);
+    if (!status && options->emit == EMIT_AST_BIN)
+        status = write_output(job, ".sla", write_ast_file_output, ast);
+    if (!status && options->run_vm)
+        status = run_on_vm(job, ast);
+    if (!status && options->run_jit)
+        status = run_on_jit(job, ast);
+    if (!status && options->stop_after >= PHASE_CODEGEN)
+        status = options->target == TARGET_X86_64 ? generate_x86(job, ast) : generate_8bit(job, ast, source);
+    return status;
+}
+
+// lex, parse and generate as far as the options ask
+static int run_pipeline(CompileJob *job, char *source)
+{
+    const CompileOptions *options = job->options;
+    // the parser lexes on demand, so a timed run lexes once on its own to tell the two
+    // apart, and takes that time off the parse
+    uint64_t lexing = 0;
+    if (options->emit == EMIT_TOKENS || options->stop_after == PHASE_LEX || job->times)
+    {
+        uint64_t before = job->times ? job->times->nanoseconds[TIME_LEX] : 0;
+        int status = run_lexer(job, source);
+        if (status || options->stop_after == PHASE_LEX)
+            return status;
+        if (job->times)
+            lexing = job->times->nanoseconds[TIME_LEX] - before;
+    }
+
+    uint64_t start = begin_phase(job, TIME_PARSE);
+    Lexer *lexer = open_lexer(source);
+    if (!lexer)
+        return 1;
+    Parser *parser = create_parser(lexer);
+    if (!parser)
+    {
+        free_lexer(lexer);
+        return 1;
+    }
+    parser->max_errors = job->options->max_errors;
+
+    ASTNode *ast = parse_program(parser);
+    TIMER_STOP(job->times, TIME_PARSE, start + lexing, count_ast_nodes(ast));
+    if (check_stream(job, lexer))
+    {
+        free_ast(ast);
+        free_parser(parser);
+        free_lexer(lexer);
+        return 1;
+    }
+    if (parser->has_error || !ast)
+    {
+        report_parse_errors(job, job->input_path, parser);
+        free_ast(ast);
+        free_parser(parser);
+        free_lexer(lexer);
+        return 1;
+    }
+
+    int status = compile_tree(job, ast, source);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return status;
+}
+
+// extension of the file an emitted output goes to, NULL for listings sent to stdout
+static const char *emit_extension(const CompileOptions *options)
+{
+    int x86 = options->target == TARGET_X86_64;
+    switch (options->emit)
+    {
+    case EMIT_ASM:
+        return x86 ? ".s" : ".asm";
+    case EMIT_BIN:
+        return x86 ? "" : ".bin";
+    case EMIT_HEX:
+        return ".hex";
+    case EMIT_OBJ:
+        return ".slo";
+    case EMIT_AST_BIN:
+        return ".sla";
+    default:
+        return NULL;
+    }
+}
+
+// only outputs are cached, runs and reports have to happen every time
+static int is_cacheable(const CompileOptions *options)
+{
+    return options->emit != EMIT_NONE && !options->simulate && !options->run_vm && !options->run_jit &&
+           !options->passes.print_after && !options->pass_stats;
+}
+
+// everything the output bytes depend on
+static uint64_t cache_key(const CompileJob *job, const char *source)
+{
+    const CompileOptions *options = job->options;
+    int shape[] = {options->target, options->emit, options->stop_after, (int)options->passes.enabled};
+    uint64_t hash = hash_bytes(job->cache->compiler_hash, shape, sizeof(shape));
+    return hash_bytes(hash, source, strlen(source));
+}
+
+// a hit writes the stored bytes out; a miss compiles and stores what was written
+static int compile_cached(CompileJob *job, char *source)
+{
+    char *path = output_path(job, emit_extension(job->options));
+    if (!path)
+        return 1;
+    uint64_t start = begin_phase(job, TIME_CACHE);
+    uint64_t key = cache_key(job, source);
+    size_t length;
+    char *data = cache_lookup(job->cache, key, &length);
+    TIMER_STOP(job->times, TIME_CACHE, start, 0);
+    int status;
+
+    if (data)
+    {
+        start = begin_phase(job, TIME_WRITE);
+        OutputSink *sink = open_output(job, path);
+        status = sink ? 0 : 1;
+        if (sink)
+        {
+            sink_write(sink, data, length);
+            status = close_output(job, sink) == 0 ? 0 : 1;
+        }
+        TIMER_STOP(job->times, TIME_WRITE, start, length);
+        if (status)
+            output_error(job, path);
+        else if (job->options->target == TARGET_X86_64 && job->options->emit == EMIT_BIN)
+            chmod(path, 0755);
+        free(data);
+    }
+    else if (strcmp(path, "-") == 0)
+    {
+        // listings are captured on their way to stdout
+        OutputSink *out = job->out;
+        OutputSink *capture = create_memory_sink();
+        status = 1;
+        if (capture)
+        {
+            job->out = capture;
+            status = run_pipeline(job, source);
+            job->out = out;
+            const char *text = sink_contents(capture, &length);
+            start = begin_phase(job, TIME_CACHE);
+            if (!status && !job->linked)
+                cache_store(job->cache, key, text, length);
+            TIMER_STOP(job->times, TIME_CACHE, start, 0);
+            sink_write(out, text, length);
+            close_sink(capture);
+        }
+    }
+    else
+    {
+        status = run_pipeline(job, source);
+        start = begin_phase(job, TIME_CACHE);
+        if (!status && !job->linked)
+            cache_store_file(job->cache, key, path);
+        TIMER_STOP(job->times, TIME_CACHE, start, 0);
+    }
+    free(path);
+    return status;
+}
+
+int compile_source(CompileJob *job, char *source)
+{
+    if (job->cache && is_cacheable(job->options))
+        return compile_cached(job, source);
+    return run_pipeline(job, source);
+}
+
+// stdin is lexed as it arrives, so the compiler can sit at the end of a pipeline, unless
+// something needs the whole text: a cache key, the separate lex pass of a timed run or a
+// token dump ahead of later phases, the source hash of an object, or a listing's lines
+static int streams_input(const CompileJob *job)
+{
+    const CompileOptions *options = job->options;
+    return strcmp(job->input_path, "-") == 0 && !(job->cache && is_cacheable(options)) && !job->times &&
+           !(options->emit == EMIT_TOKENS && options->stop_after > PHASE_LEX) && options->emit != EMIT_OBJ &&
+           options->emit != EMIT_LISTING;
+}
+
+// map an AST file, then build the tree the code generators take from it in place of a parse
+static int compile_ast_file(CompileJob *job)
+{
+    uint64_t start = begin_phase(job, TIME_READ);
+    char *path = resolve_path(job->options, job->input_path);
+    ASTFile *file = path ? map_ast_file(path) : NULL;
+    free(path);
+    if (!file)
+    {
+        sink_printf(job->diagnostics, "Error: '%s' is not a simplelang AST file\n", job->input_path);
+        return 1;
+    }
+    TIMER_STOP(job->times, TIME_READ, start, file->size);
+
+    start = begin_phase(job, TIME_PARSE);
+    ASTNode *ast = ast_from_file(file->data);
+    TIMER_STOP(job->times, TIME_PARSE, start, ast ? count_ast_nodes(ast) : 0);
+    unmap_ast_file(file);
+    if (!ast)
+        return 1;
+    int status = compile_tree(job, ast, NULL);
+    free_ast(ast);
+    return status;
+}
+
+// read and compile under the allocator the options ask for
+static int read_and_compile(CompileJob *job)
+{
+    if (job->options->from == INPUT_AST_BIN)
+        return job->status = compile_ast_file(job);
+    if (streams_input(job))
+        return job->status = run_pipeline(job, NULL);
+
+    uint64_t start = begin_phase(job, TIME_READ);
+    char *path = resolve_path(job->options, job->input_path);
+    char *source = path ? read_file(path) : NULL;
+    free(path);
+    if (!source)
+    {
+        sink_printf(job->diagnostics, "Error: Failed to read input file '%s'\n", job->input_path);
+        job->status = 1;
+        return 1;
+    }
+    TIMER_STOP(job->times, TIME_READ, start, strlen(source));
+    job->status = compile_source(job, source);
+    sl_free(source);
+    return job->status;
+}
+
+int compile_file(CompileJob *job)
+{
+    if (job->options->allocator == ALLOCATOR_SYSTEM && !job->memory)
+        return read_and_compile(job);
+
+    Allocator *arena = NULL;
+    if (job->options->allocator == ALLOCATOR_ARENA && !(arena = create_arena_allocator(0)))
+        return job->status = 1;
+    Allocator *counting = NULL;
+    if (job->memory && !(counting = create_counting_allocator(arena ? arena : current_allocator())))
+    {
+        free_arena_allocator(arena);
+        return job->status = 1;
+    }
+
+    Allocator *previous = set_allocator(counting ? counting : arena);
+    read_and_compile(job);
+    set_allocator(previous);
+
+    if (counting)
+    {
+        if (merge_allocation_stats(job->memory, counting_allocator_stats(counting)) != 0)
+            job->status = 1;
+        free_counting_allocator(counting);
+    }
+    free_arena_allocator(arena);
+    return job->status;
+}
+
+static void compile_task(void *arg)
+{
+    compile_file(arg);
+}
+
+static int default_thread_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+// stream straight into the caller's sinks: one input, or several compiled one after another
+// shared holds what every input's job starts from: options, sinks, cache and times
+static int compile_in_order(const CompileJob *shared)
+{
+    const CompileOptions *options = shared->options;
+    int status = 0;
+    for (int i = 0; i < options->input_count; i++)
+    {
+        CompileJob job = *shared;
+        job.input_path = options->input_paths[i];
+        if (compile_file(&job) != 0)
+            status = 1;
+        // keep this input's messages next to its output
+        sink_flush(job.out);
+        sink_flush(job.diagnostics);
+    }
+    return shared->out->has_error ? 1 : status;
+}
+
+static int thread_count(const CompileOptions *options)
+{
+    int threads = options->jobs ? options->jobs : default_thread_count();
+    return threads < options->input_count ? threads : options->input_count;
+}
+
+static int compile_inputs(const CompileJob *shared)
+{
+    const CompileOptions *options = shared->options;
+    int threads = thread_count(options);
+    if (threads <= 1)
+        return compile_in_order(shared);
+
+    // every job writes into sinks of its own, replayed in input order once all are done;
+    // timed and counted jobs keep their own reports too, merged at the end
+    CompileJob *jobs = calloc(options->input_count, sizeof(CompileJob));
+    TimeReport *times = shared->times ? calloc(options->input_count, sizeof(TimeReport)) : NULL;
+    AllocationStats *memory = shared->memory ? calloc(options->input_count, sizeof(AllocationStats)) : NULL;
+    int reports_ready = (times || !shared->times) && (memory || !shared->memory);
+    ThreadPool *pool = jobs && reports_ready ? create_thread_pool(threads) : NULL;
+    if (!pool)
+    {
+        free(memory);
+        free(times);
+        free(jobs);
+        return compile_in_order(shared);
+    }
+
+    int status = 0;
+    for (int i = 0; i < options->input_count; i++)
+    {
+        jobs[i] = *shared;
+        jobs[i].input_path = options->input_paths[i];
+        jobs[i].times = times ? &times[i] : NULL;
+        jobs[i].memory = memory ? &memory[i] : NULL;
+        jobs[i].out = create_memory_sink();
+        jobs[i].diagnostics = create_memory_sink();
+        if (!jobs[i].out || !jobs[i].diagnostics ||
+            thread_pool_submit(pool, compile_task, &jobs[i]) != 0)
+        {
+            jobs[i].status = 1;
+            status = 1;
+        }
+    }
+    thread_pool_wait(pool);
+    free_thread_pool(pool);
+
+    OutputSink *out = shared->out;
+    OutputSink *diagnostics = shared->diagnostics;
+    for (int i = 0; i < options->input_count; i++)
+    {
+        size_t length;
+        const char *text;
+        if (jobs[i].out && (text = sink_contents(jobs[i].out, &length)))
+        {
+            sink_write(out, text, length);
+            sink_flush(out);
+        }
+        if (jobs[i].diagnostics && (text = sink_contents(jobs[i].diagnostics, &length)))
+        {
+            sink_write(diagnostics, text, length);
+            sink_flush(diagnostics);
+        }
+        if (times)
+            merge_time_report(shared->times, &times[i]);
+        if (memory)
+        {
+            if (merge_allocation_stats(shared->memory, &memory[i]) != 0)
+                status = 1;
+            free_allocation_stats(&memory[i]);
+        }
+        if (jobs[i].status != 0)
+            status = 1;
+        if (jobs[i].out)
+            close_sink(jobs[i].out);
+        if (jobs[i].diagnostics)
+            close_sink(jobs[i].diagnostics);
+    }
+    if (out->has_error)
+        status = 1;
+    free(memory);
+    free(times);
+    free(jobs);
+    return status;
+}
+
+static void write_cache_stats(OutputSink *sink, Cache *cache)
+{
+    sink_printf(sink, "Cache: %d hits, %d misses, %d stored, %d evicted, %zu bytes in %d entries (limit %zu)\n",
+                cache->hits, cache->misses, cache->stores, cache->evictions,
+                cache->total_size, cache->entry_count, cache->size_limit);
+}
+
+// the report goes to stderr, or into the --time-report file
+static int write_timing(const CompileOptions *options, const TimeReport *times, uint64_t wall, OutputSink *diagnostics)
+{
+    char *path = options->time_report_path ? resolve_path(options, options->time_report_path) : NULL;
+    OutputSink *sink = path ? create_file_sink(path) : diagnostics;
+    if (!sink)
+    {
+        sink_printf(diagnostics, "Error: Failed to write time report to '%s'\n", options->time_report_path);
+        free(path);
+        return -1;
+    }
+    write_time_report(sink, times, options->time_format, options->input_count, thread_count(options), wall);
+    int result = sink == diagnostics ? sink_flush(sink) : close_sink(sink);
+    free(path);
+    return result;
+}
+
+int compile_all(const CompileOptions *options, OutputSink *out, OutputSink *diagnostics)
+{
+    Cache *cache = options->shared_cache;
+    if (options->cache_directory && !cache)
+    {
+        char *directory = resolve_path(options, options->cache_directory);
+        cache = directory ? open_cache(directory, options->cache_size) : NULL;
+        if (!cache)
+            sink_printf(diagnostics, "Warning: Cannot use cache directory '%s', compiling without it\n",
+                        options->cache_directory);
+        free(directory);
+    }
+
+    TimeReport times;
+    AllocationStats memory;
+    memset(&times, 0, sizeof(times));
+    memset(&memory, 0, sizeof(memory));
+    CompileJob shared = {options, NULL, out, diagnostics, 0, cache,
+                         options->time_report ? &times : NULL, options->mem_report ? &memory : NULL, 0};
+    uint64_t start = TIMER_START(shared.times);
+    int status = options->link ? link_inputs(&shared) : compile_inputs(&shared);
+    if (shared.times && write_timing(options, &times, monotonic_nanoseconds() - start, diagnostics) != 0)
+        status = 1;
+    if (shared.memory)
+    {
+        write_memory_report(diagnostics, &memory, allocator_names[options->allocator], MEM_REPORT_SITES);
+        sink_flush(diagnostics);
+        free_allocation_stats(&memory);
+    }
+
+    if (cache)
+    {
+        // once per run rather than per store: trimming reads the whole directory
+        if (!options->shared_cache)
+            cache_trim(cache);
+        if (options->cache_stats)
+        {
+            write_cache_stats(diagnostics, cache);
+            sink_flush(diagnostics);
+        }
+        if (!options->shared_cache)
+            close_cache(cache);
+    }
+    return status;
+}
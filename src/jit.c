@@ -0,0 +1,612 @@
+#define _DEFAULT_SOURCE
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "../include/jit.h"
+
+#if defined(__x86_64__)
+
+// x86-64 register numbers
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RSI 6
+#define RDI 7
+#define R8 8
+#define R9 9
+#define R10 10
+#define R11 11
+
+// rdi holds the slot array for the whole program, r11 is scratch for spills
+#define BASE RDI
+#define SCRATCH R11
+#define TEMP_REGISTERS 7
+static const int temp_registers[TEMP_REGISTERS] = {RAX, RCX, RDX, RSI, R8, R9, R10};
+
+// opcodes of the three arithmetic forms: rm += reg, reg += [mem], rm += imm (group 0x81 extension)
+typedef struct
+{
+    unsigned char reg_reg;
+    unsigned char reg_mem;
+    unsigned char imm_ext;
+} ArithmeticEncoding;
+
+static const ArithmeticEncoding add_encoding = {0x01, 0x03, 0};
+static const ArithmeticEncoding sub_encoding = {0x29, 0x2B, 5};
+static const ArithmeticEncoding cmp_encoding = {0x39, 0x3B, 7};
+
+typedef struct
+{
+    unsigned char *code;
+    size_t length;
+    size_t capacity;
+    SymbolTable *symbols;
+    int has_error;
+} JitCompiler;
+
+static void emit_byte(JitCompiler *jit, unsigned char byte)
+{
+    if (jit->length >= jit->capacity)
+    {
+        size_t capacity = jit->capacity ? jit->capacity * 2 : 4096;
+        unsigned char *code = realloc(jit->code, capacity);
+        if (!code)
+        {
+            jit->has_error = 1;
+            return;
+        }
+        jit->code = code;
+        jit->capacity = capacity;
+    }
+    jit->code[jit->length++] = byte;
+}
+
+static void emit_u32(JitCompiler *jit, unsigned int value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        emit_byte(jit, (unsigned char)(value >> (8 * i)));
+    }
+}
+
+// REX prefix for the extended registers; byte registers 4..7 (spl..dil) need an empty one
+static void emit_rex(JitCompiler *jit, int reg, int rm, int byte_operands)
+{
+    int rex = 0x40 | (((reg >> 3) & 1) << 2) | ((rm >> 3) & 1);
+    if (rex != 0x40 || (byte_operands && ((reg >= 4 && reg < 8) || (rm >= 4 && rm < 8))))
+        emit_byte(jit, (unsigned char)rex);
+}
+
+static void emit_modrm(JitCompiler *jit, int mod, int reg, int rm)
+{
+    emit_byte(jit, (unsigned char)((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// reg op [rdi + slot * 4]
+static void emit_mem_op(JitCompiler *jit, unsigned char opcode, int reg, int slot)
+{
+    emit_rex(jit, reg, BASE, 0);
+    emit_byte(jit, opcode);
+    emit_modrm(jit, 2, reg, BASE);
+    emit_u32(jit, (unsigned int)slot * 4);
+}
+
+// rm op reg, both registers
+static void emit_reg_op(JitCompiler *jit, unsigned char opcode, int reg, int rm)
+{
+    emit_rex(jit, reg, rm, 0);
+    emit_byte(jit, opcode);
+    emit_modrm(jit, 3, reg, rm);
+}
+
+static void emit_imm_op(JitCompiler *jit, int extension, int rm, int imm)
+{
+    emit_rex(jit, 0, rm, 0);
+    emit_byte(jit, 0x81);
+    emit_modrm(jit, 3, extension, rm);
+    emit_u32(jit, (unsigned int)imm);
+}
+
+static void emit_mov_imm(JitCompiler *jit, int reg, int imm)
+{
+    emit_rex(jit, 0, reg, 0);
+    emit_byte(jit, (unsigned char)(0xB8 + (reg & 7)));
+    emit_u32(jit, (unsigned int)imm);
+}
+
+static void emit_push(JitCompiler *jit, int reg)
+{
+    if (reg >= 8)
+        emit_byte(jit, 0x41);
+    emit_byte(jit, (unsigned char)(0x50 + (reg & 7)));
+}
+
+static void emit_pop(JitCompiler *jit, int reg)
+{
+    if (reg >= 8)
+        emit_byte(jit, 0x41);
+    emit_byte(jit, (unsigned char)(0x58 + (reg & 7)));
+}
+
+// reg = (flags say equal) ? 1 : 0, via sete + movzx
+static void emit_set_equal(JitCompiler *jit, int reg)
+{
+    emit_rex(jit, 0, reg, 1);
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0x94);
+    emit_modrm(jit, 3, 0, reg);
+    emit_rex(jit, reg, reg, 1);
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0xB6);
+    emit_modrm(jit, 3, reg, reg);
+}
+
+// jcc/jmp with a rel32 to fill in later, returns the position of the displacement
+static size_t emit_jump(JitCompiler *jit, unsigned char condition)
+{
+    if (condition)
+    {
+        emit_byte(jit, 0x0F);
+        emit_byte(jit, condition);
+    }
+    else
+    {
+        emit_byte(jit, 0xE9);
+    }
+    size_t position = jit->length;
+    emit_u32(jit, 0);
+    return position;
+}
+
+static void patch_jump(JitCompiler *jit, size_t position)
+{
+    if (jit->has_error)
+        return;
+    unsigned int displacement = (unsigned int)(jit->length - (position + 4));
+    for (int i = 0; i < 4; i++)
+    {
+        jit->code[position + i] = (unsigned char)(displacement >> (8 * i));
+    }
+}
+
+// jcc/jmp to code already emitted at target
+static void emit_jump_back(JitCompiler *jit, unsigned char condition, size_t target)
+{
+    size_t position = emit_jump(jit, condition);
+    if (jit->has_error)
+        return;
+    unsigned int displacement = (unsigned int)(target - (position + 4));
+    for (int i = 0; i < 4; i++)
+    {
+        jit->code[position + i] = (unsigned char)(displacement >> (8 * i));
+    }
+}
+
+#define JCC_JB 0x82
+#define JCC_JE 0x84
+#define JCC_JNE 0x85
+
+// the program starts by jumping over a stub that returns RUN_LIMIT_REACHED, which loops
+// branch back to once the iteration budget at [rdi - 8] runs out
+#define LIMIT_STUB 2
+
+static int slot_of(JitCompiler *jit, const char *name)
+{
+    int slot = intern_symbol(jit->symbols, name);
+    if (slot < 0)
+        jit->has_error = 1;
+    return slot;
+}
+
+static const ArithmeticEncoding *encoding_for(TokenType op)
+{
+    switch (op)
+    {
+    case TOKEN_PLUS:
+        return &add_encoding;
+    case TOKEN_MINUS:
+        return &sub_encoding;
+    default:
+        return &cmp_encoding;
+    }
+}
+
+// shl and sar, the /digit of the shift group; >> keeps the sign like the bytecode VM
+#define SHL_EXT 4
+#define SAR_EXT 7
+
+static int shift_extension(TokenType op)
+{
+    return op == TOKEN_SHIFT_LEFT ? SHL_EXT : SAR_EXT;
+}
+
+// dest = dest * rm, imul r32, r/m32 with rm a register or (BASE set) a slot
+static void emit_imul(JitCompiler *jit, int dest, int rm, int slot)
+{
+    emit_rex(jit, dest, rm, 0);
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0xAF);
+    emit_modrm(jit, rm == BASE ? 2 : 3, dest, rm);
+    if (rm == BASE)
+        emit_u32(jit, (unsigned int)slot * 4);
+}
+
+static void emit_shift_imm(JitCompiler *jit, int extension, int rm, int count)
+{
+    emit_rex(jit, 0, rm, 0);
+    emit_byte(jit, 0xC1);
+    emit_modrm(jit, 3, extension, rm);
+    emit_byte(jit, (unsigned char)(count & 31));
+}
+
+// dest = dest shifted by SCRATCH: the count has to be in cl, so rcx and r11 trade places
+// around the shift (a dest of rcx is then in r11)
+static void emit_shift_by_scratch(JitCompiler *jit, int extension, int dest)
+{
+    int target = dest == RCX ? SCRATCH : dest;
+    emit_reg_op(jit, 0x87, SCRATCH, RCX); // xchg
+    emit_rex(jit, 0, target, 0);
+    emit_byte(jit, 0xD3);
+    emit_modrm(jit, 3, extension, target);
+    emit_reg_op(jit, 0x87, SCRATCH, RCX);
+}
+
+// dest = dest <op> src, both registers
+static void emit_operator_reg(JitCompiler *jit, TokenType op, int dest, int src)
+{
+    switch (op)
+    {
+    case TOKEN_STAR:
+        emit_imul(jit, dest, src, 0);
+        break;
+    case TOKEN_SHIFT_LEFT:
+    case TOKEN_SHIFT_RIGHT:
+        if (src != SCRATCH)
+            emit_reg_op(jit, 0x89, src, SCRATCH);
+        emit_shift_by_scratch(jit, shift_extension(op), dest);
+        break;
+    default:
+        emit_reg_op(jit, encoding_for(op)->reg_reg, src, dest);
+        break;
+    }
+}
+
+// dest = dest <op> slot
+static void emit_operator_mem(JitCompiler *jit, TokenType op, int dest, int slot)
+{
+    switch (op)
+    {
+    case TOKEN_STAR:
+        emit_imul(jit, dest, BASE, slot);
+        break;
+    case TOKEN_SHIFT_LEFT:
+    case TOKEN_SHIFT_RIGHT:
+        emit_mem_op(jit, 0x8B, SCRATCH, slot);
+        emit_shift_by_scratch(jit, shift_extension(op), dest);
+        break;
+    default:
+        emit_mem_op(jit, encoding_for(op)->reg_mem, dest, slot);
+        break;
+    }
+}
+
+// dest = dest <op> imm; a multiplier that is a power of two becomes a shift
+static void emit_operator_imm(JitCompiler *jit, TokenType op, int dest, int imm)
+{
+    int shift = 0;
+    switch (op)
+    {
+    case TOKEN_STAR:
+        while (shift < 31 && (1 << shift) < imm)
+            shift++;
+        if (imm > 0 && 1 << shift == imm)
+        {
+            emit_shift_imm(jit, SHL_EXT, dest, shift);
+            break;
+        }
+        emit_rex(jit, dest, dest, 0);
+        emit_byte(jit, 0x69);
+        emit_modrm(jit, 3, dest, dest);
+        emit_u32(jit, (unsigned int)imm);
+        break;
+    case TOKEN_SHIFT_LEFT:
+    case TOKEN_SHIFT_RIGHT:
+        emit_shift_imm(jit, shift_extension(op), dest, imm);
+        break;
+    default:
+        emit_imm_op(jit, encoding_for(op)->imm_ext, dest, imm);
+        break;
+    }
+}
+
+// added to the register depth in a frame's value: the == of an if condition leaves its
+// result in the flags for the branch instead of turning it into 0 or 1
+#define KEEP_FLAGS 0x10000
+
+static int is_equality(const ASTNode *node)
+{
+    return node->type == AST_BINARY_OP && node->data.binary_op.operator == TOKEN_EQUAL;
+}
+
+// Compile statements and expressions in one walk without recursion (see ASTWalk). An
+// expression frame's value is the depth of the temporary register it computes into;
+// an operator computes temp[depth] = temp[depth] <op> right, with flags set for ==. An
+// if or while frame's value is the jump to patch.
+static void compile_tree(JitCompiler *jit, ASTNode *root)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, root, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !walk.failed)
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        int depth = frame->value & ~KEEP_FLAGS;
+        int done = 1; // the node is finished after this step
+        switch (node->type)
+        {
+        case AST_NUMBER:
+            emit_mov_imm(jit, temp_registers[depth], node->data.number.value);
+            break;
+
+        case AST_IDENTIFIER:
+            emit_mem_op(jit, 0x8B, temp_registers[depth], slot_of(jit, node->data.identifier.name));
+            break;
+
+        case AST_BINARY_OP:
+        {
+            TokenType op = node->data.binary_op.operator;
+            ASTNode *right = node->data.binary_op.right;
+            int dest = temp_registers[depth];
+            if (step == 0)
+            {
+                done = 0;
+                ast_walk_push(&walk, node->data.binary_op.left, depth);
+            }
+            else if (step == 1 && right->type == AST_NUMBER)
+            {
+                emit_operator_imm(jit, op, dest, right->data.number.value);
+            }
+            else if (step == 1 && right->type == AST_IDENTIFIER)
+            {
+                emit_operator_mem(jit, op, dest, slot_of(jit, right->data.identifier.name));
+            }
+            else if (step == 1 && depth + 1 < TEMP_REGISTERS)
+            {
+                done = 0;
+                ast_walk_push(&walk, right, depth + 1);
+            }
+            else if (step == 1)
+            {
+                // out of registers, park the left value on the stack
+                done = 0;
+                frame->step = 3;
+                emit_push(jit, dest);
+                ast_walk_push(&walk, right, depth);
+            }
+            else if (step == 2)
+            {
+                emit_operator_reg(jit, op, dest, temp_registers[depth + 1]);
+            }
+            else
+            {
+                emit_reg_op(jit, 0x89, dest, SCRATCH);
+                emit_pop(jit, dest);
+                emit_operator_reg(jit, op, dest, SCRATCH);
+            }
+            if (done && op == TOKEN_EQUAL && !(frame->value & KEEP_FLAGS))
+                emit_set_equal(jit, dest);
+            break;
+        }
+
+        case AST_DECLARATION:
+            if (step == 0)
+            {
+                frame->value = slot_of(jit, node->data.declaration.var_name);
+                done = !node->data.declaration.init_value;
+                ast_walk_push(&walk, node->data.declaration.init_value, 0);
+            }
+            else
+            {
+                emit_mem_op(jit, 0x89, RAX, frame->value);
+            }
+            break;
+
+        case AST_ASSIGNMENT:
+            if (step == 0)
+            {
+                done = 0;
+                ast_walk_push(&walk, node->data.assignment.value, 0);
+            }
+            else
+            {
+                emit_mem_op(jit, 0x89, RAX, slot_of(jit, node->data.assignment.var_name));
+            }
+            break;
+
+        case AST_IF_STATEMENT:
+            done = 0;
+            if (step == 0)
+            {
+                // a top level == compares and branches directly
+                ASTNode *condition = node->data.if_stmt.condition;
+                ast_walk_push(&walk, condition, is_equality(condition) ? KEEP_FLAGS : 0);
+            }
+            else if (step == 1)
+            {
+                // jump to the else part when the condition is false
+                if (!is_equality(node->data.if_stmt.condition))
+                    emit_reg_op(jit, 0x85, RAX, RAX); // test eax, eax
+                frame->value = (int)emit_jump(jit, is_equality(node->data.if_stmt.condition) ? JCC_JNE : JCC_JE);
+                ast_walk_push(&walk, node->data.if_stmt.then_block, 0);
+            }
+            else if (step == 2 && node->data.if_stmt.else_block)
+            {
+                size_t end_jump = emit_jump(jit, 0);
+                patch_jump(jit, frame->value);
+                frame->value = (int)end_jump;
+                ast_walk_push(&walk, node->data.if_stmt.else_block, 0);
+            }
+            else
+            {
+                // past the then block with no else, or past the else block
+                patch_jump(jit, frame->value);
+                done = 1;
+            }
+            break;
+
+        // jmp cond; body: ...; cond: ...; jcc body, one backward branch per iteration
+        case AST_WHILE_STATEMENT:
+        {
+            ASTNode *condition = node->data.while_stmt.condition;
+            done = step == 2;
+            if (step == 0)
+            {
+                frame->value = (int)emit_jump(jit, 0);
+                // the body is only entered from the backward branch: one iteration
+                emit_byte(jit, 0x48); // sub qword [rdi - 8], 1
+                emit_byte(jit, 0x83);
+                emit_modrm(jit, 1, 5, BASE);
+                emit_byte(jit, 0xF8);
+                emit_byte(jit, 1);
+                emit_jump_back(jit, JCC_JB, LIMIT_STUB);
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+            }
+            else if (step == 1)
+            {
+                patch_jump(jit, frame->value);
+                ast_walk_push(&walk, condition, is_equality(condition) ? KEEP_FLAGS : 0);
+            }
+            else
+            {
+                // the body starts right after the first jump
+                if (!is_equality(condition))
+                    emit_reg_op(jit, 0x85, RAX, RAX); // test eax, eax
+                emit_jump_back(jit, is_equality(condition) ? JCC_JE : JCC_JNE, frame->value + 4);
+            }
+            break;
+        }
+
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            done = step >= node->data.block.count;
+            if (!done)
+                ast_walk_push(&walk, node->data.block.statements[step], 0);
+            break;
+
+        default:
+            jit->has_error = 1;
+            break;
+        }
+        if (done)
+            ast_walk_pop(&walk);
+    }
+
+    if (walk.failed)
+        jit->has_error = 1;
+    free_ast_walk(&walk);
+}
+
+JitProgram *jit_compile(ASTNode *ast)
+{
+    JitProgram *program = calloc(1, sizeof(JitProgram));
+    if (!program)
+        return NULL;
+    init_symbol_table(&program->symbols);
+
+    JitCompiler jit = {NULL, 0, 0, &program->symbols, 0};
+    emit_byte(&jit, 0xEB); // jmp over the stub
+    emit_byte(&jit, 6);
+    emit_mov_imm(&jit, RAX, RUN_LIMIT_REACHED);
+    emit_byte(&jit, 0xC3); // ret
+    if (ast && ast->type == AST_PROGRAM)
+        compile_tree(&jit, ast);
+    emit_reg_op(&jit, 0x31, RAX, RAX); // xor eax, eax
+    emit_byte(&jit, 0xC3); // ret
+
+    if (jit.has_error)
+    {
+        free(jit.code);
+        free_jit_program(program);
+        return NULL;
+    }
+
+    // write the code while the page is writable, then flip it to read + execute
+    void *code = mmap(NULL, jit.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+    {
+        free(jit.code);
+        free_jit_program(program);
+        return NULL;
+    }
+    memcpy(code, jit.code, jit.length);
+    free(jit.code);
+    program->code = code;
+    program->size = jit.length;
+    if (mprotect(code, jit.length, PROT_READ | PROT_EXEC) != 0)
+    {
+        free_jit_program(program);
+        return NULL;
+    }
+    return program;
+}
+
+int jit_run(const JitProgram *program, int *slots, long long max_iterations)
+{
+    // the code finds the budget just below the slots
+    size_t size = sizeof(int) * program->symbols.count;
+    long long *frame = malloc(sizeof(long long) + size);
+    if (!frame)
+        return 1;
+    frame[0] = max_iterations > 0 ? max_iterations : LLONG_MAX;
+    memcpy(frame + 1, slots, size);
+
+    int (*entry)(int *);
+    // function and object pointers do not convert directly in ISO C
+    memcpy(&entry, &program->code, sizeof(entry));
+    int result = entry((int *)(frame + 1));
+    memcpy(slots, frame + 1, size);
+    free(frame);
+    return result;
+}
+
+#else
+
+JitProgram *jit_compile(ASTNode *ast)
+{
+    (void)ast;
+    return NULL;
+}
+
+int jit_run(const JitProgram *program, int *slots, long long max_iterations)
+{
+    (void)program;
+    (void)slots;
+    (void)max_iterations;
+    return 1;
+}
+
+#endif
+
+void free_jit_program(JitProgram *program)
+{
+    if (program)
+    {
+        if (program->code)
+            munmap(program->code, program->size);
+        free_symbol_table(&program->symbols);
+        free(program);
+    }
+}
+
+void write_jit_variables(OutputSink *sink, const JitProgram *program, const int *slots)
+{
+    for (int i = 0; i < program->symbols.count; i++)
+    {
+        sink_printf(sink, "%s = %d\n", symbol_name(&program->symbols, i), slots[i]);
+    }
+}
@@ -1,19 +1,23 @@
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "../include/lexer.h"
+#include "../include/allocator.h"
 
 Lexer *create_lexer(char *input)
 {
-    Lexer *lexer = malloc(sizeof(Lexer));
+    Lexer *lexer = sl_malloc(sizeof(Lexer));
     if (!lexer)
         return NULL;
 
     lexer->length = strlen(input);
-    lexer->input = malloc(lexer->length + 1);
+    lexer->input = sl_malloc(lexer->length + 1);
     if (!lexer->input)
     {
-        free(lexer);
+        sl_free(lexer);
         return NULL;
     }
 
@@ -22,22 +26,94 @@ Lexer *create_lexer(char *input)
     lexer->line = 1;
     lexer->column = 1;
     lexer->current_char = lexer->length > 0 ? lexer->input[0] : '\0';
+    lexer->read = NULL;
+    lexer->context = NULL;
+    lexer->capacity = lexer->length;
+    lexer->read_error = 0;
 
     return lexer;
 }
 
+// slide the unread part of the window (at most the current character) to the front and
+// read the next chunk behind it
+static void fill_window(Lexer *lexer)
+{
+    int kept = lexer->length - lexer->position;
+    memmove(lexer->input, lexer->input + lexer->position, kept);
+    lexer->position = 0;
+    lexer->length = kept;
+    while (lexer->read)
+    {
+        int count = lexer->read(lexer->context, lexer->input + kept, lexer->capacity - kept);
+        if (count > 0)
+        {
+            lexer->length += count;
+            break;
+        }
+        if (count < 0)
+            lexer->read_error = 1;
+        lexer->read = NULL;
+    }
+    lexer->input[lexer->length] = '\0';
+}
+
+Lexer *create_stream_lexer(LexerReader read, void *context)
+{
+    Lexer *lexer = sl_malloc(sizeof(Lexer));
+    if (!lexer)
+        return NULL;
+
+    lexer->input = sl_malloc(LEXER_CHUNK_SIZE + 1);
+    if (!lexer->input)
+    {
+        sl_free(lexer);
+        return NULL;
+    }
+    lexer->capacity = LEXER_CHUNK_SIZE;
+    lexer->read = read;
+    lexer->context = context;
+    lexer->read_error = 0;
+    lexer->position = 0;
+    lexer->length = 0;
+    lexer->line = 1;
+    lexer->column = 1;
+    fill_window(lexer);
+    lexer->current_char = lexer->length > 0 ? lexer->input[0] : '\0';
+
+    return lexer;
+}
+
+static int read_descriptor(void *context, char *buffer, int size)
+{
+    int fd = (int)(intptr_t)context;
+    ssize_t count;
+    do
+    {
+        count = read(fd, buffer, size);
+    } while (count < 0 && errno == EINTR);
+    return (int)count;
+}
+
+Lexer *create_fd_lexer(int fd)
+{
+    return create_stream_lexer(read_descriptor, (void *)(intptr_t)fd);
+}
+
 void free_lexer(Lexer *lexer)
 {
     if (lexer)
     {
         if (lexer->input)
-            free(lexer->input);
-        free(lexer);
+            sl_free(lexer->input);
+        sl_free(lexer);
     }
 }
 
 void advance(Lexer *lexer)
 {
+    // a stream reads on only when the window is used up
+    if (lexer->read && lexer->position >= lexer->length - 1)
+        fill_window(lexer);
     if (lexer->position < lexer->length - 1)
     {
         if (lexer->current_char == '\n')
@@ -66,6 +142,14 @@ void skip_whitespace(Lexer *lexer)
     }
 }
 
+// the character after the current one, '\0' at the end of the input
+static char peek_char(Lexer *lexer)
+{
+    if (lexer->read && lexer->position + 1 >= lexer->length)
+        fill_window(lexer);
+    return lexer->position + 1 < lexer->length ? lexer->input[lexer->position + 1] : '\0';
+}
+
 int is_alpha(char c)
 {
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
@@ -81,6 +165,18 @@ int is_alnum(char c)
     return is_alpha(c) || is_digit(c);
 }
 
+int is_identifier(const char *name)
+{
+    if (!is_alpha(*name))
+        return 0;
+    while (*++name)
+    {
+        if (!is_alnum(*name))
+            return 0;
+    }
+    return 1;
+}
+
 Token *read_number(Lexer *lexer)
 {
     int start_column = lexer->column;
@@ -122,6 +218,12 @@ TokenType get_keyword_type(char *identifier)
         return TOKEN_IF;
     if (strcmp(identifier, "else") == 0)
         return TOKEN_ELSE;
+    if (strcmp(identifier, "while") == 0)
+        return TOKEN_WHILE;
+    if (strcmp(identifier, "import") == 0)
+        return TOKEN_IMPORT;
+    if (strcmp(identifier, "extern") == 0)
+        return TOKEN_EXTERN;
     return TOKEN_IDENTIFIER;
 }
 
@@ -157,8 +259,7 @@ Token *get_next_token(Lexer *lexer)
         switch (lexer->current_char)
         {
         case '=':
-            if (lexer->position + 1 < lexer->length &&
-                lexer->input[lexer->position + 1] == '=')
+            if (peek_char(lexer) == '=')
             {
                 advance(lexer);
                 advance(lexer);
@@ -175,6 +276,24 @@ Token *get_next_token(Lexer *lexer)
             advance(lexer);
             return create_token(TOKEN_MINUS, "-", line, column);
 
+        case '*':
+            advance(lexer);
+            return create_token(TOKEN_STAR, "*", line, column);
+
+        case '<':
+        case '>':
+            if (peek_char(lexer) == lexer->current_char)
+            {
+                int left = lexer->current_char == '<';
+                advance(lexer);
+                advance(lexer);
+                return left ? create_token(TOKEN_SHIFT_LEFT, "<<", line, column)
+                            : create_token(TOKEN_SHIFT_RIGHT, ">>", line, column);
+            }
+            char single[2] = {lexer->current_char, '\0'};
+            advance(lexer);
+            return create_token(TOKEN_ERROR, single, line, column);
+
         case ';':
             advance(lexer);
             return create_token(TOKEN_SEMICOLON, ";", line, column);
@@ -207,27 +326,39 @@ Token *get_next_token(Lexer *lexer)
 
 char *read_file(char *filename)
 {
-    FILE *file = fopen(filename, "r");
+    int is_stdin = strcmp(filename, "-") == 0;
+    FILE *file = is_stdin ? stdin : fopen(filename, "r");
     if (!file)
-    {
-        printf("Error: Cannot open file '%s'\n", filename);
         return NULL;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
 
-    char *buffer = malloc(size + 1);
-    if (!buffer)
+    // no seeking: grow by doubling until a read comes up short
+    size_t capacity = LEXER_CHUNK_SIZE;
+    size_t size = 0;
+    char *buffer = sl_malloc(capacity + 1);
+    while (buffer)
     {
-        fclose(file);
-        return NULL;
+        size += fread(buffer + size, 1, capacity - size, file);
+        if (size < capacity)
+            break;
+        char *grown = sl_realloc(buffer, capacity * 2 + 1);
+        if (!grown)
+        {
+            sl_free(buffer);
+            buffer = NULL;
+            break;
+        }
+        buffer = grown;
+        capacity *= 2;
     }
-
-    fread(buffer, 1, size, file);
-    buffer[size] = '\0';
-    fclose(file);
+    if (buffer && ferror(file))
+    {
+        sl_free(buffer);
+        buffer = NULL;
+    }
+    if (buffer)
+        buffer[size] = '\0';
+    if (!is_stdin)
+        fclose(file);
 
     return buffer;
 }
@@ -236,20 +367,23 @@ int tokenize_file(char *filename, char *output_filename)
 {
     char *input = read_file(filename);
     if (!input)
+    {
+        printf("Error: Cannot open file '%s'\n", filename);
         return 1;
+    }
 
     FILE *output = fopen(output_filename, "w");
     if (!output)
     {
         printf("Error: Cannot create output file '%s'\n", output_filename);
-        free(input);
+        sl_free(input);
         return 1;
     }
 
     Lexer *lexer = create_lexer(input);
     if (!lexer)
     {
-        free(input);
+        sl_free(input);
         fclose(output);
         return 1;
     }
@@ -282,7 +416,7 @@ int tokenize_file(char *filename, char *output_filename)
     printf("\nTotal tokens: %d\n", count);
 
     free_lexer(lexer);
-    free(input);
+    sl_free(input);
     fclose(output);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,575 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/linker.h"
+#include "../include/lexer.h"
+
+#define OBJECT_MAGIC "SLO4"
+// longest name the reader accepts, far above what the lexer produces
+#define OBJECT_NAME_MAX 4096
+
+ObjectModule *create_object_module(const CodeGenerator *gen, const ProgramImage *image, uint64_t source_hash)
+{
+    ObjectModule *module = calloc(1, sizeof(ObjectModule));
+    if (!module)
+        return NULL;
+    module->source_hash = source_hash;
+
+    // the final hlt belongs to the program, the linker adds it once after every module,
+    // followed by the runtime routines
+    module->text_size = image->text_size;
+    for (int i = gen->count - 1; i >= 0; i--)
+    {
+        if (gen->instructions[i].opcode == OP_HLT)
+        {
+            module->text_size = image->instruction_address[i];
+            break;
+        }
+    }
+
+    module->text = malloc(module->text_size + 1);
+    module->symbols = calloc(gen->symbols.count + 1, sizeof(ObjectSymbol));
+    module->relocations = malloc(sizeof(Relocation) * (gen->count + 1));
+    module->jumps = malloc(sizeof(int) * (gen->count + 1));
+    module->calls = malloc(sizeof(RuntimeCall) * (gen->count + 1));
+    module->imports = calloc(gen->imports.count + 1, sizeof(char *));
+    if (!module->text || !module->symbols || !module->relocations || !module->jumps || !module->calls ||
+        !module->imports)
+    {
+        free_object_module(module);
+        return NULL;
+    }
+    memcpy(module->text, image->bytes, module->text_size);
+
+    for (int i = 0; i < gen->symbols.count; i++)
+    {
+        ObjectSymbol *symbol = &module->symbols[module->symbol_count++];
+        symbol->name = strdup(symbol_name(&gen->symbols, i));
+        if (!symbol->name)
+        {
+            free_object_module(module);
+            return NULL;
+        }
+        if (find_symbol(&gen->externs, symbol->name) >= 0)
+        {
+            symbol->kind = OBJECT_SYMBOL_EXTERN;
+        }
+        else
+        {
+            symbol->offset = module->data_size;
+            module->data_size += GLOBAL_SIZE;
+        }
+    }
+
+    // every memory operand is an absolute data address: lda and sta, after the opcode byte,
+    // left holding the offset into the slot;
+    // jumps hold text addresses, which stay relative to the module until it is placed,
+    // and calls are left zero for the linker to point at its copy of the routine
+    for (int i = 0; i < gen->count; i++)
+    {
+        const Instruction *inst = &gen->instructions[i];
+        int address = image->instruction_address[i] + 1;
+        if (address >= module->text_size)
+            continue;
+        if (inst->opcode == OP_JMP || inst->opcode == OP_JZ || inst->opcode == OP_JNZ || inst->opcode == OP_JNC)
+            module->jumps[module->jump_count++] = address;
+        if (inst->opcode == OP_CALL)
+        {
+            RuntimeCall *call = &module->calls[module->call_count++];
+            call->offset = address;
+            call->routine = 0;
+            while (call->routine < RUNTIME_COUNT - 1 && gen->runtime_label[call->routine] != inst->operand[0])
+                call->routine++;
+            module->text[address] = 0;
+            module->text[address + 1] = 0;
+        }
+        if (inst->operand_kind[0] != OPERAND_SYMBOL)
+            continue;
+        module->text[address] = inst->operand_kind[1] == OPERAND_IMMEDIATE ? (unsigned char)inst->operand[1] : 0;
+        module->text[address + 1] = 0;
+        module->relocations[module->relocation_count].offset = address;
+        module->relocations[module->relocation_count].symbol = inst->operand[0];
+        module->relocation_count++;
+    }
+
+    for (int i = 0; i < gen->imports.count; i++)
+    {
+        module->imports[i] = strdup(symbol_name(&gen->imports, i));
+        if (!module->imports[i])
+        {
+            free_object_module(module);
+            return NULL;
+        }
+        module->import_count++;
+    }
+    return module;
+}
+
+void free_object_module(ObjectModule *module)
+{
+    if (!module)
+        return;
+    if (module->symbols)
+    {
+        for (int i = 0; i < module->symbol_count; i++)
+        {
+            free(module->symbols[i].name);
+        }
+    }
+    if (module->imports)
+    {
+        for (int i = 0; i < module->import_count; i++)
+        {
+            free(module->imports[i]);
+        }
+    }
+    free(module->text);
+    free(module->symbols);
+    free(module->relocations);
+    free(module->jumps);
+    free(module->calls);
+    free(module->imports);
+    free(module);
+}
+
+static void write_u32(OutputSink *sink, uint32_t value)
+{
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    sink_write(sink, (const char *)bytes, sizeof(bytes));
+}
+
+static void write_name(OutputSink *sink, const char *name)
+{
+    size_t length = strlen(name);
+    write_u32(sink, (uint32_t)length);
+    sink_write(sink, name, length);
+}
+
+int write_object(const ObjectModule *module, OutputSink *sink)
+{
+    unsigned char hash[8];
+    for (int i = 0; i < 8; i++)
+    {
+        hash[i] = (unsigned char)(module->source_hash >> (8 * i));
+    }
+    sink_write(sink, OBJECT_MAGIC, 4);
+    sink_write(sink, (const char *)hash, sizeof(hash));
+
+    write_u32(sink, module->text_size);
+    sink_write(sink, (const char *)module->text, module->text_size);
+    write_u32(sink, module->data_size);
+
+    write_u32(sink, module->symbol_count);
+    for (int i = 0; i < module->symbol_count; i++)
+    {
+        write_u32(sink, module->symbols[i].kind);
+        write_u32(sink, module->symbols[i].offset);
+        write_name(sink, module->symbols[i].name);
+    }
+    write_u32(sink, module->relocation_count);
+    for (int i = 0; i < module->relocation_count; i++)
+    {
+        write_u32(sink, module->relocations[i].offset);
+        write_u32(sink, module->relocations[i].symbol);
+    }
+    write_u32(sink, module->jump_count);
+    for (int i = 0; i < module->jump_count; i++)
+    {
+        write_u32(sink, module->jumps[i]);
+    }
+    write_u32(sink, module->call_count);
+    for (int i = 0; i < module->call_count; i++)
+    {
+        write_u32(sink, module->calls[i].offset);
+        write_u32(sink, module->calls[i].routine);
+    }
+    write_u32(sink, module->import_count);
+    for (int i = 0; i < module->import_count; i++)
+    {
+        write_name(sink, module->imports[i]);
+    }
+    return sink->has_error ? -1 : 0;
+}
+
+// bounds checked cursor over the object bytes; any overrun sets failed
+typedef struct
+{
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+    int failed;
+} ObjectReader;
+
+static const unsigned char *take(ObjectReader *reader, size_t count)
+{
+    if (reader->failed || count > reader->length - reader->position)
+    {
+        reader->failed = 1;
+        return NULL;
+    }
+    const unsigned char *bytes = reader->data + reader->position;
+    reader->position += count;
+    return bytes;
+}
+
+// counts and sizes, at most limit
+static int read_count(ObjectReader *reader, uint32_t limit)
+{
+    const unsigned char *bytes = take(reader, 4);
+    if (!bytes)
+        return 0;
+    uint32_t value = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    if (value > limit)
+    {
+        reader->failed = 1;
+        return 0;
+    }
+    return (int)value;
+}
+
+static char *read_name(ObjectReader *reader)
+{
+    int length = read_count(reader, OBJECT_NAME_MAX);
+    const unsigned char *bytes = take(reader, length);
+    if (!bytes || length == 0 || memchr(bytes, '\0', length))
+    {
+        reader->failed = 1;
+        return NULL;
+    }
+    char *name = malloc(length + 1);
+    if (!name)
+    {
+        reader->failed = 1;
+        return NULL;
+    }
+    memcpy(name, bytes, length);
+    name[length] = '\0';
+    // symbols and imports reach assembly text and module paths, so only identifiers
+    if (!is_identifier(name))
+    {
+        free(name);
+        reader->failed = 1;
+        return NULL;
+    }
+    return name;
+}
+
+ObjectModule *read_object(const unsigned char *data, size_t length)
+{
+    ObjectReader reader = {data, length, 0, 0};
+    const unsigned char *magic = take(&reader, 4);
+    const unsigned char *hash = take(&reader, 8);
+    if (!hash || memcmp(magic, OBJECT_MAGIC, 4) != 0)
+        return NULL;
+
+    ObjectModule *module = calloc(1, sizeof(ObjectModule));
+    if (!module)
+        return NULL;
+    for (int i = 0; i < 8; i++)
+    {
+        module->source_hash |= (uint64_t)hash[i] << (8 * i);
+    }
+
+    module->text_size = read_count(&reader, IMAGE_MAX_SIZE);
+    const unsigned char *text = take(&reader, module->text_size);
+    module->text = malloc(module->text_size + 1);
+    if (text && module->text)
+        memcpy(module->text, text, module->text_size);
+    module->data_size = read_count(&reader, IMAGE_MAX_SIZE);
+
+    // every symbol takes at least 12 bytes and every relocation 8, which bounds the counts
+    int symbol_count = read_count(&reader, (uint32_t)(length / 12));
+    module->symbols = calloc(symbol_count + 1, sizeof(ObjectSymbol));
+    for (int i = 0; module->symbols && i < symbol_count && !reader.failed; i++)
+    {
+        ObjectSymbol *symbol = &module->symbols[i];
+        symbol->kind = read_count(&reader, OBJECT_SYMBOL_EXTERN);
+        symbol->offset = read_count(&reader, IMAGE_MAX_SIZE);
+        symbol->name = read_name(&reader);
+        module->symbol_count = i + 1;
+        if (symbol->kind == OBJECT_SYMBOL_DEFINED && symbol->offset + GLOBAL_SIZE > module->data_size)
+            reader.failed = 1;
+    }
+
+    int relocation_count = read_count(&reader, (uint32_t)(length / 8));
+    module->relocations = malloc(sizeof(Relocation) * (relocation_count + 1));
+    for (int i = 0; module->relocations && module->text && i < relocation_count && !reader.failed; i++)
+    {
+        Relocation *relocation = &module->relocations[i];
+        relocation->offset = read_count(&reader, IMAGE_MAX_SIZE);
+        relocation->symbol = read_count(&reader, IMAGE_MAX_SIZE);
+        module->relocation_count = i + 1;
+        if (relocation->offset + 2 > module->text_size || relocation->symbol >= module->symbol_count ||
+            (module->text[relocation->offset] | module->text[relocation->offset + 1] << 8) >= GLOBAL_SIZE)
+            reader.failed = 1;
+    }
+
+    // a jump may target the end of the text, where the next module starts
+    int jump_count = read_count(&reader, (uint32_t)(length / 4));
+    module->jumps = malloc(sizeof(int) * (jump_count + 1));
+    for (int i = 0; module->jumps && module->text && i < jump_count && !reader.failed; i++)
+    {
+        int offset = read_count(&reader, IMAGE_MAX_SIZE);
+        module->jumps[i] = offset;
+        module->jump_count = i + 1;
+        if (offset + 2 > module->text_size ||
+            (module->text[offset] | module->text[offset + 1] << 8) > module->text_size)
+            reader.failed = 1;
+    }
+
+    int call_count = read_count(&reader, (uint32_t)(length / 8));
+    module->calls = malloc(sizeof(RuntimeCall) * (call_count + 1));
+    for (int i = 0; module->calls && i < call_count && !reader.failed; i++)
+    {
+        RuntimeCall *call = &module->calls[i];
+        call->offset = read_count(&reader, IMAGE_MAX_SIZE);
+        call->routine = read_count(&reader, RUNTIME_COUNT - 1);
+        module->call_count = i + 1;
+        if (call->offset + 2 > module->text_size)
+            reader.failed = 1;
+    }
+
+    int import_count = read_count(&reader, (uint32_t)(length / 4));
+    module->imports = calloc(import_count + 1, sizeof(char *));
+    for (int i = 0; module->imports && i < import_count && !reader.failed; i++)
+    {
+        module->imports[i] = read_name(&reader);
+        module->import_count = i + 1;
+    }
+
+    if (reader.failed || reader.position != length || !module->text || !module->symbols ||
+        !module->relocations || !module->jumps || !module->calls || !module->imports)
+    {
+        free_object_module(module);
+        return NULL;
+    }
+    return module;
+}
+
+ObjectModule *load_object(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    ObjectModule *module = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        length = ftell(file);
+    unsigned char *data = length >= 0 ? malloc(length + 1) : NULL;
+    if (data && fseek(file, 0, SEEK_SET) == 0 && fread(data, 1, length, file) == (size_t)length)
+        module = read_object(data, (size_t)length);
+    free(data);
+    fclose(file);
+    return module;
+}
+
+static void link_error(ProgramImage *image, const char *format, ...)
+{
+    if (image->has_error)
+        return;
+    image->has_error = 1;
+    int length = snprintf(image->error_message, sizeof(image->error_message), "Link error: ");
+    va_list args;
+    va_start(args, format);
+    vsnprintf(image->error_message + length, sizeof(image->error_message) - length, format, args);
+    va_end(args);
+}
+
+// The runtime routines the modules call, assembled to run at base: returns their code,
+// size bytes, and sets the address of every routine (-1 for those not used). NULL when
+// out of memory.
+static unsigned char *assemble_runtime(ObjectModule *const *modules, int count, int base,
+                                       int *routine_address, int *size)
+{
+    CodeGenerator *runtime = create_codegen();
+    if (!runtime)
+        return NULL;
+    runtime->extended_isa = 1; // only modules built for the extension call them
+    for (int m = 0; m < count; m++)
+    {
+        for (int i = 0; i < modules[m]->call_count; i++)
+        {
+            int routine = modules[m]->calls[i].routine;
+            if (runtime->runtime_label[routine] < 0)
+                runtime->runtime_label[routine] = runtime->label_count++;
+        }
+    }
+    emit_runtime(runtime);
+
+    ProgramImage *code = assemble_program(runtime);
+    unsigned char *bytes = code && !code->has_error ? malloc(code->text_size + 1) : NULL;
+    if (bytes)
+    {
+        memcpy(bytes, code->bytes, code->text_size);
+        *size = code->text_size;
+        for (int routine = 0; routine < RUNTIME_COUNT; routine++)
+        {
+            int label = runtime->runtime_label[routine];
+            routine_address[routine] = label < 0 ? -1 : base + code->label_address[label];
+        }
+        for (int i = 0; i < runtime->count; i++)
+        {
+            // the two byte multiply calls the byte one, so calls move with the code too
+            int opcode = runtime->instructions[i].opcode;
+            if (opcode != OP_JMP && opcode != OP_JZ && opcode != OP_JNZ && opcode != OP_JNC &&
+                opcode != OP_CALL)
+                continue;
+            unsigned char *address = bytes + code->instruction_address[i] + 1;
+            int target = base + (address[0] | address[1] << 8);
+            address[0] = (unsigned char)(target & 0xFF);
+            address[1] = (unsigned char)(target >> 8);
+        }
+    }
+    free_program_image(code);
+    free_codegen(runtime);
+    return bytes;
+}
+
+ProgramImage *link_modules(ObjectModule *const *modules, const char *const *names, int count,
+                           SymbolTable *symbols)
+{
+    ProgramImage *image = calloc(1, sizeof(ProgramImage));
+    int *text_base = malloc(sizeof(int) * (count + 1));
+    int *owner = NULL; // defining module of every global
+    int owner_capacity = 0;
+    if (!image || !text_base)
+    {
+        free(image);
+        free(text_base);
+        return NULL;
+    }
+
+    // globals in module order, so data is laid out the way the modules were given
+    int address = 0;
+    for (int m = 0; m < count; m++)
+    {
+        text_base[m] = address;
+        address += modules[m]->text_size;
+        for (int i = 0; i < modules[m]->symbol_count; i++)
+        {
+            const ObjectSymbol *symbol = &modules[m]->symbols[i];
+            if (symbol->kind != OBJECT_SYMBOL_DEFINED)
+                continue;
+            int id = find_symbol(symbols, symbol->name);
+            if (id >= 0)
+            {
+                link_error(image, "'%s' is defined in both %s and %s", symbol->name, names[owner[id]], names[m]);
+                continue;
+            }
+            id = intern_symbol(symbols, symbol->name);
+            if (id >= owner_capacity)
+            {
+                int capacity = owner_capacity ? owner_capacity * 2 : 64;
+                int *grown = id >= 0 ? realloc(owner, sizeof(int) * capacity) : NULL;
+                if (!grown)
+                {
+                    free(owner);
+                    free(text_base);
+                    free_program_image(image);
+                    return NULL;
+                }
+                owner = grown;
+                owner_capacity = capacity;
+            }
+            owner[id] = m;
+        }
+    }
+    for (int m = 0; m < count; m++)
+    {
+        for (int i = 0; i < modules[m]->symbol_count; i++)
+        {
+            const ObjectSymbol *symbol = &modules[m]->symbols[i];
+            if (symbol->kind == OBJECT_SYMBOL_EXTERN && find_symbol(symbols, symbol->name) < 0)
+                link_error(image, "undefined reference to '%s' in %s", symbol->name, names[m]);
+        }
+    }
+    free(owner);
+
+    // one hlt ends the program, then the runtime routines and two data bytes per global
+    int routine_address[RUNTIME_COUNT], runtime_size = 0;
+    unsigned char *runtime = assemble_runtime(modules, count, address + 1, routine_address, &runtime_size);
+    if (!runtime)
+    {
+        free(text_base);
+        free_program_image(image);
+        return NULL;
+    }
+    image->text_size = address + 1 + runtime_size;
+    image->symbol_count = symbols->count;
+    image->size = image->text_size + GLOBAL_SIZE * symbols->count;
+    image->symbol_address = malloc(sizeof(int) * (symbols->count + 1));
+    image->symbol_size = malloc(sizeof(int) * (symbols->count + 1));
+    if (!image->symbol_address || !image->symbol_size)
+    {
+        free(text_base);
+        free(runtime);
+        free_program_image(image);
+        return NULL;
+    }
+    for (int i = 0; i < symbols->count; i++)
+    {
+        image->symbol_address[i] = image->text_size + GLOBAL_SIZE * i;
+        image->symbol_size[i] = GLOBAL_SIZE;
+    }
+    if (image->has_error)
+    {
+        free(text_base);
+        free(runtime);
+        return image;
+    }
+    if (image->size > IMAGE_MAX_SIZE)
+    {
+        link_error(image, "program does not fit in the 64 KiB address space");
+        free(text_base);
+        free(runtime);
+        return image;
+    }
+
+    image->bytes = calloc(image->size, 1);
+    if (!image->bytes)
+    {
+        free(text_base);
+        free(runtime);
+        free_program_image(image);
+        return NULL;
+    }
+    for (int m = 0; m < count; m++)
+    {
+        const ObjectModule *module = modules[m];
+        unsigned char *text = image->bytes + text_base[m];
+        memcpy(text, module->text, module->text_size);
+        for (int i = 0; i < module->relocation_count; i++)
+        {
+            const Relocation *relocation = &module->relocations[i];
+            int target = image->symbol_address[find_symbol(symbols, module->symbols[relocation->symbol].name)] +
+                         text[relocation->offset];
+            text[relocation->offset] = (unsigned char)(target & 0xFF);
+            text[relocation->offset + 1] = (unsigned char)(target >> 8);
+        }
+        for (int i = 0; i < module->jump_count; i++)
+        {
+            unsigned char *address = text + module->jumps[i];
+            int target = text_base[m] + (address[0] | address[1] << 8);
+            address[0] = (unsigned char)(target & 0xFF);
+            address[1] = (unsigned char)(target >> 8);
+        }
+        for (int i = 0; i < module->call_count; i++)
+        {
+            int target = routine_address[module->calls[i].routine];
+            text[module->calls[i].offset] = (unsigned char)(target & 0xFF);
+            text[module->calls[i].offset + 1] = (unsigned char)(target >> 8);
+        }
+    }
+    image->bytes[address] = ENC_HLT;
+    memcpy(image->bytes + address + 1, runtime, runtime_size);
+    free(text_base);
+    free(runtime);
+    return image;
+}
@@ -0,0 +1,400 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/listing.h"
+#include "../include/simulator.h"
+#include "../include/allocator.h"
+
+// the source split into lines, numbered from 1
+typedef struct
+{
+    const char **starts;
+    int *lengths;
+    int count;
+} SourceLines;
+
+// code of one statement, found by the position its instructions carry
+typedef struct
+{
+    int line;
+    int column;
+    int bytes;
+    int cycles;
+} Spot;
+
+// totals of a statement or block, nested ones included
+typedef struct
+{
+    int bytes;
+    int cycles;
+    int first; // lines spanned, first > last when it has no statements
+    int last;
+} Cost;
+
+static int split_lines(const char *source, SourceLines *lines)
+{
+    lines->starts = NULL;
+    lines->lengths = NULL;
+    lines->count = 0;
+    if (!source)
+        return 0;
+
+    int count = 1;
+    for (const char *c = source; *c; c++)
+    {
+        if (*c == '\n')
+            count++;
+    }
+    lines->starts = sl_malloc(sizeof(const char *) * count);
+    lines->lengths = sl_malloc(sizeof(int) * count);
+    if (!lines->starts || !lines->lengths)
+        return -1;
+
+    const char *start = source;
+    for (;;)
+    {
+        const char *end = strchr(start, '\n');
+        int length = end ? (int)(end - start) : (int)strlen(start);
+        if (length > 0 && start[length - 1] == '\r')
+            length--;
+        lines->starts[lines->count] = start;
+        lines->lengths[lines->count++] = length;
+        if (!end)
+            break;
+        start = end + 1;
+    }
+    // the newline ending the last line does not start another
+    if (lines->count > 1 && lines->lengths[lines->count - 1] == 0 && !*lines->starts[lines->count - 1])
+        lines->count--;
+    return 0;
+}
+
+static int instruction_cycles(const Instruction *inst)
+{
+    return inst->opcode == OP_LABEL ? 0 : opcode_cycles((Opcode)inst->opcode);
+}
+
+static void write_source_line(OutputSink *sink, const SourceLines *lines, int line, const char *totals)
+{
+    if (line <= lines->count)
+        sink_printf(sink, "%5d %s | %.*s\n", line, totals, lines->lengths[line - 1], lines->starts[line - 1]);
+    else
+        sink_printf(sink, "%5d %s |\n", line, totals);
+}
+
+static void write_row(OutputSink *sink, const CodeGenerator *gen, const ProgramImage *image, int index)
+{
+    const Instruction *inst = &gen->instructions[index];
+    int address = image->instruction_address[index];
+    int size = instruction_size(inst);
+
+    char code[16] = "";
+    int used = 0;
+    for (int i = 0; i < size && i < 4; i++)
+        used += sprintf(code + used, i ? " %02x" : "%02x", image->bytes[address + i]);
+
+    // only long variable names need a buffer of their own
+    char text[64];
+    char *shown = text;
+    int length = format_instruction(gen, inst, text, sizeof(text));
+    if (length >= (int)sizeof(text))
+    {
+        shown = sl_malloc((size_t)length + 1);
+        if (shown)
+            format_instruction(gen, inst, shown, (size_t)length + 1);
+        else
+            shown = text;
+    }
+
+    if (inst->opcode == OP_LABEL)
+        sink_printf(sink, "      %04x            %s\n", address, shown);
+    else
+        sink_printf(sink, "      %04x  %-9s   %-24s %3d\n", address, code, shown, instruction_cycles(inst));
+    if (shown != text)
+        sl_free(shown);
+}
+
+static int compare_spots(const void *a, const void *b)
+{
+    const Spot *left = a, *right = b;
+    if (left->line != right->line)
+        return left->line < right->line ? -1 : 1;
+    return left->column < right->column ? -1 : left->column > right->column;
+}
+
+// code per statement position, sorted for lookup; count set to the number of spots
+static Spot *collect_spots(const CodeGenerator *gen, int *count)
+{
+    Spot *spots = sl_malloc(sizeof(Spot) * (gen->count > 0 ? gen->count : 1));
+    if (!spots)
+        return NULL;
+    int used = 0;
+    for (int i = 0; i < gen->count; i++)
+    {
+        if (gen->positions[i].line == 0)
+            continue;
+        Spot spot = {gen->positions[i].line, gen->positions[i].column, instruction_size(&gen->instructions[i]),
+                     instruction_cycles(&gen->instructions[i])};
+        spots[used++] = spot;
+    }
+    qsort(spots, used, sizeof(Spot), compare_spots);
+
+    int merged = 0;
+    for (int i = 0; i < used; i++)
+    {
+        if (merged > 0 && compare_spots(&spots[merged - 1], &spots[i]) == 0)
+        {
+            spots[merged - 1].bytes += spots[i].bytes;
+            spots[merged - 1].cycles += spots[i].cycles;
+        }
+        else
+        {
+            spots[merged++] = spots[i];
+        }
+    }
+    *count = merged;
+    return spots;
+}
+
+// statements and blocks get a row, expressions are part of their statement's
+static int is_listed(const ASTNode *node)
+{
+    return node && node->type != AST_EXPRESSION && node->type != AST_BINARY_OP && node->type != AST_NUMBER &&
+           node->type != AST_IDENTIFIER;
+}
+
+static int is_statement(const ASTNode *node)
+{
+    return node->type != AST_PROGRAM && node->type != AST_BLOCK;
+}
+
+// every listed node's totals, in pre order; NULL when out of memory
+static Cost *cost_tree(ASTNode *program, const Spot *spots, int spot_count)
+{
+    Cost *costs = sl_malloc(sizeof(Cost) * count_ast_nodes(program));
+    if (!costs)
+        return NULL;
+    int next = 0;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) != NULL)
+    {
+        ASTNode *node = frame->node;
+        if (frame->step == 0)
+        {
+            Cost cost = {0, 0, INT_MAX, 0};
+            if (is_statement(node))
+            {
+                Spot key = {node->line, node->column, 0, 0};
+                const Spot *spot = bsearch(&key, spots, spot_count, sizeof(Spot), compare_spots);
+                if (spot)
+                {
+                    cost.bytes = spot->bytes;
+                    cost.cycles = spot->cycles;
+                }
+                cost.first = cost.last = node->line;
+            }
+            frame->value = next;
+            costs[next++] = cost;
+        }
+
+        int child = frame->step++;
+        if (child < ast_child_count(node))
+        {
+            ASTNode *next_child = ast_child(node, child);
+            if (is_listed(next_child))
+                ast_walk_push(&walk, next_child, 0);
+            continue;
+        }
+
+        Cost done = costs[frame->value];
+        ast_walk_pop(&walk);
+        ASTFrame *parent = ast_walk_top(&walk);
+        if (parent)
+        {
+            Cost *total = &costs[parent->value];
+            total->bytes += done.bytes;
+            total->cycles += done.cycles;
+            if (done.first < total->first)
+                total->first = done.first;
+            if (done.last > total->last)
+                total->last = done.last;
+        }
+    }
+
+    int failed = walk.failed;
+    free_ast_walk(&walk);
+    if (failed)
+    {
+        sl_free(costs);
+        return NULL;
+    }
+    return costs;
+}
+
+// what a row stands for; index is a block's place in its parent
+static void write_description(OutputSink *sink, const ASTNode *node, const ASTNode *parent, int index)
+{
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+        sink_printf(sink, "program\n");
+        break;
+    case AST_DECLARATION:
+        sink_printf(sink, "int %s\n", node->data.declaration.var_name);
+        break;
+    case AST_ASSIGNMENT:
+        sink_printf(sink, "%s =\n", node->data.assignment.var_name);
+        break;
+    case AST_IF_STATEMENT:
+        sink_printf(sink, "if\n");
+        break;
+    case AST_WHILE_STATEMENT:
+        sink_printf(sink, "while\n");
+        break;
+    case AST_IMPORT:
+        sink_printf(sink, "import %s\n", node->data.import.module);
+        break;
+    case AST_EXTERN:
+        sink_printf(sink, "extern int %s\n", node->data.extern_decl.var_name);
+        break;
+    default:
+        if (parent && parent->type == AST_IF_STATEMENT)
+            sink_printf(sink, "%s\n", index == 1 ? "then" : "else");
+        else
+            sink_printf(sink, "body\n");
+        break;
+    }
+}
+
+static void write_costs(OutputSink *sink, ASTNode *program, const Cost *costs)
+{
+    sink_printf(sink, "\n; statements and blocks, with everything nested in them\n");
+    sink_printf(sink, "; bytes  cycles  lines\n");
+    int next = 0;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) != NULL)
+    {
+        ASTNode *node = frame->node;
+        if (frame->step == 0)
+        {
+            const Cost *cost = &costs[next++];
+            char lines[32] = "-";
+            if (cost->first == cost->last)
+                sprintf(lines, "%d", cost->first);
+            else if (cost->first < cost->last)
+                sprintf(lines, "%d-%d", cost->first, cost->last);
+            int depth = walk.count - 1 < AST_DRAW_DEPTH ? walk.count - 1 : AST_DRAW_DEPTH;
+            sink_printf(sink, "%7d %7d  %-11s %*s", cost->bytes, cost->cycles, lines, depth * 2, "");
+            const ASTNode *parent = walk.count > 1 ? walk.frames[walk.count - 2].node : NULL;
+            write_description(sink, node, parent, frame->value);
+        }
+
+        int child = frame->step++;
+        if (child < ast_child_count(node))
+        {
+            ASTNode *next_child = ast_child(node, child);
+            if (is_listed(next_child))
+                ast_walk_push(&walk, next_child, child);
+            continue;
+        }
+        ast_walk_pop(&walk);
+    }
+    free_ast_walk(&walk);
+}
+
+// every instruction under the source line it was generated for, then the totals
+static void write_lines(OutputSink *sink, const CodeGenerator *gen, const ProgramImage *image,
+                        const SourceLines *lines, const int *line_bytes, const int *line_cycles)
+{
+    sink_printf(sink, "; line  bytes cycles | source\n");
+    sink_printf(sink, ";     address  code        instruction           cycles\n");
+    int shown = 0;    // source lines up to this one have been written in order
+    int current = -1; // line of the instruction before
+    for (int i = 0; i < gen->count; i++)
+    {
+        int line = gen->positions[i].line;
+        if (line != current)
+        {
+            char totals[32];
+            if (line == 0)
+            {
+                for (shown++; shown <= lines->count; shown++)
+                    write_source_line(sink, lines, shown, "             ");
+                sink_printf(sink, "; hlt and runtime routines: %d bytes, %d cycles\n", line_bytes[0], line_cycles[0]);
+            }
+            else if (line > shown)
+            {
+                // lines without code of their own, for context
+                for (shown++; shown < line; shown++)
+                    write_source_line(sink, lines, shown, "             ");
+                sprintf(totals, "%6d %6d", line_bytes[line], line_cycles[line]);
+                write_source_line(sink, lines, line, totals);
+            }
+            else
+            {
+                write_source_line(sink, lines, line, "  (continued)");
+            }
+            current = line;
+        }
+        write_row(sink, gen, image, i);
+    }
+}
+
+int write_listing(OutputSink *sink, const CodeGenerator *gen, const ProgramImage *image, ASTNode *program,
+                  const char *source)
+{
+    int line_count = 0;
+    for (int i = 0; i < gen->count; i++)
+    {
+        if (gen->positions[i].line > line_count)
+            line_count = gen->positions[i].line;
+    }
+    SourceLines lines;
+    int split = split_lines(source, &lines);
+    if (lines.count > line_count)
+        line_count = lines.count;
+
+    // per line totals, line 0 being the hlt and the runtime
+    int *line_bytes = sl_calloc(line_count + 1, sizeof(int));
+    int *line_cycles = sl_calloc(line_count + 1, sizeof(int));
+    int spot_count = 0;
+    Spot *spots = collect_spots(gen, &spot_count);
+    Cost *costs = spots ? cost_tree(program, spots, spot_count) : NULL;
+
+    int status = -1;
+    if (split == 0 && line_bytes && line_cycles && costs)
+    {
+        for (int i = 0; i < gen->count; i++)
+        {
+            line_bytes[gen->positions[i].line] += instruction_size(&gen->instructions[i]);
+            line_cycles[gen->positions[i].line] += instruction_cycles(&gen->instructions[i]);
+        }
+        write_lines(sink, gen, image, &lines, line_bytes, line_cycles);
+        write_costs(sink, program, costs);
+
+        int code_cycles = 0;
+        for (int line = 1; line <= line_count; line++)
+            code_cycles += line_cycles[line];
+        sink_printf(sink, "; %d bytes of code and %d cycles with every instruction run once, %d bytes of hlt and "
+                          "runtime, %d bytes of data\n",
+                    image->text_size - line_bytes[0], code_cycles, line_bytes[0], image->size - image->text_size);
+        status = sink->has_error ? -1 : 0;
+    }
+
+    sl_free(lines.starts);
+    sl_free(lines.lengths);
+    sl_free(line_bytes);
+    sl_free(line_cycles);
+    sl_free(spots);
+    sl_free(costs);
+    return status;
+}
@@ -0,0 +1,866 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "../include/lsp.h"
+#include "../include/document.h"
+
+// largest message body accepted, well above a didOpen of a very large file
+#define LSP_MAX_MESSAGE (256L * 1024 * 1024)
+// nesting limit of the JSON reader, the protocol itself needs a handful of levels
+#define JSON_MAX_DEPTH 64
+
+#define LSP_METHOD_NOT_FOUND -32601
+#define LSP_PARSE_ERROR -32700
+
+// Just enough JSON for the protocol: the whole message is read into a tree of values.
+typedef enum
+{
+    JSON_NULL,
+    JSON_FALSE,
+    JSON_TRUE,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} JsonType;
+
+typedef struct JsonValue JsonValue;
+struct JsonValue
+{
+    JsonType type;
+    double number;
+    char *string; // NUL terminated, length bytes (which may include NULs)
+    size_t length;
+    JsonValue *items; // array elements or object members
+    char **keys;      // objects only
+    int count;
+};
+
+typedef struct
+{
+    const char *text;
+    size_t position;
+    size_t length;
+    int depth;
+} JsonReader;
+
+typedef struct
+{
+    int fd;
+    char buffer[4096];
+    size_t start;
+    size_t end;
+} MessageReader;
+
+typedef struct
+{
+    char *uri;
+    int version;
+    Document *document;
+} OpenDocument;
+
+typedef struct
+{
+    OutputSink *out;
+    OpenDocument *documents;
+    int count;
+    int capacity;
+    int shutdown;
+} LanguageServer;
+
+static void free_json(JsonValue *value)
+{
+    free(value->string);
+    for (int i = 0; i < value->count; i++)
+    {
+        free_json(&value->items[i]);
+        if (value->keys)
+            free(value->keys[i]);
+    }
+    free(value->items);
+    free(value->keys);
+    memset(value, 0, sizeof(JsonValue));
+}
+
+static void skip_json_space(JsonReader *reader)
+{
+    while (reader->position < reader->length)
+    {
+        char c = reader->text[reader->position];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+            break;
+        reader->position++;
+    }
+}
+
+static int read_hex4(JsonReader *reader, unsigned *code)
+{
+    if (reader->length - reader->position < 4)
+        return -1;
+    *code = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        char c = reader->text[reader->position++];
+        int digit = c >= '0' && c <= '9'   ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                           : -1;
+        if (digit < 0)
+            return -1;
+        *code = *code * 16 + digit;
+    }
+    return 0;
+}
+
+static size_t put_utf8(char *out, unsigned code)
+{
+    if (code < 0x80)
+    {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800)
+    {
+        out[0] = (char)(0xC0 | code >> 6);
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000)
+    {
+        out[0] = (char)(0xE0 | code >> 12);
+        out[1] = (char)(0x80 | (code >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | code >> 18);
+    out[1] = (char)(0x80 | (code >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (code >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+// a string at the opening quote; decoded text is never longer than its escaped form
+static int read_json_string(JsonReader *reader, char **string, size_t *length)
+{
+    reader->position++;
+    size_t end = reader->position;
+    while (end < reader->length && reader->text[end] != '"')
+        end += reader->text[end] == '\\' ? 2 : 1;
+    if (end >= reader->length)
+        return -1;
+
+    char *out = malloc(end - reader->position + 1);
+    if (!out)
+        return -1;
+    size_t n = 0;
+    while (reader->position < end)
+    {
+        char c = reader->text[reader->position++];
+        if (c != '\\')
+        {
+            out[n++] = c;
+            continue;
+        }
+        c = reader->text[reader->position++];
+        unsigned code;
+        switch (c)
+        {
+        case 'n':
+            out[n++] = '\n';
+            break;
+        case 't':
+            out[n++] = '\t';
+            break;
+        case 'r':
+            out[n++] = '\r';
+            break;
+        case 'b':
+            out[n++] = '\b';
+            break;
+        case 'f':
+            out[n++] = '\f';
+            break;
+        case 'u':
+            if (read_hex4(reader, &code) != 0)
+            {
+                free(out);
+                return -1;
+            }
+            // a surrogate pair is one character
+            if (code >= 0xD800 && code < 0xDC00 && end - reader->position >= 6 &&
+                reader->text[reader->position] == '\\' && reader->text[reader->position + 1] == 'u')
+            {
+                unsigned low;
+                reader->position += 2;
+                if (read_hex4(reader, &low) != 0)
+                {
+                    free(out);
+                    return -1;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            n += put_utf8(out + n, code);
+            break;
+        default: // '"', '\\' and '/' stand for themselves
+            out[n++] = c;
+            break;
+        }
+    }
+    reader->position = end + 1;
+    out[n] = '\0';
+    *string = out;
+    *length = n;
+    return 0;
+}
+
+static int read_json_value(JsonReader *reader, JsonValue *value);
+
+static int add_json_item(JsonValue *container, int *capacity, const JsonValue *item, char *key)
+{
+    if (container->count == *capacity)
+    {
+        int grown = *capacity ? *capacity * 2 : 8;
+        JsonValue *items = realloc(container->items, sizeof(JsonValue) * grown);
+        if (!items)
+            return -1;
+        container->items = items;
+        if (container->type == JSON_OBJECT)
+        {
+            char **keys = realloc(container->keys, sizeof(char *) * grown);
+            if (!keys)
+                return -1;
+            container->keys = keys;
+        }
+        *capacity = grown;
+    }
+    container->items[container->count] = *item;
+    if (container->keys)
+        container->keys[container->count] = key;
+    container->count++;
+    return 0;
+}
+
+// the members of an array or object, at its opening bracket
+static int read_json_container(JsonReader *reader, JsonValue *value, char close)
+{
+    if (++reader->depth > JSON_MAX_DEPTH)
+        return -1;
+    reader->position++;
+    int capacity = 0;
+    skip_json_space(reader);
+    if (reader->position < reader->length && reader->text[reader->position] == close)
+    {
+        reader->position++;
+        reader->depth--;
+        return 0;
+    }
+    for (;;)
+    {
+        char *key = NULL;
+        size_t key_length;
+        skip_json_space(reader);
+        if (value->type == JSON_OBJECT)
+        {
+            if (reader->position >= reader->length || reader->text[reader->position] != '"' ||
+                read_json_string(reader, &key, &key_length) != 0)
+                return -1;
+            skip_json_space(reader);
+            if (reader->position >= reader->length || reader->text[reader->position++] != ':')
+            {
+                free(key);
+                return -1;
+            }
+        }
+        JsonValue item;
+        if (read_json_value(reader, &item) != 0)
+        {
+            free(key);
+            return -1;
+        }
+        if (add_json_item(value, &capacity, &item, key) != 0)
+        {
+            free_json(&item);
+            free(key);
+            return -1;
+        }
+        skip_json_space(reader);
+        if (reader->position >= reader->length)
+            return -1;
+        char c = reader->text[reader->position++];
+        if (c == close)
+            break;
+        if (c != ',')
+            return -1;
+    }
+    reader->depth--;
+    return 0;
+}
+
+static int read_json_value(JsonReader *reader, JsonValue *value)
+{
+    memset(value, 0, sizeof(JsonValue));
+    skip_json_space(reader);
+    if (reader->position >= reader->length)
+        return -1;
+
+    const char *at = reader->text + reader->position;
+    size_t left = reader->length - reader->position;
+    int status = 0;
+    switch (*at)
+    {
+    case '{':
+        value->type = JSON_OBJECT;
+        status = read_json_container(reader, value, '}');
+        break;
+    case '[':
+        value->type = JSON_ARRAY;
+        status = read_json_container(reader, value, ']');
+        break;
+    case '"':
+        value->type = JSON_STRING;
+        status = read_json_string(reader, &value->string, &value->length);
+        break;
+    case 't':
+        value->type = JSON_TRUE;
+        status = left >= 4 && strncmp(at, "true", 4) == 0 ? 0 : -1;
+        reader->position += 4;
+        break;
+    case 'f':
+        value->type = JSON_FALSE;
+        status = left >= 5 && strncmp(at, "false", 5) == 0 ? 0 : -1;
+        reader->position += 5;
+        break;
+    case 'n':
+        value->type = JSON_NULL;
+        status = left >= 4 && strncmp(at, "null", 4) == 0 ? 0 : -1;
+        reader->position += 4;
+        break;
+    default:
+    {
+        // the message is NUL terminated, so strtod stops inside it
+        char *end;
+        value->type = JSON_NUMBER;
+        value->number = strtod(at, &end);
+        status = end > at ? 0 : -1;
+        reader->position += end - at;
+        break;
+    }
+    }
+    if (status != 0)
+        free_json(value);
+    return status;
+}
+
+static int parse_json(const char *text, size_t length, JsonValue *value)
+{
+    JsonReader reader = {text, 0, length, 0};
+    if (read_json_value(&reader, value) != 0)
+        return -1;
+    skip_json_space(&reader);
+    if (reader.position != reader.length)
+    {
+        free_json(value);
+        return -1;
+    }
+    return 0;
+}
+
+static const JsonValue *json_member(const JsonValue *object, const char *key)
+{
+    if (!object || object->type != JSON_OBJECT)
+        return NULL;
+    for (int i = 0; i < object->count; i++)
+    {
+        if (strcmp(object->keys[i], key) == 0)
+            return &object->items[i];
+    }
+    return NULL;
+}
+
+static const char *json_string(const JsonValue *value)
+{
+    return value && value->type == JSON_STRING ? value->string : NULL;
+}
+
+static int json_int(const JsonValue *value, int fallback)
+{
+    return value && value->type == JSON_NUMBER ? (int)value->number : fallback;
+}
+
+static void write_json_string(OutputSink *sink, const char *text, size_t length)
+{
+    sink_puts(sink, "\"");
+    size_t run = 0; // characters written as they are, flushed in one piece
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        sink_write(sink, text + run, i - run);
+        run = i + 1;
+        if (c == '"' || c == '\\')
+            sink_printf(sink, "\\%c", c);
+        else if (c == '\n')
+            sink_puts(sink, "\\n");
+        else if (c == '\t')
+            sink_puts(sink, "\\t");
+        else
+            sink_printf(sink, "\\u%04x", c);
+    }
+    sink_write(sink, text + run, length - run);
+    sink_puts(sink, "\"");
+}
+
+static void write_json_id(OutputSink *sink, const JsonValue *id)
+{
+    if (id && id->type == JSON_STRING)
+        write_json_string(sink, id->string, id->length);
+    else if (id && id->type == JSON_NUMBER)
+        sink_printf(sink, "%.17g", id->number);
+    else
+        sink_puts(sink, "null");
+}
+
+static void write_range(OutputSink *sink, int line, int character, int end_character)
+{
+    sink_printf(sink, "{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}}",
+                line, character, line, end_character);
+}
+
+// frame a body built in a memory sink and send it at once
+static void send_message(LanguageServer *server, OutputSink *body)
+{
+    size_t length;
+    const char *contents = sink_contents(body, &length);
+    if (contents)
+    {
+        sink_printf(server->out, "Content-Length: %zu\r\n\r\n", length);
+        sink_write(server->out, contents, length);
+        sink_flush(server->out);
+    }
+    close_sink(body);
+}
+
+static OutputSink *start_response(const JsonValue *id)
+{
+    OutputSink *body = create_memory_sink();
+    if (!body)
+        return NULL;
+    sink_puts(body, "{\"jsonrpc\":\"2.0\",\"id\":");
+    write_json_id(body, id);
+    return body;
+}
+
+static void send_error(LanguageServer *server, const JsonValue *id, int code, const char *message)
+{
+    OutputSink *body = start_response(id);
+    if (!body)
+        return;
+    sink_printf(body, ",\"error\":{\"code\":%d,\"message\":", code);
+    write_json_string(body, message, strlen(message));
+    sink_puts(body, "}}");
+    send_message(server, body);
+}
+
+static OpenDocument *find_document(LanguageServer *server, const char *uri)
+{
+    for (int i = 0; uri && i < server->count; i++)
+    {
+        if (strcmp(server->documents[i].uri, uri) == 0)
+            return &server->documents[i];
+    }
+    return NULL;
+}
+
+static void publish_diagnostics(LanguageServer *server, const char *uri, const OpenDocument *open)
+{
+    OutputSink *body = create_memory_sink();
+    if (!body)
+        return;
+    sink_puts(body, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    write_json_string(body, uri, strlen(uri));
+    if (open)
+        sink_printf(body, ",\"version\":%d", open->version);
+    sink_puts(body, ",\"diagnostics\":[");
+    int written = 0;
+    for (int i = 0; open && i < open->document->statement_count; i++)
+    {
+        const DocumentStatement *statement = &open->document->statements[i];
+        if (!statement->error)
+            continue;
+        int line = statement->error_line - 1 + statement_line_shift(open->document, statement);
+        int character = statement->error_column - 1;
+        sink_puts(body, written++ ? ",{\"range\":" : "{\"range\":");
+        write_range(body, line, character, character + statement->error_length);
+        sink_puts(body, ",\"severity\":1,\"source\":\"simplelang\",\"message\":");
+        write_json_string(body, statement->error, strlen(statement->error));
+        sink_puts(body, "}");
+    }
+    sink_puts(body, "]}}");
+    send_message(server, body);
+}
+
+// LSP symbol kinds
+#define SYMBOL_MODULE 2
+#define SYMBOL_VARIABLE 13
+
+static void write_symbol(OutputSink *body, const Document *document, const ASTNode *node, int shift,
+                         const char *name, const char *detail, int kind, int *written)
+{
+    int line = node->line - 1 + shift;
+    int character = node->column - 1;
+    // the name itself is selected, found after the keyword on the node's line
+    if (line >= 0 && line < document->line_count)
+    {
+        size_t start = document->line_starts[line];
+        size_t end = line + 1 < document->line_count ? document->line_starts[line + 1] : document->length;
+        size_t length = strlen(name);
+        for (size_t at = start + character; at + length <= end; at++)
+        {
+            if (memcmp(document->text + at, name, length) == 0)
+            {
+                character = (int)(at - start);
+                break;
+            }
+        }
+    }
+    sink_puts(body, (*written)++ ? ",{\"name\":" : "{\"name\":");
+    write_json_string(body, name, strlen(name));
+    sink_puts(body, ",\"detail\":");
+    write_json_string(body, detail, strlen(detail));
+    sink_printf(body, ",\"kind\":%d,\"range\":", kind);
+    write_range(body, line, character, character + (int)strlen(name));
+    sink_puts(body, ",\"selectionRange\":");
+    write_range(body, line, character, character + (int)strlen(name));
+    sink_puts(body, "}");
+}
+
+// the declarations in a statement, in source order, nested blocks included
+static void write_symbols(OutputSink *body, const Document *document, ASTNode *root, int shift, int *written)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, root, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        switch (node->type)
+        {
+        case AST_DECLARATION:
+            write_symbol(body, document, node, shift, node->data.declaration.var_name, "int", SYMBOL_VARIABLE, written);
+            break;
+        case AST_EXTERN:
+            write_symbol(body, document, node, shift, node->data.extern_decl.var_name, "extern int", SYMBOL_VARIABLE, written);
+            break;
+        case AST_IMPORT:
+            write_symbol(body, document, node, shift, node->data.import.module, "import", SYMBOL_MODULE, written);
+            break;
+        case AST_IF_STATEMENT:
+            if (step < 2)
+            {
+                ast_walk_push(&walk, step == 0 ? node->data.if_stmt.then_block : node->data.if_stmt.else_block, 0);
+                continue;
+            }
+            break;
+        case AST_WHILE_STATEMENT:
+            if (step == 0)
+            {
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+                continue;
+            }
+            break;
+        case AST_BLOCK:
+        case AST_PROGRAM:
+            if (step < node->data.block.count)
+            {
+                ast_walk_push(&walk, node->data.block.statements[step], 0);
+                continue;
+            }
+            break;
+        default:
+            break;
+        }
+        ast_walk_pop(&walk);
+    }
+    free_ast_walk(&walk);
+}
+
+static void send_symbols(LanguageServer *server, const JsonValue *id, const OpenDocument *open)
+{
+    OutputSink *body = start_response(id);
+    if (!body)
+        return;
+    sink_puts(body, ",\"result\":[");
+    int written = 0;
+    for (int i = 0; open && i < open->document->statement_count; i++)
+    {
+        const DocumentStatement *statement = &open->document->statements[i];
+        write_symbols(body, open->document, statement->ast, statement_line_shift(open->document, statement), &written);
+    }
+    sink_puts(body, "]}");
+    send_message(server, body);
+}
+
+static void open_document(LanguageServer *server, const JsonValue *params)
+{
+    const JsonValue *item = json_member(params, "textDocument");
+    const char *uri = json_string(json_member(item, "uri"));
+    const JsonValue *text = json_member(item, "text");
+    if (!uri || !text || text->type != JSON_STRING)
+        return;
+
+    OpenDocument *open = find_document(server, uri);
+    if (open)
+    {
+        // opened again: the new text wins
+        set_document_text(open->document, text->string, text->length);
+    }
+    else
+    {
+        if (server->count == server->capacity)
+        {
+            int capacity = server->capacity ? server->capacity * 2 : 8;
+            OpenDocument *documents = realloc(server->documents, sizeof(OpenDocument) * capacity);
+            if (!documents)
+                return;
+            server->documents = documents;
+            server->capacity = capacity;
+        }
+        open = &server->documents[server->count];
+        open->uri = strdup(uri);
+        open->document = create_document(text->string, text->length);
+        if (!open->uri || !open->document)
+        {
+            free(open->uri);
+            free_document(open->document);
+            return;
+        }
+        server->count++;
+    }
+    open->version = json_int(json_member(item, "version"), 0);
+    publish_diagnostics(server, uri, open);
+}
+
+static void change_document(LanguageServer *server, const JsonValue *params)
+{
+    const JsonValue *item = json_member(params, "textDocument");
+    const char *uri = json_string(json_member(item, "uri"));
+    OpenDocument *open = find_document(server, uri);
+    const JsonValue *changes = json_member(params, "contentChanges");
+    if (!open || !changes || changes->type != JSON_ARRAY)
+        return;
+
+    for (int i = 0; i < changes->count; i++)
+    {
+        const JsonValue *change = &changes->items[i];
+        const JsonValue *text = json_member(change, "text");
+        const JsonValue *range = json_member(change, "range");
+        if (!text || text->type != JSON_STRING)
+            continue;
+        if (!range)
+        {
+            set_document_text(open->document, text->string, text->length);
+            continue;
+        }
+        const JsonValue *start = json_member(range, "start");
+        const JsonValue *end = json_member(range, "end");
+        edit_document(open->document,
+                      json_int(json_member(start, "line"), 0), json_int(json_member(start, "character"), 0),
+                      json_int(json_member(end, "line"), 0), json_int(json_member(end, "character"), 0),
+                      text->string, text->length);
+    }
+    open->version = json_int(json_member(item, "version"), open->version);
+    publish_diagnostics(server, uri, open);
+}
+
+static void close_document(LanguageServer *server, const JsonValue *params)
+{
+    const char *uri = json_string(json_member(json_member(params, "textDocument"), "uri"));
+    OpenDocument *open = find_document(server, uri);
+    if (!open)
+        return;
+    // an editor keeps showing diagnostics of a closed file until they are cleared
+    publish_diagnostics(server, uri, NULL);
+    free(open->uri);
+    free_document(open->document);
+    *open = server->documents[--server->count];
+}
+
+// 1 once the client says exit
+static int handle_message(LanguageServer *server, const JsonValue *message)
+{
+    const char *method = json_string(json_member(message, "method"));
+    const JsonValue *id = json_member(message, "id");
+    const JsonValue *params = json_member(message, "params");
+    if (!method)
+        return 0; // a response to something the server never asks
+
+    if (strcmp(method, "exit") == 0)
+        return 1;
+    if (strcmp(method, "textDocument/didOpen") == 0)
+        open_document(server, params);
+    else if (strcmp(method, "textDocument/didChange") == 0)
+        change_document(server, params);
+    else if (strcmp(method, "textDocument/didClose") == 0)
+        close_document(server, params);
+    else if (!id)
+        return 0; // initialized and any other notification
+    else if (strcmp(method, "initialize") == 0)
+    {
+        OutputSink *body = start_response(id);
+        if (!body)
+            return 0;
+        // openClose and incremental (2) sync
+        sink_puts(body, ",\"result\":{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                        "\"documentSymbolProvider\":true},\"serverInfo\":{\"name\":\"simplelang\"}}}");
+        send_message(server, body);
+    }
+    else if (strcmp(method, "shutdown") == 0)
+    {
+        server->shutdown = 1;
+        OutputSink *body = start_response(id);
+        if (!body)
+            return 0;
+        sink_puts(body, ",\"result\":null}");
+        send_message(server, body);
+    }
+    else if (strcmp(method, "textDocument/documentSymbol") == 0)
+    {
+        const char *uri = json_string(json_member(json_member(params, "textDocument"), "uri"));
+        send_symbols(server, id, find_document(server, uri));
+    }
+    else
+    {
+        send_error(server, id, LSP_METHOD_NOT_FOUND, "Method not found");
+    }
+    return 0;
+}
+
+static int next_byte(MessageReader *reader)
+{
+    if (reader->start == reader->end)
+    {
+        ssize_t count;
+        do
+        {
+            count = read(reader->fd, reader->buffer, sizeof(reader->buffer));
+        } while (count < 0 && errno == EINTR);
+        if (count <= 0)
+            return -1;
+        reader->start = 0;
+        reader->end = (size_t)count;
+    }
+    return (unsigned char)reader->buffer[reader->start++];
+}
+
+// the body of the next message: 1 with *body set, 0 at the end of the input, -1 for a
+// header without a usable Content-Length (that message is skipped)
+static int read_message(MessageReader *reader, char **body, size_t *length)
+{
+    long content_length = -1;
+    for (;;)
+    {
+        char line[256];
+        size_t n = 0;
+        int c;
+        while ((c = next_byte(reader)) >= 0 && c != '\n')
+        {
+            if (n < sizeof(line) - 1)
+                line[n++] = (char)c;
+        }
+        if (c < 0)
+            return 0;
+        if (n > 0 && line[n - 1] == '\r')
+            n--;
+        line[n] = '\0';
+        if (n == 0)
+            break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+            content_length = strtol(line + 15, NULL, 10);
+    }
+    if (content_length < 0 || content_length > LSP_MAX_MESSAGE)
+        return -1;
+
+    char *text = malloc(content_length + 1);
+    if (!text)
+        return -1;
+    size_t have = 0;
+    while (have < (size_t)content_length)
+    {
+        if (reader->start == reader->end)
+        {
+            // past the buffer, the rest of a large body goes straight into place
+            ssize_t count = read(reader->fd, text + have, content_length - have);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+            {
+                free(text);
+                return 0;
+            }
+            have += (size_t)count;
+            continue;
+        }
+        size_t take = reader->end - reader->start;
+        if (take > content_length - have)
+            take = content_length - have;
+        memcpy(text + have, reader->buffer + reader->start, take);
+        reader->start += take;
+        have += take;
+    }
+    text[content_length] = '\0';
+    *body = text;
+    *length = (size_t)content_length;
+    return 1;
+}
+
+int run_language_server(int input_fd, OutputSink *out)
+{
+    LanguageServer server = {out, NULL, 0, 0, 0};
+    MessageReader reader;
+    reader.fd = input_fd;
+    reader.start = reader.end = 0;
+
+    int status = 1;
+    for (;;)
+    {
+        char *text;
+        size_t length;
+        int result = read_message(&reader, &text, &length);
+        if (result == 0)
+            break;
+        if (result < 0)
+            continue;
+
+        JsonValue message;
+        if (parse_json(text, length, &message) != 0)
+        {
+            free(text);
+            send_error(&server, NULL, LSP_PARSE_ERROR, "Parse error");
+            continue;
+        }
+        free(text);
+        int done = handle_message(&server, &message);
+        free_json(&message);
+        if (done)
+        {
+            status = server.shutdown ? 0 : 1;
+            break;
+        }
+    }
+
+    for (int i = 0; i < server.count; i++)
+    {
+        free(server.documents[i].uri);
+        free_document(server.documents[i].document);
+    }
+    free(server.documents);
+    return status;
+}
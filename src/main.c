@@ -1,125 +1,97 @@
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
-#include "../include/lexer.h"
-#include "../include/parser.h"
-#include "../include/ast.h"
-#include "../include/codegen.h"
+#include <unistd.h>
+#include "../include/driver.h"
+#include "../include/server.h"
+#include "../include/lsp.h"
 
-int main(int argc, char *argv[])
+// "--daemon" or "--daemon=<socket>": NULL if arg is not this mode, otherwise the socket path
+static const char *mode_socket(const char *arg, const char *mode, char *buffer, size_t size)
 {
-    // take command line argument for input file from input.sl(simple lang)
-    if (argc != 2)
-    {
-        printf("FILE IS MISSING");
+    size_t length = strlen(mode);
+    if (strncmp(arg, mode, length) != 0)
+        return NULL;
+    if (arg[length] == '=')
+        return arg + length + 1;
+    if (arg[length] != '\0')
+        return NULL;
+    default_socket_path(buffer, size);
+    return buffer;
+}
+
+static int compile_command_line(int argc, char *argv[], const char *program)
+{
+    OutputSink *out = create_fd_sink(STDOUT_FILENO);
+    OutputSink *diagnostics = create_fd_sink(STDERR_FILENO);
+    if (!out || !diagnostics)
         return 1;
-    }
-    // store in character buffer processing
-    char *input_filename = argv[1];
-    char *input_content = read_file(input_filename);
-    if (!input_content)
+
+    CompileOptions options;
+    init_compile_options(&options);
+    int status;
+    int result = parse_options(argc, argv, &options, diagnostics);
+    if (result > 0)
     {
-        printf("Error: Failed to read input file '%s'\n", input_filename);
-        return 1;
+        write_usage(out, program);
+        status = 0;
     }
-    // Create lexer and feed the input.sl file for input of lexer
-    printf("Lexical Analysis (Tokenization)\n\n");
-    Lexer *lexer = create_lexer(input_content);
-    if (!lexer)
+    else if (result < 0)
     {
-        printf("Error: Failed to create lexer\n");
-        free(input_content);
-        return 1;
+        sink_printf(diagnostics, "Run '%s --help' for usage\n", program);
+        status = 1;
     }
-    // temporary lexer for printing the lexer
-    Lexer *temp_lexer = create_lexer(input_content);
-    Token *token;
-    int token_count = 0;
-    // loop through all input file for printing lexer output
-    while ((token = get_next_token(temp_lexer)) && token->type != TOKEN_EOF)
+    else
     {
-        print_token(token);
-        token_count++;
-        free_token(token);
+        status = compile_all(&options, out, diagnostics);
     }
+    free_compile_options(&options);
 
-    if (token)
-    {
-        print_token(token);
-        free_token(token);
-    }
-    // Count the number of tokens generated
-    printf("Total tokens: %d\n\n", token_count);
+    if (close_sink(out) != 0)
+        status = 1;
+    close_sink(diagnostics);
+    return status;
+}
 
-    free_lexer(temp_lexer);
-    // Give output of lexer to the parser
-    printf("Syntax Analysis (Parsing)\n");
-    Parser *parser = create_parser(lexer);
-    if (!parser)
-    {
-        printf("Error: Failed to create parser\n");
-        free_lexer(lexer);
-        free(input_content);
-        return 1;
-    }
-    // Generate ABSTRACT SYNTAX TREE from parser
-    ASTNode *ast = parse_program(parser);
-    // If parser encountered error print parser error
-    if (parser->has_error)
-    {
-        printf("PARSING FAILED!\n");
-        printf("Error: %s\n", parser->error_message);
-        free_parser(parser);
-        free_lexer(lexer);
-        free(input_content);
-        return 1;
-    }
-    else if (ast)
+int main(int argc, char *argv[])
+{
+    // take command line arguments for input files from input.sl(simple lang), or @lists of them;
+    // by default the 8-bit assembly goes to output/<name>.asm and nothing is printed.
+    // See write_usage (or --help) for --emit, -o, --stop-after and the run modes.
+    // A leading --daemon, --connect or --stop-daemon (each optionally =<socket>) runs or
+    // talks to the resident compile server instead, and --lsp serves an editor on stdio.
+    char socket_buffer[256];
+    const char *socket_path;
+    if (argc > 1)
     {
+        if (strcmp(argv[1], "--lsp") == 0)
+        {
+            OutputSink *out = create_fd_sink(STDOUT_FILENO);
+            if (!out)
+                return 1;
+            int status = run_language_server(STDIN_FILENO, out);
+            close_sink(out);
+            return status;
+        }
+
+        if ((socket_path = mode_socket(argv[1], "--daemon", socket_buffer, sizeof(socket_buffer))))
+            return run_server(socket_path);
 
-        printf("PARSING SUCCESSFUL!\n");
-        printf("Generated Abstract Syntax Tree (AST):\n\n");
-        print_ast(ast, 0, 1, "");
-        
-        // Code Generation
-        printf("\nCode Generation (8-bit CPU Assembly)\n");
-        CodeGenerator *codegen = create_codegen();
-        if (codegen) {
-            generate_code(codegen, ast);
-            
-            // Create output filename in output directory
-            char output_filename[256];
-            char *base = strrchr(input_filename, '/');
-            if (base) base++; else base = input_filename;
-            
-            strcpy(output_filename, "output/");
-            strcat(output_filename, base);
-            char *dot = strrchr(output_filename, '.');
-            if (dot) *dot = '\0';
-            strcat(output_filename, ".asm");
-            
-            write_assembly_file(codegen, output_filename);
-            printf("Assembly code generated: %s\n", output_filename);
-            
-            free_codegen(codegen);
+        if ((socket_path = mode_socket(argv[1], "--stop-daemon", socket_buffer, sizeof(socket_buffer))))
+        {
+            if (stop_server(socket_path) == 0)
+                return 0;
+            fprintf(stderr, "Error: No compile server on '%s'\n", socket_path);
+            return 1;
         }
-        
-        free_ast(ast);
-    }
-    // Throw error if AST not generated
-    else
-    {
-        printf("PARSING FAILED!\n");
-        printf("Error: No AST generated (unknown error)\n");
-        free_parser(parser);
-        free_lexer(lexer);
-        free(input_content);
-        return 1;
-    }
-    // Clean the dynamic allocated memory
-    free_parser(parser);
-    free_lexer(lexer);
-    free(input_content);
 
-    return 0;
-}
\ No newline at end of file
+        if ((socket_path = mode_socket(argv[1], "--connect", socket_buffer, sizeof(socket_buffer))))
+        {
+            // the rest of the command line goes to the server, or is compiled here if none runs
+            int status = run_client(socket_path, argc - 1, argv + 1);
+            if (status >= 0)
+                return status;
+            return compile_command_line(argc - 1, argv + 1, argv[0]);
+        }
+    }
+    return compile_command_line(argc, argv, argv[0]);
+}
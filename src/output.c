@@ -0,0 +1,198 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/output.h"
+
+// memory sinks start small, a batch compile keeps one per input alive at once
+#define MEMORY_SINK_INITIAL_SIZE 1024
+
+static OutputSink *create_sink(SinkKind kind, int fd, int owns_fd, size_t capacity)
+{
+    OutputSink *sink = malloc(sizeof(OutputSink));
+    if (!sink)
+        return NULL;
+
+    sink->buffer = malloc(capacity);
+    if (!sink->buffer)
+    {
+        free(sink);
+        return NULL;
+    }
+    sink->kind = kind;
+    sink->fd = fd;
+    sink->owns_fd = owns_fd;
+    sink->length = 0;
+    sink->capacity = capacity;
+    sink->total_length = 0;
+    sink->has_error = 0;
+    return sink;
+}
+
+OutputSink *create_file_sink(const char *path)
+{
+    if (strcmp(path, "-") == 0)
+        return create_fd_sink(STDOUT_FILENO);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return NULL;
+    OutputSink *sink = create_sink(SINK_FD, fd, 1, SINK_BUFFER_SIZE);
+    if (!sink)
+        close(fd);
+    return sink;
+}
+
+OutputSink *create_fd_sink(int fd)
+{
+    return create_sink(SINK_FD, fd, 0, SINK_BUFFER_SIZE);
+}
+
+OutputSink *create_memory_sink(void)
+{
+    return create_sink(SINK_MEMORY, -1, 0, MEMORY_SINK_INITIAL_SIZE);
+}
+
+int sink_flush(OutputSink *sink)
+{
+    if (sink->kind != SINK_FD)
+        return sink->has_error ? -1 : 0;
+
+    size_t written = 0;
+    while (written < sink->length)
+    {
+        ssize_t n = write(sink->fd, sink->buffer + written, sink->length - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            sink->has_error = 1;
+            break;
+        }
+        written += (size_t)n;
+    }
+    sink->length = 0;
+    return sink->has_error ? -1 : 0;
+}
+
+char *sink_reserve(OutputSink *sink, size_t length)
+{
+    if (sink->capacity - sink->length >= length)
+        return sink->buffer + sink->length;
+
+    // descriptor sinks drain the buffer first, and only grow it for oversized writes
+    if (sink->kind == SINK_FD)
+    {
+        sink_flush(sink);
+        if (sink->capacity >= length)
+            return sink->buffer;
+    }
+
+    size_t capacity = sink->capacity;
+    while (capacity - sink->length < length)
+    {
+        capacity *= 2;
+    }
+    char *grown = realloc(sink->buffer, capacity);
+    if (!grown)
+    {
+        sink->has_error = 1;
+        return NULL;
+    }
+    sink->buffer = grown;
+    sink->capacity = capacity;
+    return sink->buffer + sink->length;
+}
+
+void sink_commit(OutputSink *sink, size_t length)
+{
+    sink->length += length;
+    sink->total_length += length;
+}
+
+int sink_write(OutputSink *sink, const char *data, size_t length)
+{
+    // large writes to a descriptor skip the copy
+    if (sink->kind == SINK_FD && length >= sink->capacity)
+    {
+        if (sink_flush(sink) != 0)
+            return -1;
+        char *saved = sink->buffer;
+        sink->buffer = (char *)data;
+        sink->length = length;
+        int result = sink_flush(sink);
+        sink->buffer = saved;
+        sink->total_length += length;
+        return result;
+    }
+
+    char *space = sink_reserve(sink, length);
+    if (!space)
+        return -1;
+    memcpy(space, data, length);
+    sink_commit(sink, length);
+    return 0;
+}
+
+int sink_puts(OutputSink *sink, const char *text)
+{
+    return sink_write(sink, text, strlen(text));
+}
+
+int sink_printf(OutputSink *sink, const char *format, ...)
+{
+    va_list args;
+    size_t room = sink->capacity - sink->length;
+
+    va_start(args, format);
+    int length = vsnprintf(sink->buffer + sink->length, room, format, args);
+    va_end(args);
+    if (length < 0)
+    {
+        sink->has_error = 1;
+        return -1;
+    }
+    if ((size_t)length >= room)
+    {
+        // did not fit, make room and format again
+        char *space = sink_reserve(sink, (size_t)length + 1);
+        if (!space)
+            return -1;
+        va_start(args, format);
+        vsnprintf(space, (size_t)length + 1, format, args);
+        va_end(args);
+    }
+    sink_commit(sink, (size_t)length);
+    return 0;
+}
+
+const char *sink_contents(OutputSink *sink, size_t *length)
+{
+    if (sink->kind != SINK_MEMORY)
+        return NULL;
+    // keep a terminator behind the data without counting it
+    char *end = sink_reserve(sink, 1);
+    if (!end)
+        return NULL;
+    *end = '\0';
+    if (length)
+        *length = sink->length;
+    return sink->buffer;
+}
+
+int close_sink(OutputSink *sink)
+{
+    if (!sink)
+        return -1;
+
+    int result = sink_flush(sink);
+    if (sink->owns_fd && close(sink->fd) != 0)
+        result = -1;
+    free(sink->buffer);
+    free(sink);
+    return result;
+}
@@ -1,5 +1,8 @@
 #include "../include/parser.h"
 #include "../include/ast.h"
+#include "../include/allocator.h"
+#include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,7 +10,7 @@
 Parser *create_parser(Lexer *lexer)
 {
     // Create parser
-    Parser *parser = malloc(sizeof(Parser));
+    Parser *parser = sl_malloc(sizeof(Parser));
     if (!parser)
     {
         return NULL;
@@ -16,7 +19,16 @@ Parser *create_parser(Lexer *lexer)
     parser->lexer = lexer;
     parser->current_token = get_next_token(lexer);
     parser->has_error = 0;
-    parser->error_message[0] = '\0';
+    parser->first_error.line = 0;
+    parser->first_error.column = 0;
+    parser->first_error.message[0] = '\0';
+    parser->errors = NULL;
+    parser->error_count = 0;
+    parser->error_capacity = 0;
+    parser->max_errors = PARSER_MAX_ERRORS;
+    parser->stopped = 0;
+    parser->panicking = 0;
+    parser->depth = 0;
     return parser;
 }
 
@@ -29,7 +41,8 @@ void free_parser(Parser *parser)
         {
             free_token(parser->current_token);
         }
-        free(parser);
+        sl_free(parser->errors);
+        sl_free(parser);
     }
 }
 
@@ -40,14 +53,19 @@ void free_parser(Parser *parser)
 // Create AST
 
 /*
-program → statement*
-statement → declaration | assignment | if_statement
+program → (import | extern_declaration | statement)*
+import → 'import' IDENTIFIER ';'
+extern_declaration → 'extern' 'int' IDENTIFIER ';'
+statement → declaration | assignment | if_statement | while_statement
 declaration → 'int' IDENTIFIER ('=' expression)? ';'
 assignment → IDENTIFIER '=' expression ';'
 if_statement → 'if' '(' expression ')' block ('else' block)?
+while_statement → 'while' '(' expression ')' block
 block → '{' statement* '}'
-expression → term ('==' term)*
-term → factor (('+' | '-') factor)*
+expression → shift ('==' shift)*
+shift → term (('<<' | '>>') term)*
+term → product (('+' | '-') product)*
+product → factor ('*' factor)*
 factor → NUMBER | IDENTIFIER | '(' expression ')'
 */
 // Clear the current token and move the pointer of parser token to next token
@@ -81,15 +99,92 @@ void skip_newlines(Parser *parser)
 }
 void parser_error(Parser *parser, char *message)
 {
+    // whatever goes wrong before the next statement follows from this error
+    if (parser->panicking || parser->stopped)
+        return;
+    parser->panicking = 1;
+
+    ParseError error;
+    error.line = parser->current_token ? parser->current_token->line : 0;
+    error.column = parser->current_token ? parser->current_token->column : 0;
+    snprintf(error.message, sizeof(error.message), "%s", message);
+    if (!parser->has_error)
+        parser->first_error = error;
     parser->has_error = 1;
-    // print the error message with formatting
-    snprintf(
-        parser->error_message,
-        sizeof(parser->error_message),
-        "Parse error at line %d, column %d: %s",
-        parser->current_token ? parser->current_token->line : 0,
-        parser->current_token ? parser->current_token->column : 0,
-        message);
+
+    if (parser->error_count == parser->error_capacity)
+    {
+        int capacity = parser->error_capacity ? parser->error_capacity * 2 : 8;
+        ParseError *grown = sl_realloc(parser->errors, sizeof(ParseError) * capacity);
+        if (!grown)
+        {
+            parser->stopped = 1;
+            return;
+        }
+        parser->errors = grown;
+        parser->error_capacity = capacity;
+    }
+    parser->errors[parser->error_count++] = error;
+    if (parser->max_errors > 0 && parser->error_count >= parser->max_errors)
+        parser->stopped = 1;
+}
+static int starts_statement(TokenType type)
+{
+    return type == TOKEN_INT || type == TOKEN_IF || type == TOKEN_WHILE || type == TOKEN_IMPORT ||
+           type == TOKEN_EXTERN;
+}
+// Panic mode: skip past the next ';' or the end of a block (and its else), or up to a '}'
+// or a statement keyword. The token the failed statement started at is always skipped,
+// so every error moves the parse forward; a run of stray '}' goes with it, as one error.
+void synchronize(Parser *parser, int line, int column)
+{
+    if (parser->current_token && parser->current_token->type != TOKEN_EOF &&
+        parser->current_token->line == line && parser->current_token->column == column)
+    {
+        int stray = peek_token(parser, TOKEN_RBRACE);
+        advance_token(parser);
+        if (stray)
+        {
+            while (peek_token(parser, TOKEN_RBRACE) || peek_token(parser, TOKEN_NEWLINE))
+                advance_token(parser);
+            parser->panicking = 0;
+            return;
+        }
+    }
+    int nesting = 0;
+    while (parser->current_token && parser->current_token->type != TOKEN_EOF)
+    {
+        TokenType type = parser->current_token->type;
+        if (nesting == 0 && type == TOKEN_SEMICOLON)
+        {
+            advance_token(parser);
+            break;
+        }
+        if (nesting == 0 && (type == TOKEN_RBRACE || starts_statement(type)))
+            break;
+        advance_token(parser);
+        if (type == TOKEN_LBRACE)
+        {
+            nesting++;
+        }
+        else if (type == TOKEN_RBRACE && --nesting == 0 && !peek_token(parser, TOKEN_ELSE))
+        {
+            // the block of a skipped if or while ends it
+            break;
+        }
+    }
+    parser->panicking = 0;
+}
+// the statement at the current token, or an error node after skipping it
+static ASTNode *parse_or_skip(Parser *parser, ASTNode *(*parse)(Parser *))
+{
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
+    ASTNode *stmt = parse(parser);
+    if (stmt || !parser->panicking || parser->stopped)
+        return stmt;
+    synchronize(parser, line, column);
+    return create_error_node(line, column);
 }
 ASTNode *parse_program(Parser *parser)
 {
@@ -97,24 +192,28 @@ ASTNode *parse_program(Parser *parser)
     // define function for skipping newlines if blank spaces
     skip_newlines(parser);
     // iteratively start parsing based on input lexer
-    while (parser->current_token && parser->current_token->type != TOKEN_EOF && !parser->has_error)
+    while (parser->current_token && parser->current_token->type != TOKEN_EOF && !parser->stopped)
     {
         // create statement node
-        ASTNode *stmt = parse_statement(parser);
+        ASTNode *stmt = parse_or_skip(parser, parse_top_level);
         if (stmt)
         {
             add_statement_to_block(program, stmt);
         }
         skip_newlines(parser);
     }
-    // check for errors
-    if (parser->has_error)
-    {
-        free_ast(program);
-        return NULL;
-    }
+    // with errors the program has an AST_ERROR node for every statement lost
     return program;
 }
+// imports and externs only appear out here, at the top level
+ASTNode *parse_top_level(Parser *parser)
+{
+    if (peek_token(parser, TOKEN_IMPORT))
+        return parse_import(parser);
+    if (peek_token(parser, TOKEN_EXTERN))
+        return parse_extern(parser);
+    return parse_statement(parser);
+}
 ASTNode *parse_statement(Parser *parser)
 {
     skip_newlines(parser);
@@ -126,16 +225,79 @@ ASTNode *parse_statement(Parser *parser)
     {
         return parse_if_statement(parser);
     }
+    else if (peek_token(parser, TOKEN_WHILE))
+    {
+        return parse_while_statement(parser);
+    }
     else if (peek_token(parser, TOKEN_IDENTIFIER))
     {
         return parse_assignment(parser);
     }
+    else if (peek_token(parser, TOKEN_IMPORT) || peek_token(parser, TOKEN_EXTERN))
+    {
+        parser_error(parser, "import and extern are only allowed at the top level");
+        return NULL;
+    }
     else
     {
         parser_error(parser, "Expected statement");
         return NULL;
     }
 }
+// import IDENTIFIER ; names the module IDENTIFIER.sl next to this file
+ASTNode *parse_import(Parser *parser)
+{
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
+
+    if (!match_token(parser, TOKEN_IMPORT))
+    {
+        parser_error(parser, "Expected 'import'");
+        return NULL;
+    }
+    if (!peek_token(parser, TOKEN_IDENTIFIER))
+    {
+        parser_error(parser, "Expected module name after 'import'");
+        return NULL;
+    }
+    ASTNode *import = create_import_node(parser->current_token->value, line, column);
+    advance_token(parser);
+    if (!match_token(parser, TOKEN_SEMICOLON))
+    {
+        parser_error(parser, "Expected ';' after import");
+        free_ast(import);
+        return NULL;
+    }
+    return import;
+}
+ASTNode *parse_extern(Parser *parser)
+{
+    if (!match_token(parser, TOKEN_EXTERN))
+    {
+        parser_error(parser, "Expected 'extern'");
+        return NULL;
+    }
+    if (!match_token(parser, TOKEN_INT))
+    {
+        parser_error(parser, "Expected 'int' after 'extern'");
+        return NULL;
+    }
+    if (!peek_token(parser, TOKEN_IDENTIFIER))
+    {
+        parser_error(parser, "Expected identifier after 'extern int'");
+        return NULL;
+    }
+    ASTNode *decl = create_extern_node(parser->current_token->value,
+                                       parser->current_token->line, parser->current_token->column);
+    advance_token(parser);
+    if (!match_token(parser, TOKEN_SEMICOLON))
+    {
+        parser_error(parser, "Expected ';' after extern declaration");
+        free_ast(decl);
+        return NULL;
+    }
+    return decl;
+}
 ASTNode *parse_declaration(Parser *parser)
 {
     if (!match_token(parser, TOKEN_INT))
@@ -148,7 +310,7 @@ ASTNode *parse_declaration(Parser *parser)
         parser_error(parser, "Expected identifier after 'int'");
         return NULL;
     }
-    char *var_name = malloc(strlen(parser->current_token->value) + 1);
+    char *var_name = sl_malloc(strlen(parser->current_token->value) + 1);
     strcpy(var_name, parser->current_token->value);
     int line = parser->current_token->line;
     int column = parser->current_token->column;
@@ -161,19 +323,19 @@ ASTNode *parse_declaration(Parser *parser)
         init_value = parse_expression(parser);
         if (!init_value)
         {
-            free(var_name);
+            sl_free(var_name);
             return NULL;
         }
     }
     if (!match_token(parser, TOKEN_SEMICOLON))
     {
         parser_error(parser, "Expected ';' after declaration");
-        free(var_name);
+        sl_free(var_name);
         free_ast(init_value);
         return NULL;
     }
     ASTNode *decl = create_declaration_node(var_name, init_value, line, column);
-    free(var_name);
+    sl_free(var_name);
     return decl;
 }
 ASTNode *parse_assignment(Parser *parser)
@@ -184,7 +346,7 @@ ASTNode *parse_assignment(Parser *parser)
         return NULL;
     }
 
-    char *var_name = malloc(strlen(parser->current_token->value) + 1);
+    char *var_name = sl_malloc(strlen(parser->current_token->value) + 1);
     strcpy(var_name, parser->current_token->value);
     int line = parser->current_token->line;
     int column = parser->current_token->column;
@@ -192,24 +354,24 @@ ASTNode *parse_assignment(Parser *parser)
     if (!match_token(parser, TOKEN_ASSIGN))
     {
         parser_error(parser, "Expected '=' in assignment");
-        free(var_name);
+        sl_free(var_name);
         return NULL;
     }
     ASTNode *value = parse_expression(parser);
     if (!value)
     {
-        free(var_name);
+        sl_free(var_name);
         return NULL;
     }
     if (!match_token(parser, TOKEN_SEMICOLON))
     {
         parser_error(parser, "Expected ';' in assignment");
-        free(var_name);
+        sl_free(var_name);
         free_ast(value);
         return NULL;
     }
     ASTNode *assign = create_assignment_node(var_name, value, line, column);
-    free(var_name);
+    sl_free(var_name);
     return assign;
 }
 ASTNode *parse_if_statement(Parser *parser)
@@ -258,9 +420,43 @@ ASTNode *parse_if_statement(Parser *parser)
     }
     return create_if_node(condition, then_block, else_block, line, column);
 }
+ASTNode *parse_while_statement(Parser *parser)
+{
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
+
+    if (!match_token(parser, TOKEN_WHILE))
+    {
+        parser_error(parser, "Expected 'while'");
+        return NULL;
+    }
+    if (!match_token(parser, TOKEN_LPAREN))
+    {
+        parser_error(parser, "Expected '(' after 'while'");
+        return NULL;
+    }
+    ASTNode *condition = parse_expression(parser);
+    if (!condition)
+    {
+        return NULL;
+    }
+    if (!match_token(parser, TOKEN_RPAREN))
+    {
+        parser_error(parser, "Expected ')' after while condition");
+        free_ast(condition);
+        return NULL;
+    }
+    ASTNode *body = parse_block(parser);
+    if (!body)
+    {
+        free_ast(condition);
+        return NULL;
+    }
+    return create_while_node(condition, body, line, column);
+}
 ASTNode *parse_expression(Parser *parser)
 {
-    ASTNode *left = parse_term(parser);
+    ASTNode *left = parse_shift(parser);
     if (!left)
         return NULL;
 
@@ -271,6 +467,29 @@ ASTNode *parse_expression(Parser *parser)
         int column = parser->current_token->column;
         advance_token(parser);
 
+        ASTNode *right = parse_shift(parser);
+        if (!right)
+        {
+            free_ast(left);
+            return NULL;
+        }
+        left = create_binary_op_node(left, op, right, line, column);
+    }
+    return left;
+}
+ASTNode *parse_shift(Parser *parser)
+{
+    ASTNode *left = parse_term(parser);
+    if (!left)
+        return NULL;
+
+    while (peek_token(parser, TOKEN_SHIFT_LEFT) || peek_token(parser, TOKEN_SHIFT_RIGHT))
+    {
+        TokenType op = parser->current_token->type;
+        int line = parser->current_token->line;
+        int column = parser->current_token->column;
+        advance_token(parser);
+
         ASTNode *right = parse_term(parser);
         if (!right)
         {
@@ -289,18 +508,34 @@ ASTNode *parse_block(Parser *parser)
         return NULL;
     }
 
+    if (parser->depth >= PARSER_MAX_DEPTH)
+    {
+        parser_error(parser, "Blocks nested too deeply");
+        // a limit on the parser's own stack, not something to recover from
+        parser->stopped = 1;
+        return NULL;
+    }
+    parser->depth++;
     ASTNode *block = create_block_node();
     skip_newlines(parser);
 
-    while (!peek_token(parser, TOKEN_RBRACE) && !peek_token(parser, TOKEN_EOF) && !parser->has_error)
+    while (parser->current_token && !peek_token(parser, TOKEN_RBRACE) && !peek_token(parser, TOKEN_EOF) &&
+           !parser->stopped)
     {
-        ASTNode *stmt = parse_statement(parser);
+        ASTNode *stmt = parse_or_skip(parser, parse_statement);
         if (stmt)
         {
             add_statement_to_block(block, stmt);
         }
         skip_newlines(parser);
     }
+    parser->depth--;
+    // the error limit was reached inside the block
+    if (parser->stopped)
+    {
+        free_ast(block);
+        return NULL;
+    }
     if (!match_token(parser, TOKEN_RBRACE))
     {
         parser_error(parser, "Expected '}'");
@@ -311,7 +546,7 @@ ASTNode *parse_block(Parser *parser)
 }
 ASTNode *parse_term(Parser *parser)
 {
-    ASTNode *left = parse_factor(parser);
+    ASTNode *left = parse_product(parser);
     if (!left)
         return NULL;
 
@@ -322,6 +557,29 @@ ASTNode *parse_term(Parser *parser)
         int column = parser->current_token->column;
         advance_token(parser);
 
+        ASTNode *right = parse_product(parser);
+        if (!right)
+        {
+            free_ast(left);
+            return NULL;
+        }
+        left = create_binary_op_node(left, op, right, line, column);
+    }
+    return left;
+}
+ASTNode *parse_product(Parser *parser)
+{
+    ASTNode *left = parse_factor(parser);
+    if (!left)
+        return NULL;
+
+    while (peek_token(parser, TOKEN_STAR))
+    {
+        TokenType op = parser->current_token->type;
+        int line = parser->current_token->line;
+        int column = parser->current_token->column;
+        advance_token(parser);
+
         ASTNode *right = parse_factor(parser);
         if (!right)
         {
@@ -336,28 +594,44 @@ ASTNode *parse_factor(Parser *parser)
 {
     if (peek_token(parser, TOKEN_NUMBER))
     {
-        int value = atoi(parser->current_token->value);
+        // the AST holds an int; the 8-bit target checks its own, smaller, range
+        errno = 0;
+        long value = strtol(parser->current_token->value, NULL, 10);
+        if (errno == ERANGE || value > INT_MAX)
+        {
+            parser_error(parser, "Number does not fit in an int");
+            return NULL;
+        }
         int line = parser->current_token->line;
         int column = parser->current_token->column;
         advance_token(parser);
-        return create_number_node(value, line, column);
+        return create_number_node((int)value, line, column);
     }
     if (peek_token(parser, TOKEN_IDENTIFIER))
     {
-        char *name = malloc(strlen(parser->current_token->value) + 1);
+        char *name = sl_malloc(strlen(parser->current_token->value) + 1);
         strcpy(name, parser->current_token->value);
         int line = parser->current_token->line;
         int column = parser->current_token->column;
         advance_token(parser);
 
         ASTNode *node = create_identifier_node(name, line, column);
-        free(name);
+        sl_free(name);
         return node;
     }
 
     if (match_token(parser, TOKEN_LPAREN))
     {
+        if (parser->depth >= PARSER_MAX_DEPTH)
+        {
+            parser_error(parser, "Parentheses nested too deeply");
+            // as with blocks, the limit ends the parse
+            parser->stopped = 1;
+            return NULL;
+        }
+        parser->depth++;
         ASTNode *expr = parse_expression(parser);
+        parser->depth--;
         if (!expr)
             return NULL;
 
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/passes.h"
+#include "../include/range.h"
+#include "../include/slots.h"
+#include "../include/timing.h"
+#include "../include/allocator.h"
+
+typedef enum
+{
+    LEVEL_AST,
+    LEVEL_CODEGEN,
+    LEVEL_IR,
+    LEVEL_MACHINE
+} PassLevel;
+
+typedef struct
+{
+    const char *name;
+    PassLevel level;
+    const char *changes; // what a change is, for the statistics
+    int (*run)(CodeGenerator *gen, ASTNode *ast); // changes made, -1 when out of memory;
+                                                  // NULL for choices generate_code makes
+} Pass;
+
+static int fold_constants(CodeGenerator *gen, ASTNode *ast);
+static int remove_redundant(CodeGenerator *gen, ASTNode *ast);
+static int share_slots(CodeGenerator *gen, ASTNode *ast);
+
+// in pipeline order
+static const Pass passes[PASS_COUNT] = {
+    [PASS_FOLD] = {"fold", LEVEL_AST, "nodes folded", fold_constants},
+    [PASS_LOOPS] = {"loops", LEVEL_CODEGEN, "values kept in registers", NULL},
+    [PASS_MULCHAIN] = {"mulchain", LEVEL_CODEGEN, "multiplies chained", NULL},
+    [PASS_PEEPHOLE] = {"peephole", LEVEL_IR, "instructions removed", remove_redundant},
+    [PASS_SLOTS] = {"slots", LEVEL_MACHINE, "bytes saved", share_slots},
+};
+
+int pass_level(const char *level, unsigned *enabled)
+{
+    if (strcmp(level, "0") == 0)
+        *enabled = 0;
+    else if (strcmp(level, "1") == 0)
+        *enabled = PASS_BIT(PASS_FOLD) | PASS_BIT(PASS_PEEPHOLE);
+    else if (strcmp(level, "2") == 0)
+        *enabled = PASS_BIT(PASS_COUNT) - 1;
+    else if (strcmp(level, "s") == 0)
+        *enabled = PASS_BIT(PASS_COUNT) - 1 - PASS_BIT(PASS_LOOPS);
+    else
+        return -1;
+    return 0;
+}
+
+int find_pass(const char *name)
+{
+    for (int i = 0; i < PASS_COUNT; i++)
+    {
+        if (strcmp(passes[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char *pass_name(PassId pass)
+{
+    return pass < PASS_COUNT ? passes[pass].name : "?";
+}
+
+// a op b as the 16-bit int of the target; 0 when the result is no literal (negative)
+static int fold_operator(TokenType op, int a, int b, int *result)
+{
+    long long value;
+    int count = b & 0xFFFF; // shift counts are unsigned
+    switch (op)
+    {
+    case TOKEN_PLUS:
+        value = (long long)a + b;
+        break;
+    case TOKEN_MINUS:
+        value = (long long)a - b;
+        break;
+    case TOKEN_STAR:
+        value = (long long)a * b;
+        break;
+    case TOKEN_EQUAL:
+        value = a == b;
+        break;
+    case TOKEN_SHIFT_LEFT:
+        value = count >= 16 ? 0 : (long long)a << count;
+        break;
+    case TOKEN_SHIFT_RIGHT:
+        value = count >= 16 ? 0 : a >> count;
+        break;
+    default:
+        return 0;
+    }
+    value &= 0xFFFF;
+    if (value > RANGE_MAX)
+        return 0;
+    *result = (int)value;
+    return 1;
+}
+
+static int is_number(const ASTNode *node, int value)
+{
+    return node->type == AST_NUMBER && node->data.number.value == value;
+}
+
+// Replace an operator with one of its operands, in place, so the parent's pointer stays
+static void keep_operand(ASTNode *node, ASTNode *keep, ASTNode *drop)
+{
+    free_ast(drop);
+    *node = *keep;
+    sl_free(keep); // its children now belong to node
+}
+
+// Constant folding and algebraic identities, bottom up. Literals past the int are left
+// alone so code generation still reports them.
+static int fold_constants(CodeGenerator *gen, ASTNode *ast)
+{
+    (void)gen;
+    int folded = 0;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, ast, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        if (step < ast_child_count(node))
+        {
+            ast_walk_push(&walk, ast_child(node, step), 0);
+            continue;
+        }
+        ast_walk_pop(&walk);
+        if (node->type != AST_BINARY_OP)
+            continue;
+
+        ASTNode *left = node->data.binary_op.left, *right = node->data.binary_op.right;
+        TokenType op = node->data.binary_op.operator;
+        int value;
+        if (left->type == AST_NUMBER && right->type == AST_NUMBER &&
+            left->data.number.value <= RANGE_MAX && right->data.number.value <= RANGE_MAX &&
+            fold_operator(op, left->data.number.value, right->data.number.value, &value))
+        {
+            free_ast(left);
+            free_ast(right);
+            node->type = AST_NUMBER;
+            node->data.number.value = value;
+        }
+        else if ((op == TOKEN_PLUS && is_number(left, 0)) || (op == TOKEN_STAR && is_number(left, 1)))
+        {
+            keep_operand(node, right, left);
+        }
+        else if (((op == TOKEN_PLUS || op == TOKEN_MINUS || op == TOKEN_SHIFT_LEFT || op == TOKEN_SHIFT_RIGHT) &&
+                  is_number(right, 0)) ||
+                 (op == TOKEN_STAR && is_number(right, 1)))
+        {
+            keep_operand(node, left, right);
+        }
+        else if (op == TOKEN_STAR && (is_number(left, 0) || is_number(right, 0)))
+        {
+            // expressions have no side effects, so x * 0 is 0 whatever x is
+            keep_operand(node, is_number(left, 0) ? left : right, is_number(left, 0) ? right : left);
+        }
+        else
+        {
+            continue;
+        }
+        folded++;
+    }
+    int failed = walk.failed;
+    free_ast_walk(&walk);
+    return failed ? -1 : folded;
+}
+
+static int same_memory(const Instruction *a, const Instruction *b)
+{
+    return a->operand[0] == b->operand[0] && a->operand_kind[1] == b->operand_kind[1] &&
+           (a->operand_kind[1] != OPERAND_IMMEDIATE || a->operand[1] == b->operand[1]);
+}
+
+// the register an ldi, mov or lda sets without reading it or the flags, -1 for others
+static int overwritten_register(const Instruction *inst)
+{
+    if (inst->opcode == OP_LDI)
+        return inst->operand[0];
+    if (inst->opcode == OP_MOV && inst->operand[0] != inst->operand[1])
+        return inst->operand[0];
+    if (inst->opcode == OP_LDA)
+        return REG_A;
+    return -1;
+}
+
+// Peephole pass over neighbouring instructions; a label between two keeps them both.
+// Repeated until nothing changes, as one removal can bring two more instructions together.
+static int remove_redundant(CodeGenerator *gen, ASTNode *ast)
+{
+    (void)ast;
+    int before = gen->count, changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        int count = 0;
+        for (int i = 0; i < gen->count; i++)
+        {
+            Instruction inst = gen->instructions[i];
+            Instruction *previous = count > 0 ? &gen->instructions[count - 1] : NULL;
+            int reg = overwritten_register(&inst);
+            int drop = 1;
+
+            if (inst.opcode == OP_MOV && inst.operand[0] == inst.operand[1])
+            {
+                // mov A A
+            }
+            else if (!previous)
+            {
+                drop = 0;
+            }
+            else if ((inst.opcode == OP_LDA && previous->opcode == OP_STA && same_memory(&inst, previous)) ||
+                     (inst.opcode == OP_STA && previous->opcode == OP_LDA && same_memory(&inst, previous)))
+            {
+                // A already holds the value, or the slot already does
+            }
+            else if (inst.opcode == OP_MOV && previous->opcode == OP_MOV &&
+                     inst.operand[0] == previous->operand[1] && inst.operand[1] == previous->operand[0])
+            {
+                // mov B A; mov A B
+            }
+            else if (inst.opcode == OP_POP && previous->opcode == OP_PUSH)
+            {
+                // push X; pop Y is mov Y X, or nothing at all
+                if (inst.operand[0] == previous->operand[0])
+                    count--;
+                else
+                    *previous = (Instruction){OP_MOV, {OPERAND_REGISTER, OPERAND_REGISTER},
+                                              {inst.operand[0], previous->operand[0]}};
+            }
+            else if (reg >= 0 && overwritten_register(previous) == reg &&
+                     !(inst.opcode == OP_MOV && inst.operand[1] == reg))
+            {
+                // the previous value of the register is never read
+                *previous = inst;
+                gen->positions[count - 1] = gen->positions[i];
+            }
+            else if (inst.opcode == OP_LABEL && previous->opcode == OP_JMP && previous->operand[0] == inst.operand[0])
+            {
+                // jmp .L1; .L1:
+                *previous = inst;
+                gen->positions[count - 1] = gen->positions[i];
+            }
+            else
+            {
+                drop = 0;
+            }
+
+            if (drop)
+            {
+                changed = 1;
+            }
+            else
+            {
+                gen->positions[count] = gen->positions[i];
+                gen->instructions[count++] = inst;
+            }
+        }
+        gen->count = count;
+    }
+    return before - gen->count;
+}
+
+static int share_slots(CodeGenerator *gen, ASTNode *ast)
+{
+    // a module's globals are read and stored by others, each needs its own slot
+    if (gen->shared_globals)
+        return 0;
+    return share_data_slots(gen, ast) == 0 ? data_bytes_saved(gen) : -1;
+}
+
+static void dump_program(OutputSink *dump, const CodeGenerator *gen, ASTNode *ast, PassLevel level,
+                         const char *name)
+{
+    sink_printf(dump, "; after %s\n", name);
+    if (level == LEVEL_AST)
+        write_ast(dump, ast);
+    else
+        write_ir((CodeGenerator *)gen, dump);
+}
+
+// run one pass of the pipeline, -1 when it fails
+static int run_pass(CodeGenerator *gen, ASTNode *ast, PassId pass, const PassOptions *options,
+                    PassStats *stats, OutputSink *dump)
+{
+    if (!(options->enabled & PASS_BIT(pass)))
+        return 0;
+    uint64_t start = monotonic_nanoseconds();
+    int changes = passes[pass].run(gen, ast);
+    if (changes < 0)
+        return -1;
+    stats->nanoseconds[pass] += monotonic_nanoseconds() - start;
+    stats->changes[pass] += changes;
+    stats->ran |= PASS_BIT(pass);
+    if (dump && (options->print_after & PASS_BIT(pass)))
+        dump_program(dump, gen, ast, passes[pass].level, passes[pass].name);
+    return 0;
+}
+
+int run_passes(CodeGenerator *gen, ASTNode *ast, const PassOptions *options, PassStats *stats,
+               OutputSink *dump)
+{
+    PassStats ignored;
+    if (!stats)
+        stats = &ignored;
+    memset(stats, 0, sizeof(PassStats));
+
+    for (int pass = 0; pass < PASS_COUNT; pass++)
+    {
+        if (passes[pass].level == LEVEL_AST && run_pass(gen, ast, pass, options, stats, dump) != 0)
+            return -1;
+    }
+
+    gen->keep_loop_values = (options->enabled & PASS_BIT(PASS_LOOPS)) != 0;
+    gen->chain_multiplies = (options->enabled & PASS_BIT(PASS_MULCHAIN)) != 0;
+    gen->analysis_nanoseconds = gen->loop_nanoseconds = gen->chain_nanoseconds = 0;
+    uint64_t start = monotonic_nanoseconds();
+    if (generate_code(gen, ast) != 0)
+        return -1;
+    uint64_t elapsed = monotonic_nanoseconds() - start;
+    uint64_t planning = gen->analysis_nanoseconds + gen->loop_nanoseconds + gen->chain_nanoseconds;
+    stats->analysis_nanoseconds = gen->analysis_nanoseconds;
+    stats->nanoseconds[PASS_LOOPS] = gen->loop_nanoseconds;
+    stats->nanoseconds[PASS_MULCHAIN] = gen->chain_nanoseconds;
+    stats->codegen_nanoseconds = elapsed > planning ? elapsed - planning : 0;
+    stats->instructions = gen->count;
+    stats->changes[PASS_LOOPS] = gen->loop_values;
+    stats->changes[PASS_MULCHAIN] = gen->chained_multiplies;
+    for (int pass = 0; pass < PASS_COUNT; pass++)
+    {
+        if (passes[pass].level != LEVEL_CODEGEN || !(options->enabled & PASS_BIT(pass)))
+            continue;
+        stats->ran |= PASS_BIT(pass);
+        if (dump && (options->print_after & PASS_BIT(pass)))
+            dump_program(dump, gen, ast, LEVEL_CODEGEN, passes[pass].name);
+    }
+
+    for (int pass = 0; pass < PASS_COUNT; pass++)
+    {
+        if (passes[pass].level > LEVEL_CODEGEN && run_pass(gen, ast, pass, options, stats, dump) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+void write_pass_stats(OutputSink *sink, const PassStats *stats)
+{
+    sink_printf(sink, "%-10s %12s  %s\n", "pass", "time (ms)", "changes");
+    for (int pass = 0; pass < PASS_COUNT; pass++)
+    {
+        // the analysis and the lowering come after the AST passes
+        if (pass > 0 && passes[pass - 1].level == LEVEL_AST && passes[pass].level != LEVEL_AST)
+        {
+            sink_printf(sink, "%-10s %12.3f\n", "analysis", stats->analysis_nanoseconds / 1e6);
+            sink_printf(sink, "%-10s %12.3f  %d instructions\n", "codegen",
+                        stats->codegen_nanoseconds / 1e6, stats->instructions);
+        }
+        if (!(stats->ran & PASS_BIT(pass)))
+            continue;
+        sink_printf(sink, "%-10s %12.3f  %d %s\n", passes[pass].name, stats->nanoseconds[pass] / 1e6,
+                    stats->changes[pass], passes[pass].changes);
+    }
+}
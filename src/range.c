@@ -0,0 +1,744 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/range.h"
+#include "../include/allocator.h"
+
+// a loop is repeated this many times before bounds that keep growing are widened
+#define WIDEN_AFTER 3
+// after this many, or at once when nested deeper than LOOP_DEPTH_PRECISE, the variables
+// a loop stores are taken to hold anything
+#define LOOP_ITERATIONS_MAX 12
+#define LOOP_DEPTH_PRECISE 4
+
+static const ValueRange EMPTY = {1, 0};
+static const ValueRange FULL = {RANGE_MIN, RANGE_MAX};
+
+/*
+An environment is the range of every variable at one point of the program, plus one
+last entry that is empty when the point cannot be reached. They live on a stack: entry
+0 is the current point, the statements being analysed take more while they run.
+*/
+typedef struct
+{
+    RangeAnalysis *result;
+    int variable_count;
+    ValueRange *environments;
+    int environment_count;
+    int environment_capacity;
+    ValueRange *values; // operand stack of evaluate
+    int value_count;
+    int value_capacity;
+    int *stores;        // per variable, scratch for bound_inductions
+    int loop_depth;
+    int failed;
+} Analyzer;
+
+static int is_empty(ValueRange range)
+{
+    return range.low > range.high;
+}
+
+// a result outside the int wraps around, to anything
+static ValueRange make_range(long long low, long long high)
+{
+    if (low < RANGE_MIN || high > RANGE_MAX)
+        return FULL;
+    ValueRange range = {(int)low, (int)high};
+    return range;
+}
+
+static ValueRange join(ValueRange a, ValueRange b)
+{
+    if (is_empty(a))
+        return b;
+    if (is_empty(b))
+        return a;
+    ValueRange range = {a.low < b.low ? a.low : b.low, a.high > b.high ? a.high : b.high};
+    return range;
+}
+
+static ValueRange meet(ValueRange a, ValueRange b)
+{
+    ValueRange range = {a.low > b.low ? a.low : b.low, a.high < b.high ? a.high : b.high};
+    return is_empty(range) ? EMPTY : range;
+}
+
+int fits_in_byte(ValueRange range)
+{
+    return is_empty(range) || (range.low >= 0 && range.high <= 255);
+}
+
+// Shift counts are unsigned: 16 or more, negative ones included, shift every bit out,
+// leaving 0, or -1 for >> of a negative value (>> is arithmetic).
+static ValueRange shift_range(TokenType op, ValueRange value, ValueRange count)
+{
+    ValueRange result = EMPTY;
+    if (count.low < 0 || count.high > 15)
+    {
+        ValueRange zero = {0, 0}, minus_one = {-1, -1};
+        if (op == TOKEN_SHIFT_LEFT || value.high >= 0)
+            result = join(result, zero);
+        if (op == TOKEN_SHIFT_RIGHT && value.low < 0)
+            result = join(result, minus_one);
+    }
+    int low = count.low < 0 ? 0 : count.low;
+    int high = count.high > 15 ? 15 : count.high;
+    if (low > high)
+        return result;
+    if (op == TOKEN_SHIFT_RIGHT)
+    {
+        // monotonic in both, so the extremes are at the corners
+        int a = value.low >> low, b = value.low >> high;
+        int c = value.high >> low, d = value.high >> high;
+        return join(result, make_range(a < b ? a : b, c > d ? c : d));
+    }
+    if (value.low < 0)
+        return FULL;
+    return join(result, make_range((long long)value.low << low, (long long)value.high << high));
+}
+
+static ValueRange apply_operator(TokenType op, ValueRange a, ValueRange b)
+{
+    if (is_empty(a) || is_empty(b))
+        return EMPTY;
+    switch (op)
+    {
+    case TOKEN_PLUS:
+        return make_range((long long)a.low + b.low, (long long)a.high + b.high);
+    case TOKEN_MINUS:
+        return make_range((long long)a.low - b.high, (long long)a.high - b.low);
+    case TOKEN_STAR:
+    {
+        long long products[4] = {(long long)a.low * b.low, (long long)a.low * b.high,
+                                 (long long)a.high * b.low, (long long)a.high * b.high};
+        long long low = products[0], high = products[0];
+        for (int i = 1; i < 4; i++)
+        {
+            low = products[i] < low ? products[i] : low;
+            high = products[i] > high ? products[i] : high;
+        }
+        return make_range(low, high);
+    }
+    case TOKEN_EQUAL:
+        if (a.low == a.high && b.low == b.high && a.low == b.low)
+            return make_range(1, 1);
+        if (a.high < b.low || b.high < a.low)
+            return make_range(0, 0);
+        return make_range(0, 1);
+    case TOKEN_SHIFT_LEFT:
+    case TOKEN_SHIFT_RIGHT:
+        return shift_range(op, a, b);
+    default:
+        return FULL;
+    }
+}
+
+// the node's entry in the table, or the empty one it would take
+static NodeRange *find_node(const RangeAnalysis *analysis, const ASTNode *node)
+{
+    size_t mask = (size_t)analysis->node_capacity - 1;
+    size_t slot = (size_t)(((uintptr_t)node >> 4) * 2654435761u) & mask;
+    while (analysis->nodes[slot].node && analysis->nodes[slot].node != node)
+        slot = (slot + 1) & mask;
+    return &analysis->nodes[slot];
+}
+
+static void record(RangeAnalysis *analysis, const ASTNode *node, ValueRange range)
+{
+    NodeRange *entry = find_node(analysis, node);
+    if (!entry->node)
+    {
+        entry->node = node;
+        entry->range = EMPTY;
+        analysis->node_count++;
+    }
+    entry->range = join(entry->range, range);
+}
+
+ValueRange node_range(const RangeAnalysis *analysis, const ASTNode *node)
+{
+    const NodeRange *entry = find_node(analysis, node);
+    return entry->node ? entry->range : EMPTY;
+}
+
+ValueRange variable_range(const RangeAnalysis *analysis, const char *name)
+{
+    int id = find_symbol(&analysis->variables, name);
+    return id < 0 ? EMPTY : analysis->stored[id];
+}
+
+static ValueRange *environment(Analyzer *analyzer, int index)
+{
+    return analyzer->environments + (size_t)index * (analyzer->variable_count + 1);
+}
+
+// a new environment on the stack, -1 when out of memory
+static int push_environment(Analyzer *analyzer)
+{
+    if (analyzer->environment_count == analyzer->environment_capacity)
+    {
+        int capacity = analyzer->environment_capacity * 2;
+        ValueRange *grown = sl_realloc(analyzer->environments,
+                                       sizeof(ValueRange) * (analyzer->variable_count + 1) * capacity);
+        if (!grown)
+        {
+            analyzer->failed = 1;
+            return -1;
+        }
+        analyzer->environments = grown;
+        analyzer->environment_capacity = capacity;
+    }
+    return analyzer->environment_count++;
+}
+
+static void copy_environment(Analyzer *analyzer, int to, int from)
+{
+    memcpy(environment(analyzer, to), environment(analyzer, from),
+           sizeof(ValueRange) * (analyzer->variable_count + 1));
+}
+
+static int is_unreachable(Analyzer *analyzer, int index)
+{
+    return is_empty(environment(analyzer, index)[analyzer->variable_count]);
+}
+
+static void set_unreachable(Analyzer *analyzer, int index)
+{
+    ValueRange *ranges = environment(analyzer, index);
+    for (int i = 0; i <= analyzer->variable_count; i++)
+        ranges[i] = EMPTY;
+}
+
+static int push_value(Analyzer *analyzer, ValueRange range)
+{
+    if (analyzer->value_count == analyzer->value_capacity)
+    {
+        int capacity = analyzer->value_capacity ? analyzer->value_capacity * 2 : 64;
+        ValueRange *grown = sl_realloc(analyzer->values, sizeof(ValueRange) * capacity);
+        if (!grown)
+        {
+            analyzer->failed = 1;
+            return -1;
+        }
+        analyzer->values = grown;
+        analyzer->value_capacity = capacity;
+    }
+    analyzer->values[analyzer->value_count++] = range;
+    return 0;
+}
+
+// range of an expression in an environment, recorded for it and every node under it
+static ValueRange evaluate(Analyzer *analyzer, ASTNode *expression, int index)
+{
+    RangeAnalysis *analysis = analyzer->result;
+    int base = analyzer->value_count;
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, expression, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !analyzer->failed)
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        ValueRange range = FULL;
+        if (node->type == AST_BINARY_OP && step < 2)
+        {
+            ast_walk_push(&walk, step == 0 ? node->data.binary_op.left : node->data.binary_op.right, 0);
+            continue;
+        }
+        if (node->type == AST_NUMBER)
+        {
+            // one out of range is reported, and stands for anything meanwhile
+            if (node->data.number.value <= RANGE_MAX)
+                range = make_range(node->data.number.value, node->data.number.value);
+        }
+        else if (node->type == AST_IDENTIFIER)
+        {
+            range = environment(analyzer, index)[find_symbol(&analysis->variables, node->data.identifier.name)];
+        }
+        else if (node->type == AST_BINARY_OP)
+        {
+            ValueRange right = analyzer->values[--analyzer->value_count];
+            ValueRange left = analyzer->values[--analyzer->value_count];
+            range = apply_operator(node->data.binary_op.operator, left, right);
+        }
+        ast_walk_pop(&walk);
+        record(analysis, node, range);
+        push_value(analyzer, range);
+    }
+    if (walk.failed)
+        analyzer->failed = 1;
+    free_ast_walk(&walk);
+
+    ValueRange range = analyzer->value_count > base ? analyzer->values[base] : FULL;
+    analyzer->value_count = base;
+    return range;
+}
+
+static void store(Analyzer *analyzer, int index, const char *name, ValueRange range)
+{
+    int id = find_symbol(&analyzer->result->variables, name);
+    environment(analyzer, index)[id] = range;
+    analyzer->result->stored[id] = join(analyzer->result->stored[id], range);
+}
+
+// range of an operand of a condition right after it was evaluated
+static ValueRange operand_range(Analyzer *analyzer, int index, const ASTNode *node)
+{
+    if (node->type == AST_IDENTIFIER)
+        return environment(analyzer, index)[find_symbol(&analyzer->result->variables, node->data.identifier.name)];
+    return node_range(analyzer->result, node);
+}
+
+// Narrow an environment to the runs where condition, which evaluated to range there, is
+// non-zero (truth) or zero.
+static void refine(Analyzer *analyzer, int index, const ASTNode *condition, ValueRange range, int truth)
+{
+    if (truth ? range.low == 0 && range.high == 0 : range.low > 0 || range.high < 0)
+    {
+        set_unreachable(analyzer, index);
+        return;
+    }
+    ValueRange *ranges = environment(analyzer, index);
+    const SymbolTable *variables = &analyzer->result->variables;
+    if (condition->type == AST_IDENTIFIER)
+    {
+        int id = find_symbol(variables, condition->data.identifier.name);
+        ValueRange zero = {0, 0};
+        if (!truth)
+            ranges[id] = meet(ranges[id], zero);
+        else if (ranges[id].low == 0)
+            ranges[id].low = 1;
+        else if (ranges[id].high == 0)
+            ranges[id].high = -1;
+        if (is_empty(ranges[id]))
+            set_unreachable(analyzer, index);
+        return;
+    }
+    if (condition->type != AST_BINARY_OP || condition->data.binary_op.operator != TOKEN_EQUAL)
+        return;
+
+    // x == e: x is e's range when true, and not e's one value when false
+    const ASTNode *sides[2] = {condition->data.binary_op.left, condition->data.binary_op.right};
+    ValueRange other[2] = {operand_range(analyzer, index, sides[1]), operand_range(analyzer, index, sides[0])};
+    for (int i = 0; i < 2; i++)
+    {
+        if (sides[i]->type != AST_IDENTIFIER)
+            continue;
+        int id = find_symbol(variables, sides[i]->data.identifier.name);
+        if (truth)
+        {
+            ranges[id] = meet(ranges[id], other[i]);
+        }
+        else if (other[i].low == other[i].high)
+        {
+            if (ranges[id].low == other[i].low)
+                ranges[id].low++;
+            else if (ranges[id].high == other[i].low)
+                ranges[id].high--;
+        }
+        if (is_empty(ranges[id]))
+        {
+            set_unreachable(analyzer, index);
+            return;
+        }
+    }
+}
+
+// the variable a statement stores to and the value it stores, NULL for other statements
+static const char *stored_variable(const ASTNode *node, ASTNode **value)
+{
+    if (node->type == AST_ASSIGNMENT)
+    {
+        *value = node->data.assignment.value;
+        return node->data.assignment.var_name;
+    }
+    if (node->type == AST_DECLARATION && node->data.declaration.init_value)
+    {
+        *value = node->data.declaration.init_value;
+        return node->data.declaration.var_name;
+    }
+    return NULL;
+}
+
+// add delta to the store count of every variable stored anywhere in the loop
+static void count_stores(Analyzer *analyzer, ASTNode *loop, int delta)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, loop, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node, *value;
+        ast_walk_pop(&walk);
+        const char *name = stored_variable(node, &value);
+        if (name)
+            analyzer->stores[find_symbol(&analyzer->result->variables, name)] += delta;
+        // expressions hold no stores
+        if (node->type != AST_BINARY_OP)
+            for (int i = 0; i < ast_child_count(node); i++)
+                ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    if (walk.failed)
+        analyzer->failed = 1;
+    free_ast_walk(&walk);
+}
+
+// whether an expression reads a variable
+static int reads_variable(const ASTNode *expression, const char *name)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, (ASTNode *)expression, 0);
+    int found = 0;
+    ASTFrame *frame;
+    while (!found && (frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        ast_walk_pop(&walk);
+        if (node->type == AST_IDENTIFIER)
+            found = strcmp(node->data.identifier.name, name) == 0;
+        for (int i = 0; i < ast_child_count(node); i++)
+            ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    // out of memory: assume it does
+    found |= walk.failed;
+    free_ast_walk(&walk);
+    return found;
+}
+
+// The step of a top level statement v = v + e, e + v or v - e of the loop body, whose e
+// does not read v; NULL for other statements. Sets the variable and the sign of e.
+static ASTNode *induction_step(const ASTNode *statement, const char **name, int *sign)
+{
+    ASTNode *value;
+    *name = stored_variable(statement, &value);
+    if (!*name || value->type != AST_BINARY_OP)
+        return NULL;
+    ASTNode *left = value->data.binary_op.left, *right = value->data.binary_op.right;
+    TokenType op = value->data.binary_op.operator;
+    if (op == TOKEN_PLUS && right->type == AST_IDENTIFIER && strcmp(right->data.identifier.name, *name) == 0)
+    {
+        ASTNode *swap = left;
+        left = right;
+        right = swap;
+    }
+    if ((op != TOKEN_PLUS && op != TOKEN_MINUS) || left->type != AST_IDENTIFIER ||
+        strcmp(left->data.identifier.name, *name) != 0 || reads_variable(right, *name))
+        return NULL;
+    *sign = op == TOKEN_PLUS ? 1 : -1;
+    return right;
+}
+
+// A loop under while (n) whose body counts n down by one top level n = n - 1, and
+// stores n nowhere else, runs at most n times from its entry when n >= 0 there. Every
+// variable the body steps once at its top level then stays within its entry range
+// plus that many steps: narrow head, the loop's next starting point, to that.
+static void bound_inductions(Analyzer *analyzer, ASTNode *loop, int entry, int head)
+{
+    ASTNode *condition = loop->data.while_stmt.condition;
+    ASTNode *body = loop->data.while_stmt.body;
+    const SymbolTable *variables = &analyzer->result->variables;
+    if (condition->type != AST_IDENTIFIER)
+        return;
+    const char *counter = condition->data.identifier.name;
+    ValueRange start = environment(analyzer, entry)[find_symbol(variables, counter)];
+    if (is_empty(start) || start.low < 0)
+        return;
+
+    count_stores(analyzer, loop, 1);
+    int counted = 0;
+    for (int i = 0; i < body->data.block.count; i++)
+    {
+        const char *name;
+        int sign;
+        ASTNode *step = induction_step(body->data.block.statements[i], &name, &sign);
+        counted |= step && strcmp(name, counter) == 0 && sign < 0 && step->type == AST_NUMBER &&
+                   step->data.number.value == 1;
+    }
+    if (counted && analyzer->stores[find_symbol(variables, counter)] == 1)
+    {
+        long long passes = start.high;
+        for (int i = 0; i < body->data.block.count; i++)
+        {
+            const char *name;
+            int sign;
+            ASTNode *step = induction_step(body->data.block.statements[i], &name, &sign);
+            int id = step ? find_symbol(variables, name) : -1;
+            ValueRange by = step ? node_range(analyzer->result, step) : EMPTY;
+            if (id < 0 || strcmp(name, counter) == 0 || analyzer->stores[id] != 1 || is_empty(by))
+                continue;
+            long long low = sign > 0 ? by.low : -(long long)by.high;
+            long long high = sign > 0 ? by.high : -(long long)by.low;
+            ValueRange from = environment(analyzer, entry)[id];
+            ValueRange bound = make_range(from.low + (low < 0 ? passes * low : 0),
+                                          from.high + (high > 0 ? passes * high : 0));
+            ValueRange *ranges = environment(analyzer, head);
+            if (!is_empty(meet(ranges[id], bound)))
+                ranges[id] = meet(ranges[id], bound);
+        }
+    }
+    count_stores(analyzer, loop, -1);
+}
+
+// bounds that grew since the last pass jump to the next of 0..255 and the whole int
+static void widen(Analyzer *analyzer, int previous, int next)
+{
+    const ValueRange *old = environment(analyzer, previous);
+    ValueRange *ranges = environment(analyzer, next);
+    for (int i = 0; i < analyzer->variable_count; i++)
+    {
+        if (is_empty(old[i]) || is_empty(ranges[i]))
+            continue;
+        if (ranges[i].high > old[i].high)
+            ranges[i].high = ranges[i].high <= 255 ? 255 : RANGE_MAX;
+        if (ranges[i].low < old[i].low)
+            ranges[i].low = ranges[i].low >= 0 ? 0 : RANGE_MIN;
+    }
+}
+
+// every variable the loop stores may hold anything
+static void give_up(Analyzer *analyzer, ASTNode *loop, int index)
+{
+    count_stores(analyzer, loop, 1);
+    ValueRange *ranges = environment(analyzer, index);
+    for (int i = 0; i < analyzer->variable_count; i++)
+    {
+        if (analyzer->stores[i] > 0 && !is_empty(ranges[i]))
+            ranges[i] = FULL;
+    }
+    count_stores(analyzer, loop, -1);
+}
+
+// evaluate a loop's condition at its head and enter the body: current = head, narrowed
+static void enter_loop_body(Analyzer *analyzer, ASTNode *loop, int head)
+{
+    ValueRange range = evaluate(analyzer, loop->data.while_stmt.condition, head);
+    copy_environment(analyzer, 0, head);
+    refine(analyzer, 0, loop->data.while_stmt.condition, range, 1);
+}
+
+// Follow the statements in order (see range.h). Frames of if and while statements keep
+// the environments they need on the stack: an if the one for the branch not being
+// analysed, a while its entry (frame value) and head (the next one).
+static void analyze_statements(Analyzer *analyzer, ASTNode *program)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !analyzer->failed)
+    {
+        ASTNode *node = frame->node, *value;
+        int step = frame->step++;
+        const char *name;
+        switch (node->type)
+        {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            if (step < node->data.block.count && !is_unreachable(analyzer, 0))
+                ast_walk_push(&walk, node->data.block.statements[step], 0);
+            else
+                ast_walk_pop(&walk);
+            break;
+
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+            if ((name = stored_variable(node, &value)))
+                store(analyzer, 0, name, evaluate(analyzer, value, 0));
+            ast_walk_pop(&walk);
+            break;
+
+        case AST_IF_STATEMENT:
+        {
+            ASTNode *condition = node->data.if_stmt.condition;
+            if (step == 0)
+            {
+                int other = push_environment(analyzer);
+                if (other < 0)
+                    break;
+                frame->value = other;
+                ValueRange range = evaluate(analyzer, condition, 0);
+                copy_environment(analyzer, other, 0);
+                refine(analyzer, other, condition, range, 0);
+                refine(analyzer, 0, condition, range, 1);
+                ast_walk_push(&walk, node->data.if_stmt.then_block, 0);
+            }
+            else if (step == 1)
+            {
+                // the then block is done: swap in the else block's start
+                int other = frame->value;
+                if (push_environment(analyzer) < 0)
+                    break;
+                int swap = analyzer->environment_count - 1;
+                copy_environment(analyzer, swap, 0);
+                copy_environment(analyzer, 0, other);
+                copy_environment(analyzer, other, swap);
+                analyzer->environment_count--;
+                ast_walk_push(&walk, node->data.if_stmt.else_block, 0);
+            }
+            else
+            {
+                ValueRange *current = environment(analyzer, 0);
+                const ValueRange *then_end = environment(analyzer, frame->value);
+                for (int i = 0; i <= analyzer->variable_count; i++)
+                    current[i] = join(current[i], then_end[i]);
+                analyzer->environment_count--;
+                ast_walk_pop(&walk);
+            }
+            break;
+        }
+
+        case AST_WHILE_STATEMENT:
+        {
+            if (step == 0)
+            {
+                int entry = push_environment(analyzer);
+                int head = entry < 0 ? -1 : push_environment(analyzer);
+                if (head < 0)
+                    break;
+                frame->value = entry;
+                copy_environment(analyzer, entry, 0);
+                copy_environment(analyzer, head, 0);
+                if (++analyzer->loop_depth > LOOP_DEPTH_PRECISE)
+                    give_up(analyzer, node, head);
+                enter_loop_body(analyzer, node, head);
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+                break;
+            }
+
+            // a pass is done: the next head joins what it ended with into this one
+            int entry = frame->value, head = entry + 1;
+            ValueRange *current = environment(analyzer, 0);
+            const ValueRange *previous = environment(analyzer, head);
+            for (int i = 0; i <= analyzer->variable_count; i++)
+                current[i] = join(current[i], previous[i]);
+            if (step >= WIDEN_AFTER)
+                widen(analyzer, head, 0);
+            bound_inductions(analyzer, node, entry, 0);
+            if (step >= LOOP_ITERATIONS_MAX)
+                give_up(analyzer, node, 0);
+
+            if (memcmp(environment(analyzer, 0), environment(analyzer, head),
+                       sizeof(ValueRange) * (analyzer->variable_count + 1)) != 0)
+            {
+                copy_environment(analyzer, head, 0);
+                enter_loop_body(analyzer, node, head);
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+                break;
+            }
+            // stable: leave when the condition is zero
+            ValueRange range = evaluate(analyzer, node->data.while_stmt.condition, head);
+            refine(analyzer, 0, node->data.while_stmt.condition, range, 0);
+            analyzer->environment_count -= 2;
+            analyzer->loop_depth--;
+            ast_walk_pop(&walk);
+            break;
+        }
+
+        default:
+            ast_walk_pop(&walk);
+            break;
+        }
+    }
+    if (walk.failed)
+        analyzer->failed = 1;
+    free_ast_walk(&walk);
+}
+
+// intern every variable and check every literal before the analysis starts
+static void collect_variables(RangeAnalysis *analysis, ASTNode *program, int *failed)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !*failed)
+    {
+        ASTNode *node = frame->node;
+        ast_walk_pop(&walk);
+        const char *name = NULL;
+        if (node->type == AST_IDENTIFIER)
+            name = node->data.identifier.name;
+        else if (node->type == AST_DECLARATION)
+            name = node->data.declaration.var_name;
+        else if (node->type == AST_ASSIGNMENT)
+            name = node->data.assignment.var_name;
+        else if (node->type == AST_EXTERN)
+            name = node->data.extern_decl.var_name;
+        if (name && intern_symbol(&analysis->variables, name) < 0)
+            *failed = 1;
+        if (node->type == AST_NUMBER && node->data.number.value > RANGE_MAX && !analysis->has_error)
+        {
+            analysis->has_error = 1;
+            snprintf(analysis->error_message, sizeof(analysis->error_message),
+                     "Range error at line %d, column %d: %d does not fit in a 16-bit int (%d..%d)",
+                     node->line, node->column, node->data.number.value, RANGE_MIN, RANGE_MAX);
+        }
+        for (int i = 0; i < ast_child_count(node); i++)
+            ast_walk_push(&walk, ast_child(node, i), 0);
+    }
+    if (walk.failed)
+        *failed = 1;
+    free_ast_walk(&walk);
+}
+
+RangeAnalysis *analyze_ranges(ASTNode *program, int shared)
+{
+    RangeAnalysis *analysis = sl_calloc(1, sizeof(RangeAnalysis));
+    if (!analysis)
+        return NULL;
+    init_symbol_table(&analysis->variables);
+    int failed = 0;
+    collect_variables(analysis, program, &failed);
+
+    int count = analysis->variables.count;
+    int capacity = 16;
+    while (capacity < count_ast_nodes(program) * 2)
+        capacity *= 2;
+    analysis->node_capacity = capacity;
+    analysis->nodes = sl_calloc(capacity, sizeof(NodeRange));
+    analysis->stored = sl_malloc(sizeof(ValueRange) * (count + 1));
+    Analyzer analyzer = {analysis, count, NULL, 1, 8, NULL, 0, 0, NULL, 0, failed};
+    analyzer.environments = sl_malloc(sizeof(ValueRange) * (count + 1) * analyzer.environment_capacity);
+    analyzer.stores = sl_calloc(count + 1, sizeof(int));
+    if (!analysis->nodes || !analysis->stored || !analyzer.environments || !analyzer.stores)
+        analyzer.failed = 1;
+
+    if (!analyzer.failed)
+    {
+        // data starts out zero, unless other modules get to it first
+        ValueRange start = shared ? FULL : make_range(0, 0);
+        ValueRange *ranges = environment(&analyzer, 0);
+        for (int i = 0; i < count; i++)
+        {
+            ranges[i] = start;
+            analysis->stored[i] = start;
+        }
+        ranges[count] = make_range(0, 0);
+        analyze_statements(&analyzer, program);
+    }
+
+    sl_free(analyzer.environments);
+    sl_free(analyzer.values);
+    sl_free(analyzer.stores);
+    if (analyzer.failed)
+    {
+        free_range_analysis(analysis);
+        return NULL;
+    }
+    return analysis;
+}
+
+void free_range_analysis(RangeAnalysis *analysis)
+{
+    if (!analysis)
+        return;
+    free_symbol_table(&analysis->variables);
+    sl_free(analysis->stored);
+    sl_free(analysis->nodes);
+    sl_free(analysis);
+}
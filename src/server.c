@@ -0,0 +1,747 @@
+#define _GNU_SOURCE // struct ucred for SO_PEERCRED
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../include/server.h"
+#include "../include/driver.h"
+#include "../include/lexer.h"
+#include "../include/allocator.h"
+#include "../include/threadpool.h"
+
+// a --cache-dir some request asked for, open for the rest of the server's life
+typedef struct
+{
+    char *directory; // absolute
+    Cache *cache;
+    int trimmed_at; // cache->stores at the last trim
+} ServerCache;
+
+// a kept cache is trimmed once this many entries went in since the last time
+#define SERVER_TRIM_STORES 64
+
+typedef struct
+{
+    const char *socket_path;
+    pthread_mutex_t lock; // guards stopping and the caches
+    int stopping;
+    ServerCache *caches;
+    int cache_count;
+    pthread_key_t arena; // each worker's arena, reset after every request
+} Server;
+
+typedef struct
+{
+    Server *server;
+    int fd;
+} Connection;
+
+// one decoded request
+typedef struct
+{
+    char *cwd;
+    char *source;
+    char **argv; // argv[0] is the program name, like a real command line
+    int argc;
+    int capacity;
+    int stop;
+} Request;
+
+void default_socket_path(char *buffer, size_t size)
+{
+    const char *path = getenv(SERVER_SOCKET_ENV);
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if (path && *path)
+        snprintf(buffer, size, "%s", path);
+    else if (runtime && *runtime)
+        snprintf(buffer, size, "%s/simplelang.sock", runtime);
+    else
+        snprintf(buffer, size, "/tmp/simplelang-%ld/server.sock", (long)getuid());
+}
+
+// Whether no other user can put their own socket at path: its directory must be a real
+// directory owned by this user (or root), and one others may write to must be sticky.
+// With create, a missing directory is made private to this user first.
+static int check_socket_directory(const char *path, int create)
+{
+    char directory[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    const char *slash = strrchr(path, '/');
+    if (!slash)
+        snprintf(directory, sizeof(directory), ".");
+    else if (slash == path)
+        snprintf(directory, sizeof(directory), "/");
+    else
+        snprintf(directory, sizeof(directory), "%.*s", (int)(slash - path), path);
+
+    if (create && mkdir(directory, 0700) != 0 && errno != EEXIST)
+        return -1;
+    struct stat info;
+    if (lstat(directory, &info) != 0)
+        return -1;
+    if (!S_ISDIR(info.st_mode) || (info.st_uid != getuid() && info.st_uid != 0) ||
+        ((info.st_mode & (S_IWGRP | S_IWOTH)) && !(info.st_mode & S_ISVTX)))
+    {
+        errno = EPERM;
+        return -1;
+    }
+    return 0;
+}
+
+// the user at the other end of a connected socket
+static int peer_uid(int fd, uid_t *uid)
+{
+#ifdef SO_PEERCRED
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0)
+        return -1;
+    *uid = credentials.uid;
+    return 0;
+#else
+    gid_t gid;
+    return getpeereid(fd, uid, &gid);
+#endif
+}
+
+static int same_user(int fd)
+{
+    uid_t uid;
+    return peer_uid(fd, &uid) == 0 && uid == getuid();
+}
+
+static int read_full(int fd, void *buffer, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = read(fd, (char *)buffer + done, length - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buffer, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = write(fd, (const char *)buffer + done, length - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static void put_u32(unsigned char *bytes, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+int write_frame(int fd, uint32_t type, const void *data, uint32_t length)
+{
+    unsigned char header[8];
+    put_u32(header, type);
+    put_u32(header + 4, length);
+    if (write_full(fd, header, sizeof(header)) != 0)
+        return -1;
+    return length ? write_full(fd, data, length) : 0;
+}
+
+int read_frame(int fd, uint32_t *type, char **data, uint32_t *length)
+{
+    unsigned char header[8];
+    if (read_full(fd, header, sizeof(header)) != 0)
+        return -1;
+    *type = get_u32(header);
+    *length = get_u32(header + 4);
+    if (*length > FRAME_MAX_LENGTH)
+        return -1;
+
+    *data = malloc(*length + 1);
+    if (!*data)
+        return -1;
+    if (read_full(fd, *data, *length) != 0)
+    {
+        free(*data);
+        *data = NULL;
+        return -1;
+    }
+    (*data)[*length] = '\0';
+    return 0;
+}
+
+static int fill_address(struct sockaddr_un *address, const char *path)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path))
+        return -1;
+    strcpy(address->sun_path, path);
+    return 0;
+}
+
+static int connect_socket(const char *path)
+{
+    struct sockaddr_un address;
+    if (fill_address(&address, path) != 0)
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    // requests carry sources and replies exit statuses: only talk to this user's server
+    if (!same_user(fd))
+    {
+        close(fd);
+        errno = EPERM;
+        return -1;
+    }
+    return fd;
+}
+
+static void free_request(Request *request)
+{
+    free(request->cwd);
+    free(request->source);
+    // argv[0] is a string literal
+    for (int i = 1; i < request->argc; i++)
+    {
+        free(request->argv[i]);
+    }
+    free(request->argv);
+}
+
+// takes ownership of data
+static int add_argument(Request *request, char *data)
+{
+    if (request->argc == request->capacity)
+    {
+        int capacity = request->capacity ? request->capacity * 2 : 16;
+        char **argv = realloc(request->argv, sizeof(char *) * capacity);
+        if (!argv)
+        {
+            free(data);
+            return -1;
+        }
+        request->argv = argv;
+        request->capacity = capacity;
+    }
+    request->argv[request->argc++] = data;
+    return 0;
+}
+
+static int read_request(int fd, Request *request)
+{
+    memset(request, 0, sizeof(Request));
+    request->argv = malloc(sizeof(char *) * 16);
+    if (!request->argv)
+        return -1;
+    request->argv[0] = "simplelang";
+    request->argc = 1;
+    request->capacity = 16;
+
+    for (;;)
+    {
+        uint32_t type, length;
+        char *data;
+        if (read_frame(fd, &type, &data, &length) != 0)
+            return -1;
+
+        switch (type)
+        {
+        case FRAME_END:
+            free(data);
+            return 0;
+        case FRAME_CWD:
+            free(request->cwd);
+            request->cwd = data;
+            break;
+        case FRAME_ARG:
+            if (add_argument(request, data) != 0)
+                return -1;
+            break;
+        case FRAME_SOURCE:
+            free(request->source);
+            request->source = data;
+            break;
+        case FRAME_STOP:
+            request->stop = 1;
+            free(data);
+            break;
+        default:
+            free(data);
+            return -1;
+        }
+    }
+}
+
+// the cache for a request's --cache-dir, opened by the first request that names it and
+// shared by the ones after; NULL leaves compile_all to open it (and report why it cannot)
+static Cache *server_cache(Server *server, const CompileOptions *options)
+{
+    const char *cwd = options->base_directory;
+    char *directory;
+    if (options->cache_directory[0] == '/' || !cwd)
+        directory = strdup(options->cache_directory);
+    else if ((directory = malloc(strlen(cwd) + strlen(options->cache_directory) + 2)))
+        sprintf(directory, "%s/%s", cwd, options->cache_directory);
+    if (!directory)
+        return NULL;
+
+    Cache *cache = NULL;
+    pthread_mutex_lock(&server->lock);
+    for (int i = 0; i < server->cache_count && !cache; i++)
+    {
+        if (strcmp(server->caches[i].directory, directory) == 0)
+            cache = server->caches[i].cache;
+    }
+    ServerCache *caches = cache ? NULL : realloc(server->caches, sizeof(ServerCache) * (server->cache_count + 1));
+    if (caches)
+    {
+        server->caches = caches;
+        cache = open_cache(directory, options->cache_size);
+        if (cache)
+        {
+            ServerCache entry = {directory, cache, 0};
+            server->caches[server->cache_count++] = entry;
+            directory = NULL;
+        }
+    }
+    // the latest request's --cache-size is the limit of the next trim
+    if (cache)
+        cache->size_limit = options->cache_size;
+    pthread_mutex_unlock(&server->lock);
+    free(directory);
+    return cache;
+}
+
+// trimming reads the whole directory, so it waits for enough new entries (all = 1: now)
+static void trim_server_caches(Server *server, int all)
+{
+    pthread_mutex_lock(&server->lock);
+    for (int i = 0; i < server->cache_count; i++)
+    {
+        ServerCache *entry = &server->caches[i];
+        pthread_mutex_lock(&entry->cache->lock);
+        int stores = entry->cache->stores;
+        pthread_mutex_unlock(&entry->cache->lock);
+        if (all || stores - entry->trimmed_at >= SERVER_TRIM_STORES)
+        {
+            cache_trim(entry->cache);
+            entry->trimmed_at = stores;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void free_worker_arena(void *arena)
+{
+    free_arena_allocator(arena);
+}
+
+// the calling worker's arena, made on its first request; NULL if that fails
+static Allocator *worker_arena(Server *server)
+{
+    Allocator *arena = pthread_getspecific(server->arena);
+    if (!arena && (arena = create_arena_allocator(0)) && pthread_setspecific(server->arena, arena) != 0)
+    {
+        free_arena_allocator(arena);
+        arena = NULL;
+    }
+    return arena;
+}
+
+// run one compile command line, exactly as main would but into the given sinks. The
+// compile allocates from the worker's arena (unless it asks for an arena of its own), and
+// its cache stays open for the next request
+static int serve_compile(Server *server, Request *request, OutputSink *out, OutputSink *diagnostics)
+{
+    CompileOptions options;
+    init_compile_options(&options);
+    options.base_directory = request->cwd;
+
+    int status;
+    int result = parse_options(request->argc, request->argv, &options, diagnostics);
+    // a program that never halts must not hold a worker for good
+    if (options.max_cycles == 0)
+        options.max_cycles = DEFAULT_MAX_CYCLES;
+    if (result == 0 && options.cache_directory)
+        options.shared_cache = server_cache(server, &options);
+    Allocator *arena = result == 0 ? worker_arena(server) : NULL;
+    Allocator *previous = arena ? set_allocator(arena) : NULL;
+    if (result > 0)
+    {
+        write_usage(out, "simplelang");
+        status = 0;
+    }
+    else if (result < 0)
+    {
+        sink_printf(diagnostics, "Run 'simplelang --help' for usage\n");
+        status = 1;
+    }
+    else if (request->source)
+    {
+        if (options.input_count != 1)
+        {
+            sink_printf(diagnostics, "Error: Source text needs exactly one input name\n");
+            status = 1;
+        }
+        else
+        {
+            CompileJob job = {&options, options.input_paths[0], out, diagnostics, 0, options.shared_cache, NULL, NULL, 0};
+            status = compile_source(&job, request->source);
+        }
+    }
+    else
+    {
+        // concurrency comes from concurrent clients, each one runs on a single worker
+        options.jobs = 1;
+        status = compile_all(&options, out, diagnostics);
+    }
+    if (arena)
+    {
+        set_allocator(previous);
+        reset_arena_allocator(arena);
+    }
+    if (options.shared_cache)
+        trim_server_caches(server, 0);
+    free_compile_options(&options);
+    return status;
+}
+
+static int send_reply(int fd, int status, OutputSink *out, OutputSink *diagnostics)
+{
+    unsigned char bytes[4];
+    size_t out_length = 0, diagnostics_length = 0;
+    const char *out_text = sink_contents(out, &out_length);
+    const char *diagnostics_text = sink_contents(diagnostics, &diagnostics_length);
+    if (!out_text || !diagnostics_text)
+        return -1;
+
+    put_u32(bytes, (uint32_t)status);
+    if (write_frame(fd, FRAME_STATUS, bytes, 4) != 0 ||
+        write_frame(fd, FRAME_OUT, out_text, (uint32_t)out_length) != 0 ||
+        write_frame(fd, FRAME_ERR, diagnostics_text, (uint32_t)diagnostics_length) != 0)
+        return -1;
+    return write_frame(fd, FRAME_END, NULL, 0);
+}
+
+static void handle_connection(void *arg)
+{
+    Connection *connection = arg;
+    Server *server = connection->server;
+    Request request;
+
+    if (read_request(connection->fd, &request) == 0)
+    {
+        OutputSink *out = create_memory_sink();
+        OutputSink *diagnostics = create_memory_sink();
+        int status = 1;
+        if (out && diagnostics)
+        {
+            if (request.stop)
+            {
+                pthread_mutex_lock(&server->lock);
+                server->stopping = 1;
+                pthread_mutex_unlock(&server->lock);
+                status = 0;
+            }
+            else
+            {
+                status = serve_compile(server, &request, out, diagnostics);
+            }
+            send_reply(connection->fd, status, out, diagnostics);
+        }
+        if (out)
+            close_sink(out);
+        if (diagnostics)
+            close_sink(diagnostics);
+
+        // wake the accept loop so it notices the stop
+        if (request.stop)
+        {
+            int fd = connect_socket(server->socket_path);
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+    free_request(&request);
+    close(connection->fd);
+    free(connection);
+}
+
+int run_server(const char *socket_path)
+{
+    struct sockaddr_un address;
+    if (fill_address(&address, socket_path) != 0)
+    {
+        fprintf(stderr, "Error: Socket path '%s' is too long\n", socket_path);
+        return 1;
+    }
+
+    if (check_socket_directory(socket_path, 1) != 0)
+    {
+        fprintf(stderr, "Error: The directory of '%s' is missing or open to other users\n", socket_path);
+        return 1;
+    }
+    // refuse to take over a live server's socket, but clear a stale one
+    int probe = connect_socket(socket_path);
+    if (probe < 0 && errno == EPERM)
+    {
+        fprintf(stderr, "Error: '%s' belongs to another user\n", socket_path);
+        return 1;
+    }
+    if (probe >= 0)
+    {
+        close(probe);
+        fprintf(stderr, "Error: A server is already listening on '%s'\n", socket_path);
+        return 1;
+    }
+    unlink(socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        fprintf(stderr, "Error: Cannot create socket\n");
+        return 1;
+    }
+    // only the owner may connect: requests can write files and run code as this user
+    mode_t old_mask = umask(077);
+    int bound = bind(listen_fd, (struct sockaddr *)&address, sizeof(address));
+    umask(old_mask);
+    if (bound != 0 || listen(listen_fd, 64) != 0)
+    {
+        fprintf(stderr, "Error: Cannot listen on '%s'\n", socket_path);
+        close(listen_fd);
+        return 1;
+    }
+
+    // a client hanging up early must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    ThreadPool *pool = create_thread_pool(cpus > 0 ? (int)cpus : 1);
+    if (!pool)
+    {
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.socket_path = socket_path;
+    pthread_mutex_init(&server.lock, NULL);
+    if (pthread_key_create(&server.arena, free_worker_arena) != 0)
+    {
+        free_thread_pool(pool);
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    for (;;)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        // the socket's mode keeps others out, but not on systems that ignore it
+        if (!same_user(fd))
+        {
+            close(fd);
+            continue;
+        }
+        // a read or write that stalls fails, and the worker drops the client
+        struct timeval timeout = {SERVER_CLIENT_TIMEOUT, 0};
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        pthread_mutex_lock(&server.lock);
+        int stopping = server.stopping;
+        pthread_mutex_unlock(&server.lock);
+        if (stopping)
+        {
+            close(fd);
+            break;
+        }
+
+        Connection *connection = malloc(sizeof(Connection));
+        if (!connection)
+        {
+            close(fd);
+            continue;
+        }
+        connection->server = &server;
+        connection->fd = fd;
+        if (thread_pool_submit(pool, handle_connection, connection) != 0)
+        {
+            close(fd);
+            free(connection);
+        }
+    }
+
+    // requests already accepted still get their replies; the workers' arenas go as they exit
+    free_thread_pool(pool);
+    pthread_key_delete(server.arena);
+    trim_server_caches(&server, 1);
+    for (int i = 0; i < server.cache_count; i++)
+    {
+        close_cache(server.caches[i].cache);
+        free(server.caches[i].directory);
+    }
+    free(server.caches);
+    pthread_mutex_destroy(&server.lock);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
+
+// read the reply, replaying stdout and stderr, returns the exit status or -1
+static int read_reply(int fd)
+{
+    int status = -1;
+    for (;;)
+    {
+        uint32_t type, length;
+        char *data;
+        if (read_frame(fd, &type, &data, &length) != 0)
+            return -1;
+
+        if (type == FRAME_END)
+        {
+            free(data);
+            return status;
+        }
+        if (type == FRAME_STATUS && length == 4)
+            status = (int)get_u32((unsigned char *)data);
+        else if (type == FRAME_OUT)
+            write_full(STDOUT_FILENO, data, length);
+        else if (type == FRAME_ERR)
+            write_full(STDERR_FILENO, data, length);
+        free(data);
+    }
+}
+
+// whether "-" is one of the inputs, rather than an -o argument; bad usage is left to the server
+static int reads_stdin(int argc, char *argv[])
+{
+    CompileOptions options;
+    init_compile_options(&options);
+    OutputSink *quiet = create_memory_sink();
+    int found = 0;
+    if (quiet && parse_options(argc, argv, &options, quiet) == 0)
+    {
+        for (int i = 0; i < options.input_count; i++)
+        {
+            found |= strcmp(options.input_paths[i], "-") == 0;
+        }
+    }
+    if (quiet)
+        close_sink(quiet);
+    free_compile_options(&options);
+    return found;
+}
+
+// connect_socket, refusing a socket another user could have put in place: -1 when no
+// server answers, -2 (reported) when one is refused
+static int connect_server(const char *socket_path)
+{
+    if (check_socket_directory(socket_path, 0) != 0)
+    {
+        if (errno != EPERM)
+            return -1;
+        fprintf(stderr, "Error: The directory of '%s' is open to other users\n", socket_path);
+        return -2;
+    }
+    int fd = connect_socket(socket_path);
+    if (fd < 0 && errno == EPERM)
+    {
+        fprintf(stderr, "Error: '%s' belongs to another user\n", socket_path);
+        return -2;
+    }
+    return fd;
+}
+
+int run_client(const char *socket_path, int argc, char *argv[])
+{
+    int fd = connect_server(socket_path);
+    if (fd < 0)
+        return fd == -2 ? 1 : -1;
+
+    char cwd[4096];
+    int result = 0;
+    if (getcwd(cwd, sizeof(cwd)))
+        result = write_frame(fd, FRAME_CWD, cwd, (uint32_t)strlen(cwd));
+    for (int i = 1; i < argc && result == 0; i++)
+    {
+        result = write_frame(fd, FRAME_ARG, argv[i], (uint32_t)strlen(argv[i]));
+    }
+    // the server cannot see this process's stdin, so an input of "-" travels as source text
+    if (result == 0 && reads_stdin(argc, argv))
+    {
+        char *source = read_file("-");
+        result = source ? write_frame(fd, FRAME_SOURCE, source, (uint32_t)strlen(source)) : -1;
+        sl_free(source);
+    }
+    if (result == 0)
+        result = write_frame(fd, FRAME_END, NULL, 0);
+
+    int status = result == 0 ? read_reply(fd) : -1;
+    close(fd);
+    if (status < 0)
+    {
+        // the request may already have run, so do not silently compile again
+        fprintf(stderr, "Error: Lost connection to the compile server\n");
+        return 1;
+    }
+    return status;
+}
+
+int stop_server(const char *socket_path)
+{
+    int fd = connect_server(socket_path);
+    if (fd < 0)
+        return -1;
+    int result = write_frame(fd, FRAME_STOP, NULL, 0);
+    if (result == 0)
+        result = write_frame(fd, FRAME_END, NULL, 0);
+    if (result == 0)
+        result = read_reply(fd) == 0 ? 0 : -1;
+    close(fd);
+    return result;
+}
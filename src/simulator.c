@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/simulator.h"
+
+// fetch is two cycles per byte, the rest is execution
+static const int cycle_table[OP_COUNT] = {
+    [OP_LDI] = 5,  // 2 bytes + load
+    [OP_LDA] = 8,  // 3 bytes + memory read
+    [OP_STA] = 8,  // 3 bytes + memory write
+    [OP_PUSH] = 4, // 1 byte + sp decrement + write
+    [OP_POP] = 4,  // 1 byte + read + sp increment
+    [OP_MOV] = 3,
+    [OP_ADD] = 3,
+    [OP_SUB] = 3,
+    [OP_ADC] = 3,
+    [OP_SBC] = 3,
+    [OP_CMP] = 3,
+    [OP_SHL] = 3,
+    [OP_SHR] = 3,
+    [OP_JMP] = 8,  // 3 bytes + pc load, taken or not
+    [OP_JZ] = 8,
+    [OP_JNZ] = 8,
+    [OP_JNC] = 8,
+    [OP_CALL] = 12, // 3 bytes + two stack writes + pc load
+    [OP_RET] = 8,   // 1 byte + two stack reads + pc load
+    [OP_HLT] = 2,
+};
+
+int opcode_cycles(Opcode opcode)
+{
+    if (opcode >= OP_COUNT)
+        return 0;
+    return cycle_table[opcode];
+}
+
+static void simulator_error(Simulator *sim, const char *message)
+{
+    sim->has_error = 1;
+    snprintf(sim->error_message, sizeof(sim->error_message),
+             "Simulation error at pc 0x%04X: %s", sim->pc, message);
+}
+
+Simulator *create_simulator(const ProgramImage *image)
+{
+    Simulator *sim = calloc(1, sizeof(Simulator));
+    if (!sim)
+        return NULL;
+
+    memcpy(sim->memory, image->bytes, image->size);
+    sim->sp = SIM_MEMORY_SIZE;
+    sim->stack_limit = image->size;
+    return sim;
+}
+
+void free_simulator(Simulator *sim)
+{
+    free(sim);
+}
+
+static int fetch_address(Simulator *sim)
+{
+    return sim->memory[(sim->pc + 1) & 0xFFFF] | (sim->memory[(sim->pc + 2) & 0xFFFF] << 8);
+}
+
+// turn an encoded byte back into the instruction it stands for
+static int decode_opcode(unsigned char byte)
+{
+    if ((byte & 0xC0) == ENC_MOV)
+        return OP_MOV;
+    switch (byte & 0xF8)
+    {
+    case ENC_LDI:
+        return OP_LDI;
+    case ENC_PUSH:
+        return OP_PUSH;
+    case ENC_POP:
+        return OP_POP;
+    }
+    switch (byte)
+    {
+    case ENC_HLT:
+        return OP_HLT;
+    case ENC_RET:
+        return OP_RET;
+    case ENC_LDA:
+        return OP_LDA;
+    case ENC_STA:
+        return OP_STA;
+    case ENC_JMP:
+        return OP_JMP;
+    case ENC_JZ:
+        return OP_JZ;
+    case ENC_JNZ:
+        return OP_JNZ;
+    case ENC_JNC:
+        return OP_JNC;
+    case ENC_CALL:
+        return OP_CALL;
+    case ENC_ADD:
+        return OP_ADD;
+    case ENC_SUB:
+        return OP_SUB;
+    case ENC_CMP:
+        return OP_CMP;
+    case ENC_SHL:
+        return OP_SHL;
+    case ENC_SHR:
+        return OP_SHR;
+    case ENC_ADC:
+        return OP_ADC;
+    case ENC_SBC:
+        return OP_SBC;
+    }
+    return -1;
+}
+
+static void set_flags(Simulator *sim, int result)
+{
+    sim->zero_flag = (result & 0xFF) == 0;
+    sim->carry_flag = result < 0 || result > 0xFF;
+}
+
+int step_simulator(Simulator *sim)
+{
+    if (sim->halted || sim->has_error)
+        return 1;
+
+    unsigned char byte = sim->memory[sim->pc];
+    int opcode = decode_opcode(byte);
+    if (opcode < 0)
+    {
+        simulator_error(sim, "invalid opcode");
+        return 1;
+    }
+
+    unsigned char *a = &sim->registers[REG_A];
+    unsigned char b = sim->registers[REG_B];
+    int reg = byte & 7;
+    int length = 1;
+    int depth, address, carry;
+
+    switch (opcode)
+    {
+    case OP_LDI:
+        if (reg >= SIM_REGISTER_COUNT)
+        {
+            simulator_error(sim, "invalid register");
+            return 1;
+        }
+        sim->registers[reg] = sim->memory[(sim->pc + 1) & 0xFFFF];
+        length = 2;
+        break;
+    case OP_LDA:
+        *a = sim->memory[fetch_address(sim)];
+        length = 3;
+        break;
+    case OP_STA:
+        sim->memory[fetch_address(sim)] = *a;
+        length = 3;
+        break;
+    case OP_PUSH:
+        if (sim->sp - 1 < sim->stack_limit)
+        {
+            simulator_error(sim, "stack overflow");
+            return 1;
+        }
+        sim->memory[--sim->sp] = sim->registers[reg];
+        depth = SIM_MEMORY_SIZE - sim->sp;
+        if (depth > sim->max_stack_depth)
+            sim->max_stack_depth = depth;
+        break;
+    case OP_POP:
+        if (sim->sp >= SIM_MEMORY_SIZE)
+        {
+            simulator_error(sim, "stack underflow");
+            return 1;
+        }
+        sim->registers[reg] = sim->memory[sim->sp++];
+        break;
+    case OP_MOV:
+        if (((byte >> 3) & 7) >= SIM_REGISTER_COUNT || reg >= SIM_REGISTER_COUNT)
+        {
+            simulator_error(sim, "invalid register");
+            return 1;
+        }
+        sim->registers[(byte >> 3) & 7] = sim->registers[reg];
+        break;
+    case OP_ADD:
+        set_flags(sim, *a + b);
+        *a = (unsigned char)(*a + b);
+        break;
+    case OP_SUB:
+        set_flags(sim, *a - b);
+        *a = (unsigned char)(*a - b);
+        break;
+    case OP_ADC:
+        carry = sim->carry_flag;
+        set_flags(sim, *a + b + carry);
+        *a = (unsigned char)(*a + b + carry);
+        break;
+    case OP_SBC:
+        carry = sim->carry_flag;
+        set_flags(sim, *a - b - carry);
+        *a = (unsigned char)(*a - b - carry);
+        break;
+    case OP_CMP:
+        set_flags(sim, *a - b);
+        break;
+    case OP_SHL:
+        sim->carry_flag = *a >> 7;
+        *a = (unsigned char)(*a << 1);
+        sim->zero_flag = *a == 0;
+        break;
+    case OP_SHR:
+        sim->carry_flag = *a & 1;
+        *a = *a >> 1;
+        sim->zero_flag = *a == 0;
+        break;
+    case OP_JMP:
+    case OP_JZ:
+    case OP_JNZ:
+        length = 3;
+        if (opcode == OP_JMP || sim->zero_flag == (opcode == OP_JZ))
+        {
+            sim->pc = fetch_address(sim);
+            length = 0;
+        }
+        break;
+    case OP_JNC:
+        length = 3;
+        if (!sim->carry_flag)
+        {
+            sim->pc = fetch_address(sim);
+            length = 0;
+        }
+        break;
+    case OP_CALL:
+        if (sim->sp - 2 < sim->stack_limit)
+        {
+            simulator_error(sim, "stack overflow");
+            return 1;
+        }
+        address = (sim->pc + 3) & 0xFFFF;
+        sim->memory[--sim->sp] = (unsigned char)(address >> 8);
+        sim->memory[--sim->sp] = (unsigned char)(address & 0xFF);
+        depth = SIM_MEMORY_SIZE - sim->sp;
+        if (depth > sim->max_stack_depth)
+            sim->max_stack_depth = depth;
+        sim->pc = fetch_address(sim);
+        length = 0;
+        break;
+    case OP_RET:
+        if (sim->sp + 2 > SIM_MEMORY_SIZE)
+        {
+            simulator_error(sim, "stack underflow");
+            return 1;
+        }
+        address = sim->memory[sim->sp] | sim->memory[sim->sp + 1] << 8;
+        sim->sp += 2;
+        sim->pc = address;
+        length = 0;
+        break;
+    case OP_HLT:
+        sim->halted = 1;
+        break;
+    }
+
+    sim->pc = (sim->pc + length) & 0xFFFF;
+    sim->cycles += cycle_table[opcode];
+    sim->instructions_executed++;
+    sim->opcode_counts[opcode]++;
+    return sim->halted;
+}
+
+int run_simulator(Simulator *sim, long long max_cycles)
+{
+    while (!sim->halted && !sim->has_error)
+    {
+        if (max_cycles > 0 && sim->cycles >= max_cycles)
+        {
+            simulator_error(sim, "cycle limit reached");
+            break;
+        }
+        step_simulator(sim);
+    }
+    return sim->halted && !sim->has_error ? 0 : 1;
+}
+
+int read_variable(const Simulator *sim, const ProgramImage *image, int symbol_id)
+{
+    if (symbol_id < 0 || symbol_id >= image->symbol_count)
+        return 0;
+    int address = image->symbol_address[symbol_id];
+    if (image->symbol_size[symbol_id] == 1)
+        return sim->memory[address];
+    // two bytes hold a signed 16-bit int
+    int value = sim->memory[address] | sim->memory[(address + 1) & 0xFFFF] << 8;
+    return value >= 0x8000 ? value - 0x10000 : value;
+}
+
+void write_simulation_report(OutputSink *sink, const Simulator *sim, const SymbolTable *symbols, const ProgramImage *image)
+{
+    sink_printf(sink, "Simulation %s\n", sim->has_error ? "FAILED" : "finished");
+    if (sim->has_error)
+        sink_printf(sink, "Error: %s\n", sim->error_message);
+
+    sink_printf(sink, "\nVariables:\n");
+    int data_bytes = 0;
+    for (int i = 0; i < symbols->count; i++)
+    {
+        data_bytes += image->symbol_size[i];
+        if (strcmp(symbol_name(symbols, i), RUNTIME_RETURN_SLOT) == 0)
+            continue;
+        // a block local whose slot was reused no longer holds its value
+        if (image->symbol_dead && image->symbol_dead[i])
+            sink_printf(sink, "  %-16s    -\n", symbol_name(symbols, i));
+        else
+            sink_printf(sink, "  %-16s %4d\n", symbol_name(symbols, i), read_variable(sim, image, i));
+    }
+
+    sink_printf(sink, "\nTotal cycles:          %lld\n", sim->cycles);
+    sink_printf(sink, "Instructions executed: %lld\n", sim->instructions_executed);
+    sink_printf(sink, "Max stack depth:       %d bytes\n", sim->max_stack_depth);
+    sink_printf(sink, "Data size:             %d bytes", image->size - image->text_size);
+    if (data_bytes > image->size - image->text_size)
+        sink_printf(sink, " (%d saved by sharing slots)", data_bytes - (image->size - image->text_size));
+    sink_puts(sink, "\n");
+
+    sink_printf(sink, "\nInstruction counts:\n");
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        if (sim->opcode_counts[op] == 0)
+            continue;
+        sink_printf(sink, "  %-6s %8lld  (%lld cycles)\n", opcode_name((Opcode)op),
+                sim->opcode_counts[op], sim->opcode_counts[op] * cycle_table[op]);
+    }
+}
@@ -0,0 +1,382 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/slots.h"
+#include "../include/allocator.h"
+
+// 64-bit words of each liveness bitset times the blocks: past this the program keeps
+// one slot per variable rather than spend the memory
+#define LIVENESS_WORDS_MAX (1 << 22)
+
+typedef struct
+{
+    int start; // first instruction
+    int end;   // one past the last
+    int successors[2]; // -1 when absent
+} Block;
+
+typedef struct
+{
+    int start;
+    int end;
+    int symbol;
+} Interval;
+
+static int is_branch(int opcode)
+{
+    return opcode == OP_JMP || opcode == OP_JZ || opcode == OP_JNZ || opcode == OP_JNC;
+}
+
+// no instruction after it runs next: a new block starts
+static int ends_block(int opcode)
+{
+    return is_branch(opcode) || opcode == OP_RET || opcode == OP_HLT;
+}
+
+// byte of a slot an lda or sta reaches, two per symbol
+static int memory_cell(const Instruction *inst)
+{
+    int offset = inst->operand_kind[1] == OPERAND_IMMEDIATE ? inst->operand[1] : 0;
+    return inst->operand[0] * 2 + offset;
+}
+
+static void set_bit(uint64_t *bits, int bit)
+{
+    bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+static void clear_bit(uint64_t *bits, int bit)
+{
+    bits[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+}
+
+// Mark the variables declared somewhere inside an if or while body and named nowhere
+// outside one; -1 when out of memory
+static int find_locals(ASTNode *program, const SymbolTable *symbols, unsigned char *local)
+{
+    unsigned char *outside = sl_calloc(symbols->count + 1, 1);
+    if (!outside)
+        return -1;
+
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, program, 0);
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)))
+    {
+        ASTNode *node = frame->node;
+        int inside = frame->value;
+        int step = frame->step++;
+        if (step == 0)
+        {
+            const char *name = NULL;
+            if (node->type == AST_IDENTIFIER)
+                name = node->data.identifier.name;
+            else if (node->type == AST_DECLARATION)
+                name = node->data.declaration.var_name;
+            else if (node->type == AST_ASSIGNMENT)
+                name = node->data.assignment.var_name;
+            int id = name ? find_symbol(symbols, name) : -1;
+            if (id >= 0 && !inside)
+                outside[id] = 1;
+            else if (id >= 0 && node->type == AST_DECLARATION)
+                local[id] = 1;
+        }
+        if (step < ast_child_count(node))
+        {
+            // the condition belongs where the statement is, the blocks are inside
+            int body = (node->type == AST_IF_STATEMENT || node->type == AST_WHILE_STATEMENT) && step > 0;
+            ast_walk_push(&walk, ast_child(node, step), inside || body);
+        }
+        else
+        {
+            ast_walk_pop(&walk);
+        }
+    }
+    int failed = walk.failed;
+    free_ast_walk(&walk);
+
+    for (int i = 0; i < symbols->count; i++)
+    {
+        local[i] = local[i] && !outside[i];
+    }
+    sl_free(outside);
+    return failed ? -1 : 0;
+}
+
+// The basic blocks of instructions 0..end-1, with their successors. NULL when out of memory
+static Block *find_blocks(const CodeGenerator *gen, int end, int *count)
+{
+    int *label_block = sl_malloc(sizeof(int) * (gen->label_count + 1));
+    Block *blocks = sl_malloc(sizeof(Block) * (end + 1));
+    if (!label_block || !blocks)
+    {
+        sl_free(label_block);
+        sl_free(blocks);
+        return NULL;
+    }
+    for (int i = 0; i < gen->label_count; i++)
+    {
+        label_block[i] = -1;
+    }
+
+    int n = 0;
+    for (int i = 0; i < end; i++)
+    {
+        const Instruction *inst = &gen->instructions[i];
+        if (i == 0 || inst->opcode == OP_LABEL || ends_block(gen->instructions[i - 1].opcode))
+        {
+            blocks[n].start = i;
+            n++;
+        }
+        blocks[n - 1].end = i + 1;
+        if (inst->opcode == OP_LABEL)
+            label_block[inst->operand[0]] = n - 1;
+    }
+
+    for (int b = 0; b < n; b++)
+    {
+        const Instruction *last = &gen->instructions[blocks[b].end - 1];
+        int next = b + 1 < n ? b + 1 : -1;
+        // a jmp past the hlt enters a runtime routine, which comes back to the next block
+        int leaves = last->opcode == OP_JMP && label_block[last->operand[0]] >= 0;
+        blocks[b].successors[0] = leaves || last->opcode == OP_RET || last->opcode == OP_HLT ? -1 : next;
+        blocks[b].successors[1] = is_branch(last->opcode) ? label_block[last->operand[0]] : -1;
+    }
+    sl_free(label_block);
+    *count = n;
+    return blocks;
+}
+
+static int compare_starts(const void *a, const void *b)
+{
+    const Interval *x = a, *y = b;
+    if (x->start != y->start)
+        return x->start < y->start ? -1 : 1;
+    return x->symbol - y->symbol;
+}
+
+static int compare_ends(const void *a, const void *b)
+{
+    const Interval *x = a, *y = b;
+    if (x->end != y->end)
+        return x->end < y->end ? -1 : 1;
+    return x->symbol - y->symbol;
+}
+
+// Interval coloring: in order of their start, each variable takes a slot of its size
+// that every earlier variable has finished with, or opens a new one
+static int color_intervals(CodeGenerator *gen, Interval *by_start, int count)
+{
+    Interval *by_end = sl_malloc(sizeof(Interval) * (count + 1));
+    int *free_slots = sl_malloc(sizeof(int) * (count + 1) * 2); // a stack per slot size
+    if (!by_end || !free_slots)
+    {
+        sl_free(by_end);
+        sl_free(free_slots);
+        return -1;
+    }
+    memcpy(by_end, by_start, sizeof(Interval) * count);
+    qsort(by_start, count, sizeof(Interval), compare_starts);
+    qsort(by_end, count, sizeof(Interval), compare_ends);
+
+    int free_count[2] = {0, 0};
+    int done = 0;
+    for (int i = 0; i < count; i++)
+    {
+        while (done < count && by_end[done].end < by_start[i].start)
+        {
+            int symbol = by_end[done++].symbol;
+            int size = symbol_size(gen, symbol) - 1;
+            free_slots[size * (count + 1) + free_count[size]++] = gen->data_slot[symbol];
+        }
+        int symbol = by_start[i].symbol;
+        int size = symbol_size(gen, symbol) - 1;
+        gen->data_slot[symbol] = free_count[size] > 0 ? free_slots[size * (count + 1) + --free_count[size]] : symbol;
+    }
+    sl_free(by_end);
+    sl_free(free_slots);
+    return 0;
+}
+
+int share_data_slots(CodeGenerator *gen, ASTNode *program)
+{
+    int symbols = gen->symbols.count;
+    int cells = symbols * 2;
+    int words = (cells + 63) / 64;
+
+    // the program proper ends at its hlt, the runtime routines after it touch no data
+    int end = 0;
+    while (end < gen->count && gen->instructions[end].opcode != OP_HLT)
+        end++;
+    if (symbols == 0 || end == gen->count)
+        return 0;
+    end++;
+
+    gen->data_slot = sl_malloc(sizeof(int) * symbols);
+    gen->dead_at_exit = sl_calloc(symbols, 1);
+    if (!gen->data_slot || !gen->dead_at_exit)
+        return -1;
+    for (int i = 0; i < symbols; i++)
+    {
+        gen->data_slot[i] = i;
+    }
+
+    int block_count;
+    Block *blocks = find_blocks(gen, end, &block_count);
+    if (!blocks)
+        return -1;
+    if ((long long)block_count * words * 4 > LIVENESS_WORDS_MAX)
+    {
+        sl_free(blocks);
+        return 0;
+    }
+
+    unsigned char *local = gen->dead_at_exit;
+    uint64_t *bits = sl_calloc((size_t)block_count * words * 4 + 1, sizeof(uint64_t));
+    uint64_t *outputs = sl_calloc(words + 1, sizeof(uint64_t));
+    Interval *intervals = sl_malloc(sizeof(Interval) * (symbols + 1));
+    if (!bits || !outputs || !intervals || find_locals(program, &gen->symbols, local) != 0)
+    {
+        sl_free(bits);
+        sl_free(outputs);
+        sl_free(intervals);
+        sl_free(blocks);
+        return -1;
+    }
+    uint64_t *use = bits, *def = use + block_count * words;
+    uint64_t *live_in = def + block_count * words, *live_out = live_in + block_count * words;
+
+    // the hlt reads what the program computed: every byte of every variable but the locals
+    for (int i = 0; i < symbols; i++)
+    {
+        if (local[i])
+            continue;
+        set_bit(outputs, i * 2);
+        if (symbol_size(gen, i) == 2)
+            set_bit(outputs, i * 2 + 1);
+    }
+
+    // what each block reads before storing it, and what it stores
+    for (int b = 0; b < block_count; b++)
+    {
+        uint64_t *block_use = use + b * words, *block_def = def + b * words;
+        for (int i = blocks[b].end - 1; i >= blocks[b].start; i--)
+        {
+            const Instruction *inst = &gen->instructions[i];
+            if (inst->opcode == OP_STA)
+            {
+                set_bit(block_def, memory_cell(inst));
+                clear_bit(block_use, memory_cell(inst));
+            }
+            else if (inst->opcode == OP_LDA)
+            {
+                set_bit(block_use, memory_cell(inst));
+            }
+            else if (inst->opcode == OP_HLT)
+            {
+                for (int w = 0; w < words; w++)
+                    block_use[w] |= outputs[w];
+            }
+        }
+    }
+
+    // live_out is what the successors need, live_in adds what the block reads
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int b = block_count - 1; b >= 0; b--)
+        {
+            uint64_t *out = live_out + b * words, *in = live_in + b * words;
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t needed = 0;
+                for (int s = 0; s < 2; s++)
+                {
+                    if (blocks[b].successors[s] >= 0)
+                        needed |= live_in[blocks[b].successors[s] * words + w];
+                }
+                uint64_t live = use[b * words + w] | (needed & ~def[b * words + w]);
+                changed |= needed != out[w] || live != in[w];
+                out[w] = needed;
+                in[w] = live;
+            }
+        }
+    }
+
+    // each variable's interval spans every point where one of its bytes is live or used
+    for (int i = 0; i < symbols; i++)
+    {
+        intervals[i].start = end;
+        intervals[i].end = -1;
+        intervals[i].symbol = i;
+    }
+    for (int b = 0; b < block_count; b++)
+    {
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t in = live_in[b * words + w], out = live_out[b * words + w];
+            for (int bit = 0; bit < 64 && (in | out) >> bit; bit++)
+            {
+                Interval *interval = &intervals[(w * 64 + bit) / 2];
+                if ((in >> bit) & 1 && blocks[b].start < interval->start)
+                    interval->start = blocks[b].start;
+                if ((out >> bit) & 1 && blocks[b].end - 1 > interval->end)
+                    interval->end = blocks[b].end - 1;
+            }
+        }
+        for (int i = blocks[b].start; i < blocks[b].end; i++)
+        {
+            const Instruction *inst = &gen->instructions[i];
+            if (inst->opcode != OP_LDA && inst->opcode != OP_STA)
+                continue;
+            Interval *interval = &intervals[inst->operand[0]];
+            if (i < interval->start)
+                interval->start = i;
+            if (i > interval->end)
+                interval->end = i;
+        }
+    }
+    // and what the program computed lasts until the hlt
+    for (int i = 0; i < symbols; i++)
+    {
+        if (!local[i])
+            intervals[i].end = end - 1;
+    }
+    // a variable the code never touches keeps a slot of its own
+    int count = 0;
+    for (int i = 0; i < symbols; i++)
+    {
+        if (intervals[i].end >= 0)
+            intervals[count++] = intervals[i];
+    }
+    int status = color_intervals(gen, intervals, count);
+
+    // a local whose slot others use as well may not hold its own value at the end
+    int *users = sl_calloc(symbols, sizeof(int));
+    if (users)
+    {
+        for (int i = 0; i < symbols; i++)
+            users[gen->data_slot[i]]++;
+        for (int i = 0; i < symbols; i++)
+            local[i] = local[i] && users[gen->data_slot[i]] > 1;
+    }
+    sl_free(users);
+    sl_free(bits);
+    sl_free(outputs);
+    sl_free(intervals);
+    sl_free(blocks);
+    return status == 0 && users ? 0 : -1;
+}
+
+int data_bytes_saved(const CodeGenerator *gen)
+{
+    int saved = 0;
+    for (int i = 0; gen->data_slot && i < gen->symbols.count; i++)
+    {
+        if (gen->data_slot[i] != i)
+            saved += symbol_size(gen, i);
+    }
+    return saved;
+}
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/symtab.h"
+
+#define INITIAL_BUCKETS 16
+
+// FNV-1a, good enough for short identifiers
+static unsigned int hash_name(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void init_symbol_table(SymbolTable *table)
+{
+    table->names = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->buckets = NULL;
+    table->bucket_count = 0;
+}
+
+void free_symbol_table(SymbolTable *table)
+{
+    for (int i = 0; i < table->count; i++)
+    {
+        free(table->names[i]);
+    }
+    free(table->names);
+    free(table->buckets);
+    init_symbol_table(table);
+}
+
+int find_symbol(const SymbolTable *table, const char *name)
+{
+    if (table->bucket_count == 0)
+        return -1;
+
+    unsigned int mask = table->bucket_count - 1;
+    unsigned int slot = hash_name(name) & mask;
+    while (table->buckets[slot] != -1)
+    {
+        int id = table->buckets[slot];
+        if (strcmp(table->names[id], name) == 0)
+            return id;
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// rebuild the bucket array at twice the size, keeping the load factor under one half
+static int grow_buckets(SymbolTable *table)
+{
+    int new_count = table->bucket_count ? table->bucket_count * 2 : INITIAL_BUCKETS;
+    int *buckets = malloc(sizeof(int) * new_count);
+    if (!buckets)
+        return 0;
+    for (int i = 0; i < new_count; i++)
+    {
+        buckets[i] = -1;
+    }
+
+    unsigned int mask = new_count - 1;
+    for (int id = 0; id < table->count; id++)
+    {
+        unsigned int slot = hash_name(table->names[id]) & mask;
+        while (buckets[slot] != -1)
+        {
+            slot = (slot + 1) & mask;
+        }
+        buckets[slot] = id;
+    }
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = new_count;
+    return 1;
+}
+
+int intern_symbol(SymbolTable *table, const char *name)
+{
+    int id = find_symbol(table, name);
+    if (id >= 0)
+        return id;
+
+    if ((table->count + 1) * 2 > table->bucket_count && !grow_buckets(table))
+        return -1;
+
+    if (table->count >= table->capacity)
+    {
+        int new_capacity = table->capacity ? table->capacity * 2 : 16;
+        char **names = realloc(table->names, sizeof(char *) * new_capacity);
+        if (!names)
+            return -1;
+        table->names = names;
+        table->capacity = new_capacity;
+    }
+
+    char *copy = malloc(strlen(name) + 1);
+    if (!copy)
+        return -1;
+    strcpy(copy, name);
+
+    id = table->count++;
+    table->names[id] = copy;
+
+    unsigned int mask = table->bucket_count - 1;
+    unsigned int slot = hash_name(name) & mask;
+    while (table->buckets[slot] != -1)
+    {
+        slot = (slot + 1) & mask;
+    }
+    table->buckets[slot] = id;
+    return id;
+}
+
+const char *symbol_name(const SymbolTable *table, int id)
+{
+    if (id < 0 || id >= table->count)
+        return NULL;
+    return table->names[id];
+}
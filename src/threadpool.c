@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/threadpool.h"
+
+typedef struct
+{
+    ThreadPool *pool;
+    int index;
+} WorkerStart;
+
+static int push_bottom(WorkQueue *queue, Task task)
+{
+    pthread_mutex_lock(&queue->lock);
+    if (queue->bottom == queue->capacity)
+    {
+        if (queue->top > 0)
+        {
+            // slide the live tasks back to the start before growing
+            memmove(queue->tasks, queue->tasks + queue->top, sizeof(Task) * (queue->bottom - queue->top));
+            queue->bottom -= queue->top;
+            queue->top = 0;
+        }
+        else
+        {
+            int capacity = queue->capacity ? queue->capacity * 2 : 64;
+            Task *tasks = realloc(queue->tasks, sizeof(Task) * capacity);
+            if (!tasks)
+            {
+                pthread_mutex_unlock(&queue->lock);
+                return -1;
+            }
+            queue->tasks = tasks;
+            queue->capacity = capacity;
+        }
+    }
+    queue->tasks[queue->bottom++] = task;
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+static int pop_bottom(WorkQueue *queue, Task *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->bottom > queue->top)
+    {
+        *task = queue->tasks[--queue->bottom];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static int steal_top(WorkQueue *queue, Task *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->bottom > queue->top)
+    {
+        *task = queue->tasks[queue->top++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+// own deque first, then every other worker's, starting with the next one along
+static int take_task(ThreadPool *pool, int index, Task *task)
+{
+    if (pop_bottom(&pool->queues[index], task))
+        return 1;
+    for (int i = 1; i < pool->thread_count; i++)
+    {
+        if (steal_top(&pool->queues[(index + i) % pool->thread_count], task))
+            return 1;
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg)
+{
+    WorkerStart start = *(WorkerStart *)arg;
+    ThreadPool *pool = start.pool;
+    free(arg);
+
+    for (;;)
+    {
+        Task task;
+        if (take_task(pool, start.index, &task))
+        {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            task.function(task.arg);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->pending == 0)
+                pthread_cond_broadcast(&pool->all_done);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        // nothing to take anywhere: sleep until a submission or shutdown
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        int stop = pool->shutdown && pool->queued == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop)
+            break;
+    }
+    return NULL;
+}
+
+ThreadPool *create_thread_pool(int thread_count)
+{
+    if (thread_count < 1)
+        thread_count = 1;
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool)
+        return NULL;
+    pool->threads = calloc(thread_count, sizeof(pthread_t));
+    pool->queues = calloc(thread_count, sizeof(WorkQueue));
+    if (!pool->threads || !pool->queues)
+    {
+        free(pool->threads);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+    pool->thread_count = thread_count;
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    // if some workers fail to start, their deques are still emptied by stealing
+    for (int i = 0; i < thread_count; i++)
+    {
+        WorkerStart *start = malloc(sizeof(WorkerStart));
+        if (!start)
+            break;
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, start) != 0)
+        {
+            free(start);
+            break;
+        }
+        pool->started++;
+    }
+    if (pool->started == 0)
+    {
+        free_thread_pool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int thread_pool_submit(ThreadPool *pool, TaskFunction function, void *arg)
+{
+    Task task = {function, arg};
+
+    // pushed and counted under the pool lock: a worker that takes the task at once waits
+    // for the lock to uncount it, so queued never drops below zero (workers never hold a
+    // deque's lock while taking the pool's)
+    pthread_mutex_lock(&pool->lock);
+    int index = pool->next_queue;
+    if (push_bottom(&pool->queues[index], task) != 0)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+    pool->next_queue = (pool->next_queue + 1) % pool->thread_count;
+    pool->pending++;
+    pool->queued++;
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void thread_pool_wait(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+    {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void free_thread_pool(ThreadPool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->started; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->thread_count; i++)
+    {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].tasks);
+    }
+    pthread_cond_destroy(&pool->all_done);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->queues);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,112 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "../include/timing.h"
+
+static const char *phase_names[] = {"read", "lex", "parse", "fold", "analysis", "codegen", "loops", "mulchain",
+                                    "peephole", "slots", "assemble", "run", "cache", "write"};
+// what items counts for each phase, NULL where there is nothing to count
+static const char *item_units[] = {"bytes", "tokens", "nodes", NULL, NULL, "instructions", NULL, NULL,
+                                   NULL, NULL, "bytes", NULL, NULL, "bytes"};
+
+const char *timed_phase_name(TimedPhase phase)
+{
+    return phase_names[phase];
+}
+
+uint64_t monotonic_nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void record_phase(TimeReport *report, TimedPhase phase, uint64_t start, uint64_t items)
+{
+    uint64_t now = monotonic_nanoseconds();
+    add_phase_time(report, phase, now > start ? now - start : 0, items);
+}
+
+void add_phase_time(TimeReport *report, TimedPhase phase, uint64_t nanoseconds, uint64_t items)
+{
+    report->nanoseconds[phase] += nanoseconds;
+    report->items[phase] += items;
+}
+
+void merge_time_report(TimeReport *total, const TimeReport *report)
+{
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        total->nanoseconds[i] += report->nanoseconds[i];
+        total->items[i] += report->items[i];
+    }
+}
+
+static uint64_t total_nanoseconds(const TimeReport *report)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        total += report->nanoseconds[i];
+    }
+    return total;
+}
+
+static double percent_of(uint64_t part, uint64_t total)
+{
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static double per_second(uint64_t items, uint64_t nanoseconds)
+{
+    return nanoseconds ? (double)items * 1e9 / (double)nanoseconds : 0.0;
+}
+
+static void write_text_report(OutputSink *sink, const TimeReport *report, int inputs, int threads, uint64_t wall)
+{
+    uint64_t total = total_nanoseconds(report);
+    sink_printf(sink, "Time report: %d input%s on %d thread%s, %.3f ms wall\n",
+                inputs, inputs == 1 ? "" : "s", threads, threads == 1 ? "" : "s", wall / 1e6);
+    sink_printf(sink, "%-10s %12s %7s %14s %-12s %14s\n", "phase", "time (ms)", "share", "items", "", "items/s");
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        // phases that never ran would only be noise
+        if (report->nanoseconds[i] == 0 && report->items[i] == 0)
+            continue;
+        sink_printf(sink, "%-10s %12.3f %6.1f%%", phase_names[i], report->nanoseconds[i] / 1e6,
+                    percent_of(report->nanoseconds[i], total));
+        if (item_units[i])
+            sink_printf(sink, " %14llu %-12s %14.0f\n", (unsigned long long)report->items[i], item_units[i],
+                        per_second(report->items[i], report->nanoseconds[i]));
+        else
+            sink_printf(sink, "\n");
+    }
+    sink_printf(sink, "%-10s %12.3f %6.1f%%\n", "total", total / 1e6, 100.0);
+}
+
+static void write_json_report(OutputSink *sink, const TimeReport *report, int inputs, int threads, uint64_t wall)
+{
+    uint64_t total = total_nanoseconds(report);
+    sink_printf(sink, "{\"inputs\": %d, \"threads\": %d, \"wall_ns\": %llu, \"total_ns\": %llu, \"phases\": [",
+                inputs, threads, (unsigned long long)wall, (unsigned long long)total);
+    for (int i = 0; i < TIME_PHASE_COUNT; i++)
+    {
+        sink_printf(sink, "%s\n  {\"phase\": \"%s\", \"ns\": %llu, \"percent\": %.2f",
+                    i ? "," : "", phase_names[i], (unsigned long long)report->nanoseconds[i],
+                    percent_of(report->nanoseconds[i], total));
+        if (item_units[i])
+            sink_printf(sink, ", \"items\": %llu, \"unit\": \"%s\", \"items_per_second\": %.0f",
+                        (unsigned long long)report->items[i], item_units[i],
+                        per_second(report->items[i], report->nanoseconds[i]));
+        sink_printf(sink, "}");
+    }
+    sink_printf(sink, "\n]}\n");
+}
+
+void write_time_report(OutputSink *sink, const TimeReport *report, TimeFormat format,
+                       int inputs, int threads, uint64_t wall)
+{
+    if (format == TIME_FORMAT_JSON)
+        write_json_report(sink, report, inputs, threads, wall);
+    else
+        write_text_report(sink, report, inputs, threads, wall);
+}
@@ -2,10 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../include/token.h"
+#include "../include/allocator.h"
 
 Token *create_token(TokenType type, char *value, int line, int column)
 {
-    Token *token = malloc(sizeof(Token));
+    Token *token = sl_malloc(sizeof(Token));
     if (!token)
         return NULL;
     token->type = type;
@@ -13,10 +14,10 @@ Token *create_token(TokenType type, char *value, int line, int column)
     token->column = column;
     if (value)
     {
-        token->value = malloc(strlen(value) + 1);
+        token->value = sl_malloc(strlen(value) + 1);
         if (!token->value)
         {
-            free(token);
+            sl_free(token);
             return NULL;
         }
         strcpy(token->value, value);
@@ -42,12 +43,24 @@ char *token_type_to_string(TokenType type)
         return "IF";
     case TOKEN_ELSE:
         return "ELSE";
+    case TOKEN_WHILE:
+        return "WHILE";
+    case TOKEN_IMPORT:
+        return "IMPORT";
+    case TOKEN_EXTERN:
+        return "EXTERN";
     case TOKEN_ASSIGN:
         return "ASSIGN";
     case TOKEN_PLUS:
         return "PLUS";
     case TOKEN_MINUS:
         return "MINUS";
+    case TOKEN_STAR:
+        return "STAR";
+    case TOKEN_SHIFT_LEFT:
+        return "SHIFT_LEFT";
+    case TOKEN_SHIFT_RIGHT:
+        return "SHIFT_RIGHT";
     case TOKEN_EQUAL:
         return "EQUAL";
     case TOKEN_SEMICOLON:
@@ -90,8 +103,8 @@ void free_token(Token *token)
     {
         if (token->value)
         {
-            free(token->value);
+            sl_free(token->value);
         }
-        free(token);
+        sl_free(token);
     }
 }
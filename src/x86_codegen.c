@@ -0,0 +1,416 @@
+#define _GNU_SOURCE // pipe2
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/x86_codegen.h"
+#include "../include/symtab.h"
+
+// registers handed out to expression temporaries, deepest operand last;
+// r11 is kept free as scratch for spilled operands
+#define TEMP_REGISTERS 8
+static const char *reg32[TEMP_REGISTERS] = {"%eax", "%ecx", "%edx", "%esi", "%edi", "%r8d", "%r9d", "%r10d"};
+static const char *reg64[TEMP_REGISTERS] = {"%rax", "%rcx", "%rdx", "%rsi", "%rdi", "%r8", "%r9", "%r10"};
+static const char *reg8[TEMP_REGISTERS] = {"%al", "%cl", "%dl", "%sil", "%dil", "%r8b", "%r9b", "%r10b"};
+
+typedef struct
+{
+    OutputSink *sink;
+    SymbolTable symbols;
+    int label_count;
+    int has_error;
+} X86Generator;
+
+// every variable becomes sl_var_<id>, names only appear in the printed output
+static int variable(X86Generator *gen, const char *name)
+{
+    int id = intern_symbol(&gen->symbols, name);
+    if (id < 0)
+        gen->has_error = 1;
+    return id;
+}
+
+static const char *arithmetic_mnemonic(TokenType op)
+{
+    switch (op)
+    {
+    case TOKEN_PLUS:
+        return "addl";
+    case TOKEN_MINUS:
+        return "subl";
+    case TOKEN_STAR:
+        return "imull";
+    case TOKEN_SHIFT_LEFT:
+        return "shll";
+    case TOKEN_SHIFT_RIGHT:
+        return "sarl"; // keeps the sign, like the bytecode VM
+    default:
+        return "cmpl";
+    }
+}
+
+static int is_shift(TokenType op)
+{
+    return op == TOKEN_SHIFT_LEFT || op == TOKEN_SHIFT_RIGHT;
+}
+
+// dest = dest shifted by %r11d: the count has to be in %cl, so %rcx and %r11 trade places
+// around the shift (a dest of %ecx is then in %r11d)
+static void emit_shift_by_scratch(X86Generator *gen, TokenType op, int depth)
+{
+    sink_printf(gen->sink, "\txchgq %%rcx, %%r11\n");
+    sink_printf(gen->sink, "\t%s %%cl, %s\n", arithmetic_mnemonic(op), depth == 1 ? "%r11d" : reg32[depth]);
+    sink_printf(gen->sink, "\txchgq %%rcx, %%r11\n");
+}
+
+// reg[depth] = reg[depth] <op> value; a multiplier that is a power of two becomes a shift
+static void emit_operator_imm(X86Generator *gen, TokenType op, int depth, int value)
+{
+    int shift = 0;
+    while (op == TOKEN_STAR && shift < 31 && (1 << shift) < value)
+        shift++;
+    if (op == TOKEN_STAR && value > 0 && 1 << shift == value)
+        sink_printf(gen->sink, "\tshll $%d, %s\n", shift, reg32[depth]);
+    else if (is_shift(op))
+        sink_printf(gen->sink, "\t%s $%d, %s\n", arithmetic_mnemonic(op), value & 31, reg32[depth]);
+    else
+        sink_printf(gen->sink, "\t%s $%d, %s\n", arithmetic_mnemonic(op), value, reg32[depth]);
+}
+
+// added to the register depth in a frame's value: the == of an if condition leaves its
+// result in the flags for the branch instead of turning it into 0 or 1
+#define KEEP_FLAGS 0x10000
+
+static int is_equality(const ASTNode *node)
+{
+    return node->type == AST_BINARY_OP && node->data.binary_op.operator == TOKEN_EQUAL;
+}
+
+// Emit statements and expressions in one walk without recursion (see ASTWalk). An
+// expression frame's value is the depth of the register it computes into; an operator
+// computes reg[depth] = reg[depth] <op> right. An if frame's value is the label still
+// to be placed, a while's the first of its two labels (body, then condition).
+static void emit_tree(X86Generator *gen, ASTNode *root)
+{
+    ASTWalk walk;
+    init_ast_walk(&walk);
+    ast_walk_push(&walk, root, 0);
+
+    ASTFrame *frame;
+    while ((frame = ast_walk_top(&walk)) && !walk.failed)
+    {
+        ASTNode *node = frame->node;
+        int step = frame->step++;
+        int depth = frame->value & ~KEEP_FLAGS;
+        int done = 1; // the node is finished after this step
+        switch (node->type)
+        {
+        case AST_NUMBER:
+            sink_printf(gen->sink, "\tmovl $%d, %s\n", node->data.number.value, reg32[depth]);
+            break;
+
+        case AST_IDENTIFIER:
+            sink_printf(gen->sink, "\tmovl sl_var_%d(%%rip), %s\n",
+                        variable(gen, node->data.identifier.name), reg32[depth]);
+            break;
+
+        case AST_BINARY_OP:
+        {
+            TokenType op = node->data.binary_op.operator;
+            ASTNode *right = node->data.binary_op.right;
+            const char *mnemonic = arithmetic_mnemonic(op);
+            const char *dest = reg32[depth];
+            if (step == 0)
+            {
+                done = 0;
+                ast_walk_push(&walk, node->data.binary_op.left, depth);
+            }
+            else if (step == 1 && right->type == AST_NUMBER)
+            {
+                emit_operator_imm(gen, op, depth, right->data.number.value);
+            }
+            else if (step == 1 && right->type == AST_IDENTIFIER && is_shift(op))
+            {
+                sink_printf(gen->sink, "\tmovl sl_var_%d(%%rip), %%r11d\n",
+                            variable(gen, right->data.identifier.name));
+                emit_shift_by_scratch(gen, op, depth);
+            }
+            else if (step == 1 && right->type == AST_IDENTIFIER)
+            {
+                sink_printf(gen->sink, "\t%s sl_var_%d(%%rip), %s\n", mnemonic,
+                            variable(gen, right->data.identifier.name), dest);
+            }
+            else if (step == 1 && depth + 1 < TEMP_REGISTERS)
+            {
+                done = 0;
+                ast_walk_push(&walk, right, depth + 1);
+            }
+            else if (step == 1)
+            {
+                // out of registers: keep the left value on the stack while the right is computed
+                done = 0;
+                frame->step = 3;
+                sink_printf(gen->sink, "\tpushq %s\n", reg64[depth]);
+                ast_walk_push(&walk, right, depth);
+            }
+            else if (step == 2 && is_shift(op))
+            {
+                sink_printf(gen->sink, "\tmovl %s, %%r11d\n", reg32[depth + 1]);
+                emit_shift_by_scratch(gen, op, depth);
+            }
+            else if (step == 2)
+            {
+                sink_printf(gen->sink, "\t%s %s, %s\n", mnemonic, reg32[depth + 1], dest);
+            }
+            else
+            {
+                sink_printf(gen->sink, "\tmovl %s, %%r11d\n", dest);
+                sink_printf(gen->sink, "\tpopq %s\n", reg64[depth]);
+                if (is_shift(op))
+                    emit_shift_by_scratch(gen, op, depth);
+                else
+                    sink_printf(gen->sink, "\t%s %%r11d, %s\n", mnemonic, dest);
+            }
+            if (done && op == TOKEN_EQUAL && !(frame->value & KEEP_FLAGS))
+            {
+                sink_printf(gen->sink, "\tsete %s\n", reg8[depth]);
+                sink_printf(gen->sink, "\tmovzbl %s, %s\n", reg8[depth], dest);
+            }
+            break;
+        }
+
+        case AST_DECLARATION:
+            if (step == 0)
+            {
+                variable(gen, node->data.declaration.var_name);
+                done = !node->data.declaration.init_value;
+                ast_walk_push(&walk, node->data.declaration.init_value, 0);
+            }
+            else
+            {
+                sink_printf(gen->sink, "\tmovl %%eax, sl_var_%d(%%rip)\n",
+                            variable(gen, node->data.declaration.var_name));
+            }
+            break;
+
+        case AST_ASSIGNMENT:
+            if (step == 0)
+            {
+                done = 0;
+                ast_walk_push(&walk, node->data.assignment.value, 0);
+            }
+            else
+            {
+                sink_printf(gen->sink, "\tmovl %%eax, sl_var_%d(%%rip)\n",
+                            variable(gen, node->data.assignment.var_name));
+            }
+            break;
+
+        case AST_IF_STATEMENT:
+            done = 0;
+            if (step == 0)
+            {
+                // a top level == compares and branches directly
+                frame->value = gen->label_count++;
+                ASTNode *condition = node->data.if_stmt.condition;
+                ast_walk_push(&walk, condition, is_equality(condition) ? KEEP_FLAGS : 0);
+            }
+            else if (step == 1)
+            {
+                // jump to the else label when the condition is false
+                if (is_equality(node->data.if_stmt.condition))
+                {
+                    sink_printf(gen->sink, "\tjne .L%d\n", frame->value);
+                }
+                else
+                {
+                    sink_printf(gen->sink, "\ttestl %%eax, %%eax\n");
+                    sink_printf(gen->sink, "\tje .L%d\n", frame->value);
+                }
+                ast_walk_push(&walk, node->data.if_stmt.then_block, 0);
+            }
+            else if (step == 2 && node->data.if_stmt.else_block)
+            {
+                int end_label = gen->label_count++;
+                sink_printf(gen->sink, "\tjmp .L%d\n", end_label);
+                sink_printf(gen->sink, ".L%d:\n", frame->value);
+                frame->value = end_label;
+                ast_walk_push(&walk, node->data.if_stmt.else_block, 0);
+            }
+            else
+            {
+                // past the then block with no else, or past the else block
+                sink_printf(gen->sink, ".L%d:\n", frame->value);
+                done = 1;
+            }
+            break;
+
+        // jmp to the condition, which sits after the body and branches back to it
+        case AST_WHILE_STATEMENT:
+        {
+            ASTNode *condition = node->data.while_stmt.condition;
+            done = step == 2;
+            if (step == 0)
+            {
+                frame->value = gen->label_count;
+                gen->label_count += 2;
+                sink_printf(gen->sink, "\tjmp .L%d\n", frame->value + 1);
+                sink_printf(gen->sink, ".L%d:\n", frame->value);
+                ast_walk_push(&walk, node->data.while_stmt.body, 0);
+            }
+            else if (step == 1)
+            {
+                sink_printf(gen->sink, ".L%d:\n", frame->value + 1);
+                ast_walk_push(&walk, condition, is_equality(condition) ? KEEP_FLAGS : 0);
+            }
+            else if (is_equality(condition))
+            {
+                sink_printf(gen->sink, "\tje .L%d\n", frame->value);
+            }
+            else
+            {
+                sink_printf(gen->sink, "\ttestl %%eax, %%eax\n");
+                sink_printf(gen->sink, "\tjne .L%d\n", frame->value);
+            }
+            break;
+        }
+
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            done = step >= node->data.block.count;
+            if (!done)
+                ast_walk_push(&walk, node->data.block.statements[step], 0);
+            break;
+
+        default:
+            gen->has_error = 1;
+            break;
+        }
+        if (done)
+            ast_walk_pop(&walk);
+    }
+
+    if (walk.failed)
+        gen->has_error = 1;
+    free_ast_walk(&walk);
+}
+
+int generate_x86_assembly(ASTNode *ast, OutputSink *sink)
+{
+    X86Generator gen;
+    gen.sink = sink;
+    init_symbol_table(&gen.symbols);
+    gen.label_count = 0;
+    gen.has_error = 0;
+
+    sink_puts(sink, "\t.text\n\t.globl main\n\t.type main, @function\nmain:\n");
+    // keeps the stack 16-byte aligned for the printf calls
+    sink_puts(sink, "\tpushq %rbx\n");
+
+    if (ast && ast->type == AST_PROGRAM)
+        emit_tree(&gen, ast);
+
+    // print every variable in order of first use
+    for (int i = 0; i < gen.symbols.count; i++)
+    {
+        sink_printf(sink, "\tleaq .Lformat(%%rip), %%rdi\n");
+        sink_printf(sink, "\tleaq .Lname_%d(%%rip), %%rsi\n", i);
+        sink_printf(sink, "\tmovl sl_var_%d(%%rip), %%edx\n", i);
+        sink_printf(sink, "\txorl %%eax, %%eax\n");
+        sink_printf(sink, "\tcall printf@PLT\n");
+    }
+    sink_puts(sink, "\txorl %eax, %eax\n\tpopq %rbx\n\tret\n\t.size main, .-main\n\n");
+
+    sink_puts(sink, "\t.section .rodata\n.Lformat:\n\t.string \"%s = %d\\n\"\n");
+    for (int i = 0; i < gen.symbols.count; i++)
+    {
+        sink_printf(sink, ".Lname_%d:\n\t.string \"%s\"\n", i, symbol_name(&gen.symbols, i));
+    }
+
+    sink_puts(sink, "\n\t.bss\n\t.align 4\n");
+    for (int i = 0; i < gen.symbols.count; i++)
+    {
+        sink_printf(sink, "sl_var_%d:\n\t.zero 4\n", i);
+    }
+    sink_puts(sink, "\n\t.section .note.GNU-stack,\"\",@progbits\n");
+
+    free_symbol_table(&gen.symbols);
+    if (gen.has_error)
+        return -1;
+    return sink->has_error ? -1 : 0;
+}
+
+int build_x86_executable(ASTNode *ast, const char *path)
+{
+    const char *cc = getenv("CC");
+    if (!cc || !*cc)
+        cc = "cc";
+
+    // the assembly goes straight down a pipe into the compiler driver, no temporary file;
+    // close-on-exec from the start, so a compiler another thread starts never holds it open
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execlp(cc, cc, "-x", "assembler", "-", "-o", path, (char *)NULL);
+        // no stdio between fork and exec, another thread may have held its lock
+        const char *message[] = {"Error: Cannot run '", cc, "'\n"};
+        for (int i = 0; i < 3; i++)
+        {
+            if (write(STDERR_FILENO, message[i], strlen(message[i])) < 0)
+                break;
+        }
+        _exit(127);
+    }
+
+    close(fds[0]);
+    // a compiler that is missing or exits early fails this build with EPIPE instead of
+    // killing the process: SIGPIPE stays blocked in this thread while writing, and one
+    // the writes raised is taken back before it is unblocked
+    sigset_t pipe_signal, old_mask;
+    sigemptyset(&pipe_signal);
+    sigaddset(&pipe_signal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_signal, &old_mask);
+
+    OutputSink *sink = create_fd_sink(fds[1]);
+    int result = -1;
+    if (sink)
+    {
+        result = generate_x86_assembly(ast, sink);
+        if (close_sink(sink) != 0)
+            result = -1;
+    }
+    close(fds[1]);
+
+    if (!sigismember(&old_mask, SIGPIPE))
+    {
+        sigset_t pending;
+        struct timespec none = {0, 0};
+        if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE))
+            sigtimedwait(&pipe_signal, NULL, &none);
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        result = -1;
+    return result;
+}
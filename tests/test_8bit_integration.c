@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ast.h"
 #include "../include/codegen.h"
+#include "../include/assembler.h"
+#include "../include/simulator.h"
 
 void test_basic_arithmetic() {
     printf("Testing basic arithmetic code generation for 8-bit CPU...\n");
@@ -29,9 +32,294 @@ void test_basic_arithmetic() {
     free_lexer(lexer);
 }
 
+// compile, assemble and run a program, returns the finished simulator; extended_isa
+// lets the code use the simulator's extension (codegen.h)
+static Simulator *run_program_on(char *input, int extended_isa, CodeGenerator **codegen_out,
+                                 ProgramImage **image_out) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    CodeGenerator *codegen = create_codegen();
+    codegen->extended_isa = extended_isa;
+    generate_code(codegen, ast);
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(!image->has_error);
+
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 1000000) == 0);
+
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    *codegen_out = codegen;
+    *image_out = image;
+    return sim;
+}
+
+static Simulator *run_program(char *input, CodeGenerator **codegen_out, ProgramImage **image_out) {
+    return run_program_on(input, 0, codegen_out, image_out);
+}
+
+// whether a run used any of the extension's opcodes
+static int used_extension(const Simulator *sim) {
+    static const Opcode extension[] = {OP_ADC, OP_SBC, OP_SHL, OP_SHR, OP_JNC, OP_CALL, OP_RET};
+    long long used = 0;
+    for (size_t i = 0; i < sizeof(extension) / sizeof(extension[0]); i++)
+        used += sim->opcode_counts[extension[i]];
+    return used > 0;
+}
+
+void test_simulated_arithmetic() {
+    printf("Testing simulated execution of arithmetic...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    Simulator *sim = run_program("int a = 10; int b = 5; int sum = a + b; int diff = a - b;", &codegen, &image);
+
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "sum")) == 15);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "diff")) == 5);
+    assert(sim->opcode_counts[OP_ADD] == 1);
+    assert(sim->opcode_counts[OP_SUB] == 1);
+    assert(sim->max_stack_depth == 1);
+    assert(sim->cycles > 0);
+
+    OutputSink *report = create_memory_sink();
+    write_simulation_report(report, sim, &codegen->symbols, image);
+    const char *text = sink_contents(report, NULL);
+    assert(strstr(text, "sum") != NULL);
+    printf("%s", text);
+    close_sink(report);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_simulated_multiply_and_shifts() {
+    printf("Testing simulated multiplication and shifts...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    // by constants, on values that fit in a byte: shift-add chains, no call
+    char *constants = "int a = 7; int b = a * 10; int c = a * 30; int d = (a << 3) + (a >> 1); "
+                      "int e = a << 5; int f = (a << 9) - 3584;";
+    for (int extended = 0; extended <= 1; extended++) {
+        Simulator *sim = run_program_on(constants, extended, &codegen, &image);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "b")) == 70);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "c")) == 210);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "d")) == 59);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "e")) == 224);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "f")) == 0);
+        assert(sim->opcode_counts[OP_CALL] == 0);
+        if (!extended) assert(!used_extension(sim));
+        free_simulator(sim);
+        free_program_image(image);
+        free_codegen(codegen);
+    }
+
+    // by variables: the routines follow the hlt, once each however often they are called
+    char *variables = "int a = 13; int b = 11; int c = a * b; int d = b * a * 2; int e = b << (a - 10); "
+                      "int f = 200 >> (b - 8); int g = 0 - 3000; int h = g >> (b - 3); int i = g << (b - 6); "
+                      "int j = g * (g + 3001);";
+    Simulator *sim = run_program_on(variables, 1, &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "c")) == 143);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "d")) == 286);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "e")) == 88);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "f")) == 25);
+    // 286 and j take the two byte multiply, which calls the byte one twice
+    assert(sim->opcode_counts[OP_CALL] == 12);
+    assert(sim->opcode_counts[OP_RET] == 12);
+    int halts = 0;
+    for (int i = 0; i < codegen->count; i++)
+        halts += codegen->instructions[i].opcode == OP_HLT;
+    assert(halts == 1);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    // the base CPU has neither call nor ret: each routine is entered by jmp and jumps back
+    sim = run_program(variables, &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "c")) == 143);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "d")) == 286);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "e")) == 88);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "f")) == 25);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "h")) == -12);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "i")) == -30464);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "j")) == -3000);
+    assert(!used_extension(sim));
+    OutputSink *report = create_memory_sink();
+    write_simulation_report(report, sim, &codegen->symbols, image);
+    assert(strstr(sink_contents(report, NULL), RUNTIME_RETURN_SLOT) == NULL);
+    close_sink(report);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    // so a routine's code is there once: each multiply adds a call site, not a copy
+    int sizes[4];
+    int counts[4] = {1, 3, 10, RUNTIME_SITES_MAX + 10};
+    for (int n = 0; n < 4; n++) {
+        char *many = malloc(64 + 32 * counts[n]);
+        char *end = many + sprintf(many, "int a = 13; int b = 11; int c = 0;");
+        for (int i = 0; i < counts[n]; i++)
+            end += sprintf(end, " c = a * b; a = c - 130;");
+        sim = run_program(many, &codegen, &image);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "c")) == 143);
+        assert(!used_extension(sim));
+        sizes[n] = image->text_size;
+        free_simulator(sim);
+        free_program_image(image);
+        free_codegen(codegen);
+        free(many);
+    }
+    printf("Base code for 1, 3, 10 and %d multiplies: %d, %d, %d and %d bytes\n", counts[3],
+           sizes[0], sizes[1], sizes[2], sizes[3]);
+    int site = (sizes[2] - sizes[1]) / 7;
+    assert(sizes[2] < 3 * sizes[0]);
+    assert(sizes[2] - sizes[1] <= 4 * (sizes[1] - sizes[0]));
+    // past the last return site id the routine goes in place again, over three calls' worth
+    assert(sizes[3] - sizes[2] > (counts[3] - 10) * site + 10 * 3 * site);
+
+    // i * 7 steps by 7 each pass instead of being multiplied again (i * 3 is cheaper to
+    // multiply than to step)
+    sim = run_program_on("int i = 0; int t = 0; int n = 10; "
+                         "while (n) { t = t + i * 7; i = i + 1; n = n - 1; }", 1, &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "t")) == 315);
+    assert(sim->opcode_counts[OP_SHL] == 3);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_simulated_nesting() {
+    printf("Testing stack depth of nested expressions...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    Simulator *sim = run_program("int a = 1; int r = a + (a + (a + (a + 4)));", &codegen, &image);
+
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "r")) == 8);
+    assert(sim->max_stack_depth == 4);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_simulated_conditionals() {
+    printf("Testing simulated conditionals...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    Simulator *sim = run_program("int x = 5; if (x == 5) { x = x + 1; } else { x = x - 1; } "
+                                 "int y = (x == 6) + (x == 7); if (y) { y = y + 10; }", &codegen, &image);
+
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "x")) == 6);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "y")) == 11);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_simulated_loops() {
+    printf("Testing simulated loops...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    Simulator *sim = run_program("int n = 10; int total = 0; int i = 0; "
+                                 "while (n) { total = total + i; i = i + 1; n = n - 1; }", &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "total")) == 45);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "n")) == 0);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    // a + b does not change in the loop and n - 1 steps with n, so both live in registers:
+    // each pass loads only s and the condition
+    sim = run_program("int a = 3; int b = 4; int s = 0; int n = 20; "
+                      "while (n) { s = s + (a + b); n = n - 1; }", &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "s")) == 140);
+    assert(sim->opcode_counts[OP_LDA] <= 2 * 20 + 4);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    // i + i + i + 1 is stepped by 3 each pass instead of being added up again (counted
+    // on the extension, where adding it to the two byte t pushes nothing)
+    sim = run_program_on("int i = 0; int t = 0; int n = 10; "
+                         "while (n) { t = t + (i + i + i + 1); i = i + 1; n = n - 1; }", 1, &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "t")) == 145);
+    assert(sim->opcode_counts[OP_PUSH] < 10);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    // nested loops, with == as the condition
+    sim = run_program("int done = 0; int count = 0; int outer = 3; "
+                      "while (done == 0) { int inner = 4; while (inner) { count = count + 1; inner = inner - 1; } "
+                      "outer = outer - 1; if (outer == 0) { done = 1; } }", &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "count")) == 12);
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_simulated_two_byte_values() {
+    printf("Testing simulated two byte ints...\n");
+
+    CodeGenerator *codegen;
+    ProgramImage *image;
+    // int is 16 bits: values past a byte carry into the high byte and wrap at 32767
+    char *input = "int a = 300; int b = a * 3; int c = 5 - 10; int d = c >> 1; "
+                  "int e = 8000 * 8; int small = 200 + 50; int f = a + 1000; int g = 5 - f; "
+                  "int h = g + 2; int i = g - 200;";
+    for (int extended = 0; extended <= 1; extended++) {
+        Simulator *sim = run_program_on(input, extended, &codegen, &image);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "b")) == 900);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "c")) == -5);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "d")) == -3);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "e")) == 64000 - 65536);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "small")) == 250);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "g")) == -1295);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "h")) == -1293);
+        assert(read_variable(sim, image, find_symbol(&codegen->symbols, "i")) == -1495);
+        // the extension carries with adc and sbc, the base CPU by comparing top bits
+        if (extended)
+            assert(sim->opcode_counts[OP_ADC] + sim->opcode_counts[OP_SBC] > 0);
+        else
+            assert(!used_extension(sim));
+        // the byte sized one keeps a one byte slot
+        assert(image->symbol_size[find_symbol(&codegen->symbols, "small")] == 1);
+        assert(image->symbol_size[find_symbol(&codegen->symbols, "b")] == 2);
+        free_simulator(sim);
+        free_program_image(image);
+        free_codegen(codegen);
+    }
+
+    // the sum outgrows a byte, the counter stays one
+    Simulator *sim = run_program("int s = 0; int n = 100; while (n) { s = s + n; n = n - 1; }", &codegen, &image);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "s")) == 5050);
+    assert(image->symbol_size[find_symbol(&codegen->symbols, "n")] == 1);
+    assert(!used_extension(sim));
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
 int main() {
     printf("=== 8-bit CPU Integration Tests ===\n\n");
     test_basic_arithmetic();
+    test_simulated_arithmetic();
+    test_simulated_multiply_and_shifts();
+    test_simulated_nesting();
+    test_simulated_conditionals();
+    test_simulated_loops();
+    test_simulated_two_byte_values();
     printf("\nAll 8-bit CPU integration tests completed!\n");
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/allocator.h"
+#include "../include/parser.h"
+
+void test_system_routing() {
+    printf("Testing the default allocator...\n");
+
+    assert(current_allocator() == system_allocator());
+    char *text = sl_strdup("int a = 1;");
+    assert(strcmp(text, "int a = 1;") == 0);
+    text = sl_realloc(text, 64);
+    strcat(text, " a = a + 1;");
+    assert(strcmp(text, "int a = 1; a = a + 1;") == 0);
+    sl_free(text);
+
+    int *zeros = sl_calloc(8, sizeof(int));
+    for (int i = 0; i < 8; i++) {
+        assert(zeros[i] == 0);
+    }
+    sl_free(zeros);
+    sl_free(NULL);
+
+    printf("System allocator test passed\n");
+}
+
+void test_arena() {
+    printf("Testing the arena allocator...\n");
+
+    Allocator *arena = create_arena_allocator(256);
+    assert(arena != NULL);
+    Allocator *previous = set_allocator(arena);
+    assert(previous == system_allocator());
+    assert(current_allocator() == arena);
+
+    char *first = sl_malloc(3);
+    char *second = sl_malloc(5);
+    assert(((uintptr_t)first & 15) == 0 && ((uintptr_t)second & 15) == 0);
+    assert(second > first);
+    memcpy(second, "abcd", 5);
+
+    // the newest block grows where it is, older ones move
+    char *grown = sl_realloc(second, 40);
+    assert(grown == second && strcmp(grown, "abcd") == 0);
+    memcpy(first, "xy", 3);
+    char *moved = sl_realloc(first, 100);
+    assert(moved != first && strcmp(moved, "xy") == 0);
+
+    // bigger than a chunk: a chunk of its own
+    char *large = sl_malloc(4096);
+    memset(large, 7, 4096);
+    assert(large[4095] == 7);
+    sl_free(large); // does nothing, the arena releases everything at once
+
+    set_allocator(previous);
+    free_arena_allocator(arena);
+    assert(current_allocator() == system_allocator());
+
+    printf("Arena test passed\n");
+}
+
+void test_counting() {
+    printf("Testing allocation counting...\n");
+
+    Allocator *counting = create_counting_allocator(NULL);
+    AllocationStats *stats = counting_allocator_stats(counting);
+    Allocator *previous = set_allocator(counting);
+
+    set_allocation_phase(TIME_LEX);
+    char *a = sl_malloc(100);
+    char *b = sl_malloc(50);
+    set_allocation_phase(TIME_PARSE);
+    a = sl_realloc(a, 160);
+    sl_free(b);
+    char *c = sl_malloc(10);
+    assert(stats->allocations == 3 && stats->reallocations == 1 && stats->frees == 1);
+    assert(stats->bytes == 100 + 50 + 60 + 10);
+    assert(stats->live_bytes == 170);
+    assert(stats->peak_bytes == 210);
+    assert(stats->phase_allocations[TIME_LEX] == 2 && stats->phase_bytes[TIME_LEX] == 150);
+    assert(stats->phase_bytes[TIME_PARSE] == 70);
+    // the realloc and the two mallocs are three different sites
+    assert(stats->site_count == 4);
+    sl_free(a);
+    sl_free(c);
+    assert(stats->live_bytes == 0);
+
+    set_allocator(previous);
+
+    AllocationStats total;
+    memset(&total, 0, sizeof(total));
+    assert(merge_allocation_stats(&total, stats) == 0);
+    assert(merge_allocation_stats(&total, stats) == 0);
+    assert(total.allocations == 6 && total.peak_bytes == 210);
+    assert(total.site_count == 4);
+
+    OutputSink *sink = create_memory_sink();
+    write_memory_report(sink, &total, "system", 2);
+    const char *report = sink_contents(sink, NULL);
+    assert(strstr(report, "6 allocations, 2 reallocations, 6 frees") != NULL);
+    assert(strstr(report, "lex") != NULL && strstr(report, "tests/test_allocator.c:") != NULL);
+    close_sink(sink);
+    free_allocation_stats(&total);
+    free_counting_allocator(counting);
+
+    printf("Counting test passed\n");
+}
+
+void test_arena_reset() {
+    printf("Testing that a reset arena reuses its chunks...\n");
+
+    Allocator *arena = create_arena_allocator(256);
+    Allocator *previous = set_allocator(arena);
+    char *first = sl_malloc(100);
+    sl_malloc(100);
+    sl_malloc(100); // a second chunk
+    sl_malloc(1000); // an oversized one, not kept
+    reset_arena_allocator(arena);
+
+    // the kept chunks come back before the system is asked for more
+    char *again = sl_malloc(100);
+    assert(again == first);
+    sl_malloc(100);
+    sl_malloc(100);
+    memset(again, 1, 100);
+    reset_arena_allocator(arena);
+    reset_arena_allocator(arena);
+
+    set_allocator(previous);
+    free_arena_allocator(arena);
+    printf("Arena reset test passed\n");
+}
+
+void test_front_end_under_arena() {
+    printf("Testing the front end on a counted arena...\n");
+
+    Allocator *arena = create_arena_allocator(0);
+    Allocator *counting = create_counting_allocator(arena);
+    Allocator *previous = set_allocator(counting);
+
+    char source[] = "int a = 1;\nif (a == 1) {\n    a = a + 2;\n}\n";
+    Lexer *lexer = create_lexer(source);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(!parser->has_error && ast != NULL);
+    assert(ast->data.block.count == 2);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+
+    // everything the front end allocates it also frees
+    AllocationStats *stats = counting_allocator_stats(counting);
+    assert(stats->allocations > 0);
+    assert(stats->live_bytes == 0);
+
+    set_allocator(previous);
+    free_counting_allocator(counting);
+    free_arena_allocator(arena);
+
+    printf("Front end test passed\n");
+}
+
+int main() {
+    printf("Running allocator tests...\n\n");
+
+    test_system_routing();
+    test_arena();
+    test_arena_reset();
+    test_counting();
+    test_front_end_under_arena();
+
+    printf("\nAll allocator tests passed!\n");
+    return 0;
+}
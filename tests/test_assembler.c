@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/codegen.h"
+#include "../include/assembler.h"
+
+// extended_isa lets the code use the simulator's extension (codegen.h)
+static CodeGenerator *compile_on(char *input, int extended_isa) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    CodeGenerator *codegen = create_codegen();
+    codegen->extended_isa = extended_isa;
+    generate_code(codegen, ast);
+
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return codegen;
+}
+
+static CodeGenerator *compile(char *input) {
+    return compile_on(input, 0);
+}
+
+void test_encoding() {
+    printf("Testing instruction encoding and data layout...\n");
+
+    CodeGenerator *codegen = compile("int a = 10; int b = a + 5;");
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(!image->has_error);
+
+    // ldi(2) sta(3) lda(3) push(1) ldi(2) mov(1) pop(1) add(1) sta(3) hlt(1)
+    unsigned char expected[] = {
+        ENC_LDI | REG_A, 10,
+        ENC_STA, 18, 0,
+        ENC_LDA, 18, 0,
+        ENC_PUSH | REG_A,
+        ENC_LDI | REG_A, 5,
+        ENC_MOV | (REG_B << 3) | REG_A,
+        ENC_POP | REG_A,
+        ENC_ADD,
+        ENC_STA, 19, 0,
+        ENC_HLT,
+        0, 0 // var_a, var_b
+    };
+    assert(image->text_size == 18);
+    assert(image->size == (int)sizeof(expected));
+    assert(memcmp(image->bytes, expected, sizeof(expected)) == 0);
+    assert(image->symbol_address[0] == 18);
+    assert(image->instruction_address[2] == 5);
+
+    printf("Encoding test passed\n");
+
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_intel_hex() {
+    printf("Testing Intel HEX output...\n");
+
+    CodeGenerator *codegen = compile("int a = 1;");
+    ProgramImage *image = assemble_program(codegen);
+    OutputSink *sink = create_memory_sink();
+    write_intel_hex(image, sink);
+
+    // ldi A 1, sta 6, hlt, data byte
+    const char *text = sink_contents(sink, NULL);
+    assert(strcmp(text, ":0700000008012106000100C8\n:00000001FF\n") == 0);
+
+    printf("Intel HEX test passed\n");
+
+    close_sink(sink);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_immediate_range() {
+    printf("Testing immediate range check...\n");
+
+    // 300 is loaded a byte at a time into a two byte slot
+    CodeGenerator *codegen = compile("int a = 300;");
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    assert(image->symbol_size[0] == 2 && image->size == image->text_size + 2);
+    assert(image->bytes[0] == (ENC_LDI | REG_A) && image->bytes[1] == 44);
+    assert(image->bytes[2] == (ENC_LDI | REG_G) && image->bytes[3] == 1);
+    // sta a, mov A G, sta a+1
+    assert(image->bytes[4] == ENC_STA && image->bytes[5] == image->symbol_address[0]);
+    assert(image->bytes[8] == ENC_STA && image->bytes[9] == image->symbol_address[0] + 1);
+    free_program_image(image);
+    free_codegen(codegen);
+
+    codegen = create_codegen();
+    emit_instruction(codegen, OP_LDI, OPERAND_REGISTER, REG_A, OPERAND_IMMEDIATE, 300);
+    image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(image->has_error);
+    printf("Got expected error: %s\n", image->error_message);
+
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_jumps() {
+    printf("Testing jump encoding...\n");
+
+    CodeGenerator *codegen = compile("int a = 1; if (a) { a = 0; }");
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(!image->has_error);
+
+    // ldi(2) sta(3) lda(3) ldi(2) cmp(1) jz(3) ldi(2) sta(3) .L0 hlt(1)
+    assert(image->label_count == 1);
+    assert(image->label_address[0] == 19);
+    unsigned char expected[] = {ENC_JZ, 19, 0};
+    assert(memcmp(image->bytes + 11, expected, sizeof(expected)) == 0);
+    assert(image->bytes[19] == ENC_HLT);
+    free_program_image(image);
+
+    // a jump to a label that is never placed
+    codegen->label_count++;
+    emit_instruction(codegen, OP_JMP, OPERAND_LABEL, codegen->label_count - 1, OPERAND_NONE, 0);
+    image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(image->has_error);
+    printf("Got expected error: %s\n", image->error_message);
+
+    printf("Jump test passed\n");
+
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_calls() {
+    printf("Testing call and ret encoding...\n");
+
+    CodeGenerator *codegen = compile_on("int a = 3; int b = a * a;", 1);
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL);
+    assert(!image->has_error);
+
+    // the call goes to the multiply routine placed after the hlt, which ends in ret
+    int label = codegen->runtime_label[RUNTIME_MULTIPLY];
+    assert(label >= 0);
+    int routine = image->label_address[label];
+    int calls = 0;
+    for (int i = 0; i < codegen->count; i++) {
+        if (codegen->instructions[i].opcode != OP_CALL)
+            continue;
+        unsigned char expected[] = {ENC_CALL, routine & 0xFF, routine >> 8};
+        assert(memcmp(image->bytes + image->instruction_address[i], expected, sizeof(expected)) == 0);
+        calls++;
+    }
+    assert(calls == 1);
+    assert(image->bytes[routine - 1] == ENC_HLT);
+    assert(image->bytes[image->text_size - 1] == ENC_RET);
+
+    printf("Call test passed\n");
+
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+int main() {
+    printf("=== Assembler Tests ===\n\n");
+    test_encoding();
+    test_intel_hex();
+    test_immediate_range();
+    test_jumps();
+    test_calls();
+    printf("\nAll assembler tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/astfile.h"
+
+static const char *program_text =
+    "import lib;\n"
+    "extern int base;\n"
+    "int a = 2 + 3 * base;\n"
+    "int b;\n"
+    "if (a == 5) { b = a << 1; } else { b = a >> 1; }\n"
+    "while (a) { a = a - 1; }\n";
+
+static ASTNode *parse_source(const char *input) {
+    Lexer *lexer = create_lexer((char *)input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+    free_parser(parser);
+    free_lexer(lexer);
+    return ast;
+}
+
+// the file of a program, in a buffer of its own the caller frees
+static uint32_t *save(ASTNode *ast, size_t *size) {
+    OutputSink *sink = create_memory_sink();
+    assert(write_ast_file(sink, ast) == 0);
+    const char *data = sink_contents(sink, size);
+    uint32_t *copy = malloc(*size + 4);
+    memcpy(copy, data, *size);
+    close_sink(sink);
+    return copy;
+}
+
+static char *draw(ASTNode *ast) {
+    OutputSink *sink = create_memory_sink();
+    write_ast(sink, ast);
+    char *text = strdup(sink_contents(sink, NULL));
+    close_sink(sink);
+    return text;
+}
+
+// a tree in memory and one in a file have the same shape, names and values
+static void assert_same(const ASTNode *node, const ASTFileNode *file) {
+    assert(file->type == node->type);
+    assert(file->line == node->line && file->column == node->column);
+    assert(ast_file_child_count(file) == ast_child_count(node));
+    if (node->type == AST_NUMBER)
+        assert(file->field[0] == node->data.number.value);
+    if (node->type == AST_BINARY_OP)
+        assert(file->operator == node->data.binary_op.operator);
+    if (node->type == AST_IDENTIFIER)
+        assert(strcmp(ast_file_name(file), node->data.identifier.name) == 0);
+    if (node->type == AST_DECLARATION)
+        assert(strcmp(ast_file_name(file), node->data.declaration.var_name) == 0);
+    if (node->type == AST_IMPORT)
+        assert(strcmp(ast_file_name(file), node->data.import.module) == 0);
+    for (int i = 0; i < ast_child_count(node); i++) {
+        const ASTNode *child = ast_child(node, i);
+        const ASTFileNode *file_child = ast_file_child(file, i);
+        assert((child == NULL) == (file_child == NULL));
+        if (child)
+            assert_same(child, file_child);
+    }
+}
+
+void test_round_trip() {
+    printf("Testing writing and walking an AST file...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    size_t size;
+    uint32_t *data = save(ast, &size);
+    const ASTFileHeader *header = (const ASTFileHeader *)data;
+    assert(memcmp(header->magic, "SLAB", 4) == 0 && header->version == AST_FILE_VERSION);
+    assert((int)header->node_count == count_ast_nodes(ast));
+    assert(size == sizeof(ASTFileHeader) + header->node_count * sizeof(ASTFileNode) + header->list_count * 4 +
+                       header->string_size);
+
+    const ASTFileNode *root = check_ast_file(data, size);
+    assert(root != NULL && root->type == AST_PROGRAM);
+    assert_same(ast, root);
+    // b has no initial value
+    assert(ast_file_child(ast_file_child(root, 3), 0) == NULL);
+
+    // built back, it draws the same as the parsed tree
+    ASTNode *loaded = ast_from_file(data);
+    assert(loaded != NULL);
+    char *before = draw(ast), *after = draw(loaded);
+    assert(strcmp(before, after) == 0);
+
+    free(before);
+    free(after);
+    free_ast(loaded);
+    free(data);
+    free_ast(ast);
+}
+
+void test_relative_offsets() {
+    printf("Testing a file moved to another address...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    size_t size;
+    uint32_t *data = save(ast, &size);
+    uint32_t *moved = malloc(size + 64);
+    memcpy(moved + 8, data, size);
+    memset(data, 0, size);
+    const ASTFileNode *root = check_ast_file(moved + 8, size);
+    assert(root != NULL);
+    assert_same(ast, root);
+
+    free(moved);
+    free(data);
+    free_ast(ast);
+}
+
+void test_mapped_file() {
+    printf("Testing a mapped AST file...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    OutputSink *sink = create_file_sink("output/test_astfile.sla");
+    assert(sink != NULL);
+    assert(write_ast_file(sink, ast) == 0);
+    assert(close_sink(sink) == 0);
+
+    ASTFile *file = map_ast_file("output/test_astfile.sla");
+    assert(file != NULL);
+    assert_same(ast, file->root);
+    unmap_ast_file(file);
+    remove("output/test_astfile.sla");
+
+    assert(map_ast_file("output/test_astfile_missing.sla") == NULL);
+    free_ast(ast);
+}
+
+void test_rejected_files() {
+    printf("Testing rejected AST files...\n");
+
+    ASTNode *ast = parse_source("int a = 1 + 2;\n");
+    size_t size;
+    uint32_t *data = save(ast, &size);
+    unsigned char *bytes = (unsigned char *)data;
+    ASTFileHeader *header = (ASTFileHeader *)data;
+    ASTFileNode *nodes = (ASTFileNode *)(header + 1);
+    assert(check_ast_file(data, size) != NULL);
+
+    // truncated, misaligned, another format or version
+    assert(check_ast_file(data, size - 1) == NULL);
+    assert(check_ast_file(data, 3) == NULL);
+    assert(check_ast_file(bytes + 1, size) == NULL);
+    header->magic[0] = 'X';
+    assert(check_ast_file(data, size) == NULL);
+    header->magic[0] = 'S';
+    header->version++;
+    assert(check_ast_file(data, size) == NULL);
+    header->version--;
+
+    // nodes are 1, 2, + then the declaration and the program: the + may not point
+    // forward, at itself, or at a node that already has a parent
+    ASTFileNode *plus = &nodes[2];
+    int32_t left = plus->field[0];
+    plus->field[0] = (int32_t)sizeof(ASTFileNode);
+    assert(check_ast_file(data, size) == NULL);
+    plus->field[0] = 0;
+    assert(check_ast_file(data, size) == NULL);
+    plus->field[0] = plus->field[1];
+    assert(check_ast_file(data, size) == NULL);
+    plus->field[0] = left + 1;
+    assert(check_ast_file(data, size) == NULL);
+    plus->field[0] = left;
+
+    // an operator the grammar lacks, a declaration whose value is the program after it
+    plus->operator = TOKEN_SEMICOLON;
+    assert(check_ast_file(data, size) == NULL);
+    plus->operator = TOKEN_PLUS;
+    nodes[3].field[1] = (int32_t)sizeof(ASTFileNode);
+    assert(check_ast_file(data, size) == NULL);
+    nodes[3].field[1] = -(int32_t)sizeof(ASTFileNode);
+
+    // a name running off the end
+    bytes[size - 1] = 'a';
+    assert(check_ast_file(data, size) == NULL);
+    bytes[size - 1] = '\0';
+    assert(check_ast_file(data, size) != NULL);
+
+    // names that are not identifiers would be copied into assembly text as they are
+    const char bad[] = {'"', '\n', '1', '\0'};
+    for (size_t i = 0; i < sizeof(bad); i++) {
+        bytes[size - 2] = bad[i];
+        assert(check_ast_file(data, size) == NULL);
+    }
+    bytes[size - 2] = 'a';
+    assert(check_ast_file(data, size) != NULL);
+
+    free(data);
+    free_ast(ast);
+}
+
+int main() {
+    printf("=== AST File Tests ===\n\n");
+    test_round_trip();
+    test_relative_offsets();
+    test_mapped_file();
+    test_rejected_files();
+    printf("\nAll AST file tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/bytecode.h"
+
+// compile and run a program, returns the value of one variable afterwards
+static int run_and_read(char *input, const char *variable) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    BytecodeProgram *program = compile_bytecode(ast);
+    assert(program != NULL);
+
+    int *slots = calloc(program->symbols.count + 1, sizeof(int));
+    assert(run_bytecode(program, slots, 0) == 0);
+    int slot = find_symbol(&program->symbols, variable);
+    assert(slot >= 0);
+    int value = slots[slot];
+
+    free(slots);
+    free_bytecode(program);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return value;
+}
+
+void test_arithmetic() {
+    printf("Testing bytecode arithmetic...\n");
+    assert(run_and_read("int a = 10; int b = 5; int sum = a + b;", "sum") == 15);
+    assert(run_and_read("int a = 10; int b = 5; int d = a - b - 1;", "d") == 4);
+    assert(run_and_read("int a = 1; int r = 10 - (a + (a + 2));", "r") == 6);
+    assert(run_and_read("int a = 300; int r = a + a;", "r") == 600);
+    printf("Arithmetic tests passed\n");
+}
+
+void test_multiply_and_shifts() {
+    printf("Testing bytecode multiplication and shifts...\n");
+    assert(run_and_read("int a = 7; int b = 13; int r = a * b + a * 10;", "r") == 161);
+    assert(run_and_read("int a = 3; int r = 1 + a * 2 << 1;", "r") == 14);
+    assert(run_and_read("int a = 0 - 100; int r = a >> 2;", "r") == -25);
+    assert(run_and_read("int a = 1; int n = 33; int r = a << n;", "r") == 2);
+    assert(run_and_read("int a = 65536; int r = a * a;", "r") == 0);
+    printf("Multiplication and shift tests passed\n");
+}
+
+void test_conditionals() {
+    printf("Testing bytecode conditionals...\n");
+    assert(run_and_read("int x = 5; if (x == 5) { x = x + 1; } else { x = x - 1; }", "x") == 6);
+    assert(run_and_read("int x = 4; if (x == 5) { x = x + 1; } else { x = x - 1; }", "x") == 3);
+    assert(run_and_read("int x = 4; int y = 0; if (x == 5) { y = 1; }", "y") == 0);
+    assert(run_and_read("int x = 2; int y = (x == 2) + (x == 3);", "y") == 1);
+    printf("Conditional tests passed\n");
+}
+
+void test_loops() {
+    printf("Testing bytecode loops...\n");
+    assert(run_and_read("int n = 10; int total = 0; while (n) { n = n - 1; total = total + n; }", "total") == 45);
+    assert(run_and_read("int n = 0; int r = 7; while (n) { r = 0; }", "r") == 7);
+    assert(run_and_read("int k = 0; int r = 0; while (k == 0) { r = r + 5; if (r == 20) { k = 1; } }", "r") == 20);
+    assert(run_and_read("int i = 3; int c = 0; while (i) { int j = 4; while (j) { c = c + 1; j = j - 1; } i = i - 1; }",
+                        "c") == 12);
+    printf("Loop tests passed\n");
+}
+
+void test_iteration_budget() {
+    printf("Testing the loop iteration budget...\n");
+    Lexer *lexer = create_lexer("int k = 1; int n = 0; while (k) { n = n + 1; }");
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    BytecodeProgram *program = compile_bytecode(ast);
+    assert(program != NULL);
+
+    int slots[2] = {0, 0};
+    assert(run_bytecode(program, slots, 1000) == RUN_LIMIT_REACHED);
+    assert(slots[find_symbol(&program->symbols, "n")] == 1000);
+
+    free_bytecode(program);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    printf("Iteration budget test passed\n");
+}
+
+void test_large_program() {
+    printf("Testing a large generated program...\n");
+
+    int statements = 20000;
+    char *input = malloc(statements * 32 + 64);
+    char *p = input;
+    p += sprintf(p, "int counter = 0;\n");
+    for (int i = 0; i < statements; i++) {
+        p += sprintf(p, "counter = counter + %d;\n", i % 7);
+    }
+
+    int expected = 0;
+    for (int i = 0; i < statements; i++) {
+        expected += i % 7;
+    }
+    assert(run_and_read(input, "counter") == expected);
+    free(input);
+
+    printf("Large program test passed\n");
+}
+
+int main() {
+    printf("=== Bytecode VM Tests ===\n\n");
+    test_arithmetic();
+    test_multiply_and_shifts();
+    test_conditionals();
+    test_loops();
+    test_iteration_budget();
+    test_large_program();
+    printf("\nAll bytecode VM tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/cache.h"
+
+#define TEST_CACHE "output/test_cache"
+
+static void empty_directory(const char *path) {
+    DIR *dir = opendir(path);
+    if (!dir)
+        return;
+    struct dirent *item;
+    char name[512];
+    while ((item = readdir(dir))) {
+        if (item->d_name[0] == '.')
+            continue;
+        snprintf(name, sizeof(name), "%s/%s", path, item->d_name);
+        unlink(name);
+    }
+    closedir(dir);
+}
+
+static int file_count(const char *path) {
+    DIR *dir = opendir(path);
+    int count = 0;
+    struct dirent *item;
+    while ((item = readdir(dir))) {
+        if (item->d_name[0] != '.')
+            count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// pretend an entry was last used at a given time
+static void set_used(Cache *cache, uint64_t key, time_t when) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%016llx", cache->directory, (unsigned long long)key);
+    struct timespec times[2] = {{when, 0}, {when, 0}};
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+void test_hash() {
+    printf("Testing key hashing...\n");
+
+    uint64_t whole = hash_bytes(HASH_SEED, "int a = 1;", 10);
+    uint64_t split = hash_bytes(hash_bytes(HASH_SEED, "int a", 5), " = 1;", 5);
+    assert(whole == split);
+    assert(whole != hash_bytes(HASH_SEED, "int a = 2;", 10));
+    assert(hash_bytes(HASH_SEED, "", 0) == HASH_SEED);
+
+    printf("Hash test passed\n");
+}
+
+void test_store_and_lookup() {
+    printf("Testing store and lookup...\n");
+
+    mkdir("output", 0755);
+    empty_directory(TEST_CACHE);
+    Cache *cache = open_cache(TEST_CACHE, CACHE_DEFAULT_SIZE_LIMIT);
+    assert(cache != NULL);
+
+    size_t length;
+    assert(cache_lookup(cache, 42, &length) == NULL);
+    assert(cache->misses == 1);
+
+    // binary outputs keep their zero bytes
+    const char image[] = {0x10, 0x00, 0x20, 0x00, 0x7f};
+    assert(cache_store(cache, 42, image, sizeof(image)) == 0);
+    char *data = cache_lookup(cache, 42, &length);
+    assert(data != NULL && length == sizeof(image));
+    assert(memcmp(data, image, sizeof(image)) == 0);
+    free(data);
+    assert(cache->hits == 1 && cache->stores == 1);
+
+    // storing again replaces the entry, and no temporary files are left behind
+    assert(cache_store(cache, 42, "ldi A 1\n", 8) == 0);
+    data = cache_lookup(cache, 42, &length);
+    assert(length == 8 && strcmp(data, "ldi A 1\n") == 0);
+    free(data);
+    assert(file_count(TEST_CACHE) == 1);
+
+    // a damaged entry is a miss
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%016llx", TEST_CACHE, 42ULL);
+    assert(truncate(path, 12) == 0);
+    assert(cache_lookup(cache, 42, &length) == NULL);
+    assert(cache->misses == 2);
+
+    close_cache(cache);
+    printf("Store and lookup test passed\n");
+}
+
+void test_trim_evicts_least_recently_used() {
+    printf("Testing LRU eviction...\n");
+
+    empty_directory(TEST_CACHE);
+    char payload[100];
+    memset(payload, 'x', sizeof(payload));
+    // each entry is the payload plus a 16 byte header
+    Cache *cache = open_cache(TEST_CACHE, 3 * (sizeof(payload) + 16));
+    assert(cache != NULL);
+    for (uint64_t key = 1; key <= 4; key++) {
+        assert(cache_store(cache, key, payload, sizeof(payload)) == 0);
+        set_used(cache, key, 1000 + key);
+    }
+    // using the oldest entry makes entry 2 the least recently used one
+    size_t length;
+    free(cache_lookup(cache, 1, &length));
+
+    assert(cache_trim(cache) == 1);
+    assert(cache->evictions == 1 && cache->entry_count == 3);
+    assert(cache->total_size == 3 * (sizeof(payload) + 16));
+    char *data = cache_lookup(cache, 2, &length);
+    assert(data == NULL);
+    uint64_t kept[] = {1, 3, 4};
+    for (int i = 0; i < 3; i++) {
+        data = cache_lookup(cache, kept[i], &length);
+        assert(data != NULL);
+        free(data);
+    }
+    // within the limit nothing goes
+    assert(cache_trim(cache) == 0);
+
+    close_cache(cache);
+    empty_directory(TEST_CACHE);
+    rmdir(TEST_CACHE);
+    printf("LRU test passed\n");
+}
+
+void test_trim_removes_stale_temporaries() {
+    printf("Testing removal of abandoned temporary files...\n");
+
+    empty_directory(TEST_CACHE);
+    Cache *cache = open_cache(TEST_CACHE, CACHE_DEFAULT_SIZE_LIMIT);
+    assert(cache != NULL);
+    // one left by a killed compiler, one still being written
+    char stale[512], fresh[512];
+    snprintf(stale, sizeof(stale), "%s/tmp.AbCdEf", TEST_CACHE);
+    snprintf(fresh, sizeof(fresh), "%s/tmp.GhIjKl", TEST_CACHE);
+    close(open(stale, O_WRONLY | O_CREAT, 0644));
+    close(open(fresh, O_WRONLY | O_CREAT, 0644));
+    struct timespec times[2] = {{1000, 0}, {1000, 0}};
+    assert(utimensat(AT_FDCWD, stale, times, 0) == 0);
+    assert(cache_store(cache, 1, "x", 1) == 0);
+
+    assert(cache_trim(cache) == 0);
+    assert(access(stale, F_OK) != 0);
+    assert(access(fresh, F_OK) == 0);
+    assert(file_count(TEST_CACHE) == 2 && cache->entry_count == 1);
+
+    close_cache(cache);
+    empty_directory(TEST_CACHE);
+    rmdir(TEST_CACHE);
+    printf("Temporary file test passed\n");
+}
+
+int main() {
+    printf("Running compilation cache tests...\n\n");
+
+    test_hash();
+    test_store_and_lookup();
+    test_trim_evicts_least_recently_used();
+    test_trim_removes_stale_temporaries();
+
+    printf("\nAll compilation cache tests passed!\n");
+    return 0;
+}
@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ast.h"
 #include "../include/codegen.h"
+#include "../include/output.h"
+#include "../include/allocator.h"
 
 void test_simple_assignment() {
     printf("Testing simple assignment code generation...\n");
@@ -29,9 +32,152 @@ void test_simple_assignment() {
     free_lexer(lexer);
 }
 
+void test_instruction_encoding() {
+    printf("Testing structured instruction encoding...\n");
+
+    char *input = "int a_rather_long_variable_name_for_testing = 1; int b = a_rather_long_variable_name_for_testing + 2;";
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    CodeGenerator *codegen = create_codegen();
+    generate_code(codegen, ast);
+
+    // ldi, sta, lda, push, ldi, mov, pop, add, sta, hlt
+    assert(codegen->count == 10);
+    assert(codegen->symbols.count == 2);
+    assert(codegen->instructions[0].opcode == OP_LDI);
+    assert(codegen->instructions[0].operand[1] == 1);
+    assert(codegen->instructions[1].opcode == OP_STA);
+    assert(codegen->instructions[1].operand_kind[0] == OPERAND_SYMBOL);
+    assert(codegen->instructions[1].operand[0] == 0);
+    assert(codegen->instructions[7].opcode == OP_ADD);
+    assert(codegen->instructions[8].operand[0] == 1);
+    assert(codegen->instructions[9].opcode == OP_HLT);
+
+    // names are no longer truncated when rendered
+    char line[128];
+    format_instruction(codegen, &codegen->instructions[1], line, sizeof(line));
+    assert(strcmp(line, "sta %var_a_rather_long_variable_name_for_testing") == 0);
+    format_instruction(codegen, &codegen->instructions[5], line, sizeof(line));
+    assert(strcmp(line, "mov B A") == 0);
+
+    printf("Instruction encoding test passed\n");
+
+    free_codegen(codegen);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+}
+
+// a + a + ... + a parses into a left spine as deep as the chain; walking it must not
+// depend on the C stack
+void test_deep_expression() {
+    printf("Testing a 1M-term expression...\n");
+
+    int terms = 1000000;
+    char *input = malloc(terms * 4 + 32);
+    size_t length = sprintf(input, "int a = 1; int b = a");
+    for (int i = 1; i < terms; i++)
+        length += sprintf(input + length, " + a");
+    strcpy(input + length, ";");
+
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+    // program, two declarations, the number, then terms identifiers and terms - 1 operators
+    assert(count_ast_nodes(ast) == 4 + terms * 2 - 1);
+
+    CodeGenerator *codegen = create_codegen();
+    assert(generate_code(codegen, ast) == 0);
+    assert(codegen->instructions[codegen->count - 1].opcode == OP_HLT);
+    free_codegen(codegen);
+
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+
+    // drawn deeper than AST_DRAW_DEPTH, nodes stay at that indentation, marked
+    length = sprintf(input, "int b = a");
+    for (int i = 1; i < 200; i++)
+        length += sprintf(input + length, " + a");
+    strcpy(input + length, ";");
+    lexer = create_lexer(input);
+    parser = create_parser(lexer);
+    ast = parse_program(parser);
+    OutputSink *sink = create_memory_sink();
+    write_ast(sink, ast);
+    const char *tree = sink_contents(sink, NULL);
+    assert(strstr(tree, "[depth 200] BINARY_OP: PLUS") != NULL);
+    assert(strstr(tree, "[depth 201] IDENTIFIER: a") != NULL);
+    close_sink(sink);
+
+    printf("Deep expression test passed\n");
+
+    free(input);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+}
+
+// the system allocator, except that growing the position array fails
+static void *fail_allocate(Allocator *self, size_t size, const char *site) {
+    (void)self;
+    (void)site;
+    return malloc(size);
+}
+
+static void *fail_reallocate(Allocator *self, void *pointer, size_t size, const char *site) {
+    (void)self;
+    if (strstr(site, "codegen.c") && size == sizeof(SourcePosition) * 200) return NULL;
+    return realloc(pointer, size);
+}
+
+static void fail_release(Allocator *self, void *pointer) {
+    (void)self;
+    free(pointer);
+}
+
+void test_out_of_memory() {
+    printf("Testing code generation running out of memory...\n");
+
+    char input[4096];
+    int length = 0;
+    for (int i = 0; i < 60; i++)
+        length += sprintf(input + length, "int v%d = %d;\n", i, i);
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL && !parser->has_error);
+
+    Allocator failing = {fail_allocate, fail_reallocate, fail_release};
+    Allocator *previous = set_allocator(&failing);
+    CodeGenerator *codegen = create_codegen();
+    // the code is truncated at 100 instructions, and generation says so
+    assert(generate_code(codegen, ast) != 0);
+    assert(codegen->out_of_memory && !codegen->has_error);
+    assert(codegen->count == codegen->capacity && codegen->capacity == 100);
+    free_codegen(codegen);
+    set_allocator(previous);
+
+    printf("Out of memory test passed\n");
+
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+}
+
 int main() {
     printf("=== Code Generator Tests ===\n\n");
     test_simple_assignment();
+    test_instruction_encoding();
+    test_deep_expression();
+    test_out_of_memory();
     printf("\nAll code generator tests passed!\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,528 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/driver.h"
+
+static int parse(CompileOptions *options, int argc, char **argv) {
+    OutputSink *diagnostics = create_fd_sink(2);
+    init_compile_options(options);
+    int result = parse_options(argc, argv, options, diagnostics);
+    close_sink(diagnostics);
+    return result;
+}
+
+void test_default_options() {
+    printf("Testing default options...\n");
+
+    CompileOptions options;
+    char *argv[] = {"simplelang", "input.sl"};
+    assert(parse(&options, 2, argv) == 0);
+    assert(options.input_count == 1);
+    assert(strcmp(options.input_paths[0], "input.sl") == 0);
+    assert(options.output_path == NULL);
+    assert(options.emit == EMIT_ASM);
+    // assembly needs no assembler pass
+    assert(options.stop_after == PHASE_CODEGEN);
+
+    char *x86[] = {"simplelang", "--target=x86-64", "input.sl"};
+    assert(parse(&options, 3, x86) == 0);
+    assert(options.emit == EMIT_BIN);
+    assert(options.stop_after == PHASE_ASSEMBLE);
+
+    assert(options.target == TARGET_X86_64);
+
+    // the 8-bit CPU with the simulator's extension writes assembly like the base one
+    char *extended[] = {"simplelang", "--target=8bit-ext", "input.sl"};
+    assert(parse(&options, 3, extended) == 0);
+    assert(options.target == TARGET_8BIT_EXT && options.emit == EMIT_ASM);
+
+    char *unlimited[] = {"simplelang", "--max-errors=0", "input.sl"};
+    assert(parse(&options, 3, unlimited) == 0);
+    assert(options.max_errors == 0);
+    assert(options.max_cycles == DEFAULT_MAX_CYCLES);
+
+    printf("Default options test passed\n");
+}
+
+void test_emit_selects_last_phase() {
+    printf("Testing that --emit runs only the phases it needs...\n");
+
+    CompileOptions options;
+    char *tokens[] = {"simplelang", "--emit=tokens", "input.sl"};
+    assert(parse(&options, 3, tokens) == 0);
+    assert(options.emit == EMIT_TOKENS && options.stop_after == PHASE_LEX);
+
+    char *ast[] = {"simplelang", "input.sl", "--emit=ast"};
+    assert(parse(&options, 3, ast) == 0);
+    assert(options.emit == EMIT_AST && options.stop_after == PHASE_PARSE);
+
+    char *hex[] = {"simplelang", "--emit=hex", "-o", "-", "input.sl"};
+    assert(parse(&options, 5, hex) == 0);
+    assert(options.emit == EMIT_HEX && options.stop_after == PHASE_ASSEMBLE);
+    assert(strcmp(options.output_path, "-") == 0);
+
+    char *listing[] = {"simplelang", "--listing", "input.sl"};
+    assert(parse(&options, 3, listing) == 0);
+    assert(options.emit == EMIT_LISTING && options.stop_after == PHASE_ASSEMBLE);
+
+    // running on the host writes nothing by default
+    char *vm[] = {"simplelang", "--vm", "input.sl"};
+    assert(parse(&options, 3, vm) == 0);
+    assert(options.emit == EMIT_NONE && options.stop_after == PHASE_PARSE);
+
+    printf("Emit phase test passed\n");
+}
+
+void test_output_extension() {
+    printf("Testing -o extension without --emit...\n");
+
+    CompileOptions options;
+    char *bin[] = {"simplelang", "input.sl", "-o", "out.bin"};
+    assert(parse(&options, 4, bin) == 0);
+    assert(options.emit == EMIT_BIN);
+
+    char *hex[] = {"simplelang", "input.sl", "-o", "out.hex"};
+    assert(parse(&options, 4, hex) == 0);
+    assert(options.emit == EMIT_HEX);
+
+    char *s[] = {"simplelang", "--target=x86-64", "input.sl", "-o", "out.s"};
+    assert(parse(&options, 5, s) == 0);
+    assert(options.emit == EMIT_ASM);
+
+    printf("Output extension test passed\n");
+}
+
+void test_stop_after() {
+    printf("Testing --stop-after...\n");
+
+    CompileOptions options;
+    char *check[] = {"simplelang", "--stop-after=parse", "input.sl"};
+    assert(parse(&options, 3, check) == 0);
+    assert(options.emit == EMIT_NONE && options.stop_after == PHASE_PARSE);
+
+    char *lex[] = {"simplelang", "--stop-after=lex", "input.sl"};
+    assert(parse(&options, 3, lex) == 0);
+    assert(options.stop_after == PHASE_LEX);
+
+    // a later phase than the output needs still runs
+    char *later[] = {"simplelang", "--emit=asm", "--stop-after=assemble", "input.sl"};
+    assert(parse(&options, 4, later) == 0);
+    assert(options.stop_after == PHASE_ASSEMBLE);
+
+    printf("Stop-after test passed\n");
+}
+
+void test_many_inputs() {
+    printf("Testing several inputs and response files...\n");
+
+    FILE *list = fopen("output/test_inputs.rsp", "w");
+    assert(list != NULL);
+    fprintf(list, "examples/counter.sl\n  examples/conditional.sl\texamples/simple_math.sl\n");
+    fclose(list);
+
+    CompileOptions options;
+    char *argv[] = {"simplelang", "-j", "4", "input.sl", "@output/test_inputs.rsp", "-o", "-"};
+    assert(parse(&options, 7, argv) == 0);
+    assert(options.jobs == 4);
+    assert(options.input_count == 4);
+    assert(strcmp(options.input_paths[0], "input.sl") == 0);
+    assert(strcmp(options.input_paths[1], "examples/counter.sl") == 0);
+    assert(strcmp(options.input_paths[2], "examples/conditional.sl") == 0);
+    assert(strcmp(options.input_paths[3], "examples/simple_math.sl") == 0);
+    free_compile_options(&options);
+    remove("output/test_inputs.rsp");
+
+    // run results say which input they belong to, in input order
+    const char *modes[] = {"--vm", "--run", "--simulate"};
+    for (int i = 0; i < 3; i++) {
+        char *run[] = {"simplelang", (char *)modes[i], "-j", "2", "examples/counter.sl", "examples/conditional.sl"};
+        assert(parse(&options, 6, run) == 0);
+        OutputSink *out = create_memory_sink();
+        OutputSink *diagnostics = create_memory_sink();
+        assert(compile_all(&options, out, diagnostics) == 0);
+        const char *text = sink_contents(out, NULL);
+        const char *first = strstr(text, "examples/counter.sl:\n");
+        const char *second = strstr(text, "examples/conditional.sl:\n");
+        assert(first == text && second != NULL && second > first);
+        close_sink(out);
+        close_sink(diagnostics);
+        free_compile_options(&options);
+    }
+
+    printf("Several inputs test passed\n");
+}
+
+void test_job_sinks() {
+    printf("Testing that a job writes only into its own sinks...\n");
+
+    CompileOptions options;
+    char *argv[] = {"simplelang", "--vm", "memory.sl"};
+    assert(parse(&options, 3, argv) == 0);
+
+    CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    char source[] = "int a = 5;\nif (a == 5) {\n    a = 6;\n}\n";
+    assert(compile_source(&job, source) == 0);
+    assert(strcmp(sink_contents(job.out, NULL), "a = 6\n") == 0);
+    assert(strcmp(sink_contents(job.diagnostics, NULL), "") == 0);
+
+    char broken[] = "int a = ;\n";
+    assert(compile_source(&job, broken) != 0);
+    assert(strncmp(sink_contents(job.diagnostics, NULL), "memory.sl:1:9: error:", 21) == 0);
+
+    // every syntax error is reported, not just the first
+    char several[] = "int b = 1 +;\nint c = 2;\nc = (3;\n";
+    assert(compile_source(&job, several) != 0);
+    const char *errors = sink_contents(job.diagnostics, NULL);
+    assert(strstr(errors, "memory.sl:1:12: error: ") != NULL);
+    assert(strstr(errors, "memory.sl:3:7: error: ") != NULL);
+
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+    free_compile_options(&options);
+
+    printf("Job sink test passed\n");
+}
+
+void test_cached_outputs() {
+    printf("Testing cached compiles...\n");
+
+    CompileOptions options;
+    char *argv[] = {"simplelang", "--emit=ir", "--cache-dir=output/test_driver_cache", "--cache-size=1m", "memory.sl"};
+    assert(parse(&options, 5, argv) == 0);
+    assert(options.cache_size == 1024 * 1024);
+    // start empty: a zero limit evicts whatever an earlier run left
+    Cache *cache = open_cache(options.cache_directory, 0);
+    assert(cache != NULL);
+    cache_trim(cache);
+    close_cache(cache);
+    cache = open_cache(options.cache_directory, options.cache_size);
+    assert(cache != NULL);
+
+    // the second compile of the same source is served from the cache, byte for byte
+    char source[] = "int a = 2;\nint b = a + 1;\n";
+    char *listings[2];
+    for (int i = 0; i < 2; i++) {
+        CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, cache, NULL, NULL, 0};
+        assert(compile_source(&job, source) == 0);
+        listings[i] = strdup(sink_contents(job.out, NULL));
+        close_sink(job.out);
+        close_sink(job.diagnostics);
+    }
+    assert(cache->misses == 1 && cache->stores == 1 && cache->hits == 1);
+    assert(strstr(listings[0], "sta %var_b") != NULL);
+    assert(strcmp(listings[0], listings[1]) == 0);
+    free(listings[0]);
+    free(listings[1]);
+
+    // failed compiles are never stored
+    char broken[] = "int = 1;\n";
+    CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, cache, NULL, NULL, 0};
+    assert(compile_source(&job, broken) != 0);
+    assert(compile_source(&job, broken) != 0);
+    assert(cache->stores == 1 && cache->misses == 3);
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+
+    // every entry goes once the limit is below any of them
+    cache->size_limit = 0;
+    assert(cache_trim(cache) == 1);
+    close_cache(cache);
+    remove("output/test_driver_cache");
+    free_compile_options(&options);
+
+    printf("Cache test passed\n");
+}
+
+void test_time_report() {
+    printf("Testing per-phase timing...\n");
+
+    CompileOptions options;
+    char *argv[] = {"simplelang", "--time-report=output/times.json", "--emit=ir", "memory.sl"};
+    assert(parse(&options, 4, argv) == 0);
+    assert(options.time_report && options.time_format == TIME_FORMAT_JSON);
+
+    TimeReport times = {{0}, {0}};
+    CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, NULL, &times, NULL, 0};
+    char source[] = "int a = 1;\nint b = a + 2;\n";
+    assert(compile_source(&job, source) == 0);
+    // int a = 1 ; and int b = a + 2 ; with a newline after each
+    assert(times.items[TIME_LEX] == 14);
+    // program, two declarations, number, binary op and its two operands
+    assert(times.items[TIME_PARSE] == 7);
+    assert(times.items[TIME_CODEGEN] > 0);
+    // the analysis and every pass that ran have rows of their own, as --pass-stats shows them
+    assert(times.nanoseconds[TIME_ANALYSIS] > 0 && times.nanoseconds[TIME_FOLD] > 0);
+    assert(times.nanoseconds[TIME_PEEPHOLE] > 0 && times.nanoseconds[TIME_SLOTS] > 0);
+    assert(times.items[TIME_WRITE] == strlen(sink_contents(job.out, NULL)));
+    assert(times.items[TIME_ASSEMBLE] == 0);
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+    free_compile_options(&options);
+
+    printf("Timing test passed\n");
+}
+
+void test_run_budget() {
+    printf("Testing that runs stop at --max-cycles...\n");
+
+    char source[] = "int k = 1;\nwhile (k) { k = k + 0; }\n";
+    const char *modes[] = {"--simulate", "--vm", "--run"};
+    for (int i = 0; i < 3; i++) {
+        CompileOptions options;
+        char *argv[] = {"simplelang", (char *)modes[i], "--max-cycles=5000", "memory.sl"};
+        assert(parse(&options, 4, argv) == 0);
+        assert(options.max_cycles == 5000);
+        CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+        char copy[sizeof(source)];
+        memcpy(copy, source, sizeof(source));
+        assert(compile_source(&job, copy) != 0);
+        const char *report = i == 0 ? sink_contents(job.out, NULL) : sink_contents(job.diagnostics, NULL);
+        assert(strstr(report, i == 0 ? "cycle limit reached" : "Stopped after 5000 loop iterations") != NULL);
+        close_sink(job.out);
+        close_sink(job.diagnostics);
+        free_compile_options(&options);
+    }
+
+    printf("Run budget test passed\n");
+}
+
+void test_output_directory() {
+    printf("Testing that default outputs create output/...\n");
+
+    char directory[] = "/tmp/simplelang-driver-XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    CompileOptions options;
+    char *argv[] = {"simplelang", "memory.sl"};
+    assert(parse(&options, 2, argv) == 0);
+    options.base_directory = directory;
+    CompileJob job = {&options, "memory.sl", create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    char source[] = "int a = 5;\n";
+    assert(compile_source(&job, source) == 0);
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/output/memory.asm", directory);
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+    fclose(file);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/output", directory);
+    rmdir(path);
+    rmdir(directory);
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+    free_compile_options(&options);
+
+    printf("Output directory test passed\n");
+}
+
+static void write_text(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    assert(file != NULL);
+    fputs(text, file);
+    fclose(file);
+}
+
+// the objects saved under output/ for modules named name, their paths in found
+static int saved_objects(const char *name, char found[][512], int capacity) {
+    DIR *dir = opendir("output");
+    assert(dir != NULL);
+    int count = 0;
+    size_t length = strlen(name);
+    struct dirent *item;
+    while ((item = readdir(dir))) {
+        const char *entry = item->d_name;
+        if (strncmp(entry, name, length) == 0 && entry[length] == '-' && count < capacity) {
+            // a temporary file left by the rename would show up here too
+            assert(strcmp(entry + strlen(entry) - 4, ".slo") == 0);
+            snprintf(found[count++], 512, "output/%s", entry);
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+void test_modules() {
+    printf("Testing imports, objects and linking...\n");
+
+    CompileOptions options;
+    char *objects[] = {"simplelang", "a.slo", "b.slo", "-o", "program.hex"};
+    assert(parse(&options, 5, objects) == 0);
+    assert(options.link && options.emit == EMIT_HEX && options.stop_after == PHASE_ASSEMBLE);
+    free_compile_options(&options);
+
+    // an import is built into output/<module>-<path hash>.slo and linked in ahead of the importer
+    write_text("output/test_driver_lib.sl", "int base = 40;\n");
+    write_text("output/test_driver_main.sl", "import test_driver_lib;\nextern int base;\nint answer = base + 2;\n");
+    char *argv[] = {"simplelang", "--simulate", "output/test_driver_main.sl"};
+    assert(parse(&options, 3, argv) == 0);
+    CompileJob job = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&job) == 0);
+    assert(job.linked);
+    assert(strstr(sink_contents(job.out, NULL), "answer             42") != NULL);
+    char objects_saved[4][512];
+    assert(saved_objects("test_driver_lib", objects_saved, 4) == 1);
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+
+    // a changed import is rebuilt rather than taken from the stale object
+    write_text("output/test_driver_lib.sl", "int base = 1;\n");
+    CompileJob again = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&again) == 0);
+    assert(strstr(sink_contents(again.out, NULL), "answer              3") != NULL);
+    close_sink(again.out);
+    close_sink(again.diagnostics);
+    free_compile_options(&options);
+
+    assert(saved_objects("test_driver_lib", objects_saved, 4) == 1);
+
+    // a module of the same name in another directory gets an object of its own
+    assert(mkdir("output/test_driver_other", 0755) == 0);
+    write_text("output/test_driver_other/test_driver_lib.sl", "int base = 7;\n");
+    write_text("output/test_driver_other/test_driver_main.sl",
+               "import test_driver_lib;\nextern int base;\nint answer = base + 2;\n");
+    char *other[] = {"simplelang", "--simulate", "output/test_driver_other/test_driver_main.sl"};
+    assert(parse(&options, 3, other) == 0);
+    CompileJob elsewhere = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&elsewhere) == 0);
+    assert(strstr(sink_contents(elsewhere.out, NULL), "answer              9") != NULL);
+    close_sink(elsewhere.out);
+    close_sink(elsewhere.diagnostics);
+    free_compile_options(&options);
+    assert(saved_objects("test_driver_lib", objects_saved, 4) == 2);
+    for (int i = 0; i < 2; i++)
+        remove(objects_saved[i]);
+
+    remove("output/test_driver_lib.sl");
+    remove("output/test_driver_main.sl");
+    remove("output/test_driver_other/test_driver_lib.sl");
+    remove("output/test_driver_other/test_driver_main.sl");
+    rmdir("output/test_driver_other");
+
+    printf("Modules test passed\n");
+}
+
+void test_ast_files() {
+    printf("Testing --emit=ast-bin and --from=ast-bin...\n");
+
+    write_text("output/test_driver_tree.sl", "int n = 4; int s = 0;\nwhile (n) { s = s + n; n = n - 1; }\n");
+    CompileOptions options;
+    char *save[] = {"simplelang", "--emit=ast-bin", "output/test_driver_tree.sl"};
+    assert(parse(&options, 3, save) == 0);
+    assert(options.emit == EMIT_AST_BIN && options.stop_after == PHASE_PARSE);
+    CompileJob job = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&job) == 0);
+    close_sink(job.out);
+    close_sink(job.diagnostics);
+    free_compile_options(&options);
+
+    // the tree is mapped and compiled without the source
+    remove("output/test_driver_tree.sl");
+    char *load[] = {"simplelang", "--from=ast-bin", "--simulate", "output/test_driver_tree.sla"};
+    assert(parse(&options, 4, load) == 0);
+    assert(options.from == INPUT_AST_BIN && options.stop_after == PHASE_ASSEMBLE);
+    CompileJob run = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&run) == 0);
+    assert(strstr(sink_contents(run.out, NULL), "s                  10") != NULL);
+    close_sink(run.out);
+    close_sink(run.diagnostics);
+    free_compile_options(&options);
+
+    // a source is no AST file
+    write_text("output/test_driver_tree.sla", "int n = 4;\n");
+    char *text[] = {"simplelang", "--from=ast-bin", "output/test_driver_tree.sla"};
+    assert(parse(&options, 3, text) == 0);
+    CompileJob wrong = {&options, options.input_paths[0], create_memory_sink(), create_memory_sink(), 0, NULL, NULL, NULL, 0};
+    assert(compile_file(&wrong) != 0);
+    assert(strstr(sink_contents(wrong.diagnostics, NULL), "not a simplelang AST file") != NULL);
+    close_sink(wrong.out);
+    close_sink(wrong.diagnostics);
+    free_compile_options(&options);
+    remove("output/test_driver_tree.sla");
+
+    printf("AST file test passed\n");
+}
+
+void test_bad_usage() {
+    printf("Testing rejected command lines (errors expected below)...\n");
+
+    CompileOptions options;
+    char *none[] = {"simplelang"};
+    assert(parse(&options, 1, none) == -1);
+
+    char *early[] = {"simplelang", "--emit=asm", "--stop-after=parse", "input.sl"};
+    assert(parse(&options, 4, early) == -1);
+
+    char *kind[] = {"simplelang", "--emit=pdf", "input.sl"};
+    assert(parse(&options, 3, kind) == -1);
+
+    char *two[] = {"simplelang", "a.sl", "b.sl", "-o", "out.asm"};
+    assert(parse(&options, 5, two) == -1);
+
+    char *ir[] = {"simplelang", "--target=x86-64", "--emit=ir", "input.sl"};
+    assert(parse(&options, 4, ir) == -1);
+
+    char *x86_listing[] = {"simplelang", "--target=x86-64", "--listing", "input.sl"};
+    assert(parse(&options, 4, x86_listing) == -1);
+
+    char *stdin_twice[] = {"simplelang", "-", "-"};
+    assert(parse(&options, 3, stdin_twice) == -1);
+
+    char *mixed[] = {"simplelang", "a.slo", "b.sl"};
+    assert(parse(&options, 3, mixed) == -1);
+
+    char *listing[] = {"simplelang", "--emit=asm", "a.slo"};
+    assert(parse(&options, 3, listing) == -1);
+
+    char *size[] = {"simplelang", "--cache-size=12q", "input.sl"};
+    assert(parse(&options, 3, size) == -1);
+
+    char *tokens[] = {"simplelang", "--from=ast-bin", "--emit=tokens", "a.sla"};
+    assert(parse(&options, 4, tokens) == -1);
+
+    char *from_stdin[] = {"simplelang", "--from=ast-bin", "-"};
+    assert(parse(&options, 3, from_stdin) == -1);
+
+    char *errors[] = {"simplelang", "--max-errors=some", "input.sl"};
+    assert(parse(&options, 3, errors) == -1);
+
+    char *cycles[] = {"simplelang", "--max-cycles=-1", "input.sl"};
+    assert(parse(&options, 3, cycles) == -1);
+
+    char *help[] = {"simplelang", "--help"};
+    assert(parse(&options, 2, help) == 1);
+    // the modes main takes before any option are listed too
+    OutputSink *usage = create_memory_sink();
+    write_usage(usage, "simplelang");
+    const char *text = sink_contents(usage, NULL);
+    assert(strstr(text, "--daemon") && strstr(text, "--connect") && strstr(text, "--stop-daemon") &&
+           strstr(text, "--lsp"));
+    close_sink(usage);
+
+    printf("Bad usage test passed\n");
+}
+
+int main() {
+    printf("Running driver tests...\n\n");
+
+    test_default_options();
+    test_emit_selects_last_phase();
+    test_output_extension();
+    test_stop_after();
+    test_many_inputs();
+    test_job_sinks();
+    test_run_budget();
+    test_output_directory();
+    test_cached_outputs();
+    test_time_report();
+    test_modules();
+    test_ast_files();
+    test_bad_usage();
+
+    printf("\nAll driver tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/jit.h"
+#include "../include/bytecode.h"
+
+// run a program with the JIT and the bytecode VM and check both agree on every variable
+static void check_against_vm(char *input) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    JitProgram *jit = jit_compile(ast);
+    assert(jit != NULL);
+    BytecodeProgram *vm = compile_bytecode(ast);
+    assert(vm != NULL);
+    assert(jit->symbols.count == vm->symbols.count);
+
+    int *jit_slots = calloc(jit->symbols.count + 1, sizeof(int));
+    int *vm_slots = calloc(vm->symbols.count + 1, sizeof(int));
+    assert(jit_run(jit, jit_slots, 0) == 0);
+    assert(run_bytecode(vm, vm_slots, 0) == 0);
+    for (int i = 0; i < jit->symbols.count; i++) {
+        assert(strcmp(symbol_name(&jit->symbols, i), symbol_name(&vm->symbols, i)) == 0);
+        assert(jit_slots[i] == vm_slots[i]);
+    }
+
+    free(jit_slots);
+    free(vm_slots);
+    free_bytecode(vm);
+    free_jit_program(jit);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+}
+
+void test_arithmetic() {
+    printf("Testing JIT arithmetic...\n");
+    check_against_vm("int a = 10; int b = 5; int sum = a + b; int diff = a - b;");
+    check_against_vm("int a = 7; int r = (a - 1) - (a - (a + 2));");
+    check_against_vm("int a = 2147483647; int r = a + 1;");
+    printf("Arithmetic tests passed\n");
+}
+
+void test_multiply_and_shifts() {
+    printf("Testing JIT multiplication and shifts...\n");
+    check_against_vm("int a = 7; int b = 13; int c = a * b; int d = a * 10 + b * 8; int e = 3 * a;");
+    check_against_vm("int a = 0 - 100; int n = 35; int r = (a >> 2) + (a << 3) + (a >> n) + (1 << n);");
+    check_against_vm("int a = 65537; int r = a * a * 4096;");
+    // the shift count in rcx while rcx holds the other operand, and both spilled
+    check_against_vm("int a = 5; int r = a << (a - 3); int s = (a + 1) >> (a - 4);");
+    check_against_vm("int a = 2; int r = a * (a << (a * (a << (a * (a << (a * (a << (a * (a >> 1)))))))));");
+    printf("Multiplication and shift tests passed\n");
+}
+
+void test_conditionals() {
+    printf("Testing JIT conditionals...\n");
+    check_against_vm("int x = 5; if (x == 5) { x = x + 1; } else { x = x - 1; }");
+    check_against_vm("int x = 4; if (x == 5) { x = x + 1; } else { x = x - 1; }");
+    check_against_vm("int x = 2; int y = (x == 2) + (x == 3); if (y) { x = 0; }");
+    check_against_vm("int x = 1; int y = 1; if ((x + 1) == (y + 1)) { y = 9; }");
+    printf("Conditional tests passed\n");
+}
+
+void test_loops() {
+    printf("Testing JIT loops...\n");
+    check_against_vm("int n = 10; int total = 0; while (n) { n = n - 1; total = total + n; }");
+    check_against_vm("int n = 0; int r = 7; while (n) { r = 0; }");
+    check_against_vm("int k = 0; int r = 0; while (k == 0) { r = r + 5; if (r == 20) { k = 1; } }");
+    check_against_vm("int i = 3; int c = 0; while (i) { int j = 4; while (j) { c = c + 1; j = j - 1; } i = i - 1; }");
+    printf("Loop tests passed\n");
+}
+
+void test_register_pressure() {
+    printf("Testing every temporary register and spills...\n");
+    // each level nests one register deeper, past the seven temporaries
+    check_against_vm("int a = 1; int r = a + (a + (a + (a + (a + (a + (a + (a + (a + (a + 1)))))))));");
+    check_against_vm("int a = 3; int r = (a == (a + (a - (a + (a == (a + (a + (a + (a - 1)))))))));");
+    printf("Register pressure tests passed\n");
+}
+
+// run with an iteration budget on both, returns what they returned after checking they agree
+static int run_with_budget(char *input, long long max_iterations, int *count) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL && !parser->has_error);
+    JitProgram *jit = jit_compile(ast);
+    BytecodeProgram *vm = compile_bytecode(ast);
+    assert(jit != NULL && vm != NULL);
+
+    int *jit_slots = calloc(jit->symbols.count + 1, sizeof(int));
+    int *vm_slots = calloc(vm->symbols.count + 1, sizeof(int));
+    int result = jit_run(jit, jit_slots, max_iterations);
+    assert(run_bytecode(vm, vm_slots, max_iterations) == result);
+    for (int i = 0; i < jit->symbols.count; i++) {
+        assert(jit_slots[i] == vm_slots[i]);
+    }
+    *count = jit_slots[find_symbol(&jit->symbols, "count")];
+
+    free(jit_slots);
+    free(vm_slots);
+    free_bytecode(vm);
+    free_jit_program(jit);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return result;
+}
+
+void test_iteration_budget() {
+    printf("Testing the loop iteration budget...\n");
+    int count;
+    char *forever = "int k = 1; int count = 0; while (k) { count = count + 1; }";
+    assert(run_with_budget(forever, 50, &count) == RUN_LIMIT_REACHED);
+    assert(count == 50);
+    char *forever_equal = "int k = 0; int count = 0; while (k == 0) { count = count + 1; }";
+    assert(run_with_budget(forever_equal, 7, &count) == RUN_LIMIT_REACHED);
+    assert(count == 7);
+
+    // iterations of every loop count, nested ones included
+    char *nested = "int i = 3; int count = 0; while (i) { int j = 4; while (j) { count = count + 1; j = j - 1; } i = i - 1; }";
+    assert(run_with_budget(nested, 15, &count) == 0);
+    assert(count == 12);
+    assert(run_with_budget(nested, 14, &count) == RUN_LIMIT_REACHED);
+    printf("Iteration budget tests passed\n");
+}
+
+int main() {
+    printf("=== JIT Tests ===\n\n");
+    test_arithmetic();
+    test_multiply_and_shifts();
+    test_conditionals();
+    test_loops();
+    test_register_pressure();
+    test_iteration_budget();
+    printf("\nAll JIT tests passed!\n");
+    return 0;
+}
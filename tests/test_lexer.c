@@ -1,14 +1,35 @@
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../include/lexer.h"
 #include "token.h"
-int main()
+
+// hands out the text a few bytes at a time, so tokens straddle the reads
+typedef struct
 {
+    const char *text;
+    int position;
+    int calls;
+    int fail_after; // calls before an error, -1 for never
+} PieceReader;
 
-    char *test_input = "int a = 42;";
+static int read_pieces(void *context, char *buffer, int size)
+{
+    PieceReader *reader = context;
+    if (reader->fail_after >= 0 && reader->calls >= reader->fail_after)
+        return -1;
+    int piece = 1 + reader->calls++ % 3;
+    int left = (int)strlen(reader->text + reader->position);
+    int count = piece < left ? piece : left;
+    count = count < size ? count : size;
+    memcpy(buffer, reader->text + reader->position, count);
+    reader->position += count;
+    return count;
+}
 
-    Lexer *lexer = create_lexer(test_input);
+static void print_tokens(Lexer *lexer)
+{
     Token *token;
     while ((token = get_next_token(lexer)) && token->type != TOKEN_EOF)
     {
@@ -21,7 +42,71 @@ int main()
         print_token(token);
         free_token(token);
     }
+}
+
+void test_stream_matches_text()
+{
+    printf("Testing a stream read in pieces against the whole text...\n");
+
+    char *text = "int counter = 42;\nif (counter == 42) {\n    counter = counter + 1;\n}\n";
+    PieceReader reader = {text, 0, 0, -1};
+    Lexer *whole = create_lexer(text);
+    Lexer *stream = create_stream_lexer(read_pieces, &reader);
+    assert(stream != NULL);
+
+    int count = 0;
+    for (;;)
+    {
+        Token *expected = get_next_token(whole);
+        Token *token = get_next_token(stream);
+        assert(token->type == expected->type);
+        assert(strcmp(token->value, expected->value) == 0);
+        assert(token->line == expected->line && token->column == expected->column);
+        int done = token->type == TOKEN_EOF;
+        free_token(expected);
+        free_token(token);
+        if (done)
+            break;
+        count++;
+    }
+    assert(count == 23);
+    assert(reader.calls > 20);
+    assert(!stream->read_error);
+
+    free_lexer(whole);
+    free_lexer(stream);
+    printf("Stream test passed\n");
+}
+
+void test_stream_error()
+{
+    printf("Testing a stream that fails part way...\n");
+
+    PieceReader reader = {"int a = 1;\nint b = 2;\n", 0, 0, 4};
+    Lexer *lexer = create_stream_lexer(read_pieces, &reader);
+    Token *token;
+    while ((token = get_next_token(lexer)) && token->type != TOKEN_EOF)
+    {
+        free_token(token);
+    }
+    free_token(token);
+    // the tokens simply end, the flag tells the caller why
+    assert(lexer->read_error);
 
     free_lexer(lexer);
+    printf("Stream error test passed\n");
+}
+
+int main()
+{
+
+    char *test_input = "int a = 42;";
+
+    Lexer *lexer = create_lexer(test_input);
+    print_tokens(lexer);
+    free_lexer(lexer);
+
+    test_stream_matches_text();
+    test_stream_error();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/codegen.h"
+#include "../include/assembler.h"
+#include "../include/linker.h"
+#include "../include/simulator.h"
+
+// extended_isa lets the code use the simulator's extension (codegen.h)
+static ObjectModule *compile_module_on(char *input, int extended_isa) {
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    CodeGenerator *codegen = create_codegen();
+    codegen->shared_globals = 1;
+    codegen->extended_isa = extended_isa;
+    generate_code(codegen, ast);
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    ObjectModule *module = create_object_module(codegen, image, 1234);
+    assert(module != NULL);
+
+    free_program_image(image);
+    free_codegen(codegen);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return module;
+}
+
+static ObjectModule *compile_module(char *input) {
+    return compile_module_on(input, 0);
+}
+
+void test_object_round_trip() {
+    printf("Testing module objects...\n");
+
+    ObjectModule *module = compile_module_on("import lib;\nextern int base;\nint x = base + 1;\n", 1);
+    // globals other modules see take two bytes: lda base+1, mov G A, lda base, ldi B 1,
+    // add, 3 mov, ldi B 0, adc, 3 mov, sta x, mov A G, sta x+1 (with the extension's adc);
+    // the hlt is left to the linker
+    assert(module->text_size == 26);
+    assert(module->data_size == 2);
+    assert(module->symbol_count == 2);
+    assert(strcmp(module->symbols[0].name, "base") == 0);
+    assert(module->symbols[0].kind == OBJECT_SYMBOL_EXTERN);
+    assert(module->symbols[1].kind == OBJECT_SYMBOL_DEFINED && module->symbols[1].offset == 0);
+    assert(module->relocation_count == 4);
+    // the address of a high byte holds its offset into the slot
+    assert(module->relocations[0].offset == 1 && module->relocations[0].symbol == 0 && module->text[1] == 1);
+    assert(module->relocations[1].offset == 5 && module->text[5] == 0);
+    assert(module->relocations[3].offset == 24 && module->relocations[3].symbol == 1 && module->text[24] == 1);
+    assert(module->import_count == 1 && strcmp(module->imports[0], "lib") == 0);
+
+    OutputSink *sink = create_memory_sink();
+    assert(write_object(module, sink) == 0);
+    size_t length;
+    const unsigned char *bytes = (const unsigned char *)sink_contents(sink, &length);
+    ObjectModule *copy = read_object(bytes, length);
+    assert(copy != NULL);
+    assert(copy->source_hash == 1234);
+    assert(copy->text_size == module->text_size);
+    assert(memcmp(copy->text, module->text, module->text_size) == 0);
+    assert(copy->symbol_count == 2 && strcmp(copy->symbols[1].name, "x") == 0);
+    assert(copy->relocation_count == 4 && copy->relocations[3].offset == 24);
+    assert(copy->import_count == 1 && strcmp(copy->imports[0], "lib") == 0);
+    free_object_module(copy);
+
+    // anything short or foreign is rejected rather than half read, and so is an address
+    // past the end of its slot (text starts after the magic, hash and text size)
+    assert(read_object(bytes, length - 1) == NULL);
+    assert(read_object((const unsigned char *)"SLC1xxxxxxxxxxxxxxxx", 20) == NULL);
+    unsigned char *bad = malloc(length);
+    memcpy(bad, bytes, length);
+    bad[16 + 1] = 2;
+    assert(read_object(bad, length) == NULL);
+    // names are identifiers, or they would be pasted into assembly as they are: the
+    // import comes last, a symbol's name is found by its text
+    memcpy(bad, bytes, length);
+    bad[length - 1] = '"';
+    assert(read_object(bad, length) == NULL);
+    bad[length - 1] = 'b';
+    bad[length - 3] = '1';
+    assert(read_object(bad, length) == NULL);
+    memcpy(bad, bytes, length);
+    size_t name = 0;
+    while (memcmp(bad + name, "base", 4) != 0) name++;
+    bad[name + 2] = '\n';
+    assert(read_object(bad, length) == NULL);
+    free(bad);
+
+    printf("Object test passed\n");
+
+    close_sink(sink);
+    free_object_module(module);
+}
+
+void test_link_and_run() {
+    printf("Testing linking modules...\n");
+
+    ObjectModule *modules[2];
+    const char *names[] = {"lib.sl", "main.sl"};
+    modules[0] = compile_module("int base = 40;\n");
+    modules[1] = compile_module("extern int base;\nint answer = base + 2;\n");
+
+    SymbolTable symbols;
+    init_symbol_table(&symbols);
+    ProgramImage *image = link_modules(modules, names, 2, &symbols);
+    assert(image != NULL && !image->has_error);
+    // both texts, one hlt, then base and answer, two bytes each
+    assert(image->text_size == modules[0]->text_size + modules[1]->text_size + 1);
+    assert(image->bytes[image->text_size - 1] == ENC_HLT);
+    assert(image->size == image->text_size + 4);
+    assert(symbols.count == 2 && image->symbol_address[1] == image->text_size + 2);
+    assert(image->symbol_size[1] == 2);
+
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 0) == 0);
+    assert(read_variable(sim, image, find_symbol(&symbols, "base")) == 40);
+    assert(read_variable(sim, image, find_symbol(&symbols, "answer")) == 42);
+
+    printf("Link test passed\n");
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+    free_object_module(modules[1]);
+}
+
+void test_link_loops() {
+    printf("Testing jumps in linked modules...\n");
+
+    ObjectModule *modules[2];
+    const char *names[] = {"lib.sl", "main.sl"};
+    modules[0] = compile_module("int base = 0;\nint n = 4;\nwhile (n) { base = base + 10; n = n - 1; }\n");
+    modules[1] = compile_module("extern int base;\nint answer = 0;\nint k = 3;\n"
+                                "while (k) { answer = answer + base; k = k - 1; }\n");
+    // k counts down from 3, so one byte of it is enough for the loop test; the two byte
+    // sum brings jumps of its own
+    assert(modules[1]->jump_count > 2);
+
+    // jump targets stay module relative in the object and survive a round trip
+    OutputSink *sink = create_memory_sink();
+    assert(write_object(modules[1], sink) == 0);
+    size_t length;
+    const unsigned char *bytes = (const unsigned char *)sink_contents(sink, &length);
+    ObjectModule *copy = read_object(bytes, length);
+    assert(copy != NULL);
+    assert(copy->jump_count == modules[1]->jump_count &&
+           memcmp(copy->jumps, modules[1]->jumps, sizeof(int) * copy->jump_count) == 0);
+    assert(memcmp(copy->text, modules[1]->text, modules[1]->text_size) == 0);
+    free_object_module(copy);
+    close_sink(sink);
+
+    // main's loop lands after lib's text, so its jumps must be moved with it
+    SymbolTable symbols;
+    init_symbol_table(&symbols);
+    ProgramImage *image = link_modules(modules, names, 2, &symbols);
+    assert(image != NULL && !image->has_error);
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 100000) == 0);
+    assert(read_variable(sim, image, find_symbol(&symbols, "base")) == 40);
+    assert(read_variable(sim, image, find_symbol(&symbols, "answer")) == 120);
+
+    printf("Linked loop test passed\n");
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+    free_object_module(modules[1]);
+}
+
+void test_link_runtime_calls() {
+    printf("Testing runtime routines shared by linked modules...\n");
+
+    ObjectModule *modules[2];
+    const char *names[] = {"lib.sl", "main.sl"};
+    modules[0] = compile_module_on("int x = 6;\nint y = x * x;\n", 1);
+    modules[1] = compile_module_on("extern int x;\nint z = x * 7 + (x << x);\nint w = z * x;\n", 1);
+    // neither object carries the routines, only the calls to them; main.sl's x may hold
+    // anything, so its products and shift are two byte ones
+    assert(modules[0]->call_count == 1 && modules[0]->calls[0].routine == RUNTIME_MULTIPLY);
+    assert(modules[1]->calls[0].routine == RUNTIME_MULTIPLY_WIDE);
+    assert(modules[1]->call_count == 3);
+
+    OutputSink *sink = create_memory_sink();
+    assert(write_object(modules[1], sink) == 0);
+    size_t length;
+    const unsigned char *bytes = (const unsigned char *)sink_contents(sink, &length);
+    ObjectModule *copy = read_object(bytes, length);
+    assert(copy != NULL);
+    assert(copy->call_count == 3 && memcmp(copy->calls, modules[1]->calls, sizeof(RuntimeCall) * 3) == 0);
+    free_object_module(copy);
+    close_sink(sink);
+
+    // the two byte multiply, the byte one it calls and the shift after the hlt, however
+    // many modules call them
+    SymbolTable symbols;
+    init_symbol_table(&symbols);
+    ProgramImage *image = link_modules(modules, names, 2, &symbols);
+    assert(image != NULL && !image->has_error);
+    int halt = modules[0]->text_size + modules[1]->text_size;
+    assert(image->bytes[halt] == ENC_HLT);
+    int returns = 0;
+    for (int i = halt + 1; i < image->text_size; i++)
+        returns += image->bytes[i] == ENC_RET;
+    assert(returns == 3);
+
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 100000) == 0);
+    assert(read_variable(sim, image, find_symbol(&symbols, "y")) == 36);
+    assert(read_variable(sim, image, find_symbol(&symbols, "z")) == 42 + (6 << 6));
+    assert(read_variable(sim, image, find_symbol(&symbols, "w")) == (42 + (6 << 6)) * 6);
+    // one call in lib.sl, three in main.sl and two from each two byte multiply
+    assert(sim->opcode_counts[OP_CALL] == 8);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+    free_object_module(modules[1]);
+
+    // the base CPU has no call: the objects carry the routines' code in place
+    modules[0] = compile_module("int x = 6;\nint y = x * x;\n");
+    modules[1] = compile_module("extern int x;\nint z = x * 7 + (x << x);\nint w = z * x;\n");
+    assert(modules[0]->call_count == 0 && modules[1]->call_count == 0);
+    init_symbol_table(&symbols);
+    image = link_modules(modules, names, 2, &symbols);
+    assert(image != NULL && !image->has_error);
+    assert(image->text_size == modules[0]->text_size + modules[1]->text_size + 1);
+    sim = create_simulator(image);
+    assert(run_simulator(sim, 1000000) == 0);
+    assert(read_variable(sim, image, find_symbol(&symbols, "y")) == 36);
+    assert(read_variable(sim, image, find_symbol(&symbols, "w")) == (42 + (6 << 6)) * 6);
+    assert(sim->opcode_counts[OP_CALL] == 0);
+
+    printf("Runtime routine test passed\n");
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+    free_object_module(modules[1]);
+}
+
+void test_link_errors() {
+    printf("Testing undefined and duplicate globals...\n");
+
+    ObjectModule *modules[2];
+    const char *names[] = {"a.sl", "b.sl"};
+    modules[0] = compile_module("extern int missing;\nint a = missing;\n");
+    SymbolTable symbols;
+    init_symbol_table(&symbols);
+    ProgramImage *image = link_modules(modules, names, 1, &symbols);
+    assert(image != NULL && image->has_error);
+    assert(strstr(image->error_message, "undefined reference to 'missing' in a.sl") != NULL);
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+
+    modules[0] = compile_module("int shared = 1;\n");
+    modules[1] = compile_module("int shared = 2;\n");
+    init_symbol_table(&symbols);
+    image = link_modules(modules, names, 2, &symbols);
+    assert(image != NULL && image->has_error);
+    assert(strstr(image->error_message, "'shared' is defined in both a.sl and b.sl") != NULL);
+    printf("Got expected error: %s\n", image->error_message);
+
+    free_program_image(image);
+    free_symbol_table(&symbols);
+    free_object_module(modules[0]);
+    free_object_module(modules[1]);
+}
+
+int main() {
+    printf("Running linker tests...\n\n");
+
+    test_object_round_trip();
+    printf("\n");
+    test_link_and_run();
+    printf("\n");
+    test_link_loops();
+    printf("\n");
+    test_link_runtime_calls();
+    printf("\n");
+    test_link_errors();
+
+    printf("\nAll linker tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/codegen.h"
+#include "../include/passes.h"
+#include "../include/assembler.h"
+#include "../include/simulator.h"
+#include "../include/listing.h"
+
+static const char *program_text =
+    "int n = 3; int s = 0;\n"
+    "while (n) {\n"
+    "  s = s + n;\n"
+    "  n = n - 1;\n"
+    "}\n"
+    "if (s == 6) { s = s * 3; } else { s = 1; }\n";
+
+static ASTNode *parse_source(const char *input) {
+    Lexer *lexer = create_lexer((char *)input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+    free_parser(parser);
+    free_lexer(lexer);
+    return ast;
+}
+
+static CodeGenerator *compile(ASTNode *ast, unsigned enabled) {
+    CodeGenerator *codegen = create_codegen();
+    PassOptions options = {enabled, 0};
+    assert(run_passes(codegen, ast, &options, NULL, NULL) == 0);
+    return codegen;
+}
+
+// bytes and cycles of the code generated for a line, 0 for the hlt and runtime
+static void line_totals(const CodeGenerator *codegen, int line, int *bytes, int *cycles) {
+    *bytes = *cycles = 0;
+    for (int i = 0; i < codegen->count; i++) {
+        const Instruction *inst = &codegen->instructions[i];
+        if (codegen->positions[i].line != line) continue;
+        *bytes += instruction_size(inst);
+        if (inst->opcode != OP_LABEL) *cycles += opcode_cycles((Opcode)inst->opcode);
+    }
+}
+
+// bytes and cycles of the summary row ending in description
+static void row_totals(const char *text, const char *description, int *bytes, int *cycles) {
+    const char *end = strstr(text, description);
+    assert(end != NULL);
+    const char *row = end;
+    while (row > text && row[-1] != '\n') row--;
+    assert(sscanf(row, "%d %d", bytes, cycles) == 2);
+}
+
+static char *listing_of(const CodeGenerator *codegen, ASTNode *ast, const char *source) {
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    OutputSink *sink = create_memory_sink();
+    assert(write_listing(sink, codegen, image, ast, source) == 0);
+    size_t length;
+    const char *contents = sink_contents(sink, &length);
+    char *text = malloc(length + 1);
+    memcpy(text, contents, length + 1);
+
+    // every byte of code is under one line or the runtime
+    int total = 0;
+    for (int line = 0; line <= 6; line++) {
+        int bytes, cycles;
+        line_totals(codegen, line, &bytes, &cycles);
+        total += bytes;
+    }
+    assert(total == image->text_size);
+
+    close_sink(sink);
+    free_program_image(image);
+    return text;
+}
+
+void test_lines_and_rows() {
+    printf("Testing source lines with their code...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    unsigned o2;
+    assert(pass_level("2", &o2) == 0);
+    CodeGenerator *codegen = compile(ast, o2);
+    char *text = listing_of(codegen, ast, program_text);
+
+    // each line with code carries its totals
+    char header[128];
+    int bytes, cycles;
+    line_totals(codegen, 1, &bytes, &cycles);
+    snprintf(header, sizeof(header), "    1 %6d %6d | int n = 3; int s = 0;\n", bytes, cycles);
+    assert(strstr(text, header) != NULL);
+    line_totals(codegen, 6, &bytes, &cycles);
+    snprintf(header, sizeof(header), "    6 %6d %6d | if (s == 6)", bytes, cycles);
+    assert(strstr(text, header) != NULL);
+
+    // the loop's condition comes after its body, a brace has no code
+    assert(strstr(text, "    2   (continued) | while (n) {\n") != NULL);
+    assert(strstr(text, "    5               | }\n") != NULL);
+    assert(strstr(text, "; hlt and runtime routines") < strstr(text, "hlt   "));
+    // address, encoding, instruction and cycles
+    assert(strstr(text, "      0000  08 03       ldi A 3                    5\n") != NULL);
+
+    free(text);
+    free_codegen(codegen);
+    free_ast(ast);
+}
+
+void test_statement_totals() {
+    printf("Testing statement and block totals...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    CodeGenerator *codegen = compile(ast, 0);
+    char *text = listing_of(codegen, ast, program_text);
+
+    int program_bytes, program_cycles, while_bytes, while_cycles, body_bytes, body_cycles;
+    row_totals(text, "program\n", &program_bytes, &program_cycles);
+    row_totals(text, "while\n", &while_bytes, &while_cycles);
+    row_totals(text, "body\n", &body_bytes, &body_cycles);
+    assert(strstr(text, "2-4           while\n") != NULL);
+    assert(body_bytes > 0 && while_bytes > body_bytes && while_cycles > body_cycles);
+
+    // the program is every line's code, and nothing of the runtime
+    int total = 0, bytes, cycles;
+    for (int line = 1; line <= 6; line++) {
+        line_totals(codegen, line, &bytes, &cycles);
+        total += bytes;
+    }
+    assert(program_bytes == total);
+    int then_bytes, else_bytes, if_bytes, if_cycles;
+    row_totals(text, "then\n", &then_bytes, &cycles);
+    row_totals(text, "else\n", &else_bytes, &cycles);
+    row_totals(text, "if\n", &if_bytes, &if_cycles);
+    assert(if_bytes > then_bytes + else_bytes);
+
+    free(text);
+    free_codegen(codegen);
+    free_ast(ast);
+}
+
+void test_peephole_keeps_positions() {
+    printf("Testing positions through the peephole pass...\n");
+
+    ASTNode *ast = parse_source("int a = 5;\nint b = a;\na = b + 1;\n");
+    CodeGenerator *plain = compile(ast, 0);
+    CodeGenerator *peephole = compile(ast, PASS_BIT(PASS_PEEPHOLE));
+    assert(peephole->count < plain->count);
+
+    // what is removed comes off a line, nothing moves to another
+    for (int line = 0; line <= 3; line++) {
+        int plain_bytes, peephole_bytes, cycles;
+        line_totals(plain, line, &plain_bytes, &cycles);
+        line_totals(peephole, line, &peephole_bytes, &cycles);
+        assert(peephole_bytes <= plain_bytes);
+        assert((peephole_bytes > 0) == (plain_bytes > 0));
+    }
+    for (int i = 0; i < peephole->count; i++) {
+        if (peephole->instructions[i].opcode == OP_HLT)
+            assert(peephole->positions[i].line == 0);
+    }
+
+    free_codegen(plain);
+    free_codegen(peephole);
+    free_ast(ast);
+}
+
+void test_without_source() {
+    printf("Testing a listing without the source text...\n");
+
+    ASTNode *ast = parse_source(program_text);
+    CodeGenerator *codegen = compile(ast, 0);
+    char *text = listing_of(codegen, ast, NULL);
+
+    int bytes, cycles;
+    line_totals(codegen, 3, &bytes, &cycles);
+    char header[64];
+    snprintf(header, sizeof(header), "    3 %6d %6d |\n", bytes, cycles);
+    assert(strstr(text, header) != NULL);
+    assert(strstr(text, "while (n)") == NULL);
+
+    free(text);
+    free_codegen(codegen);
+    free_ast(ast);
+}
+
+int main() {
+    printf("=== Listing Tests ===\n\n");
+    test_lines_and_rows();
+    test_statement_totals();
+    test_peephole_keeps_positions();
+    test_without_source();
+    printf("\nAll listing tests passed!\n");
+    return 0;
+}
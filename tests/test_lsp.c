@@ -0,0 +1,201 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../include/document.h"
+#include "../include/lsp.h"
+
+static char *tree_text(ASTNode *ast) {
+    OutputSink *sink = create_memory_sink();
+    write_ast(sink, ast);
+    char *text = strdup(sink_contents(sink, NULL));
+    close_sink(sink);
+    return text;
+}
+
+// an edited document must look exactly like the same text parsed from scratch
+static void assert_same_as_fresh(Document *document) {
+    Document *fresh = create_document(document->text, document->length);
+    assert(fresh != NULL);
+    assert(fresh->line_count == document->line_count);
+    assert(memcmp(fresh->line_starts, document->line_starts, sizeof(size_t) * fresh->line_count) == 0);
+    assert(fresh->statement_count == document->statement_count);
+    for (int i = 0; i < fresh->statement_count; i++) {
+        DocumentStatement *expected = &fresh->statements[i];
+        DocumentStatement *statement = &document->statements[i];
+        int shift = statement_line_shift(document, statement);
+        assert(statement->start == expected->start);
+        assert(statement->line + shift == expected->line);
+        assert((statement->ast == NULL) == (expected->ast == NULL));
+        if (expected->ast) {
+            char *a = tree_text(statement->ast);
+            char *b = tree_text(expected->ast);
+            assert(strcmp(a, b) == 0);
+            assert(statement->ast->line + shift == expected->ast->line);
+            assert(statement->ast->column == expected->ast->column);
+            free(a);
+            free(b);
+        } else {
+            assert(strcmp(statement->error, expected->error) == 0);
+            assert(statement->error_line + shift == expected->error_line);
+            assert(statement->error_column == expected->error_column);
+        }
+    }
+    free_document(fresh);
+}
+
+void test_document_statements() {
+    printf("Testing a document split into statements...\n");
+
+    char *text = "import lib;\nint a = 1;  int b = a +;\nif (a == 1) {\n    b = 2;\n}\nint c = 3;\n";
+    Document *document = create_document(text, strlen(text));
+    assert(document != NULL);
+    assert(document->line_count == 7);
+    // import, a, the broken b (which takes the rest of its line), if, c
+    assert(document->statement_count == 5);
+    assert(document->statements[1].start == 12);
+    assert(document->statements[2].ast == NULL);
+    assert(strcmp(document->statements[2].error, "Expected number, identifier, or '('") == 0);
+    assert(document->statements[2].error_line == 2 && document->statements[2].error_column == 24);
+    assert(document->statements[3].ast->type == AST_IF_STATEMENT);
+    assert(document_error_count(document) == 1);
+
+    // fixing the error parses that line again and nothing after it
+    assert(edit_document(document, 1, 23, 1, 23, " 1", 2) == 0);
+    assert(document_error_count(document) == 0);
+    assert(document->statement_count == 5);
+    assert(document->reparsed == 2);
+    assert_same_as_fresh(document);
+
+    printf("Document test passed\n");
+    free_document(document);
+}
+
+void test_incremental_matches_full() {
+    printf("Testing incremental edits against parsing from scratch...\n");
+
+    char *pieces[] = {"int x = 1;\n", "x = x + 2;\n", "if (x == 3) {\n    x = 0;\n}\n", "extern int y;\n",
+                      "int z = (x + y) - 4;\n", "  z = z;\n"};
+    char *inserts[] = {"", "\n", ";", "int q", " = 5;\n", "}", "{", "if (q", "\n\n", "+ 1", "z", "x = 1;\n"};
+    char text[4096] = "";
+    unsigned seed = 12345;
+    for (int i = 0; i < 40; i++) {
+        seed = seed * 1103515245 + 12345;
+        strcat(text, pieces[(seed >> 16) % 6]);
+    }
+    Document *document = create_document(text, strlen(text));
+    assert(document != NULL && document_error_count(document) == 0);
+
+    for (int i = 0; i < 400; i++) {
+        seed = seed * 1103515245 + 12345;
+        int line = (seed >> 16) % (document->line_count + 1);
+        seed = seed * 1103515245 + 12345;
+        int character = (seed >> 16) % 12;
+        seed = seed * 1103515245 + 12345;
+        int span = (seed >> 16) % 3 == 0 ? (int)((seed >> 20) % 15) : 0;
+        seed = seed * 1103515245 + 12345;
+        char *insert = inserts[(seed >> 16) % 12];
+        assert(edit_document(document, line, character, line + span / 10, character + span % 10,
+                             insert, strlen(insert)) == 0);
+        assert_same_as_fresh(document);
+    }
+
+    printf("Incremental test passed\n");
+    free_document(document);
+}
+
+void test_edit_cost() {
+    printf("Testing that an edit re-parses only what it touches...\n");
+
+    size_t size = 20000 * 24;
+    char *text = malloc(size + 1);
+    size_t length = 0;
+    for (int i = 0; i < 20000; i++)
+        length += sprintf(text + length, "int v%d = %d;\n", i, i % 100);
+    Document *document = create_document(text, length);
+    assert(document->statement_count == 20000);
+
+    // a new line in the middle: the statement on it, and the one after as it moves
+    assert(edit_document(document, 10000, 0, 10000, 0, "int w = 1;\n", 11) == 0);
+    assert(document->statement_count == 20001);
+    assert(document->reparsed <= 2);
+    // break and mend the last statement
+    assert(edit_document(document, 20000, 0, 20000, 3, "in", 2) == 0);
+    assert(document_error_count(document) == 1);
+    assert(edit_document(document, 20000, 0, 20000, 2, "int", 3) == 0);
+    assert(document_error_count(document) == 0 && document->reparsed == 1);
+    assert(document->statements[20000].line + statement_line_shift(document, &document->statements[20000]) == 20001);
+    assert_same_as_fresh(document);
+
+    printf("Edit cost test passed\n");
+    free(text);
+    free_document(document);
+}
+
+static void send(int fd, const char *body) {
+    char header[64];
+    int length = snprintf(header, sizeof(header), "Content-Length: %zu\r\n\r\n", strlen(body));
+    assert(write(fd, header, length) == length);
+    assert(write(fd, body, strlen(body)) == (ssize_t)strlen(body));
+}
+
+void test_session() {
+    printf("Testing a language server session...\n");
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":"
+                 "{\"uri\":\"file:///a.sl\",\"languageId\":\"simplelang\",\"version\":1,"
+                 "\"text\":\"int a = 1;\\nint b = ;\\n\"}}}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":"
+                 "{\"uri\":\"file:///a.sl\",\"version\":2},\"contentChanges\":[{\"range\":"
+                 "{\"start\":{\"line\":1,\"character\":8},\"end\":{\"line\":1,\"character\":8}},\"text\":\"a\"}]}}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"id\":\"s\",\"method\":\"textDocument/documentSymbol\",\"params\":"
+                 "{\"textDocument\":{\"uri\":\"file:///a.sl\"}}}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"textDocument/hover\",\"params\":{}}");
+    send(fds[1], "{not json");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"shutdown\"}");
+    send(fds[1], "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+    close(fds[1]);
+
+    OutputSink *out = create_memory_sink();
+    assert(run_language_server(fds[0], out) == 0);
+    close(fds[0]);
+    const char *replies = sink_contents(out, NULL);
+
+    assert(strstr(replies, "\"id\":1,\"result\":{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2}"));
+    // the open shows the error, the change clears it
+    const char *opened = strstr(replies, "\"version\":1,\"diagnostics\":[{\"range\":{\"start\":{\"line\":1,\"character\":8}");
+    assert(opened != NULL);
+    assert(strstr(opened, "\"message\":\"Expected number, identifier, or '('\""));
+    assert(strstr(replies, "\"version\":2,\"diagnostics\":[]"));
+    assert(strstr(replies, "\"id\":\"s\",\"result\":[{\"name\":\"a\",\"detail\":\"int\",\"kind\":13,"
+                           "\"range\":{\"start\":{\"line\":0,\"character\":4}"));
+    assert(strstr(replies, "{\"name\":\"b\""));
+    assert(strstr(replies, "\"id\":2,\"error\":{\"code\":-32601"));
+    assert(strstr(replies, "\"id\":null,\"error\":{\"code\":-32700"));
+    assert(strstr(replies, "\"id\":3,\"result\":null"));
+    printf("Got replies:\n%s\n", replies);
+
+    printf("Session test passed\n");
+    close_sink(out);
+}
+
+int main() {
+    printf("Running language server tests...\n\n");
+
+    test_document_statements();
+    printf("\n");
+    test_incremental_matches_full();
+    printf("\n");
+    test_edit_cost();
+    printf("\n");
+    test_session();
+
+    printf("\nAll language server tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/output.h"
+
+void test_memory_sink() {
+    printf("Testing memory sink...\n");
+
+    OutputSink *sink = create_memory_sink();
+    assert(sink != NULL);
+    sink_puts(sink, ".text\n");
+    sink_printf(sink, "ldi A %d\n", 42);
+    sink_write(sink, "hlt\n", 4);
+
+    size_t length;
+    const char *text = sink_contents(sink, &length);
+    assert(strcmp(text, ".text\nldi A 42\nhlt\n") == 0);
+    assert(length == strlen(text));
+    assert(close_sink(sink) == 0);
+
+    printf("Memory sink test passed\n");
+}
+
+void test_sink_growth() {
+    printf("Testing output larger than the sink buffer...\n");
+
+    OutputSink *sink = create_memory_sink();
+    for (int i = 0; i < 20000; i++) {
+        sink_printf(sink, "sta %%var_%d\n", i);
+    }
+    size_t length;
+    const char *text = sink_contents(sink, &length);
+    assert(length > SINK_BUFFER_SIZE);
+    assert(strncmp(text, "sta %var_0\n", 11) == 0);
+    assert(strstr(text, "sta %var_19999\n") != NULL);
+    close_sink(sink);
+
+    printf("Sink growth test passed\n");
+}
+
+void test_file_sink() {
+    printf("Testing file sink...\n");
+
+    OutputSink *sink = create_file_sink("output/test_sink.asm");
+    assert(sink != NULL);
+    for (int i = 0; i < 10000; i++) {
+        sink_puts(sink, "add\n");
+    }
+    assert(close_sink(sink) == 0);
+
+    FILE *file = fopen("output/test_sink.asm", "r");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    assert(ftell(file) == 40000);
+    fclose(file);
+
+    printf("File sink test passed\n");
+}
+
+int main() {
+    printf("=== Output Sink Tests ===\n\n");
+    test_memory_sink();
+    test_sink_growth();
+    test_file_sink();
+    printf("\nAll output sink tests passed!\n");
+    return 0;
+}
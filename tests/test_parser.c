@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ast.h"
@@ -28,23 +30,91 @@ void test_parser(char *input, char *description)
 
     if (parser->has_error)
     {
-        printf("Parser Error: %s\n", parser->error_message);
+        for (int i = 0; i < parser->error_count; i++)
+        {
+            printf("Parser Error: %s\n", parser->errors[i].message);
+        }
     }
     else if (ast)
     {
         printf("AST:\n");
         print_ast(ast, 0, 1, "");
-        free_ast(ast);
     }
     else
     {
         printf("No AST generated\n");
     }
+    free_ast(ast);
 
     free_parser(parser);
     free_lexer(lexer);
 }
 
+// every error of a broken program in one parse, each lost statement an error node
+void test_error_recovery()
+{
+    printf("\n=== Testing: Recovery from several errors ===\n");
+    char input[] = "int a = ;\n"
+                   "int b = 5\n"
+                   "while (b) { b = b - ; a = a + 1; }\n"
+                   "if (a == ) { b = 1; } else { b = 2; }\n"
+                   "b = 2 +;\n"
+                   "}\n"
+                   "int c = 3;\n";
+    Lexer *lexer = create_lexer(input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL && parser->has_error);
+
+    int lines[] = {1, 2, 3, 4, 5, 6};
+    assert(parser->error_count == 6);
+    for (int i = 0; i < parser->error_count; i++)
+    {
+        printf("Parser Error: %s\n", parser->errors[i].message);
+        assert(parser->errors[i].line == lines[i]);
+    }
+    assert(strcmp(parser->first_error.message, parser->errors[0].message) == 0);
+    assert(parser->first_error.line == 1 && parser->first_error.column == 9);
+
+    // a, b, the while, the if, b = 2 +, the stray brace and c
+    assert(ast->data.block.count == 7);
+    assert(ast->data.block.statements[0]->type == AST_ERROR);
+    assert(ast->data.block.statements[1]->type == AST_ERROR);
+    ASTNode *body = ast->data.block.statements[2]->data.while_stmt.body;
+    assert(body->data.block.count == 2 && body->data.block.statements[0]->type == AST_ERROR);
+    assert(body->data.block.statements[1]->type == AST_ASSIGNMENT);
+    assert(ast->data.block.statements[3]->type == AST_ERROR);
+    assert(ast->data.block.statements[6]->type == AST_DECLARATION);
+    print_ast(ast, 0, 1, "");
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+
+    // the limit ends the parse
+    char many[] = "a = ;\nb = ;\nc = ;\nd = ;\n";
+    lexer = create_lexer(many);
+    parser = create_parser(lexer);
+    parser->max_errors = 2;
+    ast = parse_program(parser);
+    assert(parser->error_count == 2 && parser->stopped);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+
+    // a run of stray braces is one error, and the statement after it is kept
+    char braces[] = "int a = 1;\n}}\n}\nb = 2;\n";
+    lexer = create_lexer(braces);
+    parser = create_parser(lexer);
+    ast = parse_program(parser);
+    assert(parser->error_count == 1 && parser->errors[0].line == 2 && parser->errors[0].column == 1);
+    assert(ast->data.block.count == 3);
+    assert(ast->data.block.statements[1]->type == AST_ERROR);
+    assert(ast->data.block.statements[2]->type == AST_ASSIGNMENT);
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+}
+
 int main()
 {
 
@@ -72,5 +142,23 @@ int main()
     // Test 8: Complex expression
     test_parser("int result = (a + b) - c;", "Complex expression with parentheses");
 
+    // Test 9: While loop
+    test_parser("while (n) {\n  n = n - 1;\n}", "While loop");
+
+    // Test 10: Precedence, loosest first: ==, shifts, + and -, *
+    test_parser("int r = a + b * 2 << 1 == c;", "Multiplication and shift precedence");
+
+    // Test 11: Nesting past PARSER_MAX_DEPTH is an error, not a stack overflow
+    int levels = PARSER_MAX_DEPTH + 1;
+    char *nested = malloc(levels * 2 + 16);
+    strcpy(nested, "int a = ");
+    memset(nested + 8, '(', levels);
+    nested[8 + levels] = '1';
+    memset(nested + 9 + levels, ')', levels);
+    strcpy(nested + 9 + levels * 2, ";");
+    test_parser(nested, "Parentheses nested too deeply");
+    free(nested);
+
+    test_error_recovery();
     return 0;
 }
\ No newline at end of file
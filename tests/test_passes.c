@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/codegen.h"
+#include "../include/passes.h"
+#include "../include/assembler.h"
+#include "../include/simulator.h"
+
+static ASTNode *parse_source(const char *input) {
+    Lexer *lexer = create_lexer((char *)input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+    free_parser(parser);
+    free_lexer(lexer);
+    return ast;
+}
+
+static CodeGenerator *compile(const char *input, unsigned enabled, PassStats *stats) {
+    ASTNode *ast = parse_source(input);
+    CodeGenerator *codegen = create_codegen();
+    PassOptions options = {enabled, 0};
+    assert(run_passes(codegen, ast, &options, stats, NULL) == 0);
+    free_ast(ast);
+    return codegen;
+}
+
+// value of a variable once the program has run to its hlt; size and cycles may be NULL
+static int run_and_read(CodeGenerator *codegen, const char *name, int *size, long long *cycles) {
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 1000000) == 0);
+    int value = read_variable(sim, image, find_symbol(&codegen->symbols, name));
+    if (size)
+        *size = image->size;
+    if (cycles)
+        *cycles = sim->cycles;
+    free_simulator(sim);
+    free_program_image(image);
+    return value;
+}
+
+void test_levels_and_names() {
+    printf("Testing optimization levels and pass names...\n");
+
+    unsigned enabled;
+    assert(pass_level("0", &enabled) == 0 && enabled == 0);
+    assert(pass_level("1", &enabled) == 0);
+    assert(enabled == (PASS_BIT(PASS_FOLD) | PASS_BIT(PASS_PEEPHOLE)));
+    assert(pass_level("2", &enabled) == 0 && enabled == PASS_BIT(PASS_COUNT) - 1);
+    assert(pass_level("s", &enabled) == 0);
+    assert(!(enabled & PASS_BIT(PASS_LOOPS)) && (enabled & PASS_BIT(PASS_SLOTS)));
+    assert(pass_level("3", &enabled) == -1);
+
+    for (int pass = 0; pass < PASS_COUNT; pass++) {
+        assert(find_pass(pass_name(pass)) == pass);
+    }
+    assert(find_pass("peephole") == PASS_PEEPHOLE);
+    assert(find_pass("inline") == -1);
+}
+
+void test_constant_folding() {
+    printf("Testing constant folding...\n");
+
+    ASTNode *ast = parse_source("int a = 2 + 3 * 4; int b = a * 1 + 0; int c = (a - a) * 0; int d = 1 << 20;");
+    CodeGenerator *codegen = create_codegen();
+    PassOptions options = {PASS_BIT(PASS_FOLD), PASS_BIT(PASS_FOLD)};
+    PassStats stats;
+    OutputSink *dump = create_memory_sink();
+    assert(run_passes(codegen, ast, &options, &stats, dump) == 0);
+
+    // 3 * 4, 2 + 12, a * 1, + 0, * 0 and 1 << 20; a - a reads a, which is kept
+    assert(stats.changes[PASS_FOLD] == 6);
+    assert(stats.ran == PASS_BIT(PASS_FOLD));
+    size_t length;
+    const char *text = sink_contents(dump, &length);
+    assert(strstr(text, "; after fold\n") != NULL);
+    assert(strstr(text, "14") != NULL);
+
+    assert(run_and_read(codegen, "a", NULL, NULL) == 14);
+    assert(run_and_read(codegen, "b", NULL, NULL) == 14);
+    assert(run_and_read(codegen, "c", NULL, NULL) == 0);
+    assert(run_and_read(codegen, "d", NULL, NULL) == 0);
+
+    close_sink(dump);
+    free_codegen(codegen);
+    free_ast(ast);
+}
+
+void test_peephole_keeps_results() {
+    printf("Testing the peephole pass...\n");
+
+    const char *source = "int a = 5; int b = a; a = b + 1;\n"
+                         "int n = 3; int s = 0;\n"
+                         "while (n) { s = s + a; n = n - 1; }\n";
+    PassStats plain_stats, peephole_stats;
+    CodeGenerator *plain = compile(source, 0, &plain_stats);
+    CodeGenerator *peephole = compile(source, PASS_BIT(PASS_PEEPHOLE), &peephole_stats);
+
+    // the store of a followed by its load, and the load of b right after it is stored
+    assert(peephole_stats.changes[PASS_PEEPHOLE] > 0);
+    assert(peephole->count == plain->count - peephole_stats.changes[PASS_PEEPHOLE]);
+    assert(peephole_stats.instructions == plain->count);
+    for (int i = 0; i + 1 < peephole->count; i++) {
+        Instruction *inst = &peephole->instructions[i];
+        assert(!(inst->opcode == OP_MOV && inst->operand[0] == inst->operand[1]));
+    }
+
+    int plain_size, peephole_size;
+    assert(run_and_read(plain, "s", &plain_size, NULL) == 18);
+    assert(run_and_read(peephole, "s", &peephole_size, NULL) == 18);
+    assert(peephole_size < plain_size);
+
+    free_codegen(plain);
+    free_codegen(peephole);
+}
+
+void test_levels_change_code() {
+    printf("Testing the code of each level...\n");
+
+    const char *source = "int n = 10; int s = 0; int k = 4;\n"
+                         "while (n) { s = s + k * 3; n = n - 1; }\n"
+                         "int c = s * 10;\n";
+    unsigned o0, o2, os;
+    assert(pass_level("0", &o0) == 0 && pass_level("2", &o2) == 0 && pass_level("s", &os) == 0);
+    PassStats stats;
+    CodeGenerator *none = compile(source, o0, &stats);
+    assert(stats.ran == 0 && none->loop_values == 0 && none->chained_multiplies == 0);
+    CodeGenerator *all = compile(source, o2, &stats);
+    assert(stats.ran == PASS_BIT(PASS_COUNT) - 1);
+    assert(stats.changes[PASS_LOOPS] > 0 && stats.changes[PASS_MULCHAIN] > 0);
+    // planning the loop and finding the chains are timed apart from the lowering
+    assert(stats.analysis_nanoseconds > 0 && stats.nanoseconds[PASS_LOOPS] > 0);
+    assert(stats.nanoseconds[PASS_MULCHAIN] > 0);
+    CodeGenerator *small = compile(source, os, &stats);
+    assert(small->loop_values == 0);
+
+    // -O2 spends bytes before the loop to make it faster, -Os does not
+    int none_size, all_size, small_size;
+    long long none_cycles, all_cycles, small_cycles;
+    assert(run_and_read(none, "c", &none_size, &none_cycles) == 1200);
+    assert(run_and_read(all, "c", &all_size, &all_cycles) == 1200);
+    assert(run_and_read(small, "c", &small_size, &small_cycles) == 1200);
+    assert(small_size < all_size && small_size < none_size);
+    assert(all_cycles < small_cycles && small_cycles < none_cycles);
+
+    // a pass turned off is left out of a level
+    CodeGenerator *no_chain = compile(source, o2 & ~PASS_BIT(PASS_MULCHAIN), &stats);
+    assert(no_chain->chained_multiplies == 0 && !(stats.ran & PASS_BIT(PASS_MULCHAIN)));
+    assert(run_and_read(no_chain, "c", NULL, NULL) == 1200);
+
+    OutputSink *sink = create_memory_sink();
+    write_pass_stats(sink, &stats);
+    size_t length;
+    const char *text = sink_contents(sink, &length);
+    assert(strstr(text, "codegen") != NULL && strstr(text, "analysis") != NULL);
+    assert(strstr(text, "(codegen)") == NULL);
+    assert(strstr(text, "instructions removed") != NULL);
+    assert(strstr(text, "multiplies chained") == NULL);
+    close_sink(sink);
+
+    free_codegen(none);
+    free_codegen(all);
+    free_codegen(small);
+    free_codegen(no_chain);
+}
+
+int main() {
+    printf("=== Pass Manager Tests ===\n\n");
+    test_levels_and_names();
+    test_constant_folding();
+    test_peephole_keeps_results();
+    test_levels_change_code();
+    printf("\nAll pass manager tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/range.h"
+
+static ASTNode *parse_source(const char *input) {
+    Lexer *lexer = create_lexer((char *)input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+    free_parser(parser);
+    free_lexer(lexer);
+    return ast;
+}
+
+static int has_range(ValueRange range, int low, int high) {
+    return range.low == low && range.high == high;
+}
+
+void test_straight_line_ranges() {
+    printf("Testing ranges of straight line code...\n");
+
+    ASTNode *ast = parse_source("int a = 10; int b = a * 30; int c = b - 400; int d = a << 2;");
+    RangeAnalysis *analysis = analyze_ranges(ast, 0);
+    assert(analysis != NULL && !analysis->has_error);
+
+    // a slot holds its initial zero as well as what is stored in it
+    assert(has_range(variable_range(analysis, "a"), 0, 10));
+    assert(has_range(variable_range(analysis, "b"), 0, 300));
+    assert(has_range(variable_range(analysis, "c"), -100, 0));
+    assert(fits_in_byte(variable_range(analysis, "d")));
+    assert(!fits_in_byte(variable_range(analysis, "b")));
+    assert(!fits_in_byte(variable_range(analysis, "c")));
+
+    // the expression of b's assignment, a * 30
+    ASTNode *product = ast->data.block.statements[1]->data.declaration.init_value;
+    assert(has_range(node_range(analysis, product), 300, 300));
+
+    free_range_analysis(analysis);
+    free_ast(ast);
+}
+
+void test_branch_and_loop_ranges() {
+    printf("Testing ranges through branches and loops...\n");
+
+    // the loop runs at most n times, so s stays a byte; i keeps growing and is widened
+    ASTNode *ast = parse_source("int n = 10; int s = 0; int i = 0; int f = 0;\n"
+                                "while (n) { s = s + 20; n = n - 1; }\n"
+                                "while (f == 0) { i = i + 1; if (i == 1000) { f = 1; } }\n");
+    RangeAnalysis *analysis = analyze_ranges(ast, 0);
+    assert(analysis != NULL && !analysis->has_error);
+    assert(has_range(variable_range(analysis, "n"), 0, 10));
+    assert(fits_in_byte(variable_range(analysis, "s")));
+    assert(!fits_in_byte(variable_range(analysis, "i")));
+    assert(has_range(variable_range(analysis, "f"), 0, 1));
+    free_range_analysis(analysis);
+
+    // shared with other modules, nothing is known about the globals until stored
+    analysis = analyze_ranges(ast, 1);
+    assert(analysis != NULL);
+    assert(has_range(variable_range(analysis, "n"), RANGE_MIN, RANGE_MAX));
+    free_range_analysis(analysis);
+    free_ast(ast);
+}
+
+void test_literal_out_of_range() {
+    printf("Testing literals past the 16-bit int...\n");
+
+    ASTNode *ast = parse_source("int a = 1;\nint b = 40000;");
+    RangeAnalysis *analysis = analyze_ranges(ast, 0);
+    assert(analysis != NULL && analysis->has_error);
+    assert(strstr(analysis->error_message, "line 2") != NULL);
+    printf("Got expected error: %s\n", analysis->error_message);
+    free_range_analysis(analysis);
+    free_ast(ast);
+}
+
+int main() {
+    printf("=== Range Analysis Tests ===\n\n");
+    test_straight_line_ranges();
+    test_branch_and_loop_ranges();
+    test_literal_out_of_range();
+    printf("\nAll range analysis tests passed!\n");
+    return 0;
+}
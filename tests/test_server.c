@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/server.h"
+
+#define TEST_SOCKET "/tmp/simplelang-test-server.sock"
+
+void test_frame_round_trip() {
+    printf("Testing frame encoding...\n");
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    assert(write_frame(fds[0], FRAME_ARG, "--vm", 4) == 0);
+    assert(write_frame(fds[0], FRAME_END, NULL, 0) == 0);
+
+    uint32_t type, length;
+    char *data;
+    assert(read_frame(fds[1], &type, &data, &length) == 0);
+    assert(type == FRAME_ARG && length == 4 && strcmp(data, "--vm") == 0);
+    free(data);
+    assert(read_frame(fds[1], &type, &data, &length) == 0);
+    assert(type == FRAME_END && length == 0 && data[0] == '\0');
+    free(data);
+
+    // a truncated frame is an error, not a hang
+    unsigned char header[8] = {FRAME_ARG, 0, 0, 0, 10, 0, 0, 0};
+    assert(write(fds[0], header, sizeof(header)) == sizeof(header));
+    close(fds[0]);
+    assert(read_frame(fds[1], &type, &data, &length) != 0);
+    close(fds[1]);
+
+    printf("Frame test passed\n");
+}
+
+static void *server_thread(void *arg) {
+    (void)arg;
+    run_server(TEST_SOCKET);
+    return NULL;
+}
+
+static int connect_test_server(void) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, TEST_SOCKET);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+            return fd;
+        close(fd);
+        struct timespec pause = {0, 10000000};
+        nanosleep(&pause, NULL);
+    }
+    return -1;
+}
+
+// send a request with source text, collect the reply
+static int request(const char *const *args, int count, const char *source, char **out, char **err) {
+    int fd = connect_test_server();
+    assert(fd >= 0);
+    assert(write_frame(fd, FRAME_CWD, "/tmp", 4) == 0);
+    for (int i = 0; i < count; i++) {
+        assert(write_frame(fd, FRAME_ARG, args[i], strlen(args[i])) == 0);
+    }
+    if (source)
+        assert(write_frame(fd, FRAME_SOURCE, source, strlen(source)) == 0);
+    assert(write_frame(fd, FRAME_END, NULL, 0) == 0);
+
+    int status = -1;
+    *out = *err = NULL;
+    for (;;) {
+        uint32_t type, length;
+        char *data;
+        assert(read_frame(fd, &type, &data, &length) == 0);
+        if (type == FRAME_END) {
+            free(data);
+            break;
+        }
+        if (type == FRAME_STATUS)
+            status = data[0];
+        else if (type == FRAME_OUT)
+            *out = data, data = NULL;
+        else if (type == FRAME_ERR)
+            *err = data, data = NULL;
+        free(data);
+    }
+    close(fd);
+    return status;
+}
+
+void test_server_compiles_source() {
+    printf("Testing requests against a running server...\n");
+
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, server_thread, NULL) == 0);
+
+    char *out, *err;
+    const char *run[] = {"--vm", "memory.sl"};
+    assert(request(run, 2, "int a = 2;\nint b = a + 3;\n", &out, &err) == 0);
+    assert(strcmp(out, "a = 2\nb = 5\n") == 0);
+    assert(strcmp(err, "") == 0);
+    free(out);
+    free(err);
+
+    const char *ir[] = {"--emit=ir", "memory.sl"};
+    assert(request(ir, 2, "int a = 1;\n", &out, &err) == 0);
+    assert(strstr(out, "sta %var_a") != NULL);
+    free(out);
+    free(err);
+
+    const char *broken[] = {"--stop-after=parse", "broken.sl"};
+    assert(request(broken, 2, "int = 3;\n", &out, &err) == 1);
+    assert(strncmp(err, "broken.sl:1:5: error:", 21) == 0);
+    free(out);
+    free(err);
+
+    // the cache stays open between requests: the second one hits what the first stored
+    char directory[] = "/tmp/simplelang-server-XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char input[64], cache_dir[80], path[128];
+    snprintf(input, sizeof(input), "%s/a.sl", directory);
+    snprintf(cache_dir, sizeof(cache_dir), "--cache-dir=%s/cache", directory);
+    FILE *file = fopen(input, "w");
+    fputs("int a = 3;\n", file);
+    fclose(file);
+    const char *cached[] = {cache_dir, "--cache-stats", "--emit=hex", "-o", "-", input};
+    char *first;
+    assert(request(cached, 6, NULL, &first, &err) == 0);
+    assert(strstr(err, "0 hits, 1 misses") != NULL);
+    free(err);
+    assert(request(cached, 6, NULL, &out, &err) == 0);
+    assert(strstr(err, "1 hits, 1 misses") != NULL);
+    assert(strcmp(out, first) == 0);
+    free(first);
+    free(out);
+    free(err);
+
+    // a client that stalls halfway through its request is dropped, and does not keep the
+    // stop request waiting on its worker
+    int stalled = connect_test_server();
+    assert(stalled >= 0);
+    assert(write(stalled, "\1\0", 2) == 2);
+    time_t began = time(NULL);
+    char byte;
+    assert(read(stalled, &byte, 1) <= 0);
+    assert(time(NULL) - began <= SERVER_CLIENT_TIMEOUT + 2);
+    close(stalled);
+
+    assert(stop_server(TEST_SOCKET) == 0);
+    pthread_join(thread, NULL);
+    // the server trims its caches as it stops, and leaves them in place
+    snprintf(path, sizeof(path), "rm -r %s", directory);
+    assert(system(path) == 0);
+    assert(access(TEST_SOCKET, F_OK) != 0);
+
+    printf("Server test passed\n");
+}
+
+void test_socket_location() {
+    printf("Testing where the socket may live...\n");
+
+    char path[256];
+    unsetenv("SIMPLELANG_SOCKET");
+    setenv("XDG_RUNTIME_DIR", "/run/user/1000", 1);
+    default_socket_path(path, sizeof(path));
+    assert(strcmp(path, "/run/user/1000/simplelang.sock") == 0);
+    unsetenv("XDG_RUNTIME_DIR");
+    default_socket_path(path, sizeof(path));
+    char expected[64];
+    snprintf(expected, sizeof(expected), "/tmp/simplelang-%ld/server.sock", (long)getuid());
+    assert(strcmp(path, expected) == 0);
+
+    // anyone could swap the socket in a directory others can write to: neither end uses it
+    char directory[] = "/tmp/simplelang-open-XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    assert(chmod(directory, 0777) == 0);
+    snprintf(path, sizeof(path), "%s/server.sock", directory);
+    assert(run_server(path) == 1);
+    assert(access(path, F_OK) != 0);
+    char *argv[] = {"simplelang", "--vm", "memory.sl"};
+    assert(run_client(path, 3, argv) == 1);
+    rmdir(directory);
+
+    printf("Socket location test passed\n");
+}
+
+int main() {
+    printf("Running compile server tests...\n\n");
+
+    test_frame_round_trip();
+    test_server_compiles_source();
+    test_socket_location();
+
+    printf("\nAll compile server tests passed!\n");
+    return 0;
+}
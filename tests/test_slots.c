@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/codegen.h"
+#include "../include/slots.h"
+#include "../include/assembler.h"
+#include "../include/simulator.h"
+
+static CodeGenerator *compile(const char *input, int shared) {
+    Lexer *lexer = create_lexer((char *)input);
+    Parser *parser = create_parser(lexer);
+    ASTNode *ast = parse_program(parser);
+    assert(ast != NULL);
+    assert(!parser->has_error);
+
+    CodeGenerator *codegen = create_codegen();
+    codegen->shared_globals = shared;
+    assert(generate_code(codegen, ast) == 0);
+    // as the slots pass does, modules keep theirs for the linker
+    if (!shared)
+        assert(share_data_slots(codegen, ast) == 0);
+
+    free_ast(ast);
+    free_parser(parser);
+    free_lexer(lexer);
+    return codegen;
+}
+
+static int slot_of(CodeGenerator *codegen, const char *name) {
+    return codegen->data_slot[find_symbol(&codegen->symbols, name)];
+}
+
+void test_block_locals_share() {
+    printf("Testing block locals sharing slots...\n");
+
+    CodeGenerator *codegen = compile("int n = 3; int total = 0;\n"
+                                     "while (n) { int t = n * 2; total = total + t; n = n - 1; }\n"
+                                     "if (total == 12) { int u = total + 1; total = u; }\n"
+                                     "int result = total + 5;\n", 0);
+    // t is done with before u starts, and both before result is first stored
+    assert(slot_of(codegen, "u") == slot_of(codegen, "t"));
+    assert(slot_of(codegen, "result") == slot_of(codegen, "t"));
+    // the program's results keep slots of their own to the end
+    assert(slot_of(codegen, "n") == find_symbol(&codegen->symbols, "n"));
+    assert(slot_of(codegen, "total") == find_symbol(&codegen->symbols, "total"));
+    assert(data_bytes_saved(codegen) == 2);
+
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    assert(image->size - image->text_size == 3);
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 100000) == 0);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "total")) == 13);
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "result")) == 18);
+    assert(image->symbol_dead[find_symbol(&codegen->symbols, "t")]);
+    assert(!image->symbol_dead[find_symbol(&codegen->symbols, "result")]);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_loop_carried_local() {
+    printf("Testing a local read around a loop...\n");
+
+    // p is read before it is stored on every pass but the first, so it lives through the
+    // whole loop and q, stored inside it, cannot have its slot
+    CodeGenerator *codegen = compile("int n = 4; int s = 0;\n"
+                                     "while (n) { s = s + p; int p = n; int q = s + 1; s = q; n = n - 1; }\n", 0);
+    assert(slot_of(codegen, "p") != slot_of(codegen, "q"));
+
+    ProgramImage *image = assemble_program(codegen);
+    assert(image != NULL && !image->has_error);
+    Simulator *sim = create_simulator(image);
+    assert(run_simulator(sim, 100000) == 0);
+    // s gains 1 on every pass and the previous pass's n on all but the first
+    assert(read_variable(sim, image, find_symbol(&codegen->symbols, "s")) == 4 + 4 + 3 + 2);
+
+    free_simulator(sim);
+    free_program_image(image);
+    free_codegen(codegen);
+}
+
+void test_module_keeps_slots() {
+    printf("Testing module globals keeping their slots...\n");
+
+    CodeGenerator *codegen = compile("int a = 1;\nif (a) { int b = 2; a = b; }\nint c = 3;\n", 1);
+    assert(codegen->data_slot == NULL);
+    assert(data_bytes_saved(codegen) == 0);
+    free_codegen(codegen);
+}
+
+int main() {
+    printf("=== Data Slot Sharing Tests ===\n\n");
+    test_block_locals_share();
+    test_loop_carried_local();
+    test_module_keeps_slots();
+    printf("\nAll data slot sharing tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "../include/threadpool.h"
+
+#define TASK_COUNT 2000
+
+typedef struct {
+    int index;
+    int runs;
+    int spin; // uneven work so idle workers have to steal
+} Counter;
+
+static void count_task(void *arg) {
+    Counter *counter = arg;
+    volatile int sink = 0;
+    for (int i = 0; i < counter->spin; i++) {
+        sink += i;
+    }
+    (void)sink;
+    counter->runs++;
+}
+
+void test_every_task_runs_once() {
+    printf("Testing that every submitted task runs exactly once...\n");
+
+    Counter *counters = calloc(TASK_COUNT, sizeof(Counter));
+    ThreadPool *pool = create_thread_pool(4);
+    assert(pool != NULL);
+    for (int i = 0; i < TASK_COUNT; i++) {
+        counters[i].index = i;
+        // every fourth task lands on the same deque and is much heavier
+        counters[i].spin = i % 4 == 0 ? 20000 : 10;
+        assert(thread_pool_submit(pool, count_task, &counters[i]) == 0);
+    }
+    thread_pool_wait(pool);
+    for (int i = 0; i < TASK_COUNT; i++) {
+        assert(counters[i].runs == 1);
+    }
+
+    // the pool can be reused after a wait
+    for (int i = 0; i < TASK_COUNT; i++) {
+        assert(thread_pool_submit(pool, count_task, &counters[i]) == 0);
+    }
+    thread_pool_wait(pool);
+    for (int i = 0; i < TASK_COUNT; i++) {
+        assert(counters[i].runs == 2);
+    }
+
+    free_thread_pool(pool);
+    free(counters);
+    printf("Task count test passed\n");
+}
+
+void test_single_thread_and_empty_wait() {
+    printf("Testing a one-thread pool and waiting with nothing submitted...\n");
+
+    ThreadPool *pool = create_thread_pool(0);
+    assert(pool != NULL);
+    assert(pool->thread_count == 1);
+    thread_pool_wait(pool);
+
+    Counter counter = {0, 0, 100};
+    assert(thread_pool_submit(pool, count_task, &counter) == 0);
+    thread_pool_wait(pool);
+    assert(counter.runs == 1);
+
+    free_thread_pool(pool);
+    printf("Single thread test passed\n");
+}
+
+void test_free_drains_queue() {
+    printf("Testing that freeing the pool finishes queued tasks...\n");
+
+    Counter counters[64] = {{0, 0, 0}};
+    ThreadPool *pool = create_thread_pool(2);
+    for (int i = 0; i < 64; i++) {
+        counters[i].spin = 1000;
+        thread_pool_submit(pool, count_task, &counters[i]);
+    }
+    free_thread_pool(pool);
+    for (int i = 0; i < 64; i++) {
+        assert(counters[i].runs == 1);
+    }
+
+    printf("Drain test passed\n");
+}
+
+typedef struct {
+    ThreadPool *pool;
+    int lowest; // fewest queued tasks a running task has seen
+} QueuedWatch;
+
+static void watch_queued(void *arg) {
+    QueuedWatch *watch = arg;
+    pthread_mutex_lock(&watch->pool->lock);
+    if (watch->pool->queued < watch->lowest)
+        watch->lowest = watch->pool->queued;
+    pthread_mutex_unlock(&watch->pool->lock);
+}
+
+void test_queued_never_negative() {
+    printf("Testing that tasks taken as they are submitted are counted first...\n");
+
+    ThreadPool *pool = create_thread_pool(4);
+    assert(pool != NULL);
+    QueuedWatch watch = {pool, 0};
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 50; i++) {
+            assert(thread_pool_submit(pool, watch_queued, &watch) == 0);
+        }
+        thread_pool_wait(pool);
+    }
+    assert(watch.lowest == 0);
+    assert(pool->queued == 0 && pool->pending == 0);
+    free_thread_pool(pool);
+
+    printf("Queued count test passed\n");
+}
+
+int main() {
+    printf("Running thread pool tests...\n\n");
+
+    test_every_task_runs_once();
+    test_single_thread_and_empty_wait();
+    test_free_drains_queue();
+    test_queued_never_negative();
+
+    printf("\nAll thread pool tests passed!\n");
+    return 0;
+}
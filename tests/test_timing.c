@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/timing.h"
+
+void test_disabled_timers() {
+    printf("Testing that a NULL report is never touched...\n");
+
+    TimeReport *report = NULL;
+    int counted = 0;
+    uint64_t start = TIMER_START(report);
+    assert(start == 0);
+    // the item count is not even evaluated
+    TIMER_STOP(report, TIME_PARSE, start, ++counted);
+    assert(counted == 0);
+
+    printf("Disabled timer test passed\n");
+}
+
+void test_record_and_merge() {
+    printf("Testing recording and merging...\n");
+
+    TimeReport first = {{0}, {0}};
+    TimeReport *report = &first;
+    uint64_t start = TIMER_START(report);
+    assert(start > 0);
+    TIMER_STOP(report, TIME_LEX, start, 12);
+    TIMER_STOP(report, TIME_LEX, start, 3);
+    assert(first.items[TIME_LEX] == 15);
+    // a start in the future adds items but no time
+    record_phase(&first, TIME_PARSE, monotonic_nanoseconds() + 1000000000u, 5);
+    assert(first.nanoseconds[TIME_PARSE] == 0 && first.items[TIME_PARSE] == 5);
+
+    TimeReport total = {{0}, {0}};
+    merge_time_report(&total, &first);
+    merge_time_report(&total, &first);
+    assert(total.items[TIME_LEX] == 30);
+    assert(total.nanoseconds[TIME_LEX] == 2 * first.nanoseconds[TIME_LEX]);
+
+    printf("Record and merge test passed\n");
+}
+
+void test_report_formats() {
+    printf("Testing report output...\n");
+
+    TimeReport report = {{0}, {0}};
+    report.nanoseconds[TIME_READ] = 1000000; // 1 ms for 2000 bytes
+    report.items[TIME_READ] = 2000;
+    report.nanoseconds[TIME_PARSE] = 3000000;
+    report.items[TIME_PARSE] = 300;
+
+    OutputSink *text = create_memory_sink();
+    write_time_report(text, &report, TIME_FORMAT_TEXT, 2, 1, 5000000);
+    const char *contents = sink_contents(text, NULL);
+    assert(strstr(contents, "2 inputs on 1 thread, 5.000 ms wall") != NULL);
+    assert(strstr(contents, "read") != NULL && strstr(contents, "25.0%") != NULL);
+    assert(strstr(contents, "2000000") != NULL); // bytes per second
+    assert(strstr(contents, "75.0%") != NULL);
+    // phases that did not run are left out
+    assert(strstr(contents, "assemble") == NULL);
+    close_sink(text);
+
+    OutputSink *json = create_memory_sink();
+    write_time_report(json, &report, TIME_FORMAT_JSON, 2, 1, 5000000);
+    contents = sink_contents(json, NULL);
+    assert(strncmp(contents, "{\"inputs\": 2, \"threads\": 1, \"wall_ns\": 5000000, \"total_ns\": 4000000", 67) == 0);
+    assert(strstr(contents, "{\"phase\": \"parse\", \"ns\": 3000000, \"percent\": 75.00, \"items\": 300, "
+                            "\"unit\": \"nodes\", \"items_per_second\": 100000}") != NULL);
+    assert(strstr(contents, "{\"phase\": \"run\", \"ns\": 0, \"percent\": 0.00}") != NULL);
+    assert(strcmp(contents + strlen(contents) - 3, "]}\n") == 0);
+    close_sink(json);
+
+    printf("Report test passed\n");
+}
+
+int main() {
+    printf("Running timing tests...\n\n");
+
+    test_disabled_timers();
+    test_record_and_merge();
+    test_report_formats();
+
+    printf("\nAll timing tests passed!\n");
+    return 0;
+}